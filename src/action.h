@@ -20,6 +20,8 @@
 #ifndef __ACTION_H
 #define __ACTION_H
 
+#include <stdint.h>
+
 typedef enum _processing_flag
 {
   KEEP_PROCESSING,
@@ -45,8 +47,6 @@ typedef enum _game_action
   FINISH,
   LOSE,
   COUNTDOWN_EXPIRED,
-  MUSIC_NOTE,
-  SOUND_EFFECT,
 } GAME_ACTION;
 
 typedef enum _when_slowdown
@@ -55,11 +55,40 @@ typedef enum _when_slowdown
   SLOW_WHEN_SLOWDOWN,
 } WHEN_SLOWDOWN;
 
+/*
+ * Most of the game actions only have something to do when an event has
+ * happened: an interrupt timer has ticked, a door has started moving, a
+ * collectable's timer has expired. Those actions are given a ready bit and
+ * the game loop only calls them when it's set. The ISR sets the interrupt driven ones in
+ * interrupt_actions_ready (see int.h) and the loop clears those once they've
+ * been dispatched. Gameplay code sets the others here, and the action
+ * clears its own bit when it's dealt with the event.
+ *
+ * The runner physics have ALWAYS_READY and are called every time round.
+ */
+#define ALWAYS_READY             0x00
+#define READY_1000MS             0x01    /* Set by ISR */
+#define READY_500MS              0x02    /* Set by ISR */
+#define READY_DOORS              0x10
+#define READY_COLLECTABLE_TIMER  0x20    /* Set by ISR */
+
+extern uint8_t game_actions_ready;
+
+/*
+ * Only the main code touches game_actions_ready so these don't need
+ * atomic protection.
+ */
+#define SET_GAME_ACTION_READY(bit)   (game_actions_ready |= (bit))
+#define CLEAR_GAME_ACTION_READY(bit) (game_actions_ready &= (uint8_t)~(bit))
+
 typedef struct _loop_action
 {
   /* Pointer to a function which implements the action to run */
   PROCESSING_FLAG (*test_action)(void* input_data, GAME_ACTION* output_action);
 
+  /* Ready bit which has to be set for the action to run, or ALWAYS_READY */
+  uint8_t         ready_bit;
+
   /*
    * Flag indicating what to do when a slowdown pill is active. Things like
    * collision detection and interrupt servicing need to run every frame as
@@ -22,7 +22,7 @@ SECTION code_user
 ; I originally had this in a section of its own which ended up in lower, contended
 ; memory. It sounded distinctly odd, so the contended memory thing isn't a myth. :)
 
-PUBLIC _play_note_raw
+PUBLIC _play_note_slice
 
 ; hl points to the note to play, passed in from the C. The "note" is actually a delay loop counter which produces
 ; the correct pitch. That value goes in DE; actually it goes in E because it's 8 bit.
@@ -32,18 +32,22 @@ PUBLIC _play_note_raw
 ; through each time to ensure the CPU executes the exact same instructions, thus keeping the timing consistent.
 ; When E gets to zero the speaker's bit is toggled; hence, next time round the loop there's a click. Bottom line:
 ; this implements a click-pause-click-pause loop the speed of which is controlled by the value in DE.
-; This loop produces a note of hard coded duration. The duration is controlled by BC. It loops B from 255 to 0,
-; C times. C is set to 3, so that's 768 iterations.
+; This loop produces a slice of a note of hard coded duration. The duration is controlled by BC. It loops B
+; from 192 to 0, once, so that's 192 iterations.
 ;
-; 768 iterations of this takes ~31,000 T-states which on the 3.5Mhz Z80 means each note is about 8.8ms. Each game
-; cycle in the 50fps game is 20ms, and one note is played every 4 cycles. So every 4th cycle only has about 11ms
-; to complete because it spends the rest of the time in this loop. Since the game is simple and 20ms is actually
-; ample for each game cycle this is fine. It it weren't I'd have to shift some of the load out of the game cycle
-; which plays the note into the other 3 which don't.
+; 192 iterations of this takes ~7,700 T-states which on the 3.5Mhz Z80 is about 2.2ms. This is called from the
+; ISR on every interrupt, and the note changes every 4th one, so each note still gets the 768 iterations (8.8ms)
+; it got when it was played in one go from the game loop. That used to leave every 4th game cycle with about
+; 11ms to complete; now every cycle loses 2.2ms and keeps the rest.
+;
+; Timed on the emulator core wonky_profile uses, host/z80_core.c, from the call to the ret it's 7,844 T-states
+; for the low notes up to 7,871 for the high ones, which reload E more often. That's 11.3% of the 69,888 T-state
+; frame, every frame. It's all run in the top border, before the ULA starts reading the screen, and this code is
+; above 0x8000, so none of it is contended.
 
 EXTERN _GLOBAL_ZX_PORT_FE
 
-_play_note_raw:
+_play_note_slice:
 
     ;; This is z88dk_fastcall format, so the pitch value ptr arrives in HL.
     ;; Save the registers I use
@@ -54,7 +58,7 @@ _play_note_raw:
 	ld      a,(_GLOBAL_ZX_PORT_FE)     ;Pick up current port 0xfe value from z88dk global
     ld      d,0
  	ld      e,(hl) 	                   ;Initialise the pitch delay counter in E
- 	ld      bc,3 	                   ;Initialise the duration delay counters in B (0) and C (3)
+ 	ld      bc,0xC001                  ;Initialise the duration delay counters in B (192) and C (1)
 
 speaker_loop:
  	out     (254),a 	               ;T=11 Drive the speaker
@@ -63,7 +67,7 @@ speaker_loop:
  	ld      e,(hl)                     ;T=7  Reset pitch counter and toggle the speaker driver
 	xor     0x18                       ;T=7
 
-pitch_loop_not_done:                   ;Countdown B from 256 (i.e. 0) to 0
+pitch_loop_not_done:                   ;Countdown B from 192 to 0
  	djnz    speaker_loop               ;T=13 if not zero (i.e. it jumps), otherwise T=8
 
  	dec     c                          ;T=4  BC make the note duration counter
@@ -76,3 +80,310 @@ pitch_loop_not_done:                   ;Countdown B from 256 (i.e. 0) to 0
     pop     de
     pop     bc
 	ret
+
+
+PUBLIC _start_beepfx_effect
+PUBLIC _play_beepfx_slice
+
+; Shiru's beepfx effects, played a slice at a time. The data is the same as bit_beepfx plays, a list of blocks:
+;
+;   tone:  defb 1, defw frames, defw frame length, defw frequency, defw slide, defb duty, defb duty change
+;   noise: defb 2, defw frames, defw frame length, defb pitch, defb slide
+;
+; and anything else ends it. bit_beepfx runs a block's frames one after another, each a frame length's worth of
+; times round its loop, then changes the pitch (and for a tone the duty) before the next. It runs the lot in one
+; go. These are the same loops, instruction for instruction, with the duty or noise mask in L' and the border in
+; H' as bit_beepfx has them, so each time round takes the same T-states and the pitches come out the same: 79 for
+; a tone, 76 for noise. They stop after a slice, though, and everything they were using is put away until the next
+; one. A slice is 88 times round, about 7,000 T-states, a little under a music slice, and a little more if a block
+; ends in it. That stretches an effect out over several frames, at the same pitches.
+;
+; Run on host/z80_core.c with the release's bit_beepfx beside them, every effect in sound.c drives the speaker bit
+; through exactly the same sequence of values, 79 T-states apart, as bit_beepfx does. That copy was put together
+; by a stand-in assembler, not z80asm, so where the linker puts this and how the ISR calls it are still to be seen on a
+; real build.
+;
+; Sample blocks, type 3, end the effect rather than being played.
+
+BEEPFX_SLICE_LENGTH equ 88
+
+; hl points to the effect, passed in from the C. Called from the ISR.
+
+_start_beepfx_effect:
+
+    push    bc
+    push    de
+    push    af
+
+    call    beepfx_load_block
+
+    pop     af
+    pop     de
+    pop     bc
+    ret
+
+; Play a slice of the effect. Returns 0 in l once it's finished. Called from the ISR.
+
+_play_beepfx_slice:
+
+    push    bc
+    push    de
+    push    af
+    exx
+    push    hl                         ;The ISR doesn't save the alternate registers, and SP1 uses them
+    exx
+
+    ld      hl,(beepfx_block)          ;Nothing playing?
+    ld      a,h
+    or      l
+    jp      z,beepfx_finished
+
+    ld      a,(_GLOBAL_ZX_PORT_FE)     ;Keep the border colour the z88dk global says it is, in H'
+    and     0x07
+    exx
+    ld      h,a
+    exx
+
+    ld      hl,BEEPFX_SLICE_LENGTH
+    ld      (beepfx_budget),hl
+
+beepfx_next_run:
+
+    ld      hl,(beepfx_left)           ;Run for what's left of the block's frame or of the slice, whichever's less
+    ld      de,(beepfx_budget)
+    or      a
+    sbc     hl,de
+    jr      c,beepfx_frame_ends
+    ld      (beepfx_left),hl           ;The slice ends first
+    ld      b,d
+    ld      c,e
+    ld      hl,0
+    ld      (beepfx_budget),hl
+    jr      beepfx_run
+
+beepfx_frame_ends:
+    add     hl,de                      ;The frame ends first
+    ld      b,h
+    ld      c,l
+    ex      de,hl
+    or      a
+    sbc     hl,bc
+    ld      (beepfx_budget),hl
+    ld      hl,0
+    ld      (beepfx_left),hl
+
+beepfx_run:
+    ld      a,(beepfx_type)
+    cp      1
+    jr      nz,noise_run
+
+    ld      a,(tone_duty)              ;The tone loop, as bit_beepfx's. Duty in L'.
+    exx
+    ld      l,a
+    exx
+    ld      hl,(tone_phase)
+    ld      de,(tone_frequency)
+
+tone_loop:
+    add     hl,de                      ;T=11
+    ld      a,h                        ;T=4
+    exx                                ;T=4
+    cp      l                          ;T=4  Against the duty
+    sbc     a,a                        ;T=4
+    and     16                         ;T=7
+    or      h                          ;T=4  And the border
+    out     (254),a                    ;T=11 Drive the speaker
+    exx                                ;T=4
+    dec     bc                         ;T=6
+    ld      a,b                        ;T=4
+    or      c                          ;T=4
+    jr      nz,tone_loop               ;T=12 if met, T=7 if not
+
+    ld      (tone_phase),hl
+    jr      beepfx_run_done
+
+noise_run:
+    exx                                ;The noise loop, as bit_beepfx's. The noise is the ROM.
+    ld      l,16                       ;Its speaker bit is the mask, in L'
+    exx
+    ld      hl,(noise_pointer)
+    ld      de,(noise_count)           ;Count in D, pitch in E
+
+noise_loop:
+    ld      a,(hl)                     ;T=7
+    exx                                ;T=4
+    and     l                          ;T=4
+    or      h                          ;T=4  Border
+    out     (254),a                    ;T=11 Drive the speaker
+    exx                                ;T=4
+    dec     d                          ;T=4
+    jr      nz,noise_same_byte         ;T=12 if met, T=7 if not
+    ld      d,e                        ;T=4  Move on a byte every pitch times round
+    inc     hl                         ;T=6
+    ld      a,h                        ;T=4
+    and     0x1F                       ;T=7
+    ld      h,a                        ;T=4
+
+noise_same_byte:
+    dec     bc                         ;T=6
+    ld      a,b                        ;T=4
+    or      c                          ;T=4
+    jr      nz,noise_loop              ;T=12 if met, T=7 if not
+
+    ld      (noise_pointer),hl
+    ld      (noise_count),de
+
+beepfx_run_done:
+    ld      hl,(beepfx_left)           ;If the frame isn't over the slice is
+    ld      a,h
+    or      l
+    jr      nz,beepfx_playing
+
+    ld      hl,(beepfx_block)          ;End of a frame, the pitch slides
+    ld      a,(beepfx_type)
+    cp      1
+    jr      nz,noise_frame_end
+
+    ld      de,7
+    add     hl,de
+    ld      e,(hl)                     ;Tone frequency slide
+    inc     hl
+    ld      d,(hl)
+    inc     hl
+    inc     hl
+    ld      a,(tone_duty)              ;And the duty changes
+    add     a,(hl)
+    ld      (tone_duty),a
+    ld      hl,(tone_frequency)
+    add     hl,de
+    ld      (tone_frequency),hl
+    ld      de,11                      ;Tone blocks are 11 bytes
+    jr      beepfx_frame_done
+
+noise_frame_end:
+    ld      de,6
+    add     hl,de
+    ld      a,(noise_count)            ;Noise pitch slide, E of the count and pitch pair
+    add     a,(hl)
+    ld      (noise_count),a
+    ld      de,7                       ;Noise blocks are 7 bytes
+
+beepfx_frame_done:
+    ld      hl,(beepfx_frames)
+    dec     hl
+    ld      (beepfx_frames),hl
+    ld      a,h
+    or      l
+    jr      nz,beepfx_next_frame
+
+    ld      hl,(beepfx_block)          ;Block over, on to the next
+    add     hl,de
+    call    beepfx_load_block
+    or      a
+    jr      z,beepfx_finished
+    jr      beepfx_more
+
+beepfx_next_frame:
+    ld      hl,(beepfx_frame_length)
+    ld      (beepfx_left),hl
+
+beepfx_more:
+    ld      hl,(beepfx_budget)
+    ld      a,h
+    or      l
+    jp      nz,beepfx_next_run
+
+beepfx_playing:
+    ld      l,1
+    jr      beepfx_return
+
+beepfx_finished:
+    ld      l,0
+
+beepfx_return:
+    exx
+    pop     hl
+    exx
+    pop     af
+    pop     de
+    pop     bc
+    ret
+
+; hl points to a block. Sets it up to be played, returning its type in a, or 0 if the effect has ended.
+
+beepfx_load_block:
+    ld      a,(hl)
+    cp      1
+    jr      z,beepfx_load_frames
+    cp      2
+    jr      z,beepfx_load_frames
+
+    xor     a                          ;The end, or a sample
+    ld      h,a
+    ld      l,a
+    ld      (beepfx_block),hl
+    ret
+
+beepfx_load_frames:
+    ld      (beepfx_block),hl
+    ld      (beepfx_type),a
+    inc     hl
+    ld      e,(hl)
+    inc     hl
+    ld      d,(hl)
+    ld      (beepfx_frames),de
+    inc     hl
+    ld      e,(hl)
+    inc     hl
+    ld      d,(hl)
+    ld      (beepfx_frame_length),de
+    ld      (beepfx_left),de
+    inc     hl
+
+    cp      1
+    jr      nz,beepfx_load_noise
+
+    ld      e,(hl)                     ;Tone frequency
+    inc     hl
+    ld      d,(hl)
+    ld      (tone_frequency),de
+    inc     hl
+    inc     hl
+    inc     hl
+    ld      d,(hl)                     ;Duty
+    ld      hl,tone_duty
+    ld      (hl),d
+    ld      hl,0
+    ld      (tone_phase),hl
+    ret
+
+beepfx_load_noise:
+    ld      e,(hl)                     ;Noise pitch, and the count starts at 1
+    ld      d,1
+    ld      (noise_count),de
+    ld      hl,0x0101
+    ld      (noise_pointer),hl
+    ret
+
+beepfx_block:
+    defw    0
+beepfx_type:
+    defb    0
+beepfx_frames:
+    defw    0
+beepfx_frame_length:
+    defw    0
+beepfx_left:
+    defw    0
+beepfx_budget:
+    defw    0
+tone_phase:
+    defw    0
+tone_frequency:
+    defw    0
+tone_duty:
+    defb    0
+noise_pointer:
+    defw    0
+noise_count:
+    defw    0
@@ -44,7 +44,10 @@ uint8_t bonuses_left;
 
 BONUS bonuses[STARTING_NUM_BONUSES];
 
-/* This is in the assembly language file */
+/*
+ * Built from sprites.asm. Bonuses are lined up on character boundaries
+ * so there's just the one unshifted frame.
+ */
 extern uint8_t bonus[];
 
 static void initialise_colour(unsigned int count, struct sp1_cs *c)
@@ -62,8 +65,8 @@ void create_game_bonuses( uint8_t num_bonuses )
 
   for( bonus_i=0; bonus_i<num_bonuses; bonus_i++ )
   {
-    bonuses[bonus_i].sprite = sp1_CreateSpr(SP1_DRAW_LOAD1LB, SP1_TYPE_1BYTE, 2, 0, BONUS_PLANE);
-    sp1_AddColSpr(bonuses[bonus_i].sprite, SP1_DRAW_LOAD1RB, SP1_TYPE_1BYTE, 0, BONUS_PLANE);
+    bonuses[bonus_i].sprite = sp1_CreateSpr(SP1_DRAW_LOAD1NR, SP1_TYPE_1BYTE, 2, 0, BONUS_PLANE);
+    sp1_AddColSpr(bonuses[bonus_i].sprite, SP1_DRAW_LOAD1NR, SP1_TYPE_1BYTE, PRESHIFTED_COLUMN_1, BONUS_PLANE);
 
     /* Colour the cells the sprite occupies */
     sp1_IterateSprChar(bonuses[bonus_i].sprite, initialise_colour);
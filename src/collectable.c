@@ -18,8 +18,10 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 
 #include "int.h"
+#include "local_assert.h"
 #include "tracetable.h"
 #include "collectable.h"
 
@@ -40,21 +42,23 @@
 #define COLLECTABLE_TRACE_ENTRIES 120
 #define COLLECTABLE_TRACETABLE_SIZE ((size_t)sizeof(COLLECTABLE_TRACE)*COLLECTABLE_TRACE_ENTRIES)
 
-TRACE_FN( collectable, COLLECTABLE_TRACE, COLLECTABLE_TRACETABLE_SIZE )
+#if COLLECTABLE_TRACING
+
+TRACE_TABLE( collectable, COLLECTABLE_TRACE )
 
 void COLLECTABLE_TRACE_CREATE(COLLECTABLE_TRACETYPE ttype, COLLECTABLE* cptr, uint8_t x, uint8_t y)
 {
   if( collectable_tracetable != TRACING_INACTIVE )
   {
-    COLLECTABLE_TRACE     ct;           
-    ct.ticker           = GET_TICKER;   
-    ct.tracetype        = ttype;        
-    ct.collectable      = cptr;                   /* Copy of the pointer, not what's pointed at */
-    ct.available        = cptr->available;        /* Grab a copy of these 2 values at */
-    ct.timer_countdown  = cptr->timer_countdown;  /* the point the trace is collected */
-    ct.xpos             = x;
-    ct.ypos             = y;
-    collectable_add_trace(&ct);
+    COLLECTABLE_TRACE*    ct = TRACE_ENTRY(collectable);
+    TRACE_STAMP(collectable, ct);
+    ct->tracetype       = ttype;
+    ct->collectable     = cptr;                   /* Copy of the pointer, not what's pointed at */
+    ct->available       = cptr->available;        /* Grab a copy of these 2 values at */
+    ct->timer_deadline  = cptr->timer_deadline;   /* the point the trace is collected */
+    ct->xpos            = x;
+    ct->ypos            = y;
+    TRACE_ADVANCE(collectable, COLLECTABLE_TRACETABLE_SIZE);
   }
 }
 
@@ -62,3 +66,205 @@ void init_collectable_trace(void)
 {
   collectable_tracetable = collectable_next_trace = allocate_tracememory(COLLECTABLE_TRACETABLE_SIZE);
 }
+
+#endif
+
+
+/***
+ *      _______   _
+ *     |__   __| (_)
+ *        | |_ __ _  __ _  __ _  ___ _ __ ___
+ *        | | '__| |/ _` |/ _` |/ _ \ '__/ __|
+ *        | | |  | | (_| | (_| |  __/ |  \__ \
+ *        |_|_|  |_|\__, |\__, |\___|_|  |___/
+ *                   __/ | __/ |
+ *                  |___/ |___/
+ *
+ * The level's collectables, as registered by their create functions,
+ * and the trigger index built from the available ones.
+ */
+static COLLECTABLE* level_collectables[MAX_LEVEL_COLLECTABLES];
+static uint8_t      num_level_collectables;
+
+static COLLECTABLE* collectable_triggers[COLLECTABLE_TRIGGER_SLOTS];
+
+/*
+ * Called at level start, before the level's collectables are created.
+ */
+void clear_collectable_triggers(void)
+{
+  num_level_collectables = 0;
+  memset( collectable_triggers, 0, sizeof(collectable_triggers) );
+}
+
+void register_collectable( COLLECTABLE* collectable )
+{
+  local_assert( num_level_collectables < MAX_LEVEL_COLLECTABLES );
+
+  level_collectables[num_level_collectables++] = collectable;
+  rebuild_collectable_triggers();
+}
+
+void rebuild_collectable_triggers(void)
+{
+  uint8_t i;
+
+  memset( collectable_triggers, 0, sizeof(collectable_triggers) );
+
+  for( i=0; i < num_level_collectables; i++ )
+  {
+    COLLECTABLE* collectable = level_collectables[i];
+
+    if( IS_COLLECTABLE_AVAILABLE( (*collectable) ) )
+    {
+      uint8_t slot = COLLECTABLE_TRIGGER_HASH( collectable->centre_x, collectable->centre_y );
+
+      while( collectable_triggers[slot] )
+        slot = (slot+1) & (COLLECTABLE_TRIGGER_SLOTS-1);
+
+      collectable_triggers[slot] = collectable;
+    }
+  }
+}
+
+/*
+ * Returns the available collectable whose collection point is x,y, or
+ * 0 if there isn't one. Nearly every frame it's 0 from the first slot.
+ */
+COLLECTABLE* find_collectable_trigger( uint8_t x, uint8_t y )
+{
+  uint8_t      slot = COLLECTABLE_TRIGGER_HASH( x, y );
+  COLLECTABLE* collectable;
+
+  while( (collectable = collectable_triggers[slot]) )
+  {
+    if( IS_COLLECTION_POINT( x, y, (*collectable) ) )
+      return collectable;
+
+    slot = (slot+1) & (COLLECTABLE_TRIGGER_SLOTS-1);
+  }
+
+  return 0;
+}
+
+
+/***
+ *      _______ _
+ *     |__   __(_)
+ *        | |   _ _ __ ___   ___ _ __ ___
+ *        | |  | | '_ ` _ \ / _ \ '__/ __|
+ *        | |  | | | | | | |  __/ |  \__ \
+ *        |_|  |_|_| |_| |_|\___|_|  |___/
+ *
+ * The running timers, earliest deadline first. There are only ever a
+ * handful so it's a sorted array. Deadlines are ticker values, and the
+ * ticker wraps, so they're compared by signed difference.
+ */
+static COLLECTABLE* collectable_timers[MAX_LEVEL_COLLECTABLES];
+static uint8_t      num_collectable_timers;
+
+#define DEADLINE_REACHED(now,deadline) ((int16_t)((uint16_t)(now) - (deadline)) >= 0)
+
+/*
+ * Tell the ISR about the deadline at the front of the queue. It's 16 bits
+ * so interrupts are held off while it's written.
+ */
+static void set_timer_interrupt_deadline(void)
+{
+  intrinsic_di();
+  if( num_collectable_timers )
+  {
+    collectable_timer_deadline = collectable_timers[0]->timer_deadline;
+    collectable_timer_armed    = 1;
+  }
+  else
+  {
+    collectable_timer_armed    = 0;
+  }
+  intrinsic_ei();
+}
+
+static void remove_collectable_timer( COLLECTABLE* collectable )
+{
+  uint8_t i = 0;
+
+  while( collectable_timers[i] != collectable )
+    i++;
+
+  for( --num_collectable_timers; i < num_collectable_timers; i++ )
+    collectable_timers[i] = collectable_timers[i+1];
+
+  collectable->timer_running = 0;
+}
+
+/*
+ * Called at level start. Any timers still running belong to the last level.
+ */
+void clear_collectable_timers(void)
+{
+  while( num_collectable_timers )
+    collectable_timers[--num_collectable_timers]->timer_running = 0;
+
+  set_timer_interrupt_deadline();
+}
+
+/*
+ * Start, or restart, the collectable's timer. It expires ticks 50ths of a
+ * second from now. Timers with the same deadline expire in the order they
+ * were started.
+ */
+void start_collectable_timer( COLLECTABLE* collectable, uint16_t ticks )
+{
+  uint16_t deadline;
+  uint8_t  i;
+
+  if( collectable->timer_running )
+    remove_collectable_timer( collectable );
+
+  local_assert( num_collectable_timers < MAX_LEVEL_COLLECTABLES );
+
+  deadline = GET_TICKER + ticks;
+  collectable->timer_deadline = deadline;
+  collectable->timer_running  = 1;
+
+  i = num_collectable_timers++;
+  while( i && !DEADLINE_REACHED(deadline, collectable_timers[i-1]->timer_deadline) )
+  {
+    collectable_timers[i] = collectable_timers[i-1];
+    i--;
+  }
+  collectable_timers[i] = collectable;
+
+  set_timer_interrupt_deadline();
+}
+
+void cancel_collectable_timer( COLLECTABLE* collectable )
+{
+  if( collectable->timer_running )
+  {
+    remove_collectable_timer( collectable );
+    set_timer_interrupt_deadline();
+  }
+}
+
+/*
+ * Take the front timer off the queue if its deadline has been reached and
+ * return its collectable, otherwise return 0. The caller runs the timer
+ * function, which may start the timer again.
+ */
+COLLECTABLE* next_expired_collectable_timer(void)
+{
+  COLLECTABLE* collectable;
+
+  if( !num_collectable_timers )
+    return 0;
+
+  collectable = collectable_timers[0];
+  if( !DEADLINE_REACHED( GET_TICKER, collectable->timer_deadline ) )
+    return 0;
+
+  remove_collectable_timer( collectable );
+  set_timer_interrupt_deadline();
+
+  return collectable;
+}
@@ -22,6 +22,8 @@
 
 #include <stdint.h>
 
+#include "tracetable.h"
+
 /*
  * A collectable is a thing which appears on the screen and is collectable
  * by the player by walking over it. So pills, powerups, whatever.
@@ -77,18 +79,18 @@ typedef struct _collectable
   /* Function to call when collected */
   void                      (*collection_fn)(struct _collectable*, void*);
 
-  /* Countdown to timer expiring in 1/50ths sec */
-  uint16_t                  timer_countdown;
+  /*
+   * Ticker value the timer expires at, and whether it's running. Running
+   * timers are also held in the collectable timer queue.
+   */
+  uint16_t                  timer_deadline;
+  uint8_t                   timer_running;
 
   /* Function to call when countdown timer expires */
   uint8_t                   (*timer_fn)(struct _collectable*, void*);
 
 } COLLECTABLE;
 
-/* Named args macro to make initialisation code easier to read */
-#define INITIALISE_COLLECTABLE( type, xtag, x, ytag, y, xctag, xc, xytag, yc, cfn, tfn) \
-  type,x,y,xc,yc,COLLECTABLE_AVAILABLE,cfn,0,tfn
-
 /* Macro to fetch the x,y location for a collectable's screen location */
 #define COLLECTABLE_SCREEN_LOCATION(c) c.x,c.y
 
@@ -124,14 +126,44 @@ typedef struct _collectable
 #define SET_COLLECTABLE_AVAILABLE(collectable,a) (collectable.available=a)
 
 /*
- * Collectables typically start a countdown timer.
+ * Collectables typically start a countdown timer. Running timers are kept
+ * in a queue in deadline order, and the ISR watches the ticker against the
+ * one at the front. When that's reached it flags READY_COLLECTABLE_TIMER
+ * and the game loop takes the expired timers off the front of the queue.
+ * Frames where nothing expires cost nothing, however many timers are
+ * running.
+ */
+#define START_COLLECTABLE_TIMER(collectable,secs) start_collectable_timer(&(collectable),(uint16_t)((secs)*50))
+#define CANCEL_COLLECTABLE_TIMER(collectable) cancel_collectable_timer(&(collectable))
+#define COLLECTABLE_TIMER_EXPIRED(collectable) (!(collectable.timer_running))
+
+void         clear_collectable_timers(void);
+void         start_collectable_timer( COLLECTABLE* collectable, uint16_t ticks );
+void         cancel_collectable_timer( COLLECTABLE* collectable );
+COLLECTABLE* next_expired_collectable_timer(void);
+
+
+/*
+ * Trigger index. Collectables are picked up when the runner's centre lands
+ * exactly on their collection point, so the available ones are kept in a
+ * small hash table keyed on that point. The per-frame test is then one
+ * lookup of the runner's centre rather than a walk of every pill and key
+ * in the level.
+ *
+ * The index only changes when a collectable's availability changes, so
+ * the collection and timeup handlers rebuild it. It's a linear probed
+ * table, so it needs to stay well short of full: 16 slots against the
+ * 9 collectables the busiest level has.
  */
-#define START_COLLECTABLE_TIMER(collectable,secs) (collectable.timer_countdown=((secs)*50))
-#define DECREMENT_COLLECTABLE_TIMER(collectable) (--(collectable.timer_countdown))
-#define CANCEL_COLLECTABLE_TIMER(collectable) ((collectable.timer_countdown)=0)
-#define COLLECTABLE_TIMER_EXPIRED(collectable) ((collectable.timer_countdown)==0)
+#define MAX_LEVEL_COLLECTABLES    12
+#define COLLECTABLE_TRIGGER_SLOTS 16
+
+#define COLLECTABLE_TRIGGER_HASH(x,y) ( (((x)>>3) ^ ((y)>>3)) & (COLLECTABLE_TRIGGER_SLOTS-1) )
 
-uint8_t handle_timed_collectable( COLLECTABLE* collectable, void* data );
+void         clear_collectable_triggers(void);
+void         register_collectable( COLLECTABLE* collectable );
+void         rebuild_collectable_triggers(void);
+COLLECTABLE* find_collectable_trigger( uint8_t x, uint8_t y );
 
 
 typedef enum _collectable_tracetype
@@ -147,6 +179,7 @@ typedef enum _collectable_tracetype
 typedef struct _collectable_trace
 {
   uint16_t                 ticker;
+  uint8_t                  frame_seq;
   COLLECTABLE_TRACETYPE    tracetype;
 
   /*
@@ -160,14 +193,19 @@ typedef struct _collectable_trace
    */
   COLLECTABLE*             collectable;
   COLLECTABLE_AVAILABILITY available;
-  uint16_t                 timer_countdown;
+  uint16_t                 timer_deadline;
 
   uint8_t                  xpos;
   uint8_t                  ypos;
 } COLLECTABLE_TRACE;
 
 
+#if COLLECTABLE_TRACING
 void init_collectable_trace(void);
 void COLLECTABLE_TRACE_CREATE(COLLECTABLE_TRACETYPE ttype, COLLECTABLE* cptr, uint8_t x, uint8_t y);
+#else
+#define init_collectable_trace()
+#define COLLECTABLE_TRACE_CREATE(ttype,cptr,x,y)
+#endif
 
 #endif
@@ -31,6 +31,7 @@
 #include "action.h"
 #include "game_state.h"
 #include "teleporter.h"
+#include "tile_map.h"
 
 /***
  *      _______             _             
@@ -48,12 +49,11 @@
 typedef struct _collision_trace
 {
   uint16_t            ticker;
+  uint8_t             frame_seq;
   uint8_t             xpos;
   uint8_t             ypos;
   DIRECTION           direction;
   JUMP_STATUS         jump_status;
-  uint8_t             background_att;
-  uint8_t             teleporter_att;
   REACTION            reaction;
 } COLLISION_TRACE;
 
@@ -61,22 +61,22 @@ typedef struct _collision_trace
 #define COLLISION_TRACE_ENTRIES 250
 #define COLLISION_TRACETABLE_SIZE ((size_t)sizeof(COLLISION_TRACE)*COLLISION_TRACE_ENTRIES)
 
-#define COLLISION_TRACE_CREATE(x,y,d,js,b,t,r) {        \
+#if COLLISION_TRACING
+
+#define COLLISION_TRACE_CREATE(x,y,d,js,r) {        \
     if( collision_tracetable != TRACING_INACTIVE ) { \
-      COLLISION_TRACE      ct;   \
-      ct.ticker          = GET_TICKER; \
-      ct.xpos            = x; \
-      ct.ypos            = y; \
-      ct.direction       = d; \
-      ct.jump_status     = js; \
-      ct.background_att  = b; \
-      ct.teleporter_att  = t; \
-      ct.reaction        = r; \
-      collision_add_trace(&ct); \
+      COLLISION_TRACE*     ct = TRACE_ENTRY(collision); \
+      TRACE_STAMP(collision, ct); \
+      ct->xpos        = x; \
+      ct->ypos        = y; \
+      ct->direction   = d; \
+      ct->jump_status = js; \
+      ct->reaction    = r; \
+      TRACE_ADVANCE(collision, COLLISION_TRACETABLE_SIZE); \
     } \
 }
 
-TRACE_FN( collision, COLLISION_TRACE, COLLISION_TRACETABLE_SIZE )
+TRACE_TABLE( collision, COLLISION_TRACE )
 
 
 void init_collision_trace(void)
@@ -84,22 +84,118 @@ void init_collision_trace(void)
   collision_tracetable = collision_next_trace = allocate_tracememory(COLLISION_TRACETABLE_SIZE);
 }
 
+#else
 
-#define SPRITE_WIDTH  6
-#define SPRITE_HEIGHT 8
+#define COLLISION_TRACE_CREATE(x,y,d,js,r)
 
-static uint8_t is_attr_not( uint8_t x, uint8_t y, uint8_t att1, uint8_t att2 )
-{
-  register uint8_t* attr_address = zx_pxy2aaddr( x, y );
-  return ( *attr_address != att1 && *attr_address != att2 );
-}
+#endif
 
-REACTION test_direction_blocked( uint8_t x, uint8_t y,
-                                 DIRECTION facing, JUMP_STATUS jump_status, uint8_t background_att,
-                                                                            uint8_t teleporter_att )
+
+#define SPRITE_WIDTH  RUNNER_WIDTH
+#define SPRITE_HEIGHT RUNNER_HEIGHT
+
+/*
+ * Probe offsets relative to the runner's x,y, which is his top left pixel.
+ * The FRONTs are the pixel columns just outside the sprite, the EDGEs are
+ * the sprite's own outermost columns.
+ */
+#define RIGHT_FRONT   SPRITE_WIDTH
+#define RIGHT_EDGE    (SPRITE_WIDTH-1)
+#define LEFT_FRONT    (-1)
+#define LEFT_EDGE     0
+#define HEAD          0
+#define FOOT          (SPRITE_HEIGHT-1)
+#define ABOVE         (-1)
+#define BELOW         SPRITE_HEIGHT
+
+#define END_OF_PROBES {NO_REACTION, 0, 0}
+
+/*
+ * Probe sets, one per jump status. Each is walked in order and the first
+ * probe which finds a blocked cell gives the reaction. These used to be
+ * a 40 line case each in a switch statement.
+ *
+ * Walking along the ground he can only bump into a wall.
+ */
+static const PROBE walking_right_probes[] = {
+  {BOUNCE,          RIGHT_FRONT, HEAD },     /* Bang his face */
+  END_OF_PROBES
+};
+static const PROBE walking_left_probes[] = {
+  {BOUNCE,          LEFT_FRONT,  HEAD },
+  END_OF_PROBES
+};
+
+/* At the top of a jump he can hit a wall with his face or his foot */
+static const PROBE right_flat_probes[] = {
+  {BOUNCE,          RIGHT_FRONT, HEAD },     /* Bang his face */
+  {BOUNCE,          RIGHT_FRONT, FOOT },     /* Bang his foot */
+  END_OF_PROBES
+};
+static const PROBE left_flat_probes[] = {
+  {BOUNCE,          LEFT_FRONT,  HEAD },
+  {BOUNCE,          LEFT_FRONT,  FOOT },
+  END_OF_PROBES
+};
+
+/* On the way up he can hit a wall, or a ceiling with his head */
+static const PROBE right_rising_probes[] = {
+  {BOUNCE,          RIGHT_FRONT, HEAD  },    /* Bang his face */
+  {BOUNCE,          RIGHT_FRONT, FOOT  },    /* Bang his foot */
+  {DROP_VERTICALLY, RIGHT_FRONT, ABOVE },    /* Bang the front of his head */
+  {DROP_VERTICALLY, LEFT_EDGE,    ABOVE },    /* Bang the back of his head */
+  END_OF_PROBES
+};
+static const PROBE left_rising_probes[] = {
+  {BOUNCE,          LEFT_FRONT,  HEAD  },
+  {BOUNCE,          LEFT_FRONT,  FOOT  },
+  {DROP_VERTICALLY, LEFT_FRONT,  ABOVE },
+  {DROP_VERTICALLY, RIGHT_FRONT, ABOVE },
+  END_OF_PROBES
+};
+
+/* On the way down he can hit a wall, or land on something */
+static const PROBE right_falling_probes[] = {
+  {BOUNCE,          RIGHT_FRONT, HEAD  },    /* Bang his face */
+  {BOUNCE,          RIGHT_FRONT, FOOT  },    /* Bang his foot */
+  {LANDED,          RIGHT_EDGE,   BELOW },    /* Toe check */
+  {LANDED,          LEFT_EDGE,    BELOW },    /* Heel check */
+  END_OF_PROBES
+};
+static const PROBE left_falling_probes[] = {
+  {BOUNCE,          LEFT_FRONT,  HEAD  },
+  {BOUNCE,          LEFT_FRONT,  FOOT  },
+  {LANDED,          LEFT_EDGE,    BELOW },
+  {LANDED,          RIGHT_EDGE,   BELOW },
+  END_OF_PROBES
+};
+
+/*
+ * Indexed by JUMP_STATUS, so this has to match the order of that enum.
+ * NOT_JUMPING depends on which way he's facing so that entry is the
+ * facing right one and the facing left one is picked out separately.
+ */
+static const PROBE* const probe_sets[] = {
+  walking_right_probes,    /* NOT_JUMPING   */
+  right_rising_probes,     /* RIGHT_RISING  */
+  right_flat_probes,       /* RIGHT_FLAT    */
+  right_falling_probes,    /* RIGHT_FALLING */
+  left_rising_probes,      /* LEFT_RISING   */
+  left_flat_probes,        /* LEFT_FLAT     */
+  left_falling_probes,     /* LEFT_FALLING  */
+};
+
+/*
+ * The probe walker is in collision_probe.asm. It takes a single pointer so
+ * it can be fastcall, hence the request structure. Keep this global so the
+ * compiler doesn't have to build it on the stack each frame.
+ */
+static PROBE_REQUEST probe_request;
+
+REACTION test_direction_blocked( const RUNNER_NEIGHBOURHOOD* neighbourhood,
+                                 uint8_t x, uint8_t y,
+                                 DIRECTION facing, JUMP_STATUS jump_status )
 {
-  uint8_t  check_x;
-  uint8_t  check_y;
   REACTION result;
 
   if( ((facing == RIGHT) && ((x+SPRITE_WIDTH) == 255))
@@ -110,263 +206,45 @@ REACTION test_direction_blocked( uint8_t x, uint8_t y,
 
     result = BOUNCE;
   }
-  else if( jump_status == NOT_JUMPING ) {
-
-    /* He's not in a jump so bouncing off walls is the only thing to worry about */
-
-    if( facing == RIGHT ) {
-      check_x = x+SPRITE_WIDTH;
-      check_y = y;
-    }
-    else { /* Facing left */
-      check_x = x-1;
-      check_y = y;
-    }
-    if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-      result = BOUNCE;
-    }
-    else {
-      result = NO_REACTION;
-    }
+  else {
 
-  }
-  else {  /* In the middle of a jump */
-
-    switch( jump_status )
-    {
-    case RIGHT_FLAT:
-      /* Check if he's about to bang his face */
-      check_x = x+SPRITE_WIDTH;
-      check_y = y;
-
-      if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-        result = BOUNCE;
-      }
-      else {
-        /* OK, check if he's about to bang his foot */
-        check_y = y+SPRITE_HEIGHT-1;
-
-        if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-          result = BOUNCE;
-        }
-        else {
-          result = NO_REACTION;
-        }
-      }
-      break;
-
-    case LEFT_FLAT:
-      /* Check if he's about to bang his face */
-      check_x = x-1;
-      check_y = y;
-
-      if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-        result = BOUNCE;
-      }
-      else {
-        /* OK, check if he's about to bang his foot */
-        check_y = y+SPRITE_HEIGHT-1;
-
-        if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-          result = BOUNCE;
-        }
-        else {
-          result = NO_REACTION;
-        }
-      }
-      break;
-
-    case RIGHT_RISING:
-      /* Check if he's about to bang his face */
-      check_x = x+SPRITE_WIDTH;
-      check_y = y;
-
-      result = NO_REACTION;
-
-      if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-        result = BOUNCE;
-      }
-      else {
-
-        /* Check if he's about to bang his foot */
-        check_x = x+SPRITE_WIDTH;
-        check_y = y+SPRITE_HEIGHT-1;
-
-        if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-          result = BOUNCE;
-        }
-        else {
-
-          /* Check if he's about to bang the front of his head */
-          check_x = x+SPRITE_WIDTH;
-          check_y = y-1;
-
-          if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-            result = DROP_VERTICALLY;
-          }
-          else {
-
-            /* Check if he's about to bang the back of his head */
-            check_x = x;
-            check_y = y-1;
-
-            if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-              result = DROP_VERTICALLY;
-            }
-          }
-        }
-      }
-      break;
-
-    case LEFT_RISING:
-      /* Check if he's about to bang his face */
-      check_x = x-1;
-      check_y = y;
-
-      result = NO_REACTION;
-
-      if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-        result = BOUNCE;
-      }
-      else {
-
-        /* Check if he's about to bang his foot */
-        check_x = x-1;
-        check_y = y+SPRITE_HEIGHT-1;
-
-        if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-          result = BOUNCE;
-        }
-        else {
-
-          /* Check if he's about to bang the front of his head */
-          check_x = x-1;
-          check_y = y-1;
-
-          if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-            result = DROP_VERTICALLY;
-          }
-          else {
-
-            /* Check if he's about to bang the back of his head */
-            check_x = x+SPRITE_WIDTH;
-            check_y = y-1;
-
-            if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-              result = DROP_VERTICALLY;
-            }
-          }
-        }
-      }
-      break;
-
-    case RIGHT_FALLING:
-      /* Check if he's about to bang his face */
-      check_x = x+SPRITE_WIDTH;
-      check_y = y;
-
-      result = NO_REACTION;
-
-      if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-        result = BOUNCE;
-      }
-      else {
-
-        /* Check if he's about to bang his foot */
-        check_x = x+SPRITE_WIDTH;
-        check_y = y+SPRITE_HEIGHT-1;
-
-        if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-          result = BOUNCE;
-        }
-        else {
-
-          /* Check if he's landed on something (toe check) */
-          check_x = x+SPRITE_WIDTH-1;
-          check_y = y+SPRITE_HEIGHT;
-
-          if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-            result = LANDED;
-          }
-          else {
-
-            /* Check if he's landed on something (heel check) */
-            check_x = x;
-
-            if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-              result = LANDED;
-            }
-          }
-        }
-      }
-      break;
-
-    case LEFT_FALLING:
-      /* Check if he's about to bang his face */
-      check_x = x-1;
-      check_y = y;
-
-      result = NO_REACTION;
-
-      if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-        result = BOUNCE;
-      }
-      else {
-
-        /* Check if he's about to bang his foot */
-        check_x = x-1;
-        check_y = y+SPRITE_HEIGHT-1;
-
-        if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-          result = BOUNCE;
-        }
-        else {
-
-          /* Check if he's landed on something (toe check) */
-          check_x = x;
-          check_y = y+SPRITE_HEIGHT;
-
-          if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-            result = LANDED;
-          }
-          else {
-
-            /* Check if he's landed on something (heel check) */
-            check_x = x+SPRITE_WIDTH-1;
-
-            if( is_attr_not( check_x, check_y, background_att, teleporter_att ) ) {
-              result = LANDED;
-            }
-          }
-        }
-      }
-      break;
-
-    default:
-      /* Unreachable code local_assert(1); */
-      break;
-    }
+    probe_request.neighbourhood = neighbourhood;
+
+    if( (jump_status == NOT_JUMPING) && (facing == LEFT) )
+      probe_request.probes = walking_left_probes;
+    else
+      probe_request.probes = probe_sets[jump_status];
+
+    result = (REACTION)run_collision_probes( &probe_request );
   }
 
-  COLLISION_TRACE_CREATE( x, y, facing, jump_status, background_att, teleporter_att, result);
+  COLLISION_TRACE_CREATE( x, y, facing, jump_status, result);
 
   return result;
 }
 
 PROCESSING_FLAG act_on_collision( void* data, GAME_ACTION* output_action )
 {
+  GAME_STATE* game_state = (GAME_STATE*)data;
   REACTION    reaction;
 
   uint8_t     xpos = GET_RUNNER_XPOS;
   uint8_t     ypos = GET_RUNNER_YPOS;
   DIRECTION   facing = GET_RUNNER_FACING;
-  DIRECTION   jump_status = get_runner_jump_status();
+  JUMP_STATUS jump_status;
 
-  GAME_STATE* game_state = (GAME_STATE*)data;
-  uint8_t     background = game_state->current_level->background_att;
-  uint8_t     teleporter = TELEPORTER_ATT;
+#if JUMP_TABLES
+  /* Nothing to find this early in the jump, see jump_tables.h */
+  if( GET_RUNNER_JUMP_OFFSET < runner.jump_safe ) {
+    *output_action = NO_ACTION;
+    return KEEP_PROCESSING;
+  }
+#endif
+
+  jump_status = get_runner_jump_status();
 
-  reaction = test_direction_blocked( xpos, ypos, facing, jump_status, background, teleporter );
+  reaction = test_direction_blocked( &(game_state->neighbourhood),
+                                     xpos, ypos, facing, jump_status );
   switch( reaction )
   {
   case BOUNCE:
@@ -378,8 +256,20 @@ PROCESSING_FLAG act_on_collision( void* data, GAME_ACTION* output_action )
     return STOP_PROCESSING;    
 
   case LANDED:
+    /*
+     * He's normally found something below him just as his feet reach
+     * it, but bouncing off a wall on the way down moves him diagonally
+     * and that can take him past the corner of a ledge and a pixel into
+     * it. Stood there both his front probes are in the ledge, so every
+     * jump bounces straight back and he can never get out. Stand him on
+     * top of the cell his feet are in.
+     */
+    SET_RUNNER_YPOS( ((ypos+SPRITE_HEIGHT) & 0xF8) - SPRITE_HEIGHT );
     *output_action = STOP_JUMP;
     return STOP_PROCESSING;    
+
+  case NO_REACTION:
+    break;
   }
 
   *output_action = NO_ACTION;
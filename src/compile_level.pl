@@ -0,0 +1,421 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Wonky One Key, a ZX Spectrum game featuring a single control key
+# Copyright (C) 2018 Derek Fountain
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+# Level compiler. Each level is described in a .lvl file: where its map
+# is, where the runner starts, its colours, and its teleporters, pills
+# and doors. This checks the description makes sense and turns it into
+# the level blob the game loads, with everything the Spectrum used to
+# work out for itself at level start done here instead:
+#
+#  - the map, which is an SP1 print string in levels_maps.asm or the
+#    level designer's include files, packed by pack_level_maps.pl (see
+#    levels.h)
+#  - the tile map the collision code uses, with the teleporter ends in
+#    it, worked out from the colours the map prints (see tile_map.h)
+#  - the teleporter table, with the pixel and cell coordinates of each
+#    end, ready to be used where it sits
+#  - the pill and door tables, from which the game fills in its
+#    collectables
+#
+# Anything which doesn't make sense, or doesn't fit in the game's
+# tables, stops the build.
+#
+#  compile_level.pl level1.lvl > level1_blob.asm
+#
+# The .lvl format is a line per item, # to the end of a line is a
+# comment. Coordinates are x,y. Colours are Spectrum colour names.
+#
+#  map         <asm file> <label>            SP1 print string for the layout
+#  start       <x>,<y> <left|right>          runner's start pixel and facing
+#  border      <colour>
+#  background  <ink> on <paper>              the level's colours
+#  solid       <ink> on <paper>
+#  jumper      <ink> on <paper>
+#  runner      <ink>                         the runner's colour, he takes the
+#                                            paper of the cells he's in
+#  slider      <x>,<y> <ink> on <paper>      countdown slider pixel, score colours
+#  bonus       <x>,<y>                       bonus sprite pixel, x a multiple of 8
+#                                            if it's on the screen
+#  teleporter  <x>,<y> <x>,<y> <keep|turn>   cells of the two ends, and whether
+#                                            the runner turns round going through
+#  slowdown    <x>,<y> <x>,<y> <secs>        sprite pixel, collection point pixel,
+#                                            how long it lasts
+#  door        <x>,<y> <x>,<y> <ink> <key ink> on <key paper> <open secs> <start open secs>
+#                                            key cell, door cell, door colour,
+#                                            key colours, how long the key opens
+#                                            the door, how long it's open at the
+#                                            start of the level
+
+use File::Basename;
+
+# The map packer, read_asm() and pack_map()
+require( dirname($0)."/pack_level_maps.pl" );
+
+# These must match levels.h
+my $MAX_LEVEL_SLOWDOWNS     = 6;
+my $MAX_LEVEL_DOORS         = 6;
+my $FINISH_ATT              = 0x0E;   # INK_YELLOW|PAPER_BLUE
+
+# collectable.h
+my $MAX_LEVEL_COLLECTABLES  = 12;
+
+# tile_map.h and teleporter.h
+my $TILE_BACKGROUND         = 0;
+my $TILE_SOLID              = 1;
+my $TILE_JUMPER             = 2;
+my $TILE_FINISH             = 3;
+my $TILE_TELEPORTER         = 0x80;
+my $TILE_MAP_MAX_RUN        = 32;
+my $MAX_LEVEL_TELEPORTERS   = 63;
+
+# runner.h
+my %FACING = ( right => 0, left => 1 );
+
+my %COLOUR = ( black => 0, blue => 1, red => 2, magenta => 3,
+               green => 4, cyan => 5, yellow => 6, white => 7 );
+
+my $SP1_AT = 0x16;
+my $ROWS   = 24;
+my $COLS   = 32;
+
+# Run the map string the way sp1_PrintString() does and return the colour
+# each cell is left with. The print control structure starts with the
+# background colour and no mask, so a printed cell takes the current
+# colour outright.
+sub print_colours {
+  my ($label, $background, @s) = @_;
+  my @colours = ( $background ) x ( $ROWS*$COLS );
+  my ($x, $y, $attr) = (0, 0, $background);
+  my ($repeat_start, $repeat_count);
+
+  for( my $i = 0; $i < @s; $i++ ) {
+    my $c = $s[$i];
+
+    if(    $c == 0x08 ) { $x-- if $x; }
+    elsif( $c == 0x09 ) { $x++; }
+    elsif( $c == 0x0a ) { $y-- if $y; }
+    elsif( $c == 0x0b ) { $y++; }
+    elsif( $c == 0x0c ) { $x = $y = 0; }
+    elsif( $c == 0x0d ) { $x = 0; $y++; }
+    elsif( $c == 0x0e ) { $repeat_count = $s[++$i]; $repeat_start = $i; }
+    elsif( $c == 0x0f ) { $i = $repeat_start if defined($repeat_start) && --$repeat_count; }
+    elsif( $c == 0x10 ) { $attr = ($attr & 0xF8) |  ($s[++$i] & 0x07); }
+    elsif( $c == 0x11 ) { $attr = ($attr & 0xC7) | (($s[++$i] & 0x07) << 3); }
+    elsif( $c == 0x12 ) { $attr = ($attr & 0x7F) | ($s[++$i] ? 0x80 : 0); }
+    elsif( $c == 0x13 ) { $attr = ($attr & 0xBF) | ($s[++$i] ? 0x40 : 0); }
+    elsif( $c == 0x14 ) { $attr = $s[++$i]; }
+    elsif( $c == $SP1_AT ) { $y = $s[++$i]; $x = $s[++$i]; }
+    else {
+      die sprintf( "%s: prints off the screen at %d,%d\n", $label, $x, $y ) if $x >= $COLS || $y >= $ROWS;
+      $colours[$y*$COLS+$x] = $attr;
+      if( ++$x == $COLS ) { $x = 0; $y = 0 if ++$y == $ROWS; }
+    }
+  }
+
+  return @colours;
+}
+
+# The tile map as runs of a tile type, a byte each: the type in bits 5
+# and 6, the length less one in the bottom 5. Teleporter cells are their
+# own tile byte, which has the top bit set.
+sub pack_tile_map {
+  my (@map) = @_;
+  my @runs;
+
+  for( my $i = 0; $i < @map; ) {
+    my $t = $map[$i];
+
+    if( $t & $TILE_TELEPORTER ) {
+      push( @runs, $t );
+      $i++;
+      next;
+    }
+
+    my $n = 1;
+    $n++ while $i+$n < @map && $map[$i+$n] == $t && $n < $TILE_MAP_MAX_RUN;
+    push( @runs, ($t << 5) | ($n-1) );
+    $i += $n;
+  }
+
+  return @runs;
+}
+
+# The map string for a label in an ASM file, without its terminator
+sub read_map {
+  my ($file, $label, $where) = @_;
+  my @items;
+  my $bytes;
+
+  read_asm( $file, \@items );
+
+  foreach my $item ( @items ) {
+    if( exists $item->{label} ) {
+      last if defined($bytes);
+      $bytes = [] if $item->{label} eq $label;
+    }
+    elsif( defined($bytes) && exists $item->{bytes} ) {
+      push( @$bytes, @{$item->{bytes}} );
+    }
+  }
+
+  die "$where: there's no map $label in $file\n" unless defined($bytes) && @$bytes;
+  die "$where: map $label isn't zero terminated\n" unless $bytes->[-1] == 0;
+  pop( @$bytes );
+
+  return @$bytes;
+}
+
+
+#
+# Reading the description
+#
+
+my $lvl_file;
+my $line_num;
+
+sub fail { die "$lvl_file:$line_num: @_\n"; }
+
+sub number {
+  my ($value, $max, $what) = @_;
+  fail( "$what '$value' isn't a number" ) unless $value =~ /^\d+$/;
+  fail( "$what $value is out of range, 0 to $max" ) if $value > $max;
+  return $value+0;
+}
+
+sub point {
+  my ($value, $max_x, $max_y, $what) = @_;
+  fail( "$what '$value' isn't x,y" ) unless $value =~ /^(\d+),(\d+)$/;
+  return ( number( $1, $max_x, "$what x" ), number( $2, $max_y, "$what y" ) );
+}
+
+sub colour {
+  my ($name) = @_;
+  fail( "'$name' isn't a colour" ) unless exists $COLOUR{lc $name};
+  return $COLOUR{lc $name};
+}
+
+# <ink> on <paper>, as an attribute
+sub attribute {
+  my ($ink, $on, $paper) = @_;
+  fail( "colours should be <ink> on <paper>" ) unless defined($paper) && $on eq 'on';
+  return colour( $ink ) | ( colour( $paper ) << 3 );
+}
+
+sub arguments {
+  my ($directive, $want, @args) = @_;
+  fail( "$directive takes $want values, not ".scalar(@args) ) unless @args == $want;
+  return @args;
+}
+
+die "Usage: $0 level.lvl\n" unless @ARGV == 1;
+$lvl_file = $ARGV[0];
+
+my %level;
+my (@teleporters, @slowdowns, @doors);
+
+open( my $lvl, '<', $lvl_file ) or die "Can't open $lvl_file: $!\n";
+while( my $line = <$lvl> ) {
+  $line_num = $.;
+  $line =~ s/#.*//;
+  my ($directive, @args) = split( ' ', $line );
+  next unless defined($directive);
+
+  fail( "$directive is given twice" ) if exists $level{$directive};
+
+  if( $directive eq 'map' ) {
+    my ($file, $label) = arguments( $directive, 2, @args );
+    $level{map} = [ read_map( dirname($lvl_file)."/$file", $label, "$lvl_file:$line_num" ) ];
+    $level{map_label} = $label;
+  }
+  elsif( $directive eq 'start' ) {
+    my ($at, $facing) = arguments( $directive, 2, @args );
+    fail( "facing should be left or right" ) unless exists $FACING{$facing};
+    $level{start} = [ point( $at, 255, 191, "start" ), $FACING{$facing} ];
+  }
+  elsif( $directive =~ /^(border|runner)$/ ) {
+    $level{$directive} = colour( arguments( $directive, 1, @args ) );
+  }
+  elsif( $directive =~ /^(background|solid|jumper)$/ ) {
+    $level{$directive} = attribute( arguments( $directive, 3, @args ) );
+  }
+  elsif( $directive eq 'slider' ) {
+    my ($at, @colours) = arguments( $directive, 4, @args );
+    $level{slider} = [ point( $at, 255, 255, "slider" ), attribute( @colours ) ];
+  }
+  elsif( $directive eq 'bonus' ) {
+    $level{bonus} = [ point( arguments( $directive, 1, @args ), 255, 255, "bonus" ) ];
+    fail( "bonus x has to be on a character boundary" )
+      if $level{bonus}[1] < 192 && $level{bonus}[0] & 7;
+  }
+
+  # The rest can be given any number of times
+  elsif( $directive eq 'teleporter' ) {
+    my ($end_1, $end_2, $turn) = arguments( $directive, 3, @args );
+    fail( "teleporter should keep or turn" ) unless $turn =~ /^(keep|turn)$/;
+    push( @teleporters, { line  => $line_num,
+                          end_1 => [ point( $end_1, $COLS-1, $ROWS-1, "teleporter end" ) ],
+                          end_2 => [ point( $end_2, $COLS-1, $ROWS-1, "teleporter end" ) ],
+                          turn  => $turn eq 'turn' ? 1 : 0 } );
+  }
+  elsif( $directive eq 'slowdown' ) {
+    my ($at, $centre, $secs) = arguments( $directive, 3, @args );
+    push( @slowdowns, { line   => $line_num,
+                        at     => [ point( $at, 255, 191, "slowdown" ) ],
+                        centre => [ point( $centre, 255, 191, "slowdown centre" ) ],
+                        secs   => number( $secs, 255, "slowdown secs" ) } );
+    fail( "slowdown can't last 0 seconds" ) unless $slowdowns[-1]{secs};
+  }
+  elsif( $directive eq 'door' ) {
+    my ($key, $door, $ink, @rest) = arguments( $directive, 8, @args );
+    push( @doors, { line       => $line_num,
+                    key        => [ point( $key, $COLS-1, $ROWS-1, "key" ) ],
+                    door       => [ point( $door, $COLS-1, $ROWS-1, "door" ) ],
+                    ink        => colour( $ink ),
+                    key_ink    => colour( $rest[0] ),
+                    key_paper  => do { fail( "key colours should be <ink> on <paper>" ) unless $rest[1] eq 'on';
+                                       colour( $rest[2] ) },
+                    open_secs  => number( $rest[3], 255, "door open secs" ),
+                    start_secs => number( $rest[4], 255, "door start open secs" ) } );
+  }
+  else {
+    fail( "don't know what '$directive' is" );
+  }
+
+}
+close( $lvl );
+
+
+#
+# Checking it
+#
+
+$line_num = "end";
+
+foreach my $needed ( qw(map start border background solid jumper runner slider bonus) ) {
+  fail( "there's no $needed" ) unless exists $level{$needed};
+}
+
+# Cells are told apart by colour, so these have to be different
+fail( "background and jumper colours are the same" ) if $level{background} == $level{jumper};
+fail( "background is the finish colour" ) if $level{background} == $FINISH_ATT;
+fail( "jumper is the finish colour" )     if $level{jumper}     == $FINISH_ATT;
+
+fail( "too many teleporters, the most is $MAX_LEVEL_TELEPORTERS" ) if @teleporters > $MAX_LEVEL_TELEPORTERS;
+fail( "too many slowdowns, the most is $MAX_LEVEL_SLOWDOWNS" )     if @slowdowns > $MAX_LEVEL_SLOWDOWNS;
+fail( "too many doors, the most is $MAX_LEVEL_DOORS" )             if @doors > $MAX_LEVEL_DOORS;
+fail( "too many pills and keys, the most is $MAX_LEVEL_COLLECTABLES" )
+  if @slowdowns + @doors > $MAX_LEVEL_COLLECTABLES;
+
+my @tile_map = map { $_ == $level{background} ? $TILE_BACKGROUND :
+                     $_ == $FINISH_ATT        ? $TILE_FINISH     :
+                     $_ == $level{jumper}     ? $TILE_JUMPER     : $TILE_SOLID }
+               print_colours( $level{map_label}, $level{background}, @{$level{map}} );
+
+my $index = 0;
+foreach my $teleporter ( @teleporters ) {
+  $line_num = $teleporter->{line};
+
+  foreach my $end ( 0, 1 ) {
+    my ($x, $y) = @{$teleporter->{$end ? 'end_2' : 'end_1'}};
+
+    # A zeroed entry ends the list
+    fail( "a teleporter can't start at 0,0" ) if !$end && !$x && !$y;
+    fail( "teleporter end $x,$y is already a teleporter" ) if $tile_map[$y*$COLS+$x] & $TILE_TELEPORTER;
+    $tile_map[$y*$COLS+$x] = $TILE_TELEPORTER | ($index << 1) | $end;
+  }
+  $index++;
+}
+
+# Collectables are picked up on their collection point, so two can't share one
+my %collection_points;
+foreach my $collectable ( @slowdowns, @doors ) {
+  $line_num = $collectable->{line};
+
+  my ($x, $y) = $collectable->{centre} ? @{$collectable->{centre}}
+                                       : map { $_*8+4 } @{$collectable->{key}};
+
+  # Nor can one be at 0,0, which ends the list
+  my ($at_x, $at_y) = @{$collectable->{at} // $collectable->{key}};
+  fail( "can't be at 0,0" ) if !$at_x && !$at_y;
+
+  fail( "collection point $x,$y is already used on line $collection_points{\"$x,$y\"}" )
+    if exists $collection_points{"$x,$y"};
+  $collection_points{"$x,$y"} = $line_num;
+  $collectable->{collect} = [ $x, $y ];
+}
+
+foreach my $door ( @doors ) {
+  $line_num = $door->{line};
+  my ($x, $y) = @{$door->{door}};
+
+  # The door disappears into the cell above it when it opens
+  fail( "a door can't be on the top row" ) unless $y;
+  fail( "door cell $x,$y is a teleporter" ) if $tile_map[$y*$COLS+$x] & $TILE_TELEPORTER;
+}
+
+
+#
+# Writing the blob
+#
+
+my @blob = ( @{$level{start}}, $level{border},
+             $level{background}, $level{solid}, $level{jumper}, $level{runner},
+             @{$level{slider}}, @{$level{bonus}} );
+
+push( @blob, scalar(@teleporters) );
+foreach my $teleporter ( @teleporters ) {
+  my @ends = map { [ $_->[1]*8, $_->[0]*8, $_->[1], $_->[0] ] } @$teleporter{qw(end_1 end_2)};
+  push( @blob, @{$ends[0]}, @{$ends[1]}, $teleporter->{turn} );
+}
+push( @blob, (0) x 9 ) if @teleporters;
+
+push( @blob, scalar(@slowdowns) );
+push( @blob, @{$_->{at}}, @{$_->{collect}}, $_->{secs} ) foreach @slowdowns;
+
+push( @blob, scalar(@doors) );
+foreach my $door ( @doors ) {
+  my ($x, $y) = @{$door->{door}};
+  push( @blob, @{$door->{key}}, @{$door->{collect}},
+               $x, $y, $x, $y-1, $x*8+1, $y*8,
+               @$door{qw(ink key_ink key_paper open_secs start_secs)} );
+}
+
+my @tile_runs = pack_tile_map( @tile_map );
+my @packed    = ( pack_map( $level{map_label}, @{$level{map}} ), 0x00 );
+
+(my $name = basename( $lvl_file )) =~ s/\.lvl$//;
+
+printf STDERR "%-12s map %4d -> %4d bytes, tile map %4d, blob %4d\n", $name,
+  scalar(@{$level{map}})+1, scalar(@packed), scalar(@tile_runs), @blob+@tile_runs+@packed;
+
+sub defb {
+  my ($comment, @bytes) = @_;
+  print "\n        ;; $comment\n";
+  while( my @line = splice( @bytes, 0, 16 ) ) {
+    print "        defb ", join( ", ", map { sprintf( "0x%02X", $_ ) } @line ), "\n";
+  }
+}
+
+print ";; Generated from $lvl_file by $0, don't edit\n\n";
+print "PUBLIC _${name}_blob\n";
+print "._${name}_blob\n";
+defb( "Level", @blob );
+defb( "Tile map", @tile_runs );
+defb( "Map", @packed );
@@ -62,8 +62,8 @@ static void initialise_colour(unsigned int count, struct sp1_cs *c)
 /* On top, not that it matters */
 #define SLIDER_PLANE 1
 
-/* This is in the graphics ASM file */
-extern uint8_t score_slider[8];
+/* Pre-shifted frames, built from sprites.asm */
+extern uint8_t score_slider[];
 
 void create_slider( void )
 {
@@ -72,8 +72,8 @@ void create_slider( void )
    * Since it's the same colour and is designed to sit on top of the bar
    * the slider can be ORed into the display.
    */
-  slider_sprite = sp1_CreateSpr(SP1_DRAW_OR1LB, SP1_TYPE_1BYTE, 2, 0, SLIDER_PLANE);
-  sp1_AddColSpr(slider_sprite, SP1_DRAW_OR1RB, SP1_TYPE_1BYTE, 0, SLIDER_PLANE);
+  slider_sprite = sp1_CreateSpr(SP1_DRAW_OR1NR, SP1_TYPE_1BYTE, 2, 0, SLIDER_PLANE);
+  sp1_AddColSpr(slider_sprite, SP1_DRAW_OR1NR, SP1_TYPE_1BYTE, PRESHIFTED_COLUMN_1, SLIDER_PLANE);
 }
 
 void reset_slider( void )
@@ -121,8 +121,9 @@ void update_countdown_slider( SCORE_SCREEN_DATA* screen_data )
     /* Colour the cells the sprite occupies */
     sp1_IterateSprChar(slider_sprite, initialise_colour);
 
-    sp1_MoveSprPix(slider_sprite, &full_screen, (void*)score_slider,
-                   screen_data->countdown_slider_x+slider_x_pos, screen_data->countdown_slider_y);
+    slider_x_pos += screen_data->countdown_slider_x;
+    sp1_MoveSprPix(slider_sprite, &full_screen, PRESHIFTED_FRAME(score_slider, slider_x_pos),
+                   slider_x_pos, screen_data->countdown_slider_y);
   }
 }
 
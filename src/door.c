@@ -27,6 +27,7 @@
 #include "tracetable.h"
 #include "game_state.h"
 #include "graphics.h"
+#include "tile_map.h"
 
 /***
  *      _______             _             
@@ -54,6 +55,7 @@ typedef enum _door_tracetype
 typedef struct _door_trace
 {
   uint16_t           ticker;
+  uint8_t            frame_seq;
   DOOR_TRACETYPE     tracetype;
   DOOR*              door;
 } DOOR_TRACE;
@@ -62,26 +64,37 @@ typedef struct _door_trace
 #define DOOR_TRACE_ENTRIES 120
 #define DOOR_TRACETABLE_SIZE ((size_t)sizeof(DOOR_TRACE)*DOOR_TRACE_ENTRIES)
 
+#if DOOR_TRACING
+
 /* It's quicker to do this with a macro, as long as it's only used once or twice */
 #define DOOR_TRACE_CREATE(ttype,dptr) {     \
     if( door_tracetable != TRACING_INACTIVE ) { \
-      DOOR_TRACE          dt;   \
-      dt.ticker           = GET_TICKER; \
-      dt.tracetype        = ttype; \
-      dt.door             = dptr; \
-      door_add_trace(&dt); \
+      DOOR_TRACE*         dt = TRACE_ENTRY(door);   \
+      TRACE_STAMP(door, dt); \
+      dt->tracetype = ttype; \
+      dt->door      = dptr; \
+      TRACE_ADVANCE(door, DOOR_TRACETABLE_SIZE); \
     } \
 }
 
-TRACE_FN( door, DOOR_TRACE, DOOR_TRACETABLE_SIZE )
+TRACE_TABLE( door, DOOR_TRACE )
 
 void init_door_trace(void)
 {
   door_tracetable = door_next_trace = allocate_tracememory(DOOR_TRACETABLE_SIZE);
 }
 
+#else
+
+#define DOOR_TRACE_CREATE(ttype,dptr)
+
+#endif
+
 
-/* This is in the assembly language file */
+/*
+ * Built from sprites.asm. Doors are in a cell so there's just the one
+ * unshifted frame.
+ */
 extern uint8_t door_f1[];
 
 /*
@@ -99,8 +112,9 @@ extern struct sp1_pss level_print_control;
 
 /*
  * Key graphic is a static tile (a UDG). It's displayed as a tile via
- * the SP1 print routine. It must be the same ink/paper colour as the
- * runner otherwise he'll bounce off it.
+ * the SP1 print routine. It used to have to be the same ink/paper colour
+ * as the runner otherwise he'd bounce off it. Keys are printed after the
+ * tile map is built so their colours no longer matter to collisions.
  */
 static uint8_t key_sp1_string[9] = "\x16" "yx" "\x10" "i" "\x11" "p" "t";
 void display_key( DOOR* door, uint8_t visible )
@@ -136,9 +150,10 @@ void create_door( DOOR* door )
   door->moving   = DOOR_STATIONARY;
   door->y_offset = 0;
   SET_COLLECTABLE_AVAILABLE(door->collectable,COLLECTABLE_AVAILABLE);
+  register_collectable(&(door->collectable));
 
-  door->sprite = sp1_CreateSpr(SP1_DRAW_LOAD1LB, SP1_TYPE_1BYTE, 2, 0, DOOR_PLANE);
-  sp1_AddColSpr(door->sprite, SP1_DRAW_LOAD1RB, SP1_TYPE_1BYTE, 0, DOOR_PLANE);
+  door->sprite = sp1_CreateSpr(SP1_DRAW_LOAD1NR, SP1_TYPE_1BYTE, 2, 0, DOOR_PLANE);
+  sp1_AddColSpr(door->sprite, SP1_DRAW_LOAD1NR, SP1_TYPE_1BYTE, PRESHIFTED_COLUMN_1, DOOR_PLANE);
 
   /*
    * I use the _callee version specifically here because sp1_MoveSprPix()
@@ -153,6 +168,9 @@ void create_door( DOOR* door )
   ink_param = door->door_ink_colour;
   sp1_IterateSprChar(door->sprite, initialise_colour);
 
+  /* A closed door blocks the runner */
+  SET_TILE_AT_CELL(door->door_cell_x, door->door_cell_y, TILE_DOOR);
+
   DOOR_TRACE_CREATE(DOOR_CREATED,door);
 
   if( door->start_open_secs )
@@ -168,6 +186,9 @@ void destroy_door( DOOR* door )
 {
   COLLECTABLE_TRACE_CREATE(COLLECTABLE_TO_BE_DESTROYED, &(door->collectable), GET_RUNNER_XPOS, GET_RUNNER_YPOS );
 
+  /* An open door's timer may still be running */
+  CANCEL_COLLECTABLE_TIMER( door->collectable );
+
   /* Move sprite offscreen before calling delete function */
   sp1_MoveSprPix(door->sprite, &full_screen, (void*)0, 255, 255);
   sp1_DeleteSpr(door->sprite);
@@ -175,6 +196,18 @@ void destroy_door( DOOR* door )
   DOOR_TRACE_CREATE(DOOR_DESTROYED,door);
 }
 
+/*
+ * Whether any of the runner's box is in the door's cell. The subtractions
+ * wrap, so each is a single compare against the range of positions which
+ * overlap it.
+ */
+static uint8_t runner_in_doorway( DOOR* door )
+{
+  return (uint8_t)(GET_RUNNER_XPOS + RUNNER_WIDTH-1  - door->door_cell_x*8) < RUNNER_WIDTH+7
+         &&
+         (uint8_t)(GET_RUNNER_YPOS + RUNNER_HEIGHT-1 - door->door_cell_y*8) < RUNNER_HEIGHT+7;
+}
+
 void animate_door( DOOR* door )
 {
   if( door->moving == DOOR_OPENING )
@@ -185,6 +218,14 @@ void animate_door( DOOR* door )
   }
   else
   {
+    /*
+     * A door doesn't close on the runner. If it did he'd be boxed in, both
+     * ways blocked, and he'd turn to and fro until the countdown ran out.
+     * It waits, still closing, until he's out of the doorway.
+     */
+    if( runner_in_doorway( door ) )
+      return;
+
     if( --(door->y_offset) == 0 )
       door->moving = DOOR_STATIONARY;
 
@@ -194,6 +235,15 @@ void animate_door( DOOR* door )
                         (void*)door_f1,
                         DOOR_SCREEN_LOCATION_WITH_OFFSET(door));
 
+  /*
+   * The doorway is only passable once the door has slid all the way out of
+   * its cell. Any part of it left in the cell, opening or closing, blocks.
+   */
+  if( door->y_offset == 8 )
+    SET_TILE_AT_CELL(door->door_cell_x, door->door_cell_y, TILE_BACKGROUND);
+  else
+    SET_TILE_AT_CELL(door->door_cell_x, door->door_cell_y, TILE_DOOR);
+
   DOOR_TRACE_CREATE(DOOR_ANIMATED,door);
 }
 
@@ -215,6 +265,7 @@ void door_key_collected(COLLECTABLE* collectable, void* data)
   (void)collectable;
 
   SET_COLLECTABLE_AVAILABLE(door->collectable,COLLECTABLE_NOT_AVAILABLE);
+  rebuild_collectable_triggers();
 
   /* Remove key from screen */
   animate_door_key( door );
@@ -222,6 +273,7 @@ void door_key_collected(COLLECTABLE* collectable, void* data)
   /* Open the door */
   door->moving = DOOR_OPENING;
   door->animation_step = 0;
+  SET_GAME_ACTION_READY( READY_DOORS );
 
   START_COLLECTABLE_TIMER(door->collectable, door->open_secs);
 
@@ -242,6 +294,7 @@ uint8_t door_open_timeup(COLLECTABLE* collectable, void* data)
   (void)collectable;
 
   SET_COLLECTABLE_AVAILABLE(door->collectable,COLLECTABLE_AVAILABLE);
+  rebuild_collectable_triggers();
 
   /* Redraw the key */
   animate_door_key( door );
@@ -249,6 +302,7 @@ uint8_t door_open_timeup(COLLECTABLE* collectable, void* data)
   /* Close the door */
   door->moving = DOOR_CLOSING;
   door->animation_step = 0;
+  SET_GAME_ACTION_READY( READY_DOORS );
 
   COLLECTABLE_TRACE_CREATE( COLLECTABLE_TIMEOUT, &(door->collectable), GET_RUNNER_XPOS, GET_RUNNER_YPOS );
   DOOR_TRACE_CREATE(DOOR_TIMEOUT,door);
@@ -274,22 +328,3 @@ void check_door_passed_through( DOOR* door )
   }
   
 }
-
-
-void validate_door_cells( DOOR* first_door )
-{
-  DOOR* door = first_door;
-
-  while( IS_VALID_COLLECTABLE(door->collectable) )
-  {
-    /*
-     * There doesn't appear to be an SP1 interface to validate a
-     * single tile. Use a 1x1 rectangle instead.
-     */
-    struct sp1_Rect validate_cell = {door->door_protected_cell_y,
-                                     door->door_protected_cell_x, 1, 1};
-    sp1_Validate(&validate_cell);
-    
-    door++;
-  }
-}
@@ -24,6 +24,7 @@
 
 #include "action.h"
 #include "collectable.h"
+#include "tracetable.h"
 
 /*
  * Enum indicates which way a door is moving - opening or closing
@@ -90,7 +91,7 @@ typedef struct _door
   uint8_t            open_secs;
   uint8_t            start_open_secs;
 
-  /* Stuff below here isn't initialised at compile time */
+  /* Stuff below here isn't in the level blob */
 
   /*
    * Door is a sprite because it needs to be pixel-positioned as part of the
@@ -114,14 +115,6 @@ typedef struct _door
 #define KEY_TILE_NUM         133
 #define KEY_BLANK_TILE_NUM   255
 
-/*
- * Macro initialises the data for the door location. These values are set by the
- * compiler so they don't need to be calculated by the Spectrum.
- * Given the x,y cell coordinates, the protected cell is set to the one above it
- * and the stays-open pixel location is it's left side.
- */
-#define INITIALISE_DOOR_LOCATION(cellx,celly) cellx,celly,cellx,celly-1,(cellx*8)+1,celly*8
-
 /*
  * Macro answers true if the door pointed to is valid.
  * That's defined as the collectable being valid.
@@ -140,7 +133,11 @@ typedef struct _door
 #define DOOR_SCREEN_LOCATION(door)              door->door_cell_x*8,door->door_cell_y*8
 #define DOOR_SCREEN_LOCATION_WITH_OFFSET(door)  door->door_cell_x*8,(door->door_cell_y*8)-door->y_offset
 
+#if DOOR_TRACING
 void init_door_trace(void);
+#else
+#define init_door_trace()
+#endif
 
 void create_door( DOOR* door );
 void destroy_door( DOOR* door );
@@ -149,7 +146,6 @@ void animate_door( DOOR* door );
 void door_key_collected(COLLECTABLE* collectable, void* data);
 uint8_t door_open_timeup(COLLECTABLE* collectable, void* data);
 
-void validate_door_cells( DOOR* first_door );
 void check_door_passed_through( DOOR* door );
 
 #endif
@@ -0,0 +1,81 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Wonky One Key, a ZX Spectrum game featuring a single control key
+# Copyright (C) 2018 Derek Fountain
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+# Input log embedder. Turns an input log, as recorded by a build made
+# with INPUT_LOG=1 and got out of a snapshot with wonky_traces -i, into
+# the data a replay build plays. The records are checked on the way in
+# (see input_log.h for the format) and the log is given its end marker
+# if it hasn't got one. A log which doesn't make sense stops the build.
+#
+#  embed_input_log.pl run.log > input_log_data.asm
+
+use constant FRAMES_BYTE => 0x80;
+use constant FRAMES_WORD => 0x40;
+use constant KEYS        => 0x07;
+
+die "Usage: $0 input_log\n" unless @ARGV == 1;
+my $log_file = $ARGV[0];
+
+my $log;
+{
+  local $/;
+  open( my $fh, '<:raw', $log_file ) or die "Can't open $log_file: $!\n";
+  $log = <$fh>;
+  close( $fh );
+}
+my @bytes = unpack( 'C*', $log );
+
+my @records;
+my ($passes, $frames) = (0, 0);
+my $i = 0;
+
+while( $i < @bytes ) {
+  my $flags = $bytes[$i];
+
+  die "$log_file: record at $i is cut short\n" if $i+1 >= @bytes;
+  last if $bytes[$i+1] == 0;
+
+  die sprintf( "%s: record at %d has flags 0x%02X\n", $log_file, $i, $flags )
+    if ($flags & ~(KEYS|FRAMES_BYTE|FRAMES_WORD)) || (($flags & FRAMES_BYTE) && ($flags & FRAMES_WORD));
+
+  my $length = 2 + (($flags & FRAMES_WORD) ? 2 : ($flags & FRAMES_BYTE) ? 1 : 0);
+  die "$log_file: record at $i is cut short\n" if $i+$length > @bytes;
+
+  my @record = @bytes[$i .. $i+$length-1];
+  my $record_frames = ($flags & FRAMES_WORD) ? $record[2] | ($record[3] << 8)
+                    : ($flags & FRAMES_BYTE) ? $record[2]
+                    : 1;
+
+  $passes += $record[1];
+  $frames += $record[1] * $record_frames;
+  push( @records, \@record );
+  $i += $length;
+}
+
+printf STDERR "%s: %d records, %d passes, %d frames\n", $log_file, scalar @records, $passes, $frames;
+
+print ";; Generated from $log_file by $0, don't edit\n\n";
+print "SECTION LEVEL_DATA\n\n";
+print "PUBLIC _input_log_data\n";
+print "._input_log_data\n";
+foreach my $record (@records) {
+  print "        defb ", join( ", ", map { sprintf( "0x%02X", $_ ) } @$record ), "\n";
+}
+print "        defb 0x00, 0x00\n";
@@ -23,6 +23,7 @@
 #include <stdint.h>
 
 #include "levels.h"
+#include "tile_map.h"
 
 typedef enum _level_completion_type
 {
@@ -43,6 +44,12 @@ typedef struct _game_state
   uint8_t     key_processed;
 
   LEVEL_DATA* current_level;
+
+  /*
+   * Cells around the runner, captured once each time round the game loop
+   * before the action functions which test them run.
+   */
+  RUNNER_NEIGHBOURHOOD neighbourhood;
 } GAME_STATE;
 
 #endif
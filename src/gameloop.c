@@ -24,7 +24,6 @@
 #include <string.h>
 #include <stdint.h>
 #include <z80.h>
-#include <sound.h>
 
 #include "game_state.h"
 #include "runner.h"
@@ -40,7 +39,10 @@
 #include "sound.h"
 #include "bonus.h"
 #include "countdown.h"
+#include "tile_map.h"
 #include "action.h"
+#include "raster_profile.h"
+#include "input_log.h"
 
 
 /***
@@ -64,12 +66,14 @@ typedef enum _gameloop_tracetype
   BEEP,
   INT_1000MS,
   INT_500MS,
+  DISPATCH_COUNT,
   EXIT,
 } GAMELOOP_TRACETYPE;
 
 typedef struct _gameloop_trace
 {
   uint16_t           ticker;
+  uint8_t            frame_seq;
   GAMELOOP_TRACETYPE tracetype;
   uint8_t            key_pressed;
   uint8_t            key_processed;
@@ -78,110 +82,129 @@ typedef struct _gameloop_trace
   SLOWDOWN_STATUS    slowdown_active;
   GAME_ACTION        action;
   PROCESSING_FLAG    processing_flag;
+
+  /* These two are only filled in for DISPATCH_COUNT entries */
+  uint8_t            action_index;
+  uint16_t           dispatch_count;
 } GAMELOOP_TRACE;
 
 /* BE:PICKUPDEF */
 #define GAMELOOP_TRACE_ENTRIES 500
 #define GAMELOOP_TRACETABLE_SIZE ((size_t)sizeof(GAMELOOP_TRACE)*GAMELOOP_TRACE_ENTRIES)
 
+#if GAMELOOP_TRACING
+
 /* It's quicker to do this with a macro, as long as it's only used once or twice */
 #define GAMELOOP_TRACE_CREATE(ttype,keypressed,keyprocessed,x,y,sd,act,pflag) { \
     if( gameloop_tracetable != TRACING_INACTIVE ) { \
-      GAMELOOP_TRACE      glt;   \
-      glt.ticker          = GET_TICKER; \
-      glt.tracetype       = ttype; \
-      glt.key_pressed     = keypressed; \
-      glt.key_processed   = keyprocessed; \
-      glt.xpos            = x; \
-      glt.ypos            = y; \
-      glt.slowdown_active = sd; \
-      glt.action          = act; \
-      glt.processing_flag = pflag; \
-      gameloop_add_trace(&glt); \
+      GAMELOOP_TRACE*     glt = TRACE_ENTRY(gameloop);   \
+      TRACE_STAMP(gameloop, glt); \
+      glt->tracetype       = ttype; \
+      glt->key_pressed     = keypressed; \
+      glt->key_processed   = keyprocessed; \
+      glt->xpos            = x; \
+      glt->ypos            = y; \
+      glt->slowdown_active = sd; \
+      glt->action          = act; \
+      glt->processing_flag = pflag; \
+      glt->action_index    = 0; \
+      glt->dispatch_count  = 0; \
+      TRACE_ADVANCE(gameloop, GAMELOOP_TRACETABLE_SIZE); \
     } \
 }
 
-TRACE_FN( gameloop, GAMELOOP_TRACE, GAMELOOP_TRACETABLE_SIZE )
+TRACE_TABLE( gameloop, GAMELOOP_TRACE )
 
 void init_gameloop_trace(void)
 {
   gameloop_tracetable = gameloop_next_trace = allocate_tracememory(GAMELOOP_TRACETABLE_SIZE);
 }
 
+#else
+
+#define GAMELOOP_TRACE_CREATE(ttype,keypressed,keyprocessed,x,y,sd,act,pflag)
+
+#endif
 
+
+/*
+ * 1Hz ticker, just fiddles the countdown. Only called when the ISR
+ * has set READY_1000MS.
+ */
 PROCESSING_FLAG service_interrupt_1000ms( void* data, GAME_ACTION* output_action )
 {
-  *output_action = NO_ACTION;
+  GAME_STATE* game_state = (GAME_STATE*)data;
 
-  /* 1Hz ticker, just fiddles the countdown */
-  if( interrupt_service_required_1000ms )
-  {
-    GAME_STATE* game_state = (GAME_STATE*)data;
+  *output_action = NO_ACTION;
 
-    GAMELOOP_TRACE_CREATE(INT_1000MS,
-                          game_state->key_pressed,
-                          game_state->key_processed,
-                          GET_RUNNER_XPOS,
-                          GET_RUNNER_YPOS,
-                          GET_RUNNER_SLOWDOWN,
-                          0, 0);
+  GAMELOOP_TRACE_CREATE(INT_1000MS,
+                        game_state->key_pressed,
+                        game_state->key_processed,
+                        GET_RUNNER_XPOS,
+                        GET_RUNNER_YPOS,
+                        GET_RUNNER_SLOWDOWN,
+                        0, 0);
 
-    /*
-     * Countdown doesn't start running until intro level is over,
-     * so if it hasn't started, don't touch it.
-     */
-    if( GET_GAME_COUNTDOWN != 0 )
+  /*
+   * Countdown doesn't start running until intro level is over,
+   * so if it hasn't started, don't touch it.
+   */
+  if( GET_GAME_COUNTDOWN != 0 )
+  {
+    DECREMENT_GAME_COUNTDOWN;
+    if( GET_GAME_COUNTDOWN == 0 )
     {
-      DECREMENT_GAME_COUNTDOWN;
-      if( GET_GAME_COUNTDOWN == 0 )
-      {
-        /* This leads to game over so no need to worry about reseting etc */
-        *output_action = COUNTDOWN_EXPIRED;
-      }
+      /* This leads to game over so no need to worry about reseting etc */
+      *output_action = COUNTDOWN_EXPIRED;
     }
-
-    /*
-     * This flag is 8 bit and the compiler doesn't promote it, so it doesn't
-     * need atomic protection.
-     */
-    interrupt_service_required_1000ms = 0;
   }
 
   return KEEP_PROCESSING;
 }
 
+/*
+ * 2Hz ticker, animates the slowdown pills. Only called when the ISR
+ * has set READY_500MS.
+ */
 PROCESSING_FLAG service_interrupt_500ms( void* data, GAME_ACTION* output_action )
 {
-  /* 2Hz ticker, animates the slowdown pills */
-  if( interrupt_service_required_500ms )
-  {
-    GAME_STATE* game_state = (GAME_STATE*)data;
-    SLOWDOWN* slowdown = game_state->current_level->slowdowns;
+  GAME_STATE* game_state = (GAME_STATE*)data;
+  SLOWDOWN* slowdown = game_state->current_level->slowdowns;
 
-    if( slowdown != NULL )
+  if( slowdown != NULL )
+  {
+    /* Loop over any slowdown pills on screen and animate their graphic frames */
+    while( IS_VALID_SLOWDOWN(slowdown) )
     {
-      /* Loop over any slowdown pills on screen and animate their graphic frames */
-      while( IS_VALID_SLOWDOWN(slowdown) )
-      {
-        animate_slowdown_pill( slowdown );
-        slowdown++;
-      }
+      animate_slowdown_pill( slowdown );
+      slowdown++;
     }
+  }
 
-    GAMELOOP_TRACE_CREATE(INT_500MS,
-                          game_state->key_pressed,
-                          game_state->key_processed,
-                          GET_RUNNER_XPOS,
-                          GET_RUNNER_YPOS,
-                          GET_RUNNER_SLOWDOWN,
-                          0, 0);
+  GAMELOOP_TRACE_CREATE(INT_500MS,
+                        game_state->key_pressed,
+                        game_state->key_processed,
+                        GET_RUNNER_XPOS,
+                        GET_RUNNER_YPOS,
+                        GET_RUNNER_SLOWDOWN,
+                        0, 0);
 
-    /*
-     * This flag is 8 bit and the compiler doesn't promote it, so it doesn't
-     * need atomic protection.
-     */
-    interrupt_service_required_500ms = 0;
-  }
+  *output_action = NO_ACTION;
+  return KEEP_PROCESSING;
+}
+
+PROCESSING_FLAG capture_neighbourhood( void* data, GAME_ACTION* output_action )
+{
+  GAME_STATE* game_state = (GAME_STATE*)data;
+
+  /*
+   * Snapshot the cells around the runner for the tests which follow. Nothing
+   * between here and the collision check moves him without stopping the
+   * processing, so the snapshot holds for the rest of this time round. It
+   * goes after the door animation so an opening door is seen this frame.
+   */
+  capture_runner_neighbourhood( &(game_state->neighbourhood),
+                                GET_RUNNER_XPOS, GET_RUNNER_YPOS );
 
   *output_action = NO_ACTION;
   return KEEP_PROCESSING;
@@ -207,35 +230,171 @@ PROCESSING_FLAG service_interrupt_500ms( void* data, GAME_ACTION* output_action
  */
 
 
-LOOP_ACTION game_actions[15] =
+#define NUM_GAME_ACTIONS 15
+
+LOOP_ACTION game_actions[NUM_GAME_ACTIONS] =
   {
-    {play_bg_music_note,         NORMAL_WHEN_SLOWDOWN    },
-    {play_beepfx_sound,          NORMAL_WHEN_SLOWDOWN    },
-    {animate_doors,              NORMAL_WHEN_SLOWDOWN    },
-    {service_interrupt_1000ms,   NORMAL_WHEN_SLOWDOWN    },
-    {service_interrupt_500ms,    NORMAL_WHEN_SLOWDOWN    },
-    {test_for_finish,            NORMAL_WHEN_SLOWDOWN    },
-    {test_for_teleporter,        NORMAL_WHEN_SLOWDOWN    },
-    {test_for_slowdown_pill,     NORMAL_WHEN_SLOWDOWN    },
-    {test_for_door_key,          NORMAL_WHEN_SLOWDOWN    },
-    {test_for_falling,           NORMAL_WHEN_SLOWDOWN    },
-    {test_for_start_jump,        NORMAL_WHEN_SLOWDOWN    },
-    {test_for_direction_change,  NORMAL_WHEN_SLOWDOWN    },
-    {act_on_collision,           NORMAL_WHEN_SLOWDOWN    },
-    {adjust_for_jump,            SLOW_WHEN_SLOWDOWN      },
-    {move_sideways,              SLOW_WHEN_SLOWDOWN      },
+    {animate_doors,               READY_DOORS,             NORMAL_WHEN_SLOWDOWN    },
+    {service_interrupt_1000ms,    READY_1000MS,            NORMAL_WHEN_SLOWDOWN    },
+    {service_interrupt_500ms,     READY_500MS,             NORMAL_WHEN_SLOWDOWN    },
+    {capture_neighbourhood,       ALWAYS_READY,            NORMAL_WHEN_SLOWDOWN    },
+    {test_for_finish,             ALWAYS_READY,            NORMAL_WHEN_SLOWDOWN    },
+    {test_for_teleporter,         ALWAYS_READY,            NORMAL_WHEN_SLOWDOWN    },
+    {service_collectable_timers,  READY_COLLECTABLE_TIMER, NORMAL_WHEN_SLOWDOWN    },
+    {test_for_slowdown_pill,      ALWAYS_READY,            NORMAL_WHEN_SLOWDOWN    },
+    {test_for_door_key,           ALWAYS_READY,            NORMAL_WHEN_SLOWDOWN    },
+    {test_for_falling,            ALWAYS_READY,            NORMAL_WHEN_SLOWDOWN    },
+    {test_for_start_jump,         ALWAYS_READY,            NORMAL_WHEN_SLOWDOWN    },
+    {test_for_direction_change,   ALWAYS_READY,            NORMAL_WHEN_SLOWDOWN    },
+    {act_on_collision,            ALWAYS_READY,            NORMAL_WHEN_SLOWDOWN    },
+    {adjust_for_jump,             ALWAYS_READY,            SLOW_WHEN_SLOWDOWN      },
+    {move_sideways,               ALWAYS_READY,            SLOW_WHEN_SLOWDOWN      },
   };
-#define NUM_GAME_ACTIONS (sizeof(game_actions) / sizeof(LOOP_ACTION))
+
+/*
+ * Ready bits for the actions which are driven by gameplay events. See action.h.
+ */
+uint8_t game_actions_ready = 0;
+
+/*
+ * Number of times each action has been called this level, in game_actions
+ * order. These are dumped into the trace table when the level ends so
+ * it's possible to see how much work the scheduler is saving. They're
+ * only counted if the game loop is traced.
+ */
+#if GAMELOOP_TRACING
+
+static uint16_t dispatch_counts[NUM_GAME_ACTIONS];
+
+#define CLEAR_DISPATCH_COUNTS        memset( dispatch_counts, 0, sizeof(dispatch_counts) )
+#define COUNT_DISPATCH(action_iter)  dispatch_counts[action_iter]++
+
+static void trace_dispatch_counts( void )
+{
+  uint8_t action_iter;
+
+  if( gameloop_tracetable == TRACING_INACTIVE )
+    return;
+
+  for( action_iter=0; action_iter < NUM_GAME_ACTIONS; action_iter++ ) {
+    GAMELOOP_TRACE* glt = TRACE_ENTRY(gameloop);
+
+    memset( glt, 0, sizeof(GAMELOOP_TRACE) );
+    TRACE_STAMP(gameloop, glt);
+    glt->tracetype      = DISPATCH_COUNT;
+    glt->action_index   = action_iter;
+    glt->dispatch_count = dispatch_counts[action_iter];
+    TRACE_ADVANCE(gameloop, GAMELOOP_TRACETABLE_SIZE);
+  }
+}
+
+#else
+
+#define CLEAR_DISPATCH_COUNTS
+#define COUNT_DISPATCH(action_iter)
+#define trace_dispatch_counts()
+
+#endif
+
+/*
+ * Missed frames. The loop is meant to go round once a frame, with the
+ * halt at the bottom waiting out what's left of it. If the work runs
+ * past the next interrupt the halt waits for the one after, and the
+ * frame's been missed. These count how many frames each time round the
+ * loop took, and for the ones which took more, which level it was and
+ * what the loop was doing when the interrupt it missed went off. That's
+ * one of the game_actions[], or one of the phases either side of them.
+ *
+ * They're in the trace area, in a block wonky_traces reads out of a
+ * snapshot. The counts are 16 bits and stick at their maximum.
+ */
+#if FRAME_STATS_TRACING
+
+#define FRAME_HISTOGRAM_SIZE     8
+
+#define FRAME_STATS_PHASE_SP1_UPDATE  (NUM_GAME_ACTIONS+0)
+#define FRAME_STATS_PHASE_INPUT       (NUM_GAME_ACTIONS+1)
+#define FRAME_STATS_PHASE_DRAW        (NUM_GAME_ACTIONS+2)
+#define FRAME_STATS_PHASES            (NUM_GAME_ACTIONS+3)
+#define FRAME_STATS_NO_OVERRUN        0xFF
+
+typedef struct _frame_stats
+{
+  uint16_t loops;
+  uint16_t overruns;
+  uint16_t frames_per_loop[FRAME_HISTOGRAM_SIZE];  /* 1, 2, ... frames, the last that many or more */
+  uint16_t level_overruns[NUM_LEVELS];             /* By level_num */
+  uint16_t phase_overruns[FRAME_STATS_PHASES];     /* By game_actions[] entry, then the phases above */
+} FRAME_STATS;
+
+FRAME_STATS*    frame_stats = TRACING_INACTIVE;
+
+static uint16_t stats_frame_start;
+static uint8_t  overrun_phase;
+
+void init_frame_stats(void)
+{
+  frame_stats = allocate_tracememory(sizeof(FRAME_STATS));
+  if( frame_stats != TRACING_INACTIVE )
+    memset( frame_stats, 0, sizeof(FRAME_STATS) );
+}
+
+#define COUNT_STAT(c) { if( (c) != 0xFFFF ) (c)++; }
+
+#define FRAME_STATS_START \
+{ \
+  stats_frame_start = GET_FRAME_TICKER; \
+  overrun_phase     = FRAME_STATS_NO_OVERRUN; \
+}
+
+/* The first phase to finish after the interrupt is the one it went off in */
+#define FRAME_STATS_CHECK(phase) \
+{ \
+  if( overrun_phase == FRAME_STATS_NO_OVERRUN && GET_FRAME_TICKER != stats_frame_start ) \
+    overrun_phase = (phase); \
+}
+
+/* Just after the halt, so the ticker's moved on once for a frame which wasn't missed */
+static void frame_stats_end_loop( uint8_t level_num )
+{
+  uint16_t frames = GET_FRAME_TICKER - stats_frame_start;
+
+  if( frame_stats != TRACING_INACTIVE ) {
+    if( frames > FRAME_HISTOGRAM_SIZE )
+      frames = FRAME_HISTOGRAM_SIZE;
+
+    COUNT_STAT( frame_stats->loops );
+    COUNT_STAT( frame_stats->frames_per_loop[frames-1] );
+
+    if( frames != 1 ) {
+      COUNT_STAT( frame_stats->overruns );
+      if( level_num < NUM_LEVELS )
+        COUNT_STAT( frame_stats->level_overruns[level_num] );
+      if( overrun_phase != FRAME_STATS_NO_OVERRUN )
+        COUNT_STAT( frame_stats->phase_overruns[overrun_phase] );
+    }
+  }
+
+  FRAME_STATS_START;
+}
+
+#else
+
+#define FRAME_STATS_START
+#define FRAME_STATS_CHECK(phase)
+#define frame_stats_end_loop(level_num)
+
+#endif
 
 
 void finish_level(void)
 {
-  play_beepfx_sound_immediate(BEEPFX_SELECT_6);
+  start_sound_effect(EFFECT_FINISH);
 }
 
 void countdown_expired(void)
 {
-  play_beepfx_sound_immediate(BEEPFX_POWER_OFF);
+  start_sound_effect(EFFECT_LOSE);
 }
 
 
@@ -249,9 +408,19 @@ void countdown_expired(void)
  *                                                                          | |    
  *                                                                          |_|    
  */
+#if RASTER_PROFILE
+uint16_t raster_overruns = 0;
+#endif
+
 LEVEL_COMPLETION_TYPE gameloop( GAME_STATE* game_state )
 {
   uint8_t action_iter;
+  uint8_t actions_ready;
+#if RASTER_PROFILE
+  uint16_t frame_start;
+#endif
+
+  CLEAR_DISPATCH_COUNTS;
 
   /*
    * Bonuses are drawn once. It's not possible for them to be
@@ -259,10 +428,17 @@ LEVEL_COMPLETION_TYPE gameloop( GAME_STATE* game_state )
    */
   draw_bonuses( &(game_state->current_level->score_screen_data) );
 
+  RASTER_FRAME_START( frame_start );
+  FRAME_STATS_START;
+
   while(1) {
 
-    /* Check for user input, every cycle */
-    if( in_key_pressed( IN_KEY_SCANCODE_SPACE ) ) {
+    FRAME_STATS_CHECK( FRAME_STATS_PHASE_SP1_UPDATE );
+    RASTER_PHASE( RASTER_INPUT );
+
+    /* Check for user input, every cycle. Replaying, it comes from the input log. */
+    INPUT_LOG_START_PASS;
+    if( CONTROL_KEY_PRESSED ) {
 
       /*
        * Ew, yikes, this is a crude hack forced by the last minute
@@ -275,7 +451,9 @@ LEVEL_COMPLETION_TYPE gameloop( GAME_STATE* game_state )
        * not worth the churn.
        */
       if( game_state->current_level->level_num == 0 ) {
+        INPUT_LOG_END_PASS;
         finish_level();
+        trace_dispatch_counts();
         return LEVEL_COMPLETE;
       }
 
@@ -286,20 +464,45 @@ LEVEL_COMPLETION_TYPE gameloop( GAME_STATE* game_state )
       game_state->key_processed = 0;
     }
 
-    if( in_key_pressed( IN_KEY_SCANCODE_m ) ) {
-      while( in_key_pressed( IN_KEY_SCANCODE_m ) );
+    if( MUSIC_KEY_PRESSED ) {
+      WAIT_KEY_RELEASED( IN_KEY_SCANCODE_m );
       toggle_music();
     }
 
-    if( in_key_pressed( IN_KEY_SCANCODE_s ) ) {
-      while( in_key_pressed( IN_KEY_SCANCODE_s ) );
+    if( SOUND_KEY_PRESSED ) {
+      WAIT_KEY_RELEASED( IN_KEY_SCANCODE_s );
       toggle_sound_effects();
     }
 
+    /*
+     * The input log times each pass here, before the ISR's events are
+     * taken, so a replay moves the game's timers on to the same place.
+     */
+    INPUT_LOG_END_PASS;
+
+    /*
+     * Take the events the ISR has flagged since last time round. Interrupts
+     * go off while it's done so one can't be set between the read and the
+     * clear and get lost. The gameplay bits are only changed by this code so
+     * they're simply merged in.
+     */
+    intrinsic_di();
+    actions_ready = interrupt_actions_ready;
+    interrupt_actions_ready = 0;
+    intrinsic_ei();
+    actions_ready |= game_actions_ready;
+
+    FRAME_STATS_CHECK( FRAME_STATS_PHASE_INPUT );
+
     for( action_iter=0; action_iter < NUM_GAME_ACTIONS; action_iter++ ) {
       PROCESSING_FLAG flag;
       GAME_ACTION     required_action;
 
+      /* Event driven actions with nothing to do aren't called at all */
+      if( (game_actions[action_iter].ready_bit != ALWAYS_READY) &&
+          !(actions_ready & game_actions[action_iter].ready_bit) )
+        continue;
+
       if( (GET_RUNNER_SLOWDOWN == SLOWDOWN_ACTIVE) && (game_actions[action_iter].slowdown_flag == SLOW_WHEN_SLOWDOWN) && (GET_TICKER & 1) )
       {
         /*
@@ -312,7 +515,10 @@ LEVEL_COMPLETION_TYPE gameloop( GAME_STATE* game_state )
       else
       {
         /* Otherwise, run the function from the game actions list */
+        RASTER_ACTION( action_iter );
         flag = (game_actions[action_iter].test_action)(game_state, &required_action);
+        COUNT_DISPATCH(action_iter);
+        FRAME_STATS_CHECK( action_iter );
       }
 
       if( required_action != NO_ACTION ) {
@@ -332,7 +538,7 @@ LEVEL_COMPLETION_TYPE gameloop( GAME_STATE* game_state )
           break;
 
         case BOUNCE_OFF_WALL:
-          queue_beepfx_sound(BEEPFX_PICK);
+          start_sound_effect(EFFECT_BOUNCE);
           toggle_runner_direction();
           break;
 
@@ -345,8 +551,9 @@ LEVEL_COMPLETION_TYPE gameloop( GAME_STATE* game_state )
           break;
 
         case JUMP:
-          queue_beepfx_sound(BEEPFX_SHOT_1);
+          start_sound_effect(EFFECT_JUMP);
           start_runner_jumping();
+          look_up_jump_safe( game_state->current_level->level_num );
           break;
 
         case STOP_JUMP:
@@ -371,13 +578,18 @@ LEVEL_COMPLETION_TYPE gameloop( GAME_STATE* game_state )
 
         case FINISH:
           finish_level();
+          trace_dispatch_counts();
           return LEVEL_COMPLETE;
 
         case LOSE:
         case COUNTDOWN_EXPIRED:
           countdown_expired();
+          trace_dispatch_counts();
           return GAME_COMPLETE_LOSER;
 
+        case NO_ACTION:
+        case OPEN_DOOR:
+        case CLOSE_DOOR:
         case SKIP_CYCLE:
           break;
         }
@@ -386,51 +598,21 @@ LEVEL_COMPLETION_TYPE gameloop( GAME_STATE* game_state )
         break;
     }
 
+    RASTER_PHASE( RASTER_DRAW_RUNNER );
     draw_runner();
-    update_countdown_slider( &(game_state->current_level->score_screen_data) );
-    
-    /*
-     * If the level has teleporters the cells they occupy are validated so
-     * the runner doesn't get redrawn when he moves "onto" one. The effect
-     * is for him to move "into" it which is what I want.
-     *
-     * This invalidation has to be done here each time round the loop because
-     * when the runner sprite gets close the process of drawing him invalidates
-     * the cell the teleporter is on, so the cell gets redrawn as runner sprite
-     * but no teleporter. Specifically revalidating the teleporters ensures
-     * they always appear even at the "cost" of not drawing the runner.
-     *
-     * This has to be done after the runner is redrawn, so it can't be in the
-     * sequence of game actions.
-     */
-    if( game_state->current_level->teleporters )
-    {
-      TELEPORTER_DEFINITION* teleporter = game_state->current_level->teleporters;
-
-      while( teleporter->end_1_x || teleporter->end_1_y ) {
-        /*
-         * There doesn't appear to be an SP1 interface to validate a
-         * single tile. Use a 1x1 rectangle instead.
-         */
-        struct sp1_Rect validate_cell = {teleporter->end_1_y_cell, teleporter->end_1_x_cell, 1, 1};
-        sp1_Validate(&validate_cell);
-
-        validate_cell.row = teleporter->end_2_y_cell;
-        validate_cell.col = teleporter->end_2_x_cell;
-        sp1_Validate(&validate_cell);
 
-        teleporter++;
-      }
-    }
+    RASTER_PHASE( RASTER_HUD );
+    update_countdown_slider( &(game_state->current_level->score_screen_data) );
 
-    if( game_state->current_level->doors )
-    {
-      validate_door_cells( game_state->current_level->doors );
-    }
+    FRAME_STATS_CHECK( FRAME_STATS_PHASE_DRAW );
 
     /* Halt to lock the game to 50fps, then update everything */
+    RASTER_HALT_START( frame_start );
     intrinsic_halt();
+    RASTER_FRAME_START( frame_start );
+    frame_stats_end_loop( game_state->current_level->level_num );
 
+    RASTER_PHASE( RASTER_SP1_UPDATE );
     sp1_UpdateNow();
   }
 }
@@ -21,11 +21,25 @@
 #define __GAMELOOP_H
 
 #include "game_state.h"
+#include "tracetable.h"
 
 /*
  * Initialise trace table for gameloop
  */
+#if GAMELOOP_TRACING
 void init_gameloop_trace(void);
+#else
+#define init_gameloop_trace()
+#endif
+
+/*
+ * Initialise the missed frame counters, see gameloop.c
+ */
+#if FRAME_STATS_TRACING
+void init_frame_stats(void);
+#else
+#define init_frame_stats()
+#endif
 
 /*
  * This function is the main game loop. It exits when the player completes the level.
@@ -25,5 +25,20 @@
  */
 extern struct sp1_Rect full_screen;
 
+/*
+ * Sprites are drawn from frames pre-shifted by preshift_sprites.pl with
+ * SP1's non-rotating draw functions. A frame is two columns of 16 bytes,
+ * the second of which is PRESHIFTED_COLUMN_1 bytes into it. The frame
+ * for a sprite at pixel x is the (x&7)th in its block.
+ *
+ * This has to be a hard coded constant. The assembler can't export one
+ * the compiler sees, and a const variable compiles to a value held in
+ * memory. 32 compiles to 5 'add hl,hl' instructions.
+ */
+#define PRESHIFTED_FRAME_SIZE        (uint16_t)32
+#define PRESHIFTED_COLUMN_1          16
+
+#define PRESHIFTED_FRAME(block,x)    ((block)+(PRESHIFTED_FRAME_SIZE*((x)&0x07)))
+
 
 #endif
@@ -0,0 +1,102 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Wonky One Key, a ZX Spectrum game featuring a single control key
+# Copyright (C) 2018 Derek Fountain
+# 
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+# 
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+# Convert one of the game's z88dk data files (level maps, UDGs, sprite
+# graphics) into GNU assembler for the host build. The host build needs
+# exactly the same bytes at exactly the same labels, and the C code does
+# pointer arithmetic across labels (the runner animation frames are found
+# as offsets from the first one), so a byte-for-byte translation which
+# keeps everything contiguous is the simplest way to get it.
+#
+# Only the handful of directives the data files use are understood.
+# Anything else stops the build so it can't quietly go wrong.
+#
+#  asm_to_gas.pl levels_maps.asm > levels_maps.s
+
+use File::Basename;
+
+sub to_byte {
+  my ($value, $where) = @_;
+  my $byte;
+
+  if(    $value =~ /^@([01]+)$/ )            { $byte = oct("0b$1"); }
+  elsif( $value =~ /^(?:0x|\$)([0-9a-f]+)$/i ) { $byte = hex($1); }
+  elsif( $value =~ /^(\d+)$/ )               { $byte = $1; }
+  else { die "$where: can't convert value '$value'\n"; }
+
+  die "$where: value '$value' isn't a byte\n" if $byte > 255;
+  return $byte;
+}
+
+sub convert {
+  my ($file) = @_;
+  my $dir = dirname($file);
+
+  open( my $fh, '<', $file ) or die "Can't open $file: $!\n";
+
+  while( my $line = <$fh> ) {
+    my $where = "$file:$.";
+
+    $line =~ s/\r?\n$//;
+
+    # Strings are the only place a ; can legitimately appear
+    if( $line =~ /^\s*defm\s+"([^"]*)"/i ) {
+      my $string = $1;
+      $string =~ s/\\/\\\\/g;
+      print "\t.ascii \"$string\"\n";
+      next;
+    }
+
+    $line =~ s/;.*//;
+    next if $line =~ /^\s*$/;
+
+    if( $line =~ /^\s*(SECTION|ORG)\b/i ) {
+      # Placement in Spectrum memory doesn't mean anything here
+    }
+    elsif( $line =~ /^\s*PUBLIC\s+_(\w+)\s*$/i ) {
+      print "\t.globl $1\n";
+    }
+    elsif( $line =~ /^\s*\._(\w+)\s*$/ || $line =~ /^\s*_(\w+):\s*$/ ) {
+      print "$1:\n";
+    }
+    elsif( $line =~ /^\s*INCLUDE\s+"([^"]+)"\s*$/i ) {
+      convert( "$dir/$1" );
+    }
+    elsif( $line =~ /^\s*BINARY\s+"([^"]+)"\s*$/i ) {
+      print "\t.incbin \"$dir/$1\"\n";
+    }
+    elsif( $line =~ /^\s*defb\s+(.*?)\s*$/i ) {
+      my @bytes = map { to_byte( $_, $where ) } split( /\s*,\s*/, $1 );
+      print "\t.byte ", join( ", ", @bytes ), "\n";
+    }
+    else {
+      die "$where: don't know how to convert '$line'\n";
+    }
+  }
+
+  close( $fh );
+}
+
+die "Usage: $0 file.asm\n" unless @ARGV == 1;
+
+print "# Generated from $ARGV[0] by $0, don't edit\n";
+print "\t.data\n";
+convert( $ARGV[0] );
+print "\t.section .note.GNU-stack,\"\",\@progbits\n";
@@ -0,0 +1,1088 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Fuzzer. Plays the levels with random key presses, and with changes
+ * to the runs which got the runner somewhere new, on all the cores,
+ * looking for the game going wrong:
+ *
+ *  stuck   the game's gone round in a loop which no press of the key
+ *          gets it out of, like the endless teleport which
+ *          just_teleported in key_action.c put right
+ *  bounds  the runner's gone off the edge of the map
+ *  wall    the runner's centre has gone into a solid cell. Some levels
+ *          start him in one, dropping in through the top, which is fine.
+ *  assert  a local_assert() failed; the fuzzer's built without NDEBUG
+ *  crash   the game code took a signal
+ *  hang    a pass of the game loop didn't come back
+ *
+ *  wonky_fuzzer [-j workers] [-l level] [-s seed] [-t seconds] [-f run_frames] [-o script_prefix] [-v]
+ *  wonky_fuzzer -l level -r key_script [-f run_frames]
+ *
+ * Each failure is cut down to as few presses, as short, as still make
+ * it happen, and printed. With -o it's written to <script_prefix><n>.keys,
+ * a key script which "wonky_host -v -l <level>" plays to it. A failure
+ * found again, in the same place, isn't reported again. It exits 1 if
+ * anything was found.
+ *
+ * With -r it plays just the key script, then the key left up to the end
+ * of the run, and checks it the same way. The failures which have been
+ * put right are kept like that in host/regressions, see the makefile's
+ * regressions target.
+ *
+ * A loop is noticed when the state, host_state_key() with every timer
+ * tick keyed, comes round again within MAX_LOOP_FRAMES with the key the
+ * same all the while. Running to and fro in a corridor does that, so
+ * it's only a failure if, from every frame of the loop, pressing the key
+ * (or letting it go, if it's held) leads back into the loop. The state
+ * doesn't include the countdown, so a game stuck like that ends when the
+ * countdown runs out.
+ *
+ * The workers are processes, as the solver's are, and each run starts
+ * by copying the level's start back over the game's image. The fuzzer's
+ * own variables are on the stack, in the heap or in the shared mapping
+ * so that doesn't touch them. The positions reached, the failures and
+ * the counts are shared. Each worker keeps its own collection of the
+ * runs which found new positions to make changes to.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <arch/zx.h>
+#include <arch/zx/sp1.h>
+
+#include "host.h"
+#include "../game_state.h"
+#include "../runner.h"
+#include "../levels.h"
+#include "../tile_map.h"
+#include "../countdown.h"
+#include "../input_log.h"
+#include "../local_assert.h"
+
+#if INPUT_LOG == INPUT_LOG_REPLAY
+#error "The fuzzer chooses the keys, it can't be built to replay an input log"
+#endif
+
+#ifdef NDEBUG
+#error "The fuzzer needs the game's local_assert()s, build it without NDEBUG"
+#endif
+
+/* These are in main.c in the Spectrum build */
+struct sp1_Rect full_screen = {0, 0, 32, 24};
+GAME_STATE      game_state;
+
+#define MAX_WORKERS          64
+#define DEFAULT_SECONDS      60
+#define DEFAULT_RUN_FRAMES   (60*50UL)
+#define MAX_RUN_FRAMES       (COUNTDOWN_START_SECS*50UL)
+
+/* Runs kept by each worker to make changes to */
+#define CORPUS_SIZE          256
+
+/* Longest loop looked for, and how long a press has to get out of it */
+#define MAX_LOOP_FRAMES      128
+#define ESCAPE_FRAMES        (2*MAX_LOOP_FRAMES)
+
+/* Loops found not to be stuck, remembered so they aren't tried again */
+#define CHECKED_LOOPS        4096
+
+#define MAX_FAILURES         256
+#define FAILURE_SLOTS        1024
+
+/* Runs spent cutting each failure down */
+#define MAX_REDUCE_RUNS      4000
+
+/* A pass, or a loop being tried, taking this long has hung */
+#define HANG_SECS            10
+
+/*
+ * Furthest top left the runner can be and still be on the map. He's
+ * narrower than a cell, and test_direction_blocked() bounces him off
+ * the right edge of the screen with a pixel to spare.
+ */
+#define MAX_RUNNER_X         (TILE_MAP_WIDTH*8-RUNNER_WIDTH-1)
+#define MAX_RUNNER_Y         ((TILE_MAP_HEIGHT-1)*8)
+
+#define IN_WALL(x,y)         (GET_TILE_AT_PIXEL( RUNNER_CENTRE_X(x), RUNNER_CENTRE_Y(y) ) == TILE_SOLID)
+
+typedef enum _failure_kind
+{
+  FAIL_NONE,
+  FAIL_STUCK,
+  FAIL_BOUNDS,
+  FAIL_WALL,
+  FAIL_ASSERT,
+  FAIL_CRASH,
+  FAIL_HANG,
+} FAILURE_KIND;
+
+static const char* const failure_names[] = {
+  "none", "stuck", "bounds", "wall", "assert", "crash", "hang"
+};
+
+typedef struct _failure
+{
+  FAILURE_KIND kind;
+  uint8_t      level;
+  uint32_t     frame;
+  uint8_t      x;
+  uint8_t      y;
+  uint64_t     where;     /* The loop, or the address of the assert or fault */
+} FAILURE;
+
+
+/***
+ *       _____ _                     _
+ *      / ____| |                   | |
+ *     | (___ | |__   __ _ _ __ ___ | |
+ *      \___ \| '_ \ / _` | '__/ _ \| |
+ *      ____) | | | | (_| | | |  __/|_|
+ *     |_____/|_| |_|\__,_|_|  \___|(_)
+ *
+ * Everything the workers share, in memory mapped before they fork.
+ */
+
+typedef struct _fuzzer
+{
+  uint32_t    workers;
+  uint8_t     only_level;
+  uint32_t    run_frames;
+  uint64_t    seed;
+  time_t      stop_time;
+  const char* script_prefix;
+  const char* replay_script;
+  int         verbose;
+
+  /* A bit for each x,y the runner's been at, by level */
+  uint8_t     positions[NUM_LEVELS][256*256/8];
+  uint32_t    num_positions[NUM_LEVELS];
+
+  /* Failures reported, and what they were, so each is only reported once */
+  uint64_t    failure_seen[FAILURE_SLOTS];
+  FAILURE     failures[MAX_FAILURES];
+  uint32_t    num_failures;
+  uint32_t    repeats;
+
+  uint64_t    runs;
+  uint64_t    passes;
+  uint64_t    completions;
+} FUZZER;
+
+static void* map_shared( size_t size )
+{
+  void* mem = mmap( NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0 );
+
+  if( mem == MAP_FAILED )
+  {
+    perror( "mmap" );
+    exit( 2 );
+  }
+  return mem;
+}
+
+/* Answers 1 if the x,y hadn't been reached on the level before */
+static int mark_position( FUZZER* f, uint8_t level, uint8_t x, uint8_t y )
+{
+  uint16_t bit  = (y << 8) | x;
+  uint8_t  mask = 1 << (bit & 7);
+
+  if( __atomic_load_n( &f->positions[level][bit >> 3], __ATOMIC_RELAXED ) & mask )
+    return 0;
+  if( __atomic_fetch_or( &f->positions[level][bit >> 3], mask, __ATOMIC_RELAXED ) & mask )
+    return 0;
+
+  __atomic_add_fetch( &f->num_positions[level], 1, __ATOMIC_RELAXED );
+  return 1;
+}
+
+/*
+ * Answers 1 if the failure hasn't been found before. It's known by its
+ * kind and level and where it was: the loop, the address, or failing
+ * those the runner's position.
+ */
+static int new_failure( FUZZER* f, const FAILURE* failure )
+{
+  uint64_t signature = ((uint64_t)failure->kind << 56) ^ ((uint64_t)failure->level << 48) ^
+                       (failure->where ? failure->where : (uint64_t)(failure->x << 8 | failure->y));
+  uint32_t slot;
+
+  if( signature == 0 )
+    signature = 1;
+
+  for( slot = signature % FAILURE_SLOTS; ; slot = (slot+1) % FAILURE_SLOTS )
+  {
+    uint64_t seen = __atomic_load_n( &f->failure_seen[slot], __ATOMIC_ACQUIRE );
+
+    if( seen == 0 &&
+        __atomic_compare_exchange_n( &f->failure_seen[slot], &seen, signature, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+      return 1;
+    if( seen == signature )
+      return 0;
+  }
+}
+
+
+/***
+ *      _____  _
+ *     |  __ \| |
+ *     | |__) | | __ _ _   _
+ *     |  ___/| |/ _` | | | |
+ *     | |    | | (_| | |_| |
+ *     |_|    |_|\__,_|\__, |
+ *                      __/ |
+ *                     |___/
+ */
+
+typedef struct _corpus_entry
+{
+  uint8_t  level;
+  uint32_t frames;
+  uint8_t* keys;
+} CORPUS_ENTRY;
+
+/* A worker's own state, on its heap */
+typedef struct _worker
+{
+  FUZZER*      f;
+  uint32_t     id;
+  uint64_t     random;
+
+  uint64_t*    image;
+  size_t       image_words;
+  uint64_t*    level_start[NUM_LEVELS];
+  uint64_t*    loop_start;
+
+  /* The run being played, a key a frame, and a cut down copy being tried */
+  uint8_t*     keys;
+  uint8_t*     trial;
+
+  CORPUS_ENTRY corpus[CORPUS_SIZE];
+  uint32_t     corpus_count;
+
+  /* State hashes since the key last changed, a ring */
+  uint64_t     loop[MAX_LOOP_FRAMES];
+  uint32_t     loop_count;
+
+  uint64_t     checked[CHECKED_LOOPS];
+  uint32_t     num_checked;
+
+  sigjmp_buf   fail_jmp;
+  FAILURE      failure;
+  uint32_t     new_positions;
+
+  uint64_t     runs;
+  uint64_t     passes;
+  uint64_t     completions;
+} WORKER;
+
+/*
+ * The worker, for the signal handlers and local_assert_bp(). It's set
+ * before the level starts are saved, so it's put back as it was.
+ */
+static WORKER* worker_running;
+
+static void failure_signal( int sig, siginfo_t* info, void* context )
+{
+  (void)context;
+
+  worker_running->failure.where = (sig == SIGALRM) ? 0 : (uintptr_t)info->si_addr;
+  siglongjmp( worker_running->fail_jmp, (sig == SIGALRM) ? FAIL_HANG : FAIL_CRASH );
+}
+
+/* The game's assert, see local_assert.c, which isn't built in here */
+void local_assert_bp(void)
+{
+  worker_running->failure.where = (uintptr_t)__builtin_return_address( 0 );
+  siglongjmp( worker_running->fail_jmp, FAIL_ASSERT );
+}
+
+/* xorshift64* */
+static uint32_t random_number( WORKER* w, uint32_t range )
+{
+  w->random ^= w->random >> 12;
+  w->random ^= w->random << 25;
+  w->random ^= w->random >> 27;
+
+  return (uint32_t)((w->random * 0x2545F4914F6CDD1DULL) >> 32) % range;
+}
+
+static uint64_t hash_state( void )
+{
+  uint8_t  key[HOST_STATE_KEY_SIZE];
+  size_t   length = host_state_key( key, HOST_EXACT_TIMERS );
+  uint64_t hash   = 0xCBF29CE484222325ULL;
+  size_t   i;
+
+  for( i = 0; i < length; i++ )
+    hash = (hash ^ key[i]) * 0x100000001B3ULL;
+  return hash;
+}
+
+/*
+ * Notes the state and answers the length of the loop it closes, or 0.
+ * A loop's known by the smallest state hash in it, whichever frame of
+ * it was noticed first.
+ */
+static uint32_t loop_length( WORKER* w, uint64_t hash, uint64_t* loop_id )
+{
+  uint32_t looked = w->loop_count < MAX_LOOP_FRAMES ? w->loop_count : MAX_LOOP_FRAMES;
+  uint32_t length;
+
+  for( length = 1; length <= looked; length++ )
+  {
+    if( w->loop[(w->loop_count - length) % MAX_LOOP_FRAMES] == hash )
+    {
+      uint32_t i;
+
+      *loop_id = hash;
+      for( i = 1; i < length; i++ )
+      {
+        uint64_t h = w->loop[(w->loop_count - i) % MAX_LOOP_FRAMES];
+
+        if( h < *loop_id )
+          *loop_id = h;
+      }
+      break;
+    }
+  }
+
+  w->loop[w->loop_count++ % MAX_LOOP_FRAMES] = hash;
+  return length <= looked ? length : 0;
+}
+
+static int loop_checked( WORKER* w, uint64_t loop_id )
+{
+  uint32_t i;
+
+  for( i = 0; i < w->num_checked; i++ )
+  {
+    if( w->checked[i] == loop_id )
+      return 1;
+  }
+  return 0;
+}
+
+static int in_loop( const WORKER* w, uint32_t length, uint64_t hash )
+{
+  uint32_t i;
+
+  for( i = 1; i <= length; i++ )
+  {
+    if( w->loop[(w->loop_count - i) % MAX_LOOP_FRAMES] == hash )
+      return 1;
+  }
+  return 0;
+}
+
+/*
+ * The game's back where it was length frames ago, with the key as it's
+ * been. Try the other key on each frame of the loop in turn, then carry
+ * on as before, and see whether that gets out of the loop. The countdown
+ * is filled up for it so it doesn't run out instead, and the game's
+ * put back as it was after.
+ */
+static int loop_stuck( WORKER* w, uint8_t key, uint32_t length )
+{
+  uint32_t phase;
+  int      stuck = 1;
+
+  memcpy( w->loop_start, w->image, w->image_words*sizeof(uint64_t) );
+  alarm( HANG_SECS );
+
+  for( phase = 0; phase < length && stuck; phase++ )
+  {
+    uint32_t i;
+    int      result = HOST_PASS_HALTED;
+    int      back   = 0;
+
+    memcpy( w->image, w->loop_start, w->image_words*sizeof(uint64_t) );
+    SET_GAME_COUNTDOWN( COUNTDOWN_START_SECS );
+
+    for( i = 0; i < phase && result == HOST_PASS_HALTED; i++ )
+      result = host_run_pass( key );
+
+    if( result == HOST_PASS_HALTED )
+      result = host_run_pass( !key );
+
+    for( i = 0; i < ESCAPE_FRAMES && result == HOST_PASS_HALTED && !back; i++ )
+    {
+      if( in_loop( w, length, hash_state() ) )
+        back = 1;
+      else
+        result = host_run_pass( key );
+    }
+    w->passes += phase + 1 + i;
+
+    if( !back )
+      stuck = 0;
+  }
+
+  memcpy( w->image, w->loop_start, w->image_words*sizeof(uint64_t) );
+  alarm( HANG_SECS );
+  return stuck;
+}
+
+/*
+ * Play the run from the level's start. Answers what went wrong, with
+ * the details in w->failure, or FAIL_NONE if it finished, ran out of
+ * countdown, or ran out of keys. The new positions reached are counted
+ * when asked for.
+ */
+static FAILURE_KIND play( WORKER* w, uint8_t level, const uint8_t* keys, uint32_t frames, int count_positions )
+{
+  FAILURE_KIND kind;
+  uint32_t     frame;
+  int          in_wall;
+
+  memcpy( w->image, w->level_start[level], w->image_words*sizeof(uint64_t) );
+  w->loop_count      = 0;
+  w->new_positions   = 0;
+  w->failure.level   = level;
+  w->failure.where   = 0;
+  w->runs++;
+
+  alarm( HANG_SECS );
+  if( (kind = sigsetjmp( w->fail_jmp, 1 )) != FAIL_NONE )
+  {
+    alarm( 0 );
+    w->failure.kind  = kind;
+    w->failure.frame = host_frame;
+    w->failure.x     = GET_RUNNER_XPOS;
+    w->failure.y     = GET_RUNNER_YPOS;
+    return kind;
+  }
+
+  in_wall = IN_WALL( GET_RUNNER_XPOS, GET_RUNNER_YPOS );
+
+  /* Each pass halts once, so the pass is the frame */
+  for( frame = 0; frame < frames; frame++ )
+  {
+    int      result = host_run_pass( keys[frame] );
+    uint8_t  x;
+    uint8_t  y;
+    uint32_t length;
+    uint64_t loop_id;
+
+    w->passes++;
+    if( result != HOST_PASS_HALTED )
+    {
+      if( result == LEVEL_COMPLETE )
+        w->completions++;
+      break;
+    }
+
+    x = GET_RUNNER_XPOS;
+    y = GET_RUNNER_YPOS;
+
+    if( x > MAX_RUNNER_X || y > MAX_RUNNER_Y )
+      siglongjmp( w->fail_jmp, FAIL_BOUNDS );
+
+    if( IN_WALL( x, y ) )
+    {
+      if( !in_wall )
+        siglongjmp( w->fail_jmp, FAIL_WALL );
+    }
+    else
+      in_wall = 0;
+
+    if( count_positions )
+      w->new_positions += mark_position( w->f, level, x, y );
+
+    if( frame > 0 && keys[frame] != keys[frame-1] )
+      w->loop_count = 0;
+
+    if( (length = loop_length( w, hash_state(), &loop_id )) != 0 && !loop_checked( w, loop_id ) )
+    {
+      if( loop_stuck( w, keys[frame], length ) )
+      {
+        w->failure.where = loop_id;
+        siglongjmp( w->fail_jmp, FAIL_STUCK );
+      }
+
+      /* It can be got out of. Forget them all when the list's full. */
+      if( w->num_checked == CHECKED_LOOPS )
+        w->num_checked = 0;
+      w->checked[w->num_checked++] = loop_id;
+    }
+  }
+
+  alarm( 0 );
+  return FAIL_NONE;
+}
+
+
+/***
+ *      _____
+ *     |  __ \
+ *     | |__) |   _ _ __  ___
+ *     |  _  / | | | '_ \/ __|
+ *     | | \ \ |_| | | | \__ \
+ *     |_|  \_\__,_|_| |_|___/
+ */
+
+/* Fill in the keys from the given frame: presses of various lengths, with gaps between */
+static void random_presses( WORKER* w, uint8_t* keys, uint32_t from, uint32_t frames )
+{
+  uint32_t f = from;
+
+  memset( keys+from, 0, frames-from );
+  for( ;; )
+  {
+    uint32_t held = random_number( w, 5 ) ? 1 + random_number( w, 2 ) : 3 + random_number( w, 40 );
+
+    f += 1 + random_number( w, random_number( w, 4 ) ? 50 : 300 );
+    if( f >= frames )
+      break;
+    while( held-- && f < frames )
+      keys[f++] = 1;
+  }
+}
+
+/* Keys f to the end of the next press, or of the gap if it's in one */
+static uint32_t run_end( const uint8_t* keys, uint32_t f, uint32_t frames )
+{
+  uint8_t key = keys[f];
+
+  while( f < frames && keys[f] == key )
+    f++;
+  return f;
+}
+
+/*
+ * A change to a run from the collection: a press moved, lengthened,
+ * dropped or added, or a new ending, or the start of another run of the
+ * same level.
+ */
+static void mutate( WORKER* w, uint8_t* keys, uint32_t frames )
+{
+  uint32_t changes = 1 + random_number( w, 4 );
+
+  while( changes-- )
+  {
+    uint32_t f = random_number( w, frames );
+    uint32_t end;
+
+    switch( random_number( w, 6 ) )
+    {
+    case 0:  /* Flip a few frames */
+      for( end = f + 1 + random_number( w, 8 ); f < end && f < frames; f++ )
+        keys[f] = !keys[f];
+      break;
+
+    case 1:  /* Drop a press, or fill a gap */
+      memset( keys+f, !keys[f], run_end( keys, f, frames ) - f );
+      break;
+
+    case 2:  /* Start a press a frame earlier or later */
+      end = run_end( keys, f, frames );
+      if( end < frames )
+        keys[end] = keys[f];
+      else if( f > 0 )
+        keys[f-1] = !keys[f-1];
+      break;
+
+    case 3:  /* A new ending */
+      random_presses( w, keys, f, frames );
+      break;
+
+    case 4:  /* Another run's ending */
+      {
+        const CORPUS_ENTRY* other = &w->corpus[random_number( w, w->corpus_count )];
+
+        if( f < other->frames )
+          memcpy( keys+f, other->keys+f, (other->frames < frames ? other->frames : frames) - f );
+      }
+      break;
+
+    default: /* A single frame press */
+      keys[f] = 1;
+      if( f+1 < frames )
+        keys[f+1] = 0;
+      break;
+    }
+  }
+}
+
+/*
+ * The next run, in w->keys. Usually it's a change to one which found
+ * somewhere new, else it's a new random one.
+ */
+static uint8_t next_run( WORKER* w )
+{
+  FUZZER* f = w->f;
+  uint8_t level;
+
+  if( w->corpus_count && random_number( w, 4 ) )
+  {
+    const CORPUS_ENTRY* entry = &w->corpus[random_number( w, w->corpus_count )];
+
+    level = entry->level;
+    memcpy( w->keys, entry->keys, f->run_frames );
+    mutate( w, w->keys, f->run_frames );
+  }
+  else
+  {
+    level = f->only_level ? f->only_level : 1 + random_number( w, NUM_LEVELS-1 );
+    random_presses( w, w->keys, 0, f->run_frames );
+  }
+
+  return level;
+}
+
+/* Keep the run, in place of a random one when the collection's full */
+static void keep_run( WORKER* w, uint8_t level )
+{
+  CORPUS_ENTRY* entry;
+
+  if( w->corpus_count < CORPUS_SIZE )
+    entry = &w->corpus[w->corpus_count++];
+  else
+    entry = &w->corpus[random_number( w, CORPUS_SIZE )];
+
+  entry->level  = level;
+  entry->frames = w->f->run_frames;
+  memcpy( entry->keys, w->keys, w->f->run_frames );
+}
+
+
+/***
+ *      ______    _ _
+ *     |  ____|  (_) |
+ *     | |__ __ _ _| |_   _ _ __ ___  ___
+ *     |  __/ _` | | | | | | '__/ _ \/ __|
+ *     | | | (_| | | | |_| | | |  __/\__ \
+ *     |_|  \__,_|_|_|\__,_|_|  \___||___/
+ */
+
+/* Frame a press starts at, the nth one from the given frame */
+static uint32_t press_start( const uint8_t* keys, uint32_t frames, uint32_t n )
+{
+  uint32_t f;
+
+  for( f = 0; f < frames; f++ )
+  {
+    if( keys[f] && (f == 0 || !keys[f-1]) && n-- == 0 )
+      return f;
+  }
+  return frames;
+}
+
+static uint32_t count_presses( const uint8_t* keys, uint32_t frames )
+{
+  uint32_t n = 0;
+  uint32_t f;
+
+  for( f = 0; f < frames; f++ )
+  {
+    if( keys[f] && (f == 0 || !keys[f-1]) )
+      n++;
+  }
+  return n;
+}
+
+/*
+ * Try the cut down run in w->trial. If it still fails the same way it
+ * becomes the run, in w->keys, up to the frame it fails at.
+ */
+static int still_fails( WORKER* w, uint8_t level, uint32_t* frames, FAILURE* failure, uint32_t* runs )
+{
+  (*runs)++;
+  if( play( w, level, w->trial, *frames, 0 ) != failure->kind )
+    return 0;
+
+  *failure = w->failure;
+  *frames  = failure->frame+1 < *frames ? failure->frame+1 : *frames;
+  memcpy( w->keys, w->trial, *frames );
+  return 1;
+}
+
+/*
+ * Cut the failing run down. Presses are taken out, a half of them, then
+ * a quarter and so on down to one at a time, then the ones left are
+ * made as short as they can be. Only the frames up to the failure are
+ * kept.
+ */
+static uint32_t reduce( WORKER* w, uint8_t level, uint32_t frames, FAILURE* failure )
+{
+  uint32_t runs  = 0;
+  uint32_t chunk = (count_presses( w->keys, frames ) + 1) / 2;
+  uint32_t n;
+
+  frames = failure->frame+1 < frames ? failure->frame+1 : frames;
+
+  for( ; chunk > 0 && runs < MAX_REDUCE_RUNS; chunk /= 2 )
+  {
+    for( n = 0; n < count_presses( w->keys, frames ) && runs < MAX_REDUCE_RUNS; )
+    {
+      uint32_t i;
+
+      memcpy( w->trial, w->keys, frames );
+      for( i = 0; i < chunk; i++ )
+      {
+        uint32_t start = press_start( w->trial, frames, n );
+
+        if( start == frames )
+          break;
+        memset( w->trial+start, 0, run_end( w->trial, start, frames ) - start );
+      }
+
+      if( !still_fails( w, level, &frames, failure, &runs ) )
+        n += chunk;
+    }
+  }
+
+  for( n = 0; n < count_presses( w->keys, frames ) && runs < MAX_REDUCE_RUNS; n++ )
+  {
+    uint32_t start = press_start( w->keys, frames, n );
+    uint32_t end   = run_end( w->keys, start, frames );
+
+    while( end - start > 1 && runs < MAX_REDUCE_RUNS )
+    {
+      memcpy( w->trial, w->keys, frames );
+      memset( w->trial + start + (end-start)/2, 0, end - start - (end-start)/2 );
+      if( !still_fails( w, level, &frames, failure, &runs ) )
+        break;
+      end = run_end( w->keys, start, frames );
+    }
+  }
+
+  return frames;
+}
+
+/* The run as a key script, a line for each press, as the solver writes them */
+static int write_failure( const char* prefix, uint32_t number, const FAILURE* failure,
+                          const uint8_t* keys, uint32_t frames )
+{
+  char     filename[4096];
+  FILE*    fh;
+  uint32_t f;
+
+  snprintf( filename, sizeof(filename), "%s%u.keys", prefix, number );
+  if( (fh = fopen( filename, "w" )) == NULL )
+  {
+    perror( filename );
+    return 1;
+  }
+
+  fprintf( fh, "# %s on level %u at frame %u, x %u y %u, from %s\n",
+           failure_names[failure->kind], failure->level, failure->frame, failure->x, failure->y, "wonky_fuzzer" );
+  for( f = 0; f < frames; f++ )
+  {
+    uint32_t held = run_end( keys, f, frames ) - f;
+
+    if( keys[f] )
+      fprintf( fh, "%u %u\n", f, held );
+    f += held - 1;
+  }
+
+  fclose( fh );
+  return 0;
+}
+
+static void report( WORKER* w, uint8_t level )
+{
+  FUZZER*  f       = w->f;
+  FAILURE  failure = w->failure;
+  uint32_t frames;
+  uint32_t number;
+
+  if( !new_failure( f, &failure ) )
+  {
+    __atomic_add_fetch( &f->repeats, 1, __ATOMIC_RELAXED );
+    return;
+  }
+
+  frames = reduce( w, level, f->run_frames, &failure );
+  number = __atomic_fetch_add( &f->num_failures, 1, __ATOMIC_RELAXED );
+  if( number < MAX_FAILURES )
+    f->failures[number] = failure;
+
+  printf( "%s level %u frame %u x %u y %u presses %u",
+          failure_names[failure.kind], failure.level, failure.frame, failure.x, failure.y,
+          count_presses( w->keys, frames ) );
+  if( failure.kind == FAIL_ASSERT || failure.kind == FAIL_CRASH )
+    printf( " at %#lx", (unsigned long)failure.where );
+  if( f->script_prefix && write_failure( f->script_prefix, number, &failure, w->keys, frames ) == 0 )
+    printf( " in %s%u.keys", f->script_prefix, number );
+  printf( "\n" );
+  fflush( stdout );
+}
+
+/* A key script, as write_failure() writes them, into a key a frame */
+static int read_keys( const char* filename, uint8_t* keys, uint32_t frames )
+{
+  FILE*    fh;
+  char     line[128];
+  unsigned line_num = 0;
+
+  if( (fh = fopen( filename, "r" )) == NULL )
+  {
+    perror( filename );
+    return 1;
+  }
+
+  memset( keys, 0, frames );
+  while( fgets( line, sizeof(line), fh ) )
+  {
+    unsigned long start;
+    unsigned long held;
+    char          extra;
+
+    line_num++;
+
+    if( line[0] == '#' || sscanf( line, " %c", &extra ) != 1 )
+      continue;
+
+    if( sscanf( line, "%lu %lu %c", &start, &held, &extra ) != 2 || held == 0 || start+held > frames )
+    {
+      fprintf( stderr, "%s:%u: expected \"<start frame> <frames held>\" inside %u frames\n",
+               filename, line_num, frames );
+      fclose( fh );
+      return 1;
+    }
+    memset( keys+start, 1, held );
+  }
+
+  fclose( fh );
+  return 0;
+}
+
+/* The -r run, what it finds is reported as it is, without cutting it down */
+static void replay( WORKER* w, uint8_t level, const char* script )
+{
+  FUZZER* f = w->f;
+
+  if( read_keys( script, w->keys, f->run_frames ) != 0 )
+    exit( 2 );
+
+  if( play( w, level, w->keys, f->run_frames, 0 ) == FAIL_NONE )
+    return;
+
+  f->failures[0]   = w->failure;
+  f->num_failures  = 1;
+
+  printf( "%s level %u frame %u x %u y %u in %s\n", failure_names[w->failure.kind],
+          w->failure.level, w->failure.frame, w->failure.x, w->failure.y, script );
+  fflush( stdout );
+}
+
+static void worker( FUZZER* f, uint32_t id )
+{
+  WORKER*          w = calloc( 1, sizeof(WORKER) );
+  uint64_t*        setup;
+  struct sigaction action;
+  uint8_t          level;
+  uint32_t         i;
+
+  if( w == NULL || (w->image = host_game_image( &w->image_words )) == NULL )
+    exit( 2 );
+
+  w->f      = f;
+  w->id     = id;
+  w->random = (f->seed + id) * 0x9E3779B97F4A7C15ULL | 1;
+
+  memset( &action, 0, sizeof(action) );
+  action.sa_sigaction = failure_signal;
+  action.sa_flags     = SA_SIGINFO | SA_NODEFER;
+  sigaction( SIGSEGV, &action, NULL );
+  sigaction( SIGBUS,  &action, NULL );
+  sigaction( SIGFPE,  &action, NULL );
+  sigaction( SIGALRM, &action, NULL );
+
+  worker_running = w;
+
+  /* Each level's start, from the game as it's set up */
+  setup = malloc( w->image_words*sizeof(uint64_t) );
+  w->loop_start = malloc( w->image_words*sizeof(uint64_t) );
+  w->keys       = malloc( f->run_frames );
+  w->trial      = malloc( f->run_frames );
+  if( setup == NULL || w->loop_start == NULL || w->keys == NULL || w->trial == NULL )
+    exit( 2 );
+
+  memcpy( setup, w->image, w->image_words*sizeof(uint64_t) );
+  for( level = 1; level < NUM_LEVELS; level++ )
+  {
+    if( (w->level_start[level] = malloc( w->image_words*sizeof(uint64_t) )) == NULL )
+      exit( 2 );
+
+    memcpy( w->image, setup, w->image_words*sizeof(uint64_t) );
+    host_start_level( level );
+    memcpy( w->level_start[level], w->image, w->image_words*sizeof(uint64_t) );
+  }
+  free( setup );
+
+  for( i = 0; i < CORPUS_SIZE; i++ )
+  {
+    if( (w->corpus[i].keys = malloc( f->run_frames )) == NULL )
+      exit( 2 );
+  }
+
+  if( f->replay_script )
+    replay( w, f->only_level, f->replay_script );
+
+  while( !f->replay_script && time( NULL ) < f->stop_time )
+  {
+    level = next_run( w );
+
+    if( play( w, level, w->keys, f->run_frames, 1 ) != FAIL_NONE )
+      report( w, level );
+    else if( w->new_positions )
+      keep_run( w, level );
+  }
+
+  __atomic_add_fetch( &f->runs, w->runs, __ATOMIC_RELAXED );
+  __atomic_add_fetch( &f->passes, w->passes, __ATOMIC_RELAXED );
+  __atomic_add_fetch( &f->completions, w->completions, __ATOMIC_RELAXED );
+}
+
+
+/***
+ *      __  __       _
+ *     |  \/  |     (_)
+ *     | \  / | __ _ _ _ __
+ *     | |\/| |/ _` | | '_ \
+ *     | |  | | (_| | | | | |
+ *     |_|  |_|\__,_|_|_| |_|
+ */
+
+static void usage( const char* name )
+{
+  fprintf( stderr, "Usage: %s [-j workers] [-l level] [-s seed] [-t seconds] [-f run_frames] [-o script_prefix] [-v]\n"
+                   "       %s -l level -r key_script [-f run_frames]\n", name, name );
+  exit( 1 );
+}
+
+int main( int argc, char* argv[] )
+{
+  unsigned long workers       = sysconf( _SC_NPROCESSORS_ONLN );
+  unsigned long only_level    = 0;
+  unsigned long seed          = time( NULL );
+  unsigned long seconds       = DEFAULT_SECONDS;
+  unsigned long run_frames    = DEFAULT_RUN_FRAMES;
+  const char*   script_prefix = NULL;
+  const char*   replay_script = NULL;
+  int           verbose       = 0;
+  int           failed        = 0;
+  int           opt;
+  pid_t         pids[MAX_WORKERS];
+  time_t        start;
+  FUZZER*       f;
+  uint32_t      w;
+  uint8_t       level;
+
+  while( (opt = getopt( argc, argv, "j:l:s:t:f:o:r:v" )) != -1 )
+  {
+    switch( opt )
+    {
+    case 'j': workers = strtoul( optarg, NULL, 0 );    break;
+    case 'l': only_level = strtoul( optarg, NULL, 0 ); break;
+    case 's': seed = strtoul( optarg, NULL, 0 );       break;
+    case 't': seconds = strtoul( optarg, NULL, 0 );    break;
+    case 'f': run_frames = strtoul( optarg, NULL, 0 ); break;
+    case 'o': script_prefix = optarg;                  break;
+    case 'r': replay_script = optarg;                  break;
+    case 'v': verbose = 1;                             break;
+    default:  usage( argv[0] );
+    }
+  }
+
+  if( optind != argc || workers == 0 || workers > MAX_WORKERS || only_level >= NUM_LEVELS ||
+      seconds == 0 || run_frames < 2 || run_frames > MAX_RUN_FRAMES )
+    usage( argv[0] );
+
+  /* A script's for one level, and one worker plays it */
+  if( replay_script )
+  {
+    if( only_level == 0 )
+      usage( argv[0] );
+    workers = 1;
+  }
+
+  f = map_shared( sizeof(FUZZER) );
+  f->workers       = workers;
+  f->only_level    = only_level;
+  f->run_frames    = run_frames;
+  f->seed          = seed;
+  f->script_prefix = script_prefix;
+  f->replay_script = replay_script;
+  f->verbose       = verbose;
+
+  host_setup_game();
+
+  if( verbose )
+    printf( "seed %lu, %lu workers\n", seed, workers );
+
+  start = time( NULL );
+  f->stop_time = start + seconds;
+
+  fflush( stdout );
+  for( w = 0; w < workers; w++ )
+  {
+    if( (pids[w] = fork()) == 0 )
+    {
+      worker( f, w );
+      _exit( 0 );
+    }
+    if( pids[w] < 0 )
+    {
+      perror( "fork" );
+      exit( 2 );
+    }
+  }
+
+  for( w = 0; w < workers; w++ )
+  {
+    int status;
+
+    if( wait( &status ) > 0 && !(WIFEXITED(status) && WEXITSTATUS(status) == 0) && !failed )
+    {
+      fprintf( stderr, "A worker failed\n" );
+      failed = 1;
+    }
+  }
+
+  if( verbose )
+  {
+    time_t took = time( NULL ) - start;
+
+    if( took == 0 )
+      took = 1;
+    printf( "%lu runs, %lu passes, %lu finished, %lu passes a second a worker\n",
+            (unsigned long)f->runs, (unsigned long)f->passes, (unsigned long)f->completions,
+            (unsigned long)(f->passes / took / workers) );
+    for( level = 1; level < NUM_LEVELS; level++ )
+    {
+      if( !only_level || level == only_level )
+        printf( "level %u reached %u positions\n", level, f->num_positions[level] );
+    }
+  }
+
+  printf( "%u failures, %u found again\n", f->num_failures, f->repeats );
+
+  return (failed || f->num_failures) ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __HOST_H
+#define __HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+/*
+ * Shared between the pieces of the host build. None of the game code
+ * sees this.
+ */
+
+#define HOST_SCREEN_SIZE   6912
+#define HOST_ATTR_OFFSET   6144
+
+extern uint8_t  host_screen[HOST_SCREEN_SIZE];
+
+/*
+ * Number of frames run so far, i.e. the number of times the game has
+ * halted waiting for the interrupt.
+ */
+extern uint32_t host_frame;
+
+/*
+ * intrinsic_halt() jumps back here when the frame limit is reached,
+ * since there's no other way out of the game loop.
+ */
+extern jmp_buf  host_frame_limit_jmp;
+void host_set_frame_limit( uint32_t frames );
+
+/*
+ * The key script is a list of "<start frame> <frames held>" lines saying
+ * when the control key is down. Returns 0 on success.
+ */
+int  host_load_key_script( const char* filename );
+
+/*
+ * Hold the control key down (1) or leave it up (0) whatever the script
+ * says, or go back to the script.
+ */
+#define HOST_KEY_SCRIPTED  (-1)
+void host_set_control_key( int pressed );
+
+/*
+ * host_game.c, for the tools which play the game a pass at a time.
+ *
+ * host_game_image() is the executable's data and bss in words, which is
+ * all the game's state, or NULL if it isn't word aligned.
+ * host_run_pass() answers HOST_PASS_HALTED for a pass which ended at the
+ * frame's halt, else what gameloop() returned. host_state_key() fills in
+ * what decides where the game goes from here, up to HOST_STATE_KEY_SIZE
+ * bytes, and returns its length. Timers with more than timer_horizon
+ * ticks left all key the same; HOST_EXACT_TIMERS keys every tick.
+ */
+#define HOST_PASS_HALTED          0x100
+#define HOST_STATE_KEY_SIZE       128
+#define HOST_EXACT_TIMERS         0xFFFE
+#define HOST_TIMER_BEYOND_HORIZON 0xFFFF
+
+uint64_t* host_game_image( size_t* words );
+void      host_setup_game( void );
+void      host_start_level( uint8_t level );
+int       host_run_pass( uint8_t key );
+size_t    host_state_key( uint8_t* key, uint16_t timer_horizon );
+
+#endif
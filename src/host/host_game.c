@@ -0,0 +1,191 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * The game run a pass of the game loop at a time, for the host tools
+ * which choose the keys themselves: the route solver and the fuzzer.
+ * They start a level, save the game's image, and put it back to try
+ * something else from there.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <arch/zx.h>
+#include <arch/zx/sp1.h>
+
+#include "host.h"
+#include "../game_state.h"
+#include "../runner.h"
+#include "../levels.h"
+#include "../gameloop.h"
+#include "../bonus.h"
+#include "../countdown.h"
+#include "../sound.h"
+#include "../door.h"
+#include "../slowdown_pill.h"
+#include "../key_action.h"
+#include "../int.h"
+
+/* In the tool's main, as they're in main.c in the Spectrum build */
+extern struct sp1_Rect full_screen;
+extern GAME_STATE      game_state;
+
+extern LEVEL_DATA level_data[];
+
+/* The game loop's pending events, see gameloop.c */
+extern uint8_t game_actions_ready;
+
+/* Ends of the executable's writable data, from the linker */
+extern char __data_start[];
+extern char _end[];
+
+uint64_t* host_game_image( size_t* words )
+{
+  if( ((uintptr_t)__data_start & 7) != 0 )
+    return NULL;
+
+  *words = (_end - __data_start) / sizeof(uint64_t);
+  return (uint64_t*)__data_start;
+}
+
+void host_setup_game( void )
+{
+  sp1_Initialize( SP1_IFLAG_OVERWRITE_TILES | SP1_IFLAG_OVERWRITE_DFILE,
+                  INK_BLACK | PAPER_WHITE,
+                  ' ' );
+
+  setup_levels_font();
+
+  create_runner();
+  create_slider();
+  create_game_bonuses( STARTING_NUM_BONUSES );
+}
+
+/*
+ * As host_main.c starts a level, with a full countdown and the frame count
+ * at 0. teardown_level() is the other end of it.
+ */
+void host_start_level( uint8_t level )
+{
+  reset_runner( RIGHT );
+  reset_slider();
+  reset_game_bonuses( STARTING_NUM_BONUSES );
+  SET_GAME_COUNTDOWN( COUNTDOWN_START_SECS );
+
+  game_state.current_level = &level_data[level];
+  print_level_from_sp1_string( game_state.current_level );
+
+  sp1_Invalidate(&full_screen);
+  sp1_UpdateNow();
+  protect_level_cells( game_state.current_level );
+
+  game_state.key_pressed = 0;
+  game_state.key_processed = 0;
+
+  SET_RUNNER_FACING( game_state.current_level->start_facing );
+  SET_RUNNER_XPOS( game_state.current_level->start_x );
+  SET_RUNNER_YPOS( game_state.current_level->start_y );
+  set_runner_colour( game_state.current_level->runner_ink );
+  SET_RUNNER_SLOWDOWN( SLOWDOWN_INACTIVE );
+
+  start_background_music();
+
+  host_frame = 0;
+}
+
+/*
+ * gameloop() is run from the top, which only draws the bonuses and
+ * protects the level's cells again, and the host's halt jumps back out
+ * when the frame's up.
+ */
+int host_run_pass( uint8_t key )
+{
+  host_set_control_key( key );
+  host_set_frame_limit( host_frame+1 );
+
+  if( setjmp( host_frame_limit_jmp ) != 0 )
+    return HOST_PASS_HALTED;
+
+  return gameloop( &game_state );
+}
+
+/*
+ * The runner's position, facing, jump and slowdown, whether the key's
+ * press has been used (the pass reads the key itself afresh), the
+ * teleporter holdoff, the doors and pills and how long their timers have
+ * left, and the door animations waiting for the next pass. Not the
+ * countdown.
+ *
+ * Nor the ISR's ready bits. The once a second one only moves the
+ * countdown on, the twice a second one only animates the pills, and the
+ * timer one is set when a timer has no ticks left, which the timers
+ * already say.
+ *
+ * A timer with more than timer_horizon ticks left is keyed as just
+ * running, however long it has. The solver uses that for the ones which
+ * can't run out before the end of any route it's looking for.
+ */
+size_t host_state_key( uint8_t* key, uint16_t timer_horizon )
+{
+  uint8_t*  k        = key;
+  DOOR*     door     = game_state.current_level->doors;
+  SLOWDOWN* slowdown = game_state.current_level->slowdowns;
+  uint16_t  now      = GET_TICKER;
+
+  *k++ = GET_RUNNER_XPOS;
+  *k++ = GET_RUNNER_YPOS;
+  *k++ = GET_RUNNER_FACING;
+  *k++ = GET_RUNNER_JUMP_OFFSET;
+  *k++ = GET_RUNNER_SLOWDOWN;
+  *k++ = (GET_RUNNER_SLOWDOWN == SLOWDOWN_ACTIVE) ? (now & 1) : 0;
+  *k++ = game_state.key_processed;
+  *k++ = just_teleported;
+  *k++ = game_actions_ready;
+  *k++ = SLOWDOWNS_DISABLED;
+
+#define KEY_TIMER(collectable) { \
+    uint16_t left = (collectable).timer_running ? (uint16_t)((collectable).timer_deadline - now) : 0; \
+    if( left > timer_horizon ) \
+      left = HOST_TIMER_BEYOND_HORIZON; \
+    *k++ = (collectable).available; \
+    *k++ = (collectable).timer_running; \
+    *k++ = left & 0xFF; \
+    *k++ = left >> 8; \
+}
+
+  if( door != NULL )
+  {
+    for( ; IS_VALID_DOOR(door) && k < key+HOST_STATE_KEY_SIZE-8; door++ )
+    {
+      KEY_TIMER( door->collectable );
+      *k++ = door->moving;
+      *k++ = door->animation_step;
+      *k++ = door->y_offset;
+    }
+  }
+
+  if( slowdown != NULL )
+  {
+    for( ; IS_VALID_SLOWDOWN(slowdown) && k < key+HOST_STATE_KEY_SIZE-8; slowdown++ )
+      KEY_TIMER( slowdown->collectable );
+  }
+
+  return k - key;
+}
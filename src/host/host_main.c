@@ -0,0 +1,175 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Headless host build of the game logic. This runs the real game loop,
+ * collision, runner, door, pill and level code, compiled natively, with
+ * the hardware replaced by host_platform.c and host_sp1.c. It runs as
+ * fast as the host can manage rather than at 50fps, with the control
+ * key driven from a script, so it's useful for regression tests and for
+ * checking level changes.
+ *
+ *  wonky_host [-f max_frames] [-l first_level] [-v] [key_script]
+ *
+ * It plays through the levels the way main() does and prints one line
+ * per level and a result line. The result is "won", "lost" (the
+ * countdown ran out) or "stopped" (it hit the frame limit).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <arch/zx.h>
+#include <arch/zx/sp1.h>
+
+#include "host.h"
+#include "../game_state.h"
+#include "../runner.h"
+#include "../levels.h"
+#include "../gameloop.h"
+#include "../bonus.h"
+#include "../countdown.h"
+#include "../sound.h"
+
+/* These are in main.c in the Spectrum build */
+struct sp1_Rect full_screen = {0, 0, 32, 24};
+GAME_STATE      game_state;
+
+extern LEVEL_DATA level_data[];
+
+#define DEFAULT_FRAME_LIMIT  (50UL*60*60)     /* An hour of game time */
+
+static void usage( const char* name )
+{
+  fprintf( stderr, "Usage: %s [-f max_frames] [-l first_level] [-v] [key_script]\n", name );
+  exit( 1 );
+}
+
+int main( int argc, char* argv[] )
+{
+  unsigned long        frame_limit = DEFAULT_FRAME_LIMIT;
+  unsigned long        first_level = 1;
+  int                  verbose     = 0;
+  int                  opt;
+
+  /* Used after the longjmp so they have to be volatile */
+  volatile uint8_t     current_level_num;
+  const char* volatile result = "won";
+
+  while( (opt = getopt( argc, argv, "f:l:v" )) != -1 )
+  {
+    switch( opt )
+    {
+    case 'f': frame_limit = strtoul( optarg, NULL, 0 ); break;
+    case 'l': first_level = strtoul( optarg, NULL, 0 ); break;
+    case 'v': verbose = 1;                               break;
+    default:  usage( argv[0] );
+    }
+  }
+
+  if( optind < argc-1 || first_level >= NUM_LEVELS || frame_limit == 0 )
+    usage( argv[0] );
+
+  if( optind == argc-1 && host_load_key_script( argv[optind] ) != 0 )
+    return 1;
+
+  host_set_frame_limit( frame_limit );
+
+  sp1_Initialize( SP1_IFLAG_OVERWRITE_TILES | SP1_IFLAG_OVERWRITE_DFILE,
+                  INK_BLACK | PAPER_WHITE,
+                  ' ' );
+
+  setup_levels_font();
+
+  create_runner();
+  create_slider();
+  create_game_bonuses( STARTING_NUM_BONUSES );
+
+  reset_runner( RIGHT );
+  reset_slider();
+  reset_game_bonuses( STARTING_NUM_BONUSES );
+
+  /* The countdown starts with the first proper level, as in main() */
+  SET_GAME_COUNTDOWN( first_level ? COUNTDOWN_START_SECS : 0 );
+
+  current_level_num = first_level;
+
+  if( setjmp( host_frame_limit_jmp ) == 0 )
+  {
+    while( current_level_num < NUM_LEVELS )
+    {
+      LEVEL_COMPLETION_TYPE completion_type;
+
+      game_state.current_level = &level_data[current_level_num];
+      print_level_from_sp1_string( game_state.current_level );
+
+      sp1_Invalidate(&full_screen);
+      sp1_UpdateNow();
+      protect_level_cells( game_state.current_level );
+
+      game_state.key_pressed = 0;
+      game_state.key_processed = 0;
+
+      SET_RUNNER_FACING( game_state.current_level->start_facing );
+      SET_RUNNER_XPOS( game_state.current_level->start_x );
+      SET_RUNNER_YPOS( game_state.current_level->start_y );
+      set_runner_colour( game_state.current_level->runner_ink );
+      SET_RUNNER_SLOWDOWN( SLOWDOWN_INACTIVE );
+
+      start_background_music();
+      completion_type = gameloop( &game_state );
+      stop_background_music();
+      wait_for_sound_effect();
+
+      teardown_level( game_state.current_level );
+
+      if( verbose )
+        printf( "level %u %s frame %lu countdown %u\n",
+                current_level_num,
+                completion_type == GAME_COMPLETE_LOSER ? "lost" : "complete",
+                (unsigned long)host_frame,
+                (unsigned)GET_GAME_COUNTDOWN );
+
+      if( completion_type == GAME_COMPLETE_LOSER )
+      {
+        result = "lost";
+        break;
+      }
+
+      if( ++current_level_num == 1 )
+        SET_GAME_COUNTDOWN( COUNTDOWN_START_SECS );
+    }
+  }
+  else
+  {
+    result = "stopped";
+  }
+
+  printf( "result %s level %u frame %lu x %u y %u countdown %u\n",
+          (const char*)result,
+          current_level_num,
+          (unsigned long)host_frame,
+          GET_RUNNER_XPOS, GET_RUNNER_YPOS,
+          (unsigned)GET_GAME_COUNTDOWN );
+
+  return 0;
+}
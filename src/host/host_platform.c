@@ -0,0 +1,214 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Host build replacements for the hardware: the interrupt, the keyboard,
+ * the beeper and the border, plus C versions of the assembly language
+ * routines the game logic calls.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <input.h>
+#include <sound.h>
+
+#include "host.h"
+#include "../collision.h"
+#include "../tile_map.h"
+
+/* The ISR from int.c, which is an ordinary function in this build */
+void isr(void);
+
+uint32_t host_frame = 0;
+jmp_buf  host_frame_limit_jmp;
+
+static uint32_t frame_limit = 0;
+
+void host_set_frame_limit( uint32_t frames )
+{
+  frame_limit = frames;
+}
+
+/*
+ * The Spectrum halts until the next 50Hz interrupt then runs the ISR.
+ * Here that just means running the ISR, which moves the ticker on.
+ */
+void intrinsic_halt( void )
+{
+  isr();
+
+  if( ++host_frame == frame_limit )
+    longjmp( host_frame_limit_jmp, 1 );
+}
+
+
+/*
+ * Key script. Presses are kept sorted by start frame and a cursor follows
+ * the frame count along them, so looking up the key is a couple of
+ * compares however long the script is.
+ */
+typedef struct _key_press
+{
+  uint32_t start;
+  uint32_t end;
+} KEY_PRESS;
+
+static KEY_PRESS* key_presses    = NULL;
+static size_t     num_key_presses = 0;
+static size_t     key_cursor      = 0;
+
+/* Set by the route solver, which decides the key a pass at a time */
+static int        control_key     = HOST_KEY_SCRIPTED;
+
+void host_set_control_key( int pressed )
+{
+  control_key = pressed;
+}
+
+static int compare_key_press( const void* a, const void* b )
+{
+  uint32_t start_a = ((const KEY_PRESS*)a)->start;
+  uint32_t start_b = ((const KEY_PRESS*)b)->start;
+
+  return (start_a > start_b) - (start_a < start_b);
+}
+
+int host_load_key_script( const char* filename )
+{
+  FILE*    fh;
+  char     line[128];
+  unsigned line_num = 0;
+  size_t   allocated = 0;
+
+  if( (fh = fopen( filename, "r" )) == NULL )
+  {
+    perror( filename );
+    return 1;
+  }
+
+  while( fgets( line, sizeof(line), fh ) )
+  {
+    unsigned long start;
+    unsigned long held;
+    char          extra;
+
+    line_num++;
+
+    if( line[0] == '#' || sscanf( line, " %c", &extra ) != 1 )
+      continue;
+
+    if( sscanf( line, "%lu %lu %c", &start, &held, &extra ) != 2 || held == 0 )
+    {
+      fprintf( stderr, "%s:%u: expected \"<start frame> <frames held>\"\n", filename, line_num );
+      fclose( fh );
+      return 1;
+    }
+
+    if( num_key_presses == allocated )
+    {
+      allocated = allocated ? allocated*2 : 64;
+      if( (key_presses = realloc( key_presses, allocated*sizeof(KEY_PRESS) )) == NULL )
+      {
+        fprintf( stderr, "Out of memory reading %s\n", filename );
+        exit( 2 );
+      }
+    }
+
+    key_presses[num_key_presses].start = start;
+    key_presses[num_key_presses].end   = start + held;
+    num_key_presses++;
+  }
+
+  fclose( fh );
+
+  qsort( key_presses, num_key_presses, sizeof(KEY_PRESS), compare_key_press );
+  key_cursor = 0;
+
+  return 0;
+}
+
+/*
+ * Only the control key is scripted. The music and sound toggle keys are
+ * never pressed, which is as well since the game spins waiting for them
+ * to be released and no frames pass while it does.
+ */
+int in_key_pressed( uint16_t scancode )
+{
+  if( scancode != IN_KEY_SCANCODE_SPACE )
+    return 0;
+
+  if( control_key != HOST_KEY_SCRIPTED )
+    return control_key;
+
+  while( (key_cursor < num_key_presses) && (key_presses[key_cursor].end <= host_frame) )
+    key_cursor++;
+
+  return (key_cursor < num_key_presses) && (key_presses[key_cursor].start <= host_frame);
+}
+
+
+/*
+ * Sound makes no difference to the game logic, other than the time it
+ * takes on the Spectrum.
+ */
+unsigned char host_beepfx[6];
+
+void play_note_slice( uint8_t* pitch )
+{
+  (void)pitch;
+}
+
+void start_beepfx_effect( void* effect )
+{
+  (void)effect;
+}
+
+uint8_t play_beepfx_slice( void )
+{
+  return 0;
+}
+
+void zx_border( uint8_t colour )
+{
+  (void)colour;
+}
+
+
+/*
+ * C version of the probe walker in collision_probe.asm. Keep the two
+ * in step.
+ */
+uint8_t run_collision_probes( PROBE_REQUEST* request )
+{
+  const RUNNER_NEIGHBOURHOOD* neighbourhood = request->neighbourhood;
+  const PROBE*                probe         = request->probes;
+
+  for( ; probe->reaction != NO_REACTION; probe++ )
+  {
+    uint8_t column = (uint8_t)(neighbourhood->x_mod8 + 8 + probe->dx) >> 3;
+    uint8_t row    = (uint8_t)(neighbourhood->y_mod8 + 8 + probe->dy) >> 3;
+
+    if( !TILE_IS_PASSABLE( neighbourhood->tiles[row][column] ) )
+      return probe->reaction;
+  }
+
+  return NO_REACTION;
+}
@@ -0,0 +1,356 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Host build replacement for the parts of SP1 the game uses.
+ *
+ * The important bit is the update structures. The level is printed with
+ * sp1_PrintString() and the tile map is built from the colours it leaves
+ * in them, so the print string interpreter has to colour cells the same
+ * way the real one does. The control codes handled are the ones SP1
+ * documents and the game uses; anything else stops the program because
+ * it means a level won't be laid out correctly.
+ *
+ * Sprites are tracked but never drawn. sp1_UpdateNow() copies the cell
+ * colours into the attribute part of host_screen so a test can look at
+ * the screen the way a snapshot would, but there's no pixel rendering.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <arch/zx.h>
+#include <arch/zx/sp1.h>
+
+#include "host.h"
+
+#define SP1_ROWS  24
+#define SP1_COLS  32
+
+static struct sp1_update update_structs[SP1_ROWS][SP1_COLS];
+
+/*
+ * Display file and attributes, laid out as at 16384. Only the attributes
+ * are filled in.
+ */
+uint8_t host_screen[HOST_SCREEN_SIZE];
+
+/* Set when a cell has changed since the last sp1_UpdateNow() */
+static uint8_t screen_changed;
+
+void sp1_Initialize( uint8_t iflag, uint8_t colour, uint8_t tile )
+{
+  uint8_t row;
+  uint8_t col;
+
+  (void)iflag;
+
+  for( row = 0; row < SP1_ROWS; row++ )
+  {
+    for( col = 0; col < SP1_COLS; col++ )
+    {
+      update_structs[row][col].colour = colour;
+      update_structs[row][col].tile   = tile;
+    }
+  }
+
+  memset( host_screen, 0, sizeof(host_screen) );
+  screen_changed = 1;
+}
+
+void* sp1_TileEntry( uint16_t c, void* def )
+{
+  (void)c;
+  return def;
+}
+
+struct sp1_update* sp1_GetUpdateStruct( uint8_t row, uint8_t col )
+{
+  return &update_structs[row][col];
+}
+
+void sp1_ClearRectInv( struct sp1_Rect* r, uint8_t colour, uint16_t tile, uint8_t rflag )
+{
+  uint8_t row;
+  uint8_t col;
+
+  for( row = r->row; row < r->row+r->height && row < SP1_ROWS; row++ )
+  {
+    for( col = r->col; col < r->col+r->width && col < SP1_COLS; col++ )
+    {
+      if( rflag & SP1_RFLAG_COLOUR )
+        update_structs[row][col].colour = colour;
+      if( rflag & SP1_RFLAG_TILE )
+        update_structs[row][col].tile = tile;
+    }
+  }
+
+  screen_changed = 1;
+}
+
+/*
+ * Print a character at the print position and move it on, wrapping at
+ * the edge of the bounds rectangle like SP1 does.
+ */
+static void print_char( struct sp1_pss* ps, uint8_t c )
+{
+  struct sp1_Rect*   bounds = ps->bounds;
+  struct sp1_update* u;
+
+  if( (ps->x < bounds->width) && (ps->y < bounds->height) )
+  {
+    u = &update_structs[bounds->row+ps->y][bounds->col+ps->x];
+
+    u->colour = (u->colour & ps->attr_mask) | ps->attr;
+    u->tile   = c;
+  }
+
+  if( ++ps->x >= bounds->width )
+  {
+    ps->x = 0;
+    if( ++ps->y >= bounds->height )
+      ps->y = 0;
+  }
+}
+
+void sp1_PrintString( struct sp1_pss* ps, uint8_t* s )
+{
+  uint8_t* repeat_start = NULL;
+  uint8_t  repeat_count = 0;
+
+  while( *s )
+  {
+    uint8_t c = *s++;
+
+    switch( c )
+    {
+    case 0x08:   /* Left */
+      if( ps->x ) ps->x--;
+      break;
+
+    case 0x09:   /* Right */
+      ps->x++;
+      break;
+
+    case 0x0a:   /* Up */
+      if( ps->y ) ps->y--;
+      break;
+
+    case 0x0b:   /* Down */
+      ps->y++;
+      break;
+
+    case 0x0c:   /* Home */
+      ps->x = ps->y = 0;
+      break;
+
+    case 0x0d:   /* Carriage return */
+      ps->x = 0;
+      ps->y++;
+      break;
+
+    case 0x0e:   /* Repeat what follows n times */
+      repeat_count = *s++;
+      repeat_start = s;
+      break;
+
+    case 0x0f:   /* End of repeat */
+      if( repeat_start && --repeat_count )
+        s = repeat_start;
+      break;
+
+    case 0x10:   /* Ink n */
+      ps->attr      = (ps->attr & 0xF8) | (*s++ & 0x07);
+      ps->attr_mask = ps->attr_mask & 0xF8;
+      break;
+
+    case 0x11:   /* Paper n */
+      ps->attr      = (ps->attr & 0xC7) | ((*s++ & 0x07) << 3);
+      ps->attr_mask = ps->attr_mask & 0xC7;
+      break;
+
+    case 0x12:   /* Flash n */
+      ps->attr      = (ps->attr & 0x7F) | (*s++ ? FLASH : 0);
+      ps->attr_mask = ps->attr_mask & 0x7F;
+      break;
+
+    case 0x13:   /* Bright n */
+      ps->attr      = (ps->attr & 0xBF) | (*s++ ? BRIGHT : 0);
+      ps->attr_mask = ps->attr_mask & 0xBF;
+      break;
+
+    case 0x14:   /* Attribute n */
+      ps->attr      = *s++;
+      ps->attr_mask = 0;
+      break;
+
+    case 0x16:   /* AT y,x */
+      ps->y = *s++;
+      ps->x = *s++;
+      break;
+
+    default:
+      if( c < 0x20 )
+      {
+        fprintf( stderr, "sp1_PrintString: unsupported control code 0x%02x\n", c );
+        exit( 2 );
+      }
+      print_char( ps, c );
+      break;
+    }
+  }
+
+  screen_changed = 1;
+}
+
+/*
+ * Validation and invalidation decide what SP1 redraws. There's no
+ * drawing here, so they don't need to do anything.
+ */
+void sp1_Validate( struct sp1_Rect* r )
+{
+  (void)r;
+}
+
+void sp1_Invalidate( struct sp1_Rect* r )
+{
+  (void)r;
+  screen_changed = 1;
+}
+
+void sp1_InvUpdateStruct( struct sp1_update* u )
+{
+  (void)u;
+}
+
+void sp1_RemoveUpdateStruct( struct sp1_update* u )
+{
+  (void)u;
+}
+
+void sp1_RestoreUpdateStruct( struct sp1_update* u )
+{
+  (void)u;
+}
+
+void sp1_UpdateNow( void )
+{
+  uint8_t* attr;
+  uint8_t  row;
+  uint8_t  col;
+
+  if( !screen_changed )
+    return;
+
+  attr = &host_screen[HOST_ATTR_OFFSET];
+  for( row = 0; row < SP1_ROWS; row++ )
+  {
+    for( col = 0; col < SP1_COLS; col++ )
+      *attr++ = update_structs[row][col].colour;
+  }
+
+  screen_changed = 0;
+}
+
+
+struct sp1_ss* sp1_CreateSpr( void* drawf, uint8_t type, uint8_t height, int graphic, uint8_t plane )
+{
+  struct sp1_ss* s = calloc( 1, sizeof(struct sp1_ss) );
+
+  (void)drawf;
+  (void)type;
+  (void)graphic;
+
+  if( s == NULL )
+  {
+    fprintf( stderr, "sp1_CreateSpr: out of memory\n" );
+    exit( 2 );
+  }
+
+  s->width  = 1;
+  s->height = height;
+  s->plane  = plane;
+
+  return s;
+}
+
+uint8_t sp1_AddColSpr( struct sp1_ss* s, void* drawf, uint8_t type, int graphic, uint8_t plane )
+{
+  (void)drawf;
+  (void)type;
+  (void)graphic;
+  (void)plane;
+
+  s->width++;
+  return 1;
+}
+
+void sp1_DeleteSpr( struct sp1_ss* s )
+{
+  free( s );
+}
+
+void sp1_MoveSprPix( struct sp1_ss* s, struct sp1_Rect* clip, void* frame, uint16_t x, uint16_t y )
+{
+  (void)clip;
+
+  s->xpos  = x;
+  s->ypos  = y;
+  s->col   = x >> 3;
+  s->row   = y >> 3;
+  s->frame = frame;
+}
+
+void sp1_MoveSprPix_callee( struct sp1_ss* s, struct sp1_Rect* clip, void* frame, uint16_t x, uint16_t y )
+{
+  sp1_MoveSprPix( s, clip, frame, x, y );
+}
+
+/*
+ * The game only uses these to colour a sprite's cells when it's created
+ * and to force a redraw, so each hook is called once per sprite cell.
+ */
+void sp1_IterateSprChar( struct sp1_ss* s, void* hook1 )
+{
+  void          (*hook)(unsigned int, struct sp1_cs*) = (void (*)(unsigned int, struct sp1_cs*))hook1;
+  struct sp1_cs cs;
+  unsigned int  count;
+
+  for( count = 0; count < (unsigned int)(s->width * s->height); count++ )
+  {
+    cs.attr_mask = 0xFF;
+    cs.attr      = 0;
+    hook( count, &cs );
+  }
+}
+
+void sp1_IterateUpdateSpr( struct sp1_ss* s, void* hook2 )
+{
+  void         (*hook)(unsigned int, struct sp1_update*) = (void (*)(unsigned int, struct sp1_update*))hook2;
+  unsigned int count = 0;
+  uint8_t      row;
+  uint8_t      col;
+
+  for( row = s->row; row < s->row+s->height && row < SP1_ROWS; row++ )
+  {
+    for( col = s->col; col < s->col+s->width && col < SP1_COLS; col++ )
+      hook( count++, &update_structs[row][col] );
+  }
+}
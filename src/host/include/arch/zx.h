@@ -0,0 +1,53 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Host build stand-in for the z88dk <arch/zx.h>. Only the bits the game
+ * logic uses are here. See host/host_main.c for what the host build is for.
+ */
+
+#ifndef __HOST_ARCH_ZX_H
+#define __HOST_ARCH_ZX_H
+
+#include <stdint.h>
+
+#define INK_BLACK      0x00
+#define INK_BLUE       0x01
+#define INK_RED        0x02
+#define INK_MAGENTA    0x03
+#define INK_GREEN      0x04
+#define INK_CYAN       0x05
+#define INK_YELLOW     0x06
+#define INK_WHITE      0x07
+
+#define PAPER_BLACK    0x00
+#define PAPER_BLUE     0x08
+#define PAPER_RED      0x10
+#define PAPER_MAGENTA  0x18
+#define PAPER_GREEN    0x20
+#define PAPER_CYAN     0x28
+#define PAPER_YELLOW   0x30
+#define PAPER_WHITE    0x38
+
+#define BRIGHT         0x40
+#define FLASH          0x80
+
+void zx_border( uint8_t colour );
+
+#endif
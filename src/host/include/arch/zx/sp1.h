@@ -0,0 +1,119 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Host build stand-in for the z88dk SP1 sprite library. The structures
+ * have the fields the game touches, in the same order so the static
+ * initialisers in the game code still line up. The functions are in
+ * host/host_sp1.c; they keep the character cell colours and tiles the
+ * way SP1 does so the tile map is built exactly as it is on the Spectrum,
+ * but sprites are only tracked, not drawn.
+ */
+
+#ifndef __HOST_ARCH_ZX_SP1_H
+#define __HOST_ARCH_ZX_SP1_H
+
+#include <stdint.h>
+
+struct sp1_Rect
+{
+  uint8_t row;
+  uint8_t col;
+  uint8_t width;
+  uint8_t height;
+};
+
+struct sp1_ss
+{
+  uint8_t  row;
+  uint8_t  col;
+  uint8_t  width;
+  uint8_t  height;
+  uint8_t  plane;
+  uint8_t  xthresh;
+  uint8_t  ythresh;
+  uint16_t xpos;
+  uint16_t ypos;
+  void*    frame;
+};
+
+struct sp1_cs
+{
+  uint8_t  attr_mask;
+  uint8_t  attr;
+};
+
+struct sp1_update
+{
+  uint8_t  nload;
+  uint8_t  colour;
+  uint16_t tile;
+};
+
+struct sp1_pss
+{
+  struct sp1_Rect*   bounds;
+  uint8_t            flags;
+  uint8_t            x;
+  uint8_t            y;
+  uint8_t            attr_mask;
+  uint8_t            attr;
+  struct sp1_update* pos;
+  void*              visit;
+};
+
+#define SP1_PSSFLAG_INVALIDATE     0x01
+
+#define SP1_RFLAG_TILE             0x40
+#define SP1_RFLAG_COLOUR           0x20
+#define SP1_RFLAG_SPRITE           0x10
+
+#define SP1_AMASK_INK              0xF8
+#define SP1_AMASK_PAPER            0xC7
+
+#define SP1_IFLAG_MAKE_ROTTBL      0x01
+#define SP1_IFLAG_OVERWRITE_TILES  0x02
+#define SP1_IFLAG_OVERWRITE_DFILE  0x04
+
+/* Draw functions are addresses of SP1 routines, nothing to call here */
+#define SP1_DRAW_LOAD1NR           ((void*)0)
+#define SP1_DRAW_OR1NR             ((void*)0)
+#define SP1_TYPE_1BYTE             0x40
+
+void               sp1_Initialize( uint8_t iflag, uint8_t colour, uint8_t tile );
+void*              sp1_TileEntry( uint16_t c, void* def );
+struct sp1_update* sp1_GetUpdateStruct( uint8_t row, uint8_t col );
+void               sp1_PrintString( struct sp1_pss* ps, uint8_t* s );
+void               sp1_ClearRectInv( struct sp1_Rect* r, uint8_t colour, uint16_t tile, uint8_t rflag );
+void               sp1_Validate( struct sp1_Rect* r );
+void               sp1_Invalidate( struct sp1_Rect* r );
+void               sp1_InvUpdateStruct( struct sp1_update* u );
+void               sp1_RemoveUpdateStruct( struct sp1_update* u );
+void               sp1_RestoreUpdateStruct( struct sp1_update* u );
+void               sp1_UpdateNow( void );
+
+struct sp1_ss*     sp1_CreateSpr( void* drawf, uint8_t type, uint8_t height, int graphic, uint8_t plane );
+uint8_t            sp1_AddColSpr( struct sp1_ss* s, void* drawf, uint8_t type, int graphic, uint8_t plane );
+void               sp1_DeleteSpr( struct sp1_ss* s );
+void               sp1_MoveSprPix( struct sp1_ss* s, struct sp1_Rect* clip, void* frame, uint16_t x, uint16_t y );
+void               sp1_MoveSprPix_callee( struct sp1_ss* s, struct sp1_Rect* clip, void* frame, uint16_t x, uint16_t y );
+void               sp1_IterateSprChar( struct sp1_ss* s, void* hook1 );
+void               sp1_IterateUpdateSpr( struct sp1_ss* s, void* hook2 );
+
+#endif
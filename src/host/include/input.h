@@ -0,0 +1,38 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Host build stand-in for the z88dk <input.h>. Keys come from the
+ * scripted key stream in host/host_platform.c.
+ */
+
+#ifndef __HOST_INPUT_H
+#define __HOST_INPUT_H
+
+#include <stdint.h>
+
+#define IN_KEY_SCANCODE_SPACE  0x017f
+#define IN_KEY_SCANCODE_m      0x047f
+#define IN_KEY_SCANCODE_s      0x02fd
+#define IN_KEY_SCANCODE_q      0x01fb
+#define IN_KEY_SCANCODE_w      0x02fb
+
+int in_key_pressed( uint16_t scancode );
+
+#endif
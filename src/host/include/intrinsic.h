@@ -0,0 +1,44 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Host build stand-in for the z88dk <intrinsic.h>. intrinsic_halt() is
+ * where the host build's time passes: it runs the ISR once, which moves
+ * the ticker on exactly as the 50Hz interrupt does on the Spectrum.
+ */
+
+#ifndef __HOST_INTRINSIC_H
+#define __HOST_INTRINSIC_H
+
+#include <stdint.h>
+
+/*
+ * On the Spectrum this is handed the assembler name of a 16 bit variable
+ * and loads it atomically. The only one the game uses is _ticker.
+ */
+#define intrinsic_load16(sym)  (sym)
+#define _ticker                ticker
+
+void intrinsic_halt( void );
+
+/* There's nothing to interrupt the host build between halts */
+#define intrinsic_di()
+#define intrinsic_ei()
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Host build stand-in for the z88dk <sound.h>. The game's own sound.h is
+ * included with quotes so it doesn't clash with this. Effects are just
+ * distinct addresses; nothing reads them.
+ */
+
+#ifndef __HOST_Z88DK_SOUND_H
+#define __HOST_Z88DK_SOUND_H
+
+extern unsigned char host_beepfx[];
+
+#define BEEPFX_SELECT_6   ((void*)&host_beepfx[0])
+#define BEEPFX_POWER_OFF  ((void*)&host_beepfx[1])
+#define BEEPFX_SELECT_3   ((void*)&host_beepfx[2])
+#define BEEPFX_PICK       ((void*)&host_beepfx[3])
+#define BEEPFX_SHOT_1     ((void*)&host_beepfx[4])
+#define BEEPFX_JUMP_2     ((void*)&host_beepfx[5])
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Host build stand-in for the z88dk <z80.h>. There's no Spectrum memory
+ * to peek and poke. Peeks read 0 and pokes are dropped, which means the
+ * ROM never looks writable and tracing stays switched off.
+ */
+
+#ifndef __HOST_Z80_H
+#define __HOST_Z80_H
+
+#include <stdint.h>
+
+#define z80_bpeek(addr)        ((void)(addr), (uint8_t)0)
+#define z80_bpoke(addr,byte)   ((void)(addr), (void)(byte))
+#define z80_wpoke(addr,word)   ((void)(addr), (void)(word))
+#define z80_delay_ms(ms)       ((void)(ms))
+#define z80_outp(port,byte)    ((void)(port), (void)(byte))
+#define z80_inp(port)          ((void)(port), (uint8_t)0xFF)
+
+#endif
@@ -0,0 +1,704 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Jump tables. Plays every jump off every jumper block in the levels
+ * with the real game loop: from each place the runner can take off,
+ * facing each way, and turning on each pass of the jump or not at all.
+ *
+ *  wonky_jumps [-l level] [-t table_file]
+ *
+ * It prints the levels' reachability graph, tab separated, a line per
+ * jumper cell, facing, turn and landing. The take off x's which land in
+ * the same place are on the one line. "lands" is the cell under the
+ * middle of the runner once he's stopped going up or down, "crosses"
+ * every cell the runner went through on the way. A jump can also:
+ *
+ *  bounce     hit a wall and turn without the key being pressed
+ *  teleport   go through a teleporter
+ *  finish     finish the level, or lose it
+ *  nolanding  still be in the air after MAX_PASSES
+ *
+ * With -t it writes the jump tables the game is built with instead,
+ * the assembler jump_tables.asm is made from. See jump_tables.h. The
+ * jump offset probing starts at is found by running each jump which
+ * doesn't turn, checking before each pass whether act_on_collision()
+ * could find anything: test_direction_blocked() is asked with every
+ * door in the level shut, and it's over as soon as the runner is over
+ * a teleporter cell. A shut door is only ever more in the way than an
+ * open one, so nothing that happens to the doors during the jump can
+ * make the skipped probes find something.
+ *
+ * Each jump starts from the level's start, copied back over the game's
+ * image, with the runner put at the take off point.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <arch/zx.h>
+#include <arch/zx/sp1.h>
+
+#include "host.h"
+#include "../game_state.h"
+#include "../runner.h"
+#include "../levels.h"
+#include "../tile_map.h"
+#include "../collision.h"
+#include "../door.h"
+#include "../jump_tables.h"
+#include "../input_log.h"
+
+#if JUMP_TABLES
+#error "The jump tables are made from a build without them"
+#endif
+
+#if INPUT_LOG == INPUT_LOG_REPLAY
+#error "The jump tables are made by pressing the key, it can't be built to replay an input log"
+#endif
+
+/* These are in main.c in the Spectrum build */
+struct sp1_Rect full_screen = {0, 0, 32, 24};
+GAME_STATE      game_state;
+
+extern LEVEL_DATA level_data[];
+
+/* Passes of the game loop a jump gets to land in */
+#define MAX_PASSES      400
+
+/* Passes the key's held to take off */
+#define TAKE_OFF_PASSES 1
+
+/* As jump_y_offsets[] in runner.c */
+#define JUMP_LENGTH     40
+
+#define NO_TURN         0
+
+#define EVENT_BOUNCE    0x01
+#define EVENT_TELEPORT  0x02
+#define EVENT_FINISH    0x04
+#define EVENT_NOLANDING 0x08
+
+#define SPRITE_WIDTH    6
+#define SPRITE_HEIGHT   8
+
+#define MAP_CELLS       (TILE_MAP_WIDTH*TILE_MAP_HEIGHT)
+
+
+/***
+ *          _
+ *         | |
+ *         | |_   _ _ __ ___  _ __  ___
+ *     _   | | | | | '_ ` _ \| '_ \/ __|
+ *    | |__| | |_| | | | | | | |_) \__ \
+ *     \____/ \__,_|_| |_| |_| .__/|___/
+ *                           | |
+ *                           |_|
+ *
+ * A jump played from a take off point.
+ */
+
+typedef struct _played_jump
+{
+  uint8_t   level;
+  uint8_t   jumper_x;
+  uint8_t   jumper_y;
+  uint8_t   facing;
+  uint8_t   turn;
+  uint8_t   xpos;
+  uint8_t   ypos;
+
+  uint8_t   lands_x;
+  uint8_t   lands_y;
+  uint8_t   events;
+  uint16_t  frames;
+
+  /* Passes until he's not jumping any more */
+  uint16_t  jump_passes;
+
+  uint8_t   crosses[MAP_CELLS/8];
+} PLAYED_JUMP;
+
+/*
+ * These are in the image too, so they're set before the level's start
+ * is saved and never change after. What they point to is in the heap.
+ */
+static uint64_t* image;
+static size_t    image_words;
+static uint64_t* level_start;
+
+/* The level's tile map at its start, with every door shut */
+static uint8_t*  doors_shut_map;
+
+static void start_jump( uint8_t x, uint8_t y, DIRECTION facing )
+{
+  memcpy( image, level_start, image_words*sizeof(uint64_t) );
+
+  SET_RUNNER_XPOS( x );
+  SET_RUNNER_YPOS( y );
+  SET_RUNNER_FACING( facing );
+}
+
+/*
+ * Press the key with the runner standing at x,y. It's somewhere he can
+ * take off from if that starts a jump there and then.
+ */
+static int take_off( uint8_t x, uint8_t y, DIRECTION facing )
+{
+  start_jump( x, y, facing );
+
+  if( host_run_pass( 1 ) != HOST_PASS_HALTED )
+    return 0;
+
+  return (GET_RUNNER_JUMP_OFFSET == 0) && (GET_RUNNER_XPOS == x)
+         && (GET_RUNNER_YPOS == y) && (GET_RUNNER_FACING == facing);
+}
+
+/*
+ * The jumper a take off at x on top of row cy would be off: the one
+ * under him, or the one to his right if he's across two cells. NO_JUMPER
+ * if there's neither.
+ */
+#define NO_JUMPER 0xFF
+
+static uint8_t jumper_under( uint8_t x, uint8_t cy )
+{
+  uint8_t cx = x>>3;
+
+  if( GET_TILE_AT_CELL(cx, cy) == TILE_JUMPER )
+    return cx;
+  if( (cx+1 < TILE_MAP_WIDTH) && (GET_TILE_AT_CELL(cx+1, cy) == TILE_JUMPER) )
+    return cx+1;
+  return NO_JUMPER;
+}
+
+/* He has to be standing in open cells for it to be a take off point */
+static int standing_room( uint8_t x, uint8_t y )
+{
+  return TILE_IS_PASSABLE( GET_TILE_AT_PIXEL(x, y) )
+         && TILE_IS_PASSABLE( GET_TILE_AT_PIXEL(x+SPRITE_WIDTH-1, y) );
+}
+
+static void mark_crossed( uint8_t* crosses, uint8_t x, uint8_t y )
+{
+  uint8_t cx;
+  uint8_t cy;
+
+  for( cy = y>>3; cy <= ((y+SPRITE_HEIGHT-1)>>3) && cy < TILE_MAP_HEIGHT; cy++ )
+  {
+    for( cx = x>>3; cx <= ((x+SPRITE_WIDTH-1)>>3) && cx < TILE_MAP_WIDTH; cx++ )
+    {
+      uint16_t cell = TILE_MAP_CELL_OFFSET(cx, cy);
+
+      crosses[cell>>3] |= 1 << (cell&7);
+    }
+  }
+}
+
+static int over_teleporter( uint8_t x, uint8_t y )
+{
+  uint8_t crosses[MAP_CELLS/8];
+  uint16_t cell;
+
+  memset( crosses, 0, sizeof(crosses) );
+  mark_crossed( crosses, x, y );
+
+  for( cell = 0; cell < MAP_CELLS; cell++ )
+    if( (crosses[cell>>3] & (1 << (cell&7))) && TILE_IS_TELEPORTER(tile_map[cell]) )
+      return 1;
+
+  return 0;
+}
+
+/*
+ * Play the jump, turning on pass j->turn after taking off if it's not
+ * NO_TURN, until he's come down and stopped. He's stopped when he isn't
+ * jumping and a pass goes by without him going up or down.
+ */
+static void play_jump( PLAYED_JUMP* j )
+{
+  uint8_t  x = j->xpos;
+  uint8_t  y = j->ypos;
+  uint16_t pass;
+
+  take_off( x, y, (DIRECTION)j->facing );
+
+  j->events      = EVENT_NOLANDING;
+  j->frames      = MAX_PASSES;
+  j->jump_passes = 0;
+  j->lands_x     = x;
+  j->lands_y     = y;
+  memset( j->crosses, 0, sizeof(j->crosses) );
+  mark_crossed( j->crosses, x, y );
+
+  for( pass = 1; pass <= MAX_PASSES; pass++ )
+  {
+    DIRECTION facing  = GET_RUNNER_FACING;
+    int       jumping = RUNNER_JUMPING( GET_RUNNER_JUMP_OFFSET );
+    int       result  = host_run_pass( pass == j->turn );
+
+    if( result != HOST_PASS_HALTED )
+    {
+      j->events  = (j->events & ~EVENT_NOLANDING) | EVENT_FINISH;
+      j->frames  = TAKE_OFF_PASSES+pass;
+      j->lands_x = x;
+      j->lands_y = y;
+      return;
+    }
+
+    /* Teleporters can turn him round too */
+    if( abs( GET_RUNNER_XPOS-x ) > 1 || abs( GET_RUNNER_YPOS-y ) > 2 )
+      j->events |= EVENT_TELEPORT;
+    else if( (GET_RUNNER_FACING != facing) && (pass != j->turn) )
+      j->events |= EVENT_BOUNCE;
+
+    if( !RUNNER_JUMPING( GET_RUNNER_JUMP_OFFSET ) && (j->jump_passes == 0) )
+      j->jump_passes = pass;
+
+    if( !jumping && !RUNNER_JUMPING( GET_RUNNER_JUMP_OFFSET ) && (GET_RUNNER_YPOS == y) )
+    {
+      j->events &= ~EVENT_NOLANDING;
+      j->frames  = TAKE_OFF_PASSES+pass-1;
+      j->lands_x = x;
+      j->lands_y = y;
+      return;
+    }
+
+    x = GET_RUNNER_XPOS;
+    y = GET_RUNNER_YPOS;
+    mark_crossed( j->crosses, x, y );
+  }
+}
+
+/*
+ * The jump offset act_on_collision() has to start probing at for the
+ * jump from x,y which doesn't turn, at most JUMP_LENGTH.
+ */
+static uint8_t safe_jump_offset( uint8_t x, uint8_t y, DIRECTION facing )
+{
+  uint8_t saved_map[MAP_CELLS];
+
+  if( !take_off( x, y, facing ) )
+    return 0;
+
+  while( RUNNER_JUMPING( GET_RUNNER_JUMP_OFFSET ) )
+  {
+    RUNNER_NEIGHBOURHOOD neighbourhood;
+    REACTION             reaction;
+    uint8_t              offset = GET_RUNNER_JUMP_OFFSET;
+
+    x = GET_RUNNER_XPOS;
+    y = GET_RUNNER_YPOS;
+
+    if( over_teleporter( x, y ) )
+      return offset;
+
+    memcpy( saved_map, tile_map, MAP_CELLS );
+    memcpy( tile_map, doors_shut_map, MAP_CELLS );
+    capture_runner_neighbourhood( &neighbourhood, x, y );
+    memcpy( tile_map, saved_map, MAP_CELLS );
+
+    reaction = test_direction_blocked( &neighbourhood, x, y, facing, get_runner_jump_status() );
+    if( reaction != NO_REACTION )
+      return offset;
+
+    if( host_run_pass( 0 ) != HOST_PASS_HALTED )
+      return offset;
+  }
+
+  return JUMP_LENGTH;
+}
+
+static void start_level( uint8_t level )
+{
+  DOOR* door;
+
+  host_start_level( level );
+  memcpy( level_start, image, image_words*sizeof(uint64_t) );
+
+  memcpy( doors_shut_map, tile_map, MAP_CELLS );
+  door = game_state.current_level->doors;
+  if( door != NULL )
+  {
+    for( ; IS_VALID_DOOR(door); door++ )
+      doors_shut_map[TILE_MAP_CELL_OFFSET(door->door_cell_x, door->door_cell_y)] = TILE_DOOR;
+  }
+}
+
+/* Every x,y he can take off from, facing the way given, in the order of the map */
+static size_t find_take_offs( uint8_t level, DIRECTION facing, PLAYED_JUMP* jumps )
+{
+  size_t  num_jumps = 0;
+  uint8_t cy;
+  uint8_t x;
+
+  for( cy = 1; cy < TILE_MAP_HEIGHT; cy++ )
+  {
+    uint8_t y = (cy<<3)-SPRITE_HEIGHT;
+
+    for( x = 1; x < 256-SPRITE_WIDTH; x++ )
+    {
+      uint8_t jumper_x = jumper_under( x, cy );
+
+      if( jumper_x == NO_JUMPER || !standing_room( x, y ) || !take_off( x, y, facing ) )
+        continue;
+
+      jumps[num_jumps].level    = level;
+      jumps[num_jumps].jumper_x = jumper_x;
+      jumps[num_jumps].jumper_y = cy;
+      jumps[num_jumps].facing   = facing;
+      jumps[num_jumps].turn     = NO_TURN;
+      jumps[num_jumps].xpos     = x;
+      jumps[num_jumps].ypos     = y;
+      num_jumps++;
+    }
+  }
+
+  return num_jumps;
+}
+
+
+/***
+ *      _____                 _
+ *     / ____|               | |
+ *    | |  __ _ __ __ _ _ __ | |__
+ *    | | |_ | '__/ _` | '_ \| '_ \
+ *    | |__| | | | (_| | |_) | | | |
+ *     \_____|_|  \__,_| .__/|_| |_|
+ *                     | |
+ *                     |_|
+ *
+ * The reachability graph, a line per jump from a jumper to a landing.
+ */
+
+static int compare_jumps( const void* a, const void* b )
+{
+  const PLAYED_JUMP* ja = (const PLAYED_JUMP*)a;
+  const PLAYED_JUMP* jb = (const PLAYED_JUMP*)b;
+
+  if( ja->jumper_y != jb->jumper_y ) return ja->jumper_y - jb->jumper_y;
+  if( ja->jumper_x != jb->jumper_x ) return ja->jumper_x - jb->jumper_x;
+  if( ja->facing   != jb->facing   ) return ja->facing   - jb->facing;
+  if( ja->turn     != jb->turn     ) return ja->turn     - jb->turn;
+  return ja->xpos - jb->xpos;
+}
+
+/* The cell he's standing on, under the middle of him */
+#define LANDS_CELL_X(j) (RUNNER_CENTRE_X((j)->lands_x) >> 3)
+#define LANDS_CELL_Y(j) (((j)->lands_y+SPRITE_HEIGHT) >> 3)
+
+static int same_line( const PLAYED_JUMP* a, const PLAYED_JUMP* b )
+{
+  return a->jumper_x == b->jumper_x && a->jumper_y == b->jumper_y
+         && a->facing == b->facing && a->turn == b->turn
+         && a->xpos+1 == b->xpos && a->events == b->events
+         && LANDS_CELL_X(a) == LANDS_CELL_X(b) && LANDS_CELL_Y(a) == LANDS_CELL_Y(b);
+}
+
+static void print_events( uint8_t events )
+{
+  static const char* const names[] = { "bounce", "teleport", "finish", "nolanding" };
+  const char* separator = "";
+  uint8_t     i;
+
+  if( events == 0 )
+    printf( "-" );
+
+  for( i = 0; i < sizeof(names)/sizeof(names[0]); i++ )
+  {
+    if( events & (1 << i) )
+    {
+      printf( "%s%s", separator, names[i] );
+      separator = ",";
+    }
+  }
+}
+
+static void print_line( const PLAYED_JUMP* first, const PLAYED_JUMP* last, uint16_t min_frames,
+                        uint16_t max_frames, const uint8_t* crosses )
+{
+  const char* separator = "";
+  uint16_t    cell;
+
+  printf( "%u\t%u,%u\t%s\t", first->level, first->jumper_x, first->jumper_y,
+          first->facing == RIGHT ? "right" : "left" );
+  if( first->turn == NO_TURN )
+    printf( "-\t" );
+  else
+    printf( "%u\t", first->turn );
+  printf( "%u-%u\t%u\t", first->xpos, last->xpos, first->ypos );
+
+  if( first->events & EVENT_NOLANDING )
+    printf( "-" );
+  else
+    printf( "%u,%u", LANDS_CELL_X(first), LANDS_CELL_Y(first) );
+  printf( "\t%u-%u\t", min_frames, max_frames );
+  print_events( first->events );
+  printf( "\t" );
+
+  for( cell = 0; cell < MAP_CELLS; cell++ )
+  {
+    if( crosses[cell>>3] & (1 << (cell&7)) )
+    {
+      printf( "%s%u,%u", separator, cell % TILE_MAP_WIDTH, cell / TILE_MAP_WIDTH );
+      separator = " ";
+    }
+  }
+  printf( "\n" );
+}
+
+static void print_graph( PLAYED_JUMP* jumps, size_t num_jumps )
+{
+  size_t i = 0;
+
+  qsort( jumps, num_jumps, sizeof(PLAYED_JUMP), compare_jumps );
+
+  while( i < num_jumps )
+  {
+    uint8_t  crosses[MAP_CELLS/8];
+    uint16_t min_frames = jumps[i].frames;
+    uint16_t max_frames = jumps[i].frames;
+    size_t   first      = i;
+    size_t   last       = i;
+    size_t   b;
+
+    while( last+1 < num_jumps && same_line( &jumps[last], &jumps[last+1] ) )
+      last++;
+
+    memcpy( crosses, jumps[i].crosses, sizeof(crosses) );
+    for( ; i <= last; i++ )
+    {
+      if( jumps[i].frames < min_frames ) min_frames = jumps[i].frames;
+      if( jumps[i].frames > max_frames ) max_frames = jumps[i].frames;
+      for( b = 0; b < sizeof(crosses); b++ )
+        crosses[b] |= jumps[i].crosses[b];
+    }
+
+    print_line( &jumps[first], &jumps[last], min_frames, max_frames, crosses );
+  }
+}
+
+/*
+ * Play the jumps from each take off point, then again turning on each
+ * pass he's still in the air for.
+ */
+static void graph_level( uint8_t level )
+{
+  PLAYED_JUMP* take_offs = malloc( 2*256*TILE_MAP_HEIGHT*sizeof(PLAYED_JUMP) );
+  PLAYED_JUMP* jumps     = NULL;
+  size_t       num_take_offs;
+  size_t       num_jumps = 0;
+  size_t       max_jumps = 0;
+  size_t       i;
+
+  start_level( level );
+
+  num_take_offs = find_take_offs( level, RIGHT, take_offs );
+  num_take_offs += find_take_offs( level, LEFT, take_offs+num_take_offs );
+
+  for( i = 0; i < num_take_offs; i++ )
+  {
+    uint8_t turn;
+
+    play_jump( &take_offs[i] );
+
+    for( turn = NO_TURN; turn == NO_TURN || turn <= take_offs[i].jump_passes; turn = turn ? turn+1 : 2 )
+    {
+      if( num_jumps == max_jumps )
+      {
+        max_jumps = max_jumps ? 2*max_jumps : 4096;
+        jumps = realloc( jumps, max_jumps*sizeof(PLAYED_JUMP) );
+      }
+
+      jumps[num_jumps] = take_offs[i];
+      if( turn != NO_TURN )
+      {
+        jumps[num_jumps].turn = turn;
+        play_jump( &jumps[num_jumps] );
+      }
+      num_jumps++;
+    }
+  }
+
+  print_graph( jumps, num_jumps );
+  teardown_level( game_state.current_level );
+
+  free( jumps );
+  free( take_offs );
+}
+
+
+/***
+ *      _______    _     _
+ *     |__   __|  | |   | |
+ *        | | __ _| |__ | | ___  ___
+ *        | |/ _` | '_ \| |/ _ \/ __|
+ *        | | (_| | |_) | |  __/\__ \
+ *        |_|\__,_|_.__/|_|\___||___/
+ *
+ * The jump tables for the game, see jump_tables.h.
+ */
+
+/*
+ * An entry for each run of take off points next to each other on a row,
+ * with the least safe offset of any of them each way. A point he can
+ * only take off from facing one way, with a wall right next to him on
+ * the other side, makes the other way's 0.
+ */
+static size_t table_level( FILE* table, uint8_t level )
+{
+  uint8_t  safe[2][256];
+  size_t   entries = 0;
+  uint8_t  cy;
+
+  start_level( level );
+
+  for( cy = 1; cy < TILE_MAP_HEIGHT; cy++ )
+  {
+    uint8_t  y     = (cy<<3)-SPRITE_HEIGHT;
+    uint16_t first = 0;
+    uint16_t x;
+
+    for( x = 1; x < 256-SPRITE_WIDTH; x++ )
+    {
+      safe[RIGHT][x] = safe[LEFT][x] = 0;
+      if( jumper_under( x, cy ) == NO_JUMPER || !standing_room( x, y ) )
+        continue;
+
+      safe[RIGHT][x] = safe_jump_offset( x, y, RIGHT );
+      safe[LEFT][x]  = safe_jump_offset( x, y, LEFT );
+    }
+
+    /* Runs of points with a jump off them, put out as they end */
+    for( x = 1; x <= 256-SPRITE_WIDTH; x++ )
+    {
+      int jumps = (x < 256-SPRITE_WIDTH) && (safe[RIGHT][x] || safe[LEFT][x]);
+
+      if( jumps && !first )
+        first = x;
+      else if( !jumps && first )
+      {
+        uint8_t  least[2] = { JUMP_LENGTH, JUMP_LENGTH };
+        uint16_t i;
+
+        for( i = first; i < x; i++ )
+        {
+          if( safe[RIGHT][i] < least[RIGHT] ) least[RIGHT] = safe[RIGHT][i];
+          if( safe[LEFT][i]  < least[LEFT]  ) least[LEFT]  = safe[LEFT][i];
+        }
+
+        fprintf( table, "        defb 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X\n",
+                 game_state.current_level->level_num, y, first, x-1, least[RIGHT], least[LEFT] );
+        entries++;
+        first = 0;
+      }
+    }
+  }
+
+  teardown_level( game_state.current_level );
+  return entries;
+}
+
+static int write_table( const char* filename, uint8_t only_level )
+{
+  FILE*   table = fopen( filename, "w" );
+  uint8_t level;
+
+  if( table == NULL )
+  {
+    perror( filename );
+    return 1;
+  }
+
+  fprintf( table, ";; Generated from the levels by wonky_jumps, don't edit\n\n" );
+  fprintf( table, "SECTION LEVEL_DATA\n\n" );
+  fprintf( table, "PUBLIC _jump_tables\n" );
+  fprintf( table, "._jump_tables\n" );
+
+  for( level = only_level ? only_level : 1; level < NUM_LEVELS; level++ )
+  {
+    fprintf( stderr, "level %u: %lu entries\n", level, (unsigned long)table_level( table, level ) );
+    if( only_level )
+      break;
+  }
+
+  fprintf( table, "        defb 0x%02X\n", JUMP_TABLE_END );
+
+  if( fclose( table ) != 0 )
+  {
+    perror( filename );
+    return 1;
+  }
+  return 0;
+}
+
+
+static void usage( const char* name )
+{
+  fprintf( stderr, "Usage: %s [-l level] [-t table_file]\n", name );
+  exit( 1 );
+}
+
+int main( int argc, char* argv[] )
+{
+  unsigned long only_level = 0;
+  const char*   table_file = NULL;
+  int           opt;
+  uint8_t       level;
+
+  while( (opt = getopt( argc, argv, "l:t:" )) != -1 )
+  {
+    switch( opt )
+    {
+    case 'l': only_level = strtoul( optarg, NULL, 0 ); break;
+    case 't': table_file = optarg;                     break;
+    default:  usage( argv[0] );
+    }
+  }
+
+  if( optind != argc || only_level >= NUM_LEVELS )
+    usage( argv[0] );
+
+  if( (image = host_game_image( &image_words )) == NULL )
+  {
+    fprintf( stderr, "The data section isn't word aligned, the state can't be saved\n" );
+    return 2;
+  }
+  level_start    = malloc( image_words*sizeof(uint64_t) );
+  doors_shut_map = malloc( MAP_CELLS );
+
+  host_setup_game();
+
+  if( table_file != NULL )
+    return write_table( table_file, only_level );
+
+  printf( "# level\tjumper\tfacing\tturn\ttakeoff_x\ttakeoff_y\tlands\tframes\tevents\tcrosses\n" );
+
+  /* Level 0 is the intro screen, which has no jumpers */
+  for( level = only_level ? only_level : 1; level < NUM_LEVELS; level++ )
+  {
+    graph_level( level );
+    if( only_level )
+      break;
+  }
+
+  return 0;
+}
@@ -0,0 +1,742 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * T-state profiler. This runs the real Spectrum binary on the Z80 core
+ * in z80_core.c and reports where the frame time goes:
+ *
+ *  - T-states for each time round the game loop, halt to halt, with any
+ *    which took more than one frame flagged. Those are the ones where the
+ *    intrinsic_halt() at the bottom of gameloop() missed its interrupt
+ *    and the game dropped to 25fps or worse.
+ *  - T-states for each function gameloop() calls, which includes each of
+ *    the game_actions[] entries, named from wonky.sym.
+ *
+ *  wonky_profile [-s wonky.sym] [-r 48.rom] [-w] [-o offset] [-f frames] [-v] wonky.tap recording.rzx
+ *  wonky_profile -x [-s symbols] [-f frames] [-v] recording.rzx
+ *
+ * The normal mode loads wonky.tap and plays it using the control key
+ * presses from an RZX recording, by frame number, starting offset frames
+ * into the run. The recording was made on an older build so it won't
+ * follow exactly the same route, but it's a real human's play and puts
+ * the game through the same sort of load.
+ *
+ * -x replays the recording properly instead, on its own embedded snapshot,
+ * which checks the core: every frame's instruction count and port reads
+ * have to come out the same as they did on the emulator which recorded
+ * it. Symbols are only meaningful in that mode if they match the build
+ * the recording was made with.
+ *
+ * Without a ROM image (-r) the ROM area is empty apart from an EI/RET at
+ * the IM1 interrupt entry, which is enough for the game since it doesn't
+ * use the ROM. -w makes the ROM area writable, like the emulator setting
+ * that turns on the game's trace tables.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "z80_core.h"
+#include "spectrum_files.h"
+
+#define DEFAULT_SYMBOLS   "wonky.sym"
+
+/* Where the BASIC loader leaves things when it calls the code */
+#define BASIC_SP          0xFF40
+#define BASIC_IY          0x5C3A
+#define BASIC_I           0x3F
+#define IM1_ENTRY         0x0038
+
+#define ULA_PORT_MASK     0x0001
+#define SPACE_ROW_SELECT  0x8000      /* A15 low selects B N M SymShift Space */
+#define SPACE_KEY_BIT     0x01
+#define ULA_IDLE_READ     0xBF
+
+
+/***
+ *       _____                 _           _
+ *      / ____|               | |         | |
+ *     | (___  _   _ _ __ ___ | |__   ___ | |___
+ *      \___ \| | | | '_ ` _ \| '_ \ / _ \| / __|
+ *      ____) | |_| | | | | | | |_) | (_) | \__ \
+ *     |_____/ \__, |_| |_| |_|_.__/ \___/|_|___/
+ *              __/ |
+ *             |___/
+ */
+
+typedef struct _symbol
+{
+  char*    name;
+  uint16_t addr;
+} SYMBOL;
+
+static SYMBOL*  symbols     = NULL;
+static size_t   num_symbols = 0;
+
+/* Symbol index of the function starting at each address, or -1 */
+static int32_t  entry_symbol[0x10000];
+
+static int compare_symbol( const void* a, const void* b )
+{
+  uint16_t addr_a = ((const SYMBOL*)a)->addr;
+  uint16_t addr_b = ((const SYMBOL*)b)->addr;
+
+  return (addr_a > addr_b) - (addr_a < addr_b);
+}
+
+/*
+ * C functions have a leading underscore; the compiler's local labels
+ * and literals don't.
+ */
+#define IS_FUNCTION_NAME(n)  ((n)[0] == '_')
+
+/*
+ * wonky.sym is "name hexaddr" per line, as made by generate_symbols.pl.
+ */
+static int load_symbols( const char* filename )
+{
+  FILE*    fh;
+  char     name[256];
+  unsigned addr;
+  size_t   allocated = 0;
+  size_t   i;
+
+  for( i = 0; i < 0x10000; i++ )
+    entry_symbol[i] = -1;
+
+  if( (fh = fopen( filename, "r" )) == NULL )
+  {
+    perror( filename );
+    return 1;
+  }
+
+  while( fscanf( fh, "%255s %x", name, &addr ) == 2 )
+  {
+    if( num_symbols == allocated )
+    {
+      allocated = allocated ? allocated*2 : 512;
+      if( (symbols = realloc( symbols, allocated*sizeof(SYMBOL) )) == NULL )
+      {
+        fprintf( stderr, "Out of memory reading %s\n", filename );
+        exit( 2 );
+      }
+    }
+    symbols[num_symbols].name = strdup( name );
+    symbols[num_symbols].addr = addr;
+    num_symbols++;
+  }
+
+  fclose( fh );
+
+  qsort( symbols, num_symbols, sizeof(SYMBOL), compare_symbol );
+
+  for( i = 0; i < num_symbols; i++ )
+  {
+    if( IS_FUNCTION_NAME( symbols[i].name ) && entry_symbol[symbols[i].addr] == -1 )
+      entry_symbol[symbols[i].addr] = i;
+  }
+
+  return 0;
+}
+
+static const SYMBOL* find_symbol( const char* name )
+{
+  size_t i;
+
+  for( i = 0; i < num_symbols; i++ )
+    if( strcmp( symbols[i].name, name ) == 0 )
+      return &symbols[i];
+
+  return NULL;
+}
+
+/*
+ * A function runs up to the next function symbol.
+ */
+static uint16_t function_end( const SYMBOL* function )
+{
+  size_t i;
+
+  for( i = function - symbols + 1; i < num_symbols; i++ )
+    if( symbols[i].addr > function->addr && IS_FUNCTION_NAME( symbols[i].name ) )
+      return symbols[i].addr;
+
+  return 0xFFFF;
+}
+
+/* Without a leading underscore, for printing */
+static const char* display_name( int32_t symbol )
+{
+  const char* name = symbols[symbol].name;
+  return IS_FUNCTION_NAME( name ) ? name+1 : name;
+}
+
+
+/***
+ *      _____            __ _ _
+ *     |  __ \          / _(_) |
+ *     | |__) | __ ___ | |_ _| | ___
+ *     |  ___/ '__/ _ \|  _| | |/ _ \
+ *     | |   | | | (_) | | | | |  __/
+ *     |_|   |_|  \___/|_| |_|_|\___|
+ */
+
+typedef struct _function_profile
+{
+  uint32_t calls;
+  uint64_t total;
+  uint32_t max;
+  uint32_t this_iteration;
+} FUNCTION_PROFILE;
+
+static FUNCTION_PROFILE* profiles;
+
+/* gameloop() itself */
+static uint16_t gameloop_start;
+static uint16_t gameloop_end;
+
+#define IN_GAMELOOP(pc)  ((pc) >= gameloop_start && (pc) < gameloop_end)
+
+/*
+ * SDCC calls through function pointers via a helper which does a JP (HL).
+ * The helper is skipped so the time goes to the function it jumps to.
+ */
+#define IS_CALL_HELPER(n)  (strncmp( (n), "___sdcc_call_", 13 ) == 0)
+
+/*
+ * Absolute T-state count, which keeps going across frames.
+ */
+static uint64_t frame_base = 0;
+#define NOW(z)  (frame_base + (z)->tstates)
+
+/* The gameloop() callee being timed. Only direct callees are timed. */
+static int32_t  callee_symbol = -1;
+static uint64_t callee_start;
+static uint64_t callee_isr_start;
+static uint16_t callee_sp;
+static uint16_t callee_return;
+
+/* The ISR, if it's running. Its time is taken off whatever it interrupted. */
+static int      in_isr = 0;
+static uint64_t isr_start;
+static uint16_t isr_sp;
+static uint16_t isr_return;
+static uint64_t isr_total = 0;
+static uint32_t isr_calls = 0;
+static uint32_t isr_max   = 0;
+
+/* Game loop iterations, interrupt to halt */
+static int      iteration_running = 0;
+static uint64_t iteration_start;
+static uint16_t iteration_sp;
+static uint32_t iteration_interrupts;
+static uint32_t iterations = 0;
+static uint64_t iteration_total = 0;
+static uint32_t iteration_max = 0;
+static uint32_t iterations_missed = 0;
+static uint32_t frames_missed = 0;
+
+static uint32_t frame_num = 0;
+static int      verbose = 0;
+
+static void before_step( Z80_CORE* z )
+{
+  uint16_t pc = z->pc;
+
+  /*
+   * The stack going above where it was at the halt means gameloop() has
+   * returned, so the level's over and this isn't a game loop iteration.
+   */
+  if( iteration_running && z->sp > iteration_sp )
+    iteration_running = 0;
+
+  if( in_isr )
+  {
+    if( pc == isr_return && z->sp == (uint16_t)(isr_sp+2) )
+    {
+      uint32_t elapsed = NOW(z) - isr_start;
+
+      in_isr = 0;
+      isr_total += elapsed;
+      if( elapsed > isr_max )
+        isr_max = elapsed;
+    }
+    return;
+  }
+
+  if( callee_symbol >= 0 )
+  {
+    if( pc == callee_return && z->sp == (uint16_t)(callee_sp+2) )
+    {
+      FUNCTION_PROFILE* profile = &profiles[callee_symbol];
+      uint32_t          elapsed = (NOW(z) - callee_start) - (isr_total - callee_isr_start);
+
+      profile->calls++;
+      profile->total += elapsed;
+      profile->this_iteration += elapsed;
+      if( elapsed > profile->max )
+        profile->max = elapsed;
+
+      callee_symbol = -1;
+    }
+    return;
+  }
+
+  if( entry_symbol[pc] >= 0 && !IN_GAMELOOP(pc) )
+  {
+    uint16_t return_addr = Z80_CORE_PEEK16( z, z->sp );
+
+    if( IN_GAMELOOP(return_addr) && !IS_CALL_HELPER( symbols[entry_symbol[pc]].name ) )
+    {
+      callee_symbol    = entry_symbol[pc];
+      callee_start     = NOW(z);
+      callee_isr_start = isr_total;
+      callee_sp        = z->sp;
+      callee_return    = return_addr;
+    }
+  }
+}
+
+static void interrupt_taken( Z80_CORE* z, int was_halted, uint16_t halted_pc, uint16_t halted_sp, uint64_t accepted_at )
+{
+  in_isr     = 1;
+  isr_start  = accepted_at;
+  isr_sp     = z->sp;
+  isr_return = Z80_CORE_PEEK16( z, z->sp );
+  isr_calls++;
+
+  if( was_halted && IN_GAMELOOP(halted_pc) )
+  {
+    iteration_running    = 1;
+    iteration_start      = accepted_at;
+    iteration_sp         = halted_sp;
+    iteration_interrupts = 0;
+  }
+
+  if( iteration_running )
+    iteration_interrupts++;
+}
+
+static int compare_profile_total( const void* a, const void* b )
+{
+  uint64_t total_a = profiles[*(const int32_t*)a].total;
+  uint64_t total_b = profiles[*(const int32_t*)b].total;
+
+  return (total_a < total_b) - (total_a > total_b);
+}
+
+/*
+ * The CPU has just halted. If it's the halt in gameloop() that's the end
+ * of an iteration.
+ */
+static void halted( Z80_CORE* z )
+{
+  uint32_t elapsed;
+  size_t   i;
+
+  if( !iteration_running || !IN_GAMELOOP(z->pc) )
+    return;
+
+  elapsed = NOW(z) - iteration_start;
+
+  iterations++;
+  iteration_total += elapsed;
+  if( elapsed > iteration_max )
+    iteration_max = elapsed;
+
+  if( iteration_interrupts > 1 || verbose )
+  {
+    int32_t biggest = -1;
+
+    printf( "frame %6u  %6u T-states %3u%%", frame_num, elapsed, (unsigned)(elapsed*100/ZX48_FRAME_TSTATES) );
+
+    for( i = 0; i < num_symbols; i++ )
+      if( profiles[i].this_iteration && (biggest < 0 || profiles[i].this_iteration > profiles[biggest].this_iteration) )
+        biggest = i;
+    if( biggest >= 0 )
+      printf( "  biggest %s %u", display_name( biggest ), profiles[biggest].this_iteration );
+
+    if( iteration_interrupts > 1 )
+      printf( "  MISSED %u", iteration_interrupts-1 );
+    printf( "\n" );
+  }
+
+  if( iteration_interrupts > 1 )
+  {
+    iterations_missed++;
+    frames_missed += iteration_interrupts-1;
+  }
+
+  for( i = 0; i < num_symbols; i++ )
+    profiles[i].this_iteration = 0;
+
+  iteration_running = 0;
+}
+
+static void report( void )
+{
+  int32_t* order = malloc( num_symbols * sizeof(int32_t) );
+  size_t   num_called = 0;
+  size_t   i;
+
+  printf( "\n%u frames, %u game loop iterations\n", frame_num, iterations );
+  if( iterations )
+  {
+    printf( "iteration mean %llu max %u T-states, budget %u\n",
+            (unsigned long long)(iteration_total/iterations), iteration_max, ZX48_FRAME_TSTATES );
+    printf( "%u iterations over budget, %u frames missed\n", iterations_missed, frames_missed );
+  }
+  if( isr_calls )
+    printf( "isr mean %llu max %u T-states\n", (unsigned long long)(isr_total/isr_calls), isr_max );
+
+  for( i = 0; i < num_symbols; i++ )
+    if( profiles[i].calls )
+      order[num_called++] = i;
+  qsort( order, num_called, sizeof(int32_t), compare_profile_total );
+
+  printf( "\n%-32s %8s %10s %8s %8s\n", "called from gameloop", "calls", "mean", "max", "total%" );
+  for( i = 0; i < num_called; i++ )
+  {
+    FUNCTION_PROFILE* profile = &profiles[order[i]];
+
+    printf( "%-32s %8u %10llu %8u %7.1f%%\n", display_name( order[i] ), profile->calls,
+            (unsigned long long)(profile->total/profile->calls), profile->max,
+            iteration_total ? 100.0*profile->total/iteration_total : 0.0 );
+  }
+
+  free( order );
+}
+
+
+/***
+ *      _    _               _
+ *     | |  | |             | |
+ *     | |__| | __ _ _ __ __| |_      ____ _ _ __ ___
+ *     |  __  |/ _` | '__/ _` \ \ /\ / / _` | '__/ _ \
+ *     | |  | | (_| | | | (_| |\ V  V / (_| | | |  __/
+ *     |_|  |_|\__,_|_|  \__,_| \_/\_/ \__,_|_|  \___|
+ */
+
+/* Normal mode: the control key from the recording, by frame */
+static uint8_t* key_down = NULL;
+static uint32_t num_key_frames = 0;
+static uint32_t key_offset = 0;
+
+static uint8_t keyboard_in( Z80_CORE* z, uint16_t port )
+{
+  uint8_t value = 0xFF;
+  (void)z;
+
+  if( !(port & ULA_PORT_MASK) )
+  {
+    uint32_t key_frame = frame_num - key_offset;
+
+    value = ULA_IDLE_READ;
+    if( !(port & SPACE_ROW_SELECT) && frame_num >= key_offset &&
+        key_frame < num_key_frames && key_down[key_frame] )
+      value &= ~SPACE_KEY_BIT;
+  }
+
+  return value;
+}
+
+/* Exact mode: the recorded port values, in order */
+static const RZX_FRAME* replay_frame;
+static uint16_t         replay_input;
+static uint32_t         replay_overruns;
+
+static uint8_t replay_in( Z80_CORE* z, uint16_t port )
+{
+  (void)z;
+  (void)port;
+
+  if( replay_input < replay_frame->num_inputs )
+    return replay_frame->inputs[replay_input++];
+
+  replay_overruns++;
+  return 0xFF;
+}
+
+/*
+ * Skip the rest of a halt. It's NOPs, 4T and an R bump each.
+ */
+static void skip_halt( Z80_CORE* z, uint32_t nops )
+{
+  z->tstates += 4*nops;
+  z->fetches += nops;
+  z->r = (z->r & 0x80) | ((z->r + nops) & 0x7F);
+}
+
+static void step( Z80_CORE* z )
+{
+  before_step( z );
+  z80_core_step( z );
+  if( z->halted )
+    halted( z );
+}
+
+static void interrupt( Z80_CORE* z )
+{
+  int      was_halted = z->halted;
+  uint16_t halted_pc  = z->pc;
+  uint16_t halted_sp  = z->sp;
+  uint64_t accepted_at = NOW(z);
+
+  if( z80_core_interrupt( z ) )
+    interrupt_taken( z, was_halted, halted_pc, halted_sp, accepted_at );
+}
+
+/*
+ * Normal mode frame. The interrupt is held for the first 32T, and is
+ * taken at the first instruction boundary in that window where the
+ * CPU will accept it.
+ */
+static void run_frame( Z80_CORE* z )
+{
+  int taken = 0;
+
+  while( z->tstates < ZX48_FRAME_TSTATES )
+  {
+    if( !taken && z->tstates < ZX48_INT_LENGTH && z->iff1 && !z->ei_delay )
+    {
+      interrupt( z );
+      taken = 1;
+      continue;
+    }
+
+    if( z->halted && (taken || z->tstates >= ZX48_INT_LENGTH || !z->iff1) )
+    {
+      skip_halt( z, (ZX48_FRAME_TSTATES - z->tstates + 3) / 4 );
+      break;
+    }
+
+    step( z );
+  }
+
+  z->tstates -= ZX48_FRAME_TSTATES;
+  frame_base += ZX48_FRAME_TSTATES;
+}
+
+/*
+ * Exact mode frame. The recording's instruction count says where the
+ * interrupt goes, whatever the T-states say.
+ */
+static int replay_rzx_frame( Z80_CORE* z, const RZX_FRAME* frame )
+{
+  replay_frame = frame;
+  replay_input = 0;
+
+  z->fetches = 0;
+  while( z->fetches < frame->fetches )
+  {
+    if( z->halted )
+      skip_halt( z, frame->fetches - z->fetches );
+    else
+      step( z );
+  }
+
+  if( z->fetches != frame->fetches || replay_input != frame->num_inputs )
+  {
+    fprintf( stderr, "frame %u: replay diverged, %u fetches for %u, %u inputs for %u\n",
+             frame_num, z->fetches, frame->fetches, replay_input, frame->num_inputs );
+    return 1;
+  }
+
+  interrupt( z );
+
+  /* Keep the T-states lined up with the frame for the contention */
+  if( z->tstates >= ZX48_FRAME_TSTATES )
+  {
+    z->tstates -= ZX48_FRAME_TSTATES;
+    frame_base += ZX48_FRAME_TSTATES;
+  }
+  return 0;
+}
+
+
+/***
+ *      __  __       _
+ *     |  \/  |     (_)
+ *     | \  / | __ _ _ _ __
+ *     | |\/| |/ _` | | '_ \
+ *     | |  | | (_| | | | | |
+ *     |_|  |_|\__,_|_|_| |_|
+ */
+
+static void usage( const char* name )
+{
+  fprintf( stderr, "Usage: %s [-s symbols] [-r rom] [-w] [-o frame_offset] [-f max_frames] [-v] tap_file rzx_file\n"
+                   "       %s -x [-s symbols] [-f max_frames] [-v] rzx_file\n", name, name );
+  exit( 1 );
+}
+
+int main( int argc, char* argv[] )
+{
+  static Z80_CORE z;
+
+  const char*     symbols_file = DEFAULT_SYMBOLS;
+  const char*     rom_file     = NULL;
+  const char*     tap_file     = NULL;
+  const char*     rzx_file;
+  int             exact        = 0;
+  unsigned long   max_frames   = 0;
+  RZX_RECORDING   rzx;
+  const SYMBOL*   gameloop;
+  uint32_t        frame;
+  int             opt;
+
+  while( (opt = getopt( argc, argv, "s:r:wo:f:vx" )) != -1 )
+  {
+    switch( opt )
+    {
+    case 's': symbols_file = optarg;                   break;
+    case 'r': rom_file = optarg;                       break;
+    case 'w': z.rom_writable = 1;                      break;
+    case 'o': key_offset = strtoul( optarg, NULL, 0 ); break;
+    case 'f': max_frames = strtoul( optarg, NULL, 0 ); break;
+    case 'v': verbose = 1;                             break;
+    case 'x': exact = 1;                               break;
+    default:  usage( argv[0] );
+    }
+  }
+
+  if( argc - optind != (exact ? 1 : 2) )
+    usage( argv[0] );
+  if( !exact )
+    tap_file = argv[optind++];
+  rzx_file = argv[optind];
+
+  if( load_symbols( symbols_file ) || load_rzx( rzx_file, &rzx ) )
+    exit( 1 );
+
+  if( (gameloop = find_symbol( "_gameloop" )) == NULL )
+  {
+    fprintf( stderr, "%s: no _gameloop symbol\n", symbols_file );
+    exit( 1 );
+  }
+  gameloop_start = gameloop->addr;
+  gameloop_end   = function_end( gameloop );
+
+  if( (profiles = calloc( num_symbols, sizeof(FUNCTION_PROFILE) )) == NULL )
+  {
+    fprintf( stderr, "Out of memory\n" );
+    exit( 2 );
+  }
+
+  {
+    /* Reset clears the flag set by -w */
+    uint8_t rom_writable = z.rom_writable;
+    z80_core_reset( &z );
+    z.rom_writable = rom_writable;
+  }
+
+  if( exact )
+  {
+    if( strcmp( rzx.snapshot_type, "z80" ) != 0 && strcmp( rzx.snapshot_type, "Z80" ) != 0 )
+    {
+      fprintf( stderr, "%s: only .z80 snapshots are supported, not .%s\n", rzx_file, rzx.snapshot_type );
+      exit( 1 );
+    }
+    if( load_z80_snapshot( rzx.snapshot, rzx.snapshot_length, &z ) )
+      exit( 1 );
+
+    z.tstates = rzx.start_tstates % ZX48_FRAME_TSTATES;
+    z.port_in = replay_in;
+  }
+  else
+  {
+    uint16_t entry;
+
+    if( rom_file )
+    {
+      size_t   rom_length;
+      uint8_t* rom = load_file( rom_file, &rom_length );
+
+      if( rom == NULL )
+        exit( 1 );
+      if( rom_length != 0x4000 )
+      {
+        fprintf( stderr, "%s: a 48K ROM is 16384 bytes\n", rom_file );
+        exit( 1 );
+      }
+      memcpy( z.memory, rom, 0x4000 );
+      free( rom );
+    }
+    else
+    {
+      z.memory[IM1_ENTRY]   = 0xFB;   /* EI  */
+      z.memory[IM1_ENTRY+1] = 0xC9;   /* RET */
+    }
+
+    if( load_tap( tap_file, &z, &entry ) )
+      exit( 1 );
+
+    z.pc   = entry;
+    z.sp   = BASIC_SP;
+    z.iyh  = BASIC_IY >> 8;
+    z.iyl  = BASIC_IY & 0xFF;
+    z.i    = BASIC_I;
+    z.im   = 1;
+    z.iff1 = z.iff2 = 1;
+    z.port_in = keyboard_in;
+
+    /* The key is down in a frame if any port read in it saw it down */
+    num_key_frames = rzx.num_frames;
+    if( (key_down = calloc( num_key_frames, 1 )) == NULL )
+    {
+      fprintf( stderr, "Out of memory\n" );
+      exit( 2 );
+    }
+    for( frame = 0; frame < num_key_frames; frame++ )
+    {
+      uint16_t input;
+
+      for( input = 0; input < rzx.frames[frame].num_inputs; input++ )
+        if( !(rzx.frames[frame].inputs[input] & SPACE_KEY_BIT) )
+          key_down[frame] = 1;
+    }
+  }
+
+  if( max_frames == 0 )
+    max_frames = exact ? rzx.num_frames : rzx.num_frames + key_offset;
+
+  for( frame_num = 0; frame_num < max_frames; frame_num++ )
+  {
+    if( exact )
+    {
+      if( frame_num >= rzx.num_frames || replay_rzx_frame( &z, &rzx.frames[frame_num] ) )
+        break;
+    }
+    else
+    {
+      run_frame( &z );
+    }
+  }
+
+  report();
+
+  if( exact && replay_overruns )
+    printf( "%u port reads past the end of the recorded values\n", replay_overruns );
+
+  free_rzx( &rzx );
+  return (exact && frame_num != max_frames) ? 1 : 0;
+}
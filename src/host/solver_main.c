@@ -0,0 +1,826 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Route solver. Finds a route through each level, and the key presses
+ * which do it, by searching the game's states with the real game loop,
+ * the same code the host build plays. That shows the level designer
+ * whether it can be done inside the countdown at all. Where the search
+ * has room to finish, the route is the fastest there is, which is a
+ * hard lower bound on the level's time. Where it hasn't, the route is
+ * only one that can be played, so it's an upper bound.
+ *
+ *  wonky_solver [-j workers] [-l level] [-f max_frames] [-m visited_bits] [-o script_prefix] [-v]
+ *
+ * It prints a line per level. With -o the route for each level is
+ * written to <script_prefix><level>.keys, a key script which
+ * "wonky_host -v -l <level>" plays to the same finish.
+ *
+ * A state is taken after each pass of the game loop. Each pass has two
+ * moves, the control key up or down, and each costs a frame. Best first
+ * on frames is then a sweep a frame at a time: every state the level
+ * can be in after N frames is expanded before any after N+1, so the
+ * first finish found is the fastest there is. A state is only expanded
+ * the first time it's reached, as it can't do any better later.
+ *
+ * What makes a state the same as another, for that, is
+ * host_state_key(): the runner's position, facing, jump and slowdown,
+ * whether the key's press has been used (the pass reads the key itself
+ * afresh), the teleporter holdoff, the doors and pills and how long their
+ * timers have left, and the door animations waiting for the next pass.
+ * The countdown isn't part of it. A pass which runs the countdown out
+ * loses, so every route found is one which can be played, but a slower
+ * way to a state which had spent less countdown on pills isn't looked at.
+ *
+ * The timers are most of it. Every frame a pill or a key could be taken
+ * in starts its timer with a different time left, so there are hundreds
+ * of each state. A timer which won't run out before the finish makes no
+ * difference, though, so each level is searched twice. The first search
+ * doesn't key the timers at all, only whether they're running. It's
+ * quick, and the route it finds can be played, being made of real
+ * passes, so the fastest route takes no longer than that. The second
+ * keys the timers exactly, except the ones with more ticks left than
+ * there are frames to that bound, which all key alike. If that second
+ * search runs out of room before it finishes, the first route is the one
+ * given, and it says it's not been shown to be the fastest.
+ *
+ * At the default -m that's what happens on levels 3 and 5: their routes
+ * can be played but aren't shown to be the fastest. The other levels
+ * are. A run of every level takes about 7 minutes on one core. -m 28
+ * needs more than the 6GB of memory it was tried on, so whether a
+ * bigger visited set would be enough for those two is still open.
+ *
+ * The game keeps all its state in globals, so the workers are processes
+ * rather than threads, each with its own copy of the game, sharing the
+ * search through memory mapped before they're forked. A state is saved
+ * as the words of the executable's data and bss which differ from the
+ * level's start, and put back over them to be expanded, much like a
+ * snapshot of the Spectrum's memory. The visited set is a lock-free
+ * hash of the states' keys. Each frame's states are shared out across
+ * the workers, and a worker which runs out takes work from the one with
+ * the most left.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <arch/zx.h>
+#include <arch/zx/sp1.h>
+
+#include "host.h"
+#include "../game_state.h"
+#include "../levels.h"
+#include "../gameloop.h"
+#include "../countdown.h"
+#include "../input_log.h"
+
+#if INPUT_LOG == INPUT_LOG_REPLAY
+#error "The route solver chooses the keys, it can't be built to replay an input log"
+#endif
+
+/* These are in main.c in the Spectrum build */
+struct sp1_Rect full_screen = {0, 0, 32, 24};
+GAME_STATE      game_state;
+
+extern LEVEL_DATA level_data[];
+
+#define MAX_WORKERS          64
+#define DEFAULT_FRAME_LIMIT  (COUNTDOWN_START_SECS*50UL)
+#define DEFAULT_VISITED_BITS 26
+
+/* States and saved words one frame of the search can hold */
+#define MAX_LAYER_STATES     (1UL << 22)
+#define LAYER_ARENA_SIZE     (1UL << 32)
+
+#define MAX_ROUTES           (1UL << 28)
+#define NO_ROUTE             0xFFFFFFFF
+
+/* States taken from the frame's list at a time */
+#define WORK_CHUNK           16
+
+
+/***
+ *       _____ _                     _
+ *      / ____| |                   | |
+ *     | (___ | |__   __ _ _ __ ___ | |
+ *      \___ \| '_ \ / _` | '__/ _ \| |
+ *      ____) | | | | (_| | | |  __/|_|
+ *     |_____/|_| |_|\__,_|_|  \___|(_)
+ *
+ * Everything the workers share, in memory mapped before they fork.
+ */
+
+/* How each state was reached, to read the route back from the finish */
+typedef struct _route
+{
+  uint32_t parent;
+  uint8_t  key;
+} ROUTE;
+
+/* A state waiting to be expanded: its route and where its words are */
+typedef struct _state
+{
+  uint32_t route;
+  uint32_t num_words;
+  uint64_t saved;
+} STATE;
+
+/* A word of the image which differs from the level's start */
+typedef struct _saved_word
+{
+  uint32_t index;
+  uint64_t value;
+} __attribute__((packed)) SAVED_WORD;
+
+/* Each worker's share of a frame. Others take from it when they run out. */
+typedef struct _work_range
+{
+  uint32_t next;
+  uint32_t end;
+} __attribute__((aligned(64))) WORK_RANGE;
+
+typedef struct _solver
+{
+  uint32_t    workers;
+  uint32_t    frame_limit;
+
+  /* Timers which run out after this frame are keyed alike */
+  uint32_t    bound;
+
+  uint32_t    barrier_waiting;
+  uint32_t    barrier_generation;
+
+  /* The frame being expanded and the one being filled, swapped each frame */
+  uint32_t    frame;
+  uint8_t     current;
+  uint32_t    num_states[2];
+  STATE*      states[2];
+  uint64_t    arena_used[2];
+  uint8_t*    arena[2];
+
+  WORK_RANGE  ranges[MAX_WORKERS];
+
+  uint64_t*   visited;
+  uint64_t    visited_mask;
+  uint64_t    visited_count;
+
+  ROUTE*      routes;
+  uint32_t    num_routes;
+
+  /*
+   * The executable's data and bss, in words, and a copy of it at the
+   * level's start, which states are saved against.
+   */
+  uint64_t*   image;
+  size_t      image_words;
+  uint64_t*   level_start;
+
+  /* Result, for the frame the search stopped at */
+  uint32_t    finish_route;
+  uint32_t    finish_frame;
+  uint16_t    finish_countdown;
+  uint8_t     out_of_room;
+  uint8_t     done;
+
+  uint64_t    passes_run;
+  uint64_t    losses;
+} SOLVER;
+
+static void* map_shared( size_t size )
+{
+  void* mem = mmap( NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0 );
+
+  if( mem == MAP_FAILED )
+  {
+    perror( "mmap" );
+    exit( 2 );
+  }
+  return mem;
+}
+
+static void barrier( SOLVER* s )
+{
+  uint32_t generation = __atomic_load_n( &s->barrier_generation, __ATOMIC_ACQUIRE );
+
+  if( __atomic_add_fetch( &s->barrier_waiting, 1, __ATOMIC_ACQ_REL ) == s->workers )
+  {
+    __atomic_store_n( &s->barrier_waiting, 0, __ATOMIC_RELAXED );
+    __atomic_store_n( &s->barrier_generation, generation+1, __ATOMIC_RELEASE );
+  }
+  else
+  {
+    while( __atomic_load_n( &s->barrier_generation, __ATOMIC_ACQUIRE ) == generation )
+      sched_yield();
+  }
+}
+
+/*
+ * Answers 1 if the key's hash hadn't been seen before. The table is open
+ * addressed, and a slot is claimed with a compare and swap from empty.
+ * Only the 64 bit hashes are kept; a clash would lose a state, which at
+ * the sizes this runs to is vanishingly unlikely.
+ */
+static int visit( SOLVER* s, const uint8_t* key, size_t length )
+{
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  uint64_t slot;
+  size_t   i;
+
+  for( i = 0; i < length; i++ )
+    hash = (hash ^ key[i]) * 0x100000001B3ULL;
+  hash ^= hash >> 29;
+  if( hash == 0 )
+    hash = 1;
+
+  for( slot = hash & s->visited_mask; ; slot = (slot+1) & s->visited_mask )
+  {
+    uint64_t seen = __atomic_load_n( &s->visited[slot], __ATOMIC_ACQUIRE );
+
+    if( seen == 0 )
+    {
+      if( __atomic_compare_exchange_n( &s->visited[slot], &seen, hash, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+      {
+        if( __atomic_add_fetch( &s->visited_count, 1, __ATOMIC_RELAXED ) > s->visited_mask - s->visited_mask/4 )
+          __atomic_store_n( &s->out_of_room, 1, __ATOMIC_RELAXED );
+        return 1;
+      }
+    }
+    if( seen == hash )
+      return 0;
+  }
+}
+
+/*
+ * Take the next few states of this frame, from the worker's own share
+ * or, when that's gone, from whichever share has the most left.
+ */
+static int take_work( SOLVER* s, uint32_t worker, uint32_t* first, uint32_t* count )
+{
+  for( ;; )
+  {
+    uint32_t victim = worker;
+    uint32_t first_taken;
+    WORK_RANGE* range = &s->ranges[worker];
+
+    if( __atomic_load_n( &range->next, __ATOMIC_RELAXED ) >= range->end )
+    {
+      uint32_t most = 0;
+      uint32_t w;
+
+      for( w = 0; w < s->workers; w++ )
+      {
+        uint32_t next = __atomic_load_n( &s->ranges[w].next, __ATOMIC_RELAXED );
+
+        if( next < s->ranges[w].end && s->ranges[w].end - next > most )
+        {
+          most   = s->ranges[w].end - next;
+          victim = w;
+        }
+      }
+      if( most == 0 )
+        return 0;
+      range = &s->ranges[victim];
+    }
+
+    first_taken = __atomic_fetch_add( &range->next, WORK_CHUNK, __ATOMIC_RELAXED );
+    if( first_taken < range->end )
+    {
+      *first = first_taken;
+      *count = range->end - first_taken < WORK_CHUNK ? range->end - first_taken : WORK_CHUNK;
+      return 1;
+    }
+  }
+}
+
+
+/***
+ *       _____                         _____ _        _
+ *      / ____|                       / ____| |      | |
+ *     | |  __  __ _ _ __ ___   ___  | (___ | |_ __ _| |_ ___
+ *     | | |_ |/ _` | '_ ` _ \ / _ \  \___ \| __/ _` | __/ _ \
+ *     | |__| | (_| | | | | | |  __/  ____) | || (_| | ||  __/
+ *      \_____|\__,_|_| |_| |_|\___| |_____/ \__\__,_|\__\___|
+ */
+
+/*
+ * The search's own variables are all on the stack or in the shared
+ * mapping, so putting the image back doesn't touch them.
+ */
+static void restore_state( const SOLVER* s, const STATE* state, uint8_t layer )
+{
+  const SAVED_WORD* saved = (const SAVED_WORD*)(s->arena[layer] + state->saved);
+  uint64_t*         image = s->image;
+  uint32_t          i;
+
+  memcpy( image, s->level_start, s->image_words*sizeof(uint64_t) );
+  for( i = 0; i < state->num_words; i++ )
+    image[saved[i].index] = saved[i].value;
+}
+
+/*
+ * Returns the number of words saved in the buffer. Most of the image is
+ * as it was at the level's start, so it's compared a block at a time
+ * first.
+ */
+#define SAVE_BLOCK_WORDS 8
+
+static uint32_t save_state( const SOLVER* s, SAVED_WORD* buffer )
+{
+  const uint64_t* image = s->image;
+  const uint64_t* start = s->level_start;
+  uint32_t        count = 0;
+  size_t          i;
+
+  for( i = 0; i < s->image_words; i++ )
+  {
+    if( (i % SAVE_BLOCK_WORDS) == 0 && i+SAVE_BLOCK_WORDS <= s->image_words &&
+        memcmp( &image[i], &start[i], SAVE_BLOCK_WORDS*sizeof(uint64_t) ) == 0 )
+    {
+      i += SAVE_BLOCK_WORDS-1;
+      continue;
+    }
+    if( image[i] != start[i] )
+    {
+      buffer[count].index = i;
+      buffer[count].value = image[i];
+      count++;
+    }
+  }
+  return count;
+}
+
+static void start_level( SOLVER* s, uint8_t level )
+{
+  host_start_level( level );
+  memcpy( s->level_start, s->image, s->image_words*sizeof(uint64_t) );
+}
+
+
+/***
+ *      _____                      _
+ *     / ____|                    | |
+ *    | (___   ___  __ _ _ __ ___| |__
+ *     \___ \ / _ \/ _` | '__/ __| '_ \
+ *     ____) |  __/ (_| | | | (__| | | |
+ *    |_____/ \___|\__,_|_|  \___|_| |_|
+ */
+
+static void add_state( SOLVER* s, uint32_t parent, uint8_t key, SAVED_WORD* buffer )
+{
+  uint8_t  next = s->current ^ 1;
+  uint32_t num_words = save_state( s, buffer );
+  uint32_t route = __atomic_fetch_add( &s->num_routes, 1, __ATOMIC_RELAXED );
+  uint32_t index = __atomic_fetch_add( &s->num_states[next], 1, __ATOMIC_RELAXED );
+  uint64_t size  = (uint64_t)num_words * sizeof(SAVED_WORD);
+  uint64_t saved = __atomic_fetch_add( &s->arena_used[next], size, __ATOMIC_RELAXED );
+
+  if( route >= MAX_ROUTES || index >= MAX_LAYER_STATES || saved + size > LAYER_ARENA_SIZE )
+  {
+    __atomic_store_n( &s->out_of_room, 1, __ATOMIC_RELAXED );
+    return;
+  }
+
+  s->routes[route].parent = parent;
+  s->routes[route].key    = key;
+
+  memcpy( s->arena[next] + saved, buffer, size );
+  s->states[next][index].route     = route;
+  s->states[next][index].num_words = num_words;
+  s->states[next][index].saved     = saved;
+}
+
+static void finished( SOLVER* s, uint32_t parent, uint8_t key )
+{
+  uint32_t route = __atomic_fetch_add( &s->num_routes, 1, __ATOMIC_RELAXED );
+  uint32_t best;
+
+  if( route >= MAX_ROUTES )
+  {
+    __atomic_store_n( &s->out_of_room, 1, __ATOMIC_RELAXED );
+    return;
+  }
+  s->routes[route].parent = parent;
+  s->routes[route].key    = key;
+
+  /* Several may finish in the same frame. They're as fast as each other; keep the first numbered. */
+  best = __atomic_load_n( &s->finish_route, __ATOMIC_RELAXED );
+  while( route < best )
+  {
+    if( __atomic_compare_exchange_n( &s->finish_route, &best, route, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED ) )
+    {
+      s->finish_frame     = host_frame;
+      s->finish_countdown = GET_GAME_COUNTDOWN;
+      break;
+    }
+  }
+}
+
+/* Share the frame's states out evenly to start with */
+static void share_out( SOLVER* s )
+{
+  uint32_t n = s->num_states[s->current];
+  uint32_t w;
+
+  for( w = 0; w < s->workers; w++ )
+  {
+    s->ranges[w].next = (uint64_t)n * w / s->workers;
+    s->ranges[w].end  = (uint64_t)n * (w+1) / s->workers;
+  }
+}
+
+/*
+ * Ticks left a timer of the state after this frame's pass can have and
+ * still run out by the bound. There's a frame's slack each side.
+ */
+static uint16_t timer_horizon( const SOLVER* s )
+{
+  uint32_t frames_left = s->bound + 2 > s->frame ? s->bound + 2 - s->frame : 0;
+
+  return frames_left < HOST_EXACT_TIMERS ? frames_left : HOST_EXACT_TIMERS;
+}
+
+static void worker( SOLVER* s, uint32_t id )
+{
+  SAVED_WORD* buffer = malloc( s->image_words * sizeof(SAVED_WORD) );
+  uint8_t     key[HOST_STATE_KEY_SIZE];
+  uint64_t    passes = 0;
+  uint64_t    losses = 0;
+
+  if( buffer == NULL )
+  {
+    fprintf( stderr, "Out of memory\n" );
+    exit( 2 );
+  }
+
+  for( ;; )
+  {
+    uint32_t first;
+    uint32_t count;
+
+    barrier( s );
+    if( s->done )
+      break;
+
+    while( take_work( s, id, &first, &count ) )
+    {
+      uint8_t  layer   = s->current;
+      uint16_t horizon = timer_horizon( s );
+      uint32_t i;
+
+      for( i = first; i < first+count; i++ )
+      {
+        STATE   state = s->states[layer][i];
+        uint8_t pressed;
+
+        for( pressed = 0; pressed < 2; pressed++ )
+        {
+          int result;
+
+          restore_state( s, &state, layer );
+          result = host_run_pass( pressed );
+          passes++;
+
+          if( result == LEVEL_COMPLETE )
+            finished( s, state.route, pressed );
+          else if( result == HOST_PASS_HALTED )
+          {
+            if( visit( s, key, host_state_key( key, horizon ) ) )
+              add_state( s, state.route, pressed, buffer );
+          }
+          else
+            losses++;
+        }
+      }
+    }
+
+    barrier( s );
+
+    /* One worker moves the search on a frame while the others wait */
+    if( id == 0 )
+    {
+      uint8_t next = s->current ^ 1;
+
+      s->frame++;
+      if( s->finish_route != NO_ROUTE || s->out_of_room ||
+          s->num_states[next] == 0 || s->frame >= s->frame_limit )
+      {
+        s->done = 1;
+      }
+      else
+      {
+        s->num_states[s->current] = 0;
+        s->arena_used[s->current] = 0;
+        s->current = next;
+        share_out( s );
+      }
+    }
+  }
+
+  __atomic_add_fetch( &s->passes_run, passes, __ATOMIC_RELAXED );
+  __atomic_add_fetch( &s->losses, losses, __ATOMIC_RELAXED );
+  free( buffer );
+}
+
+/* A route a search found, a key a frame */
+typedef struct _found_route
+{
+  uint32_t frames;
+  uint16_t countdown;
+  uint8_t* keys;
+} FOUND_ROUTE;
+
+/* Read the route back from the finish. Returns 0 if it could. */
+static int read_route( const SOLVER* s, FOUND_ROUTE* found )
+{
+  uint32_t route;
+  uint32_t f;
+
+  found->frames    = s->finish_frame;
+  found->countdown = s->finish_countdown;
+  if( (found->keys = calloc( s->finish_frame + 1, 1 )) == NULL )
+    return 1;
+
+  /* The finishing pass doesn't halt, so it's the last frame */
+  f = s->finish_frame + 1;
+  for( route = s->finish_route; route != 0 && f > 0; route = s->routes[route].parent )
+    found->keys[--f] = s->routes[route].key;
+
+  return 0;
+}
+
+/*
+ * The route's keys are written as a key script: a line for each press,
+ * of its start frame and how long it's held.
+ */
+static int write_route( const FOUND_ROUTE* found, int fastest, const char* prefix, uint8_t level )
+{
+  uint32_t frames = found->frames + 1;
+  char     filename[4096];
+  FILE*    fh;
+  uint32_t f;
+
+  snprintf( filename, sizeof(filename), "%s%u.keys", prefix, level );
+  if( (fh = fopen( filename, "w" )) == NULL )
+  {
+    perror( filename );
+    return 1;
+  }
+
+  fprintf( fh, "# %s route through level %u, %u frames, from %s\n",
+           fastest ? "Fastest" : "Quickest found", level, found->frames, "wonky_solver" );
+  for( f = 0; f < frames; f++ )
+  {
+    uint32_t held = 0;
+
+    while( f+held < frames && found->keys[f+held] )
+      held++;
+    if( held )
+    {
+      fprintf( fh, "%u %u\n", f, held );
+      f += held;
+    }
+  }
+
+  fclose( fh );
+  return 0;
+}
+
+/*
+ * Searches the level up to frame_limit frames, keying timers which run
+ * out after the bound alike. Returns 0 if the workers all finished, and
+ * the result is in the SOLVER.
+ */
+static int search( SOLVER* s, uint8_t level, uint32_t workers, uint32_t frame_limit,
+                   uint32_t bound, int verbose )
+{
+  pid_t    pids[MAX_WORKERS];
+  uint32_t w;
+  int      failed = 0;
+  uint8_t  key[HOST_STATE_KEY_SIZE];
+
+  start_level( s, level );
+
+  memset( s->visited, 0, (s->visited_mask+1)*sizeof(uint64_t) );
+  s->visited_count      = 0;
+  s->workers            = workers;
+  s->frame_limit        = frame_limit;
+  s->bound              = bound;
+  s->barrier_waiting    = 0;
+  s->barrier_generation = 0;
+  s->frame              = 0;
+  s->current            = 0;
+  s->num_states[0]      = 1;
+  s->num_states[1]      = 0;
+  s->arena_used[0]      = 0;
+  s->arena_used[1]      = 0;
+  s->num_routes         = 1;
+  s->finish_route       = NO_ROUTE;
+  s->out_of_room        = 0;
+  s->done               = 0;
+  s->passes_run         = 0;
+  s->losses             = 0;
+
+  /* Route 0 is the start, the level as it's set up, with nothing saved */
+  s->routes[0].parent = 0;
+  s->routes[0].key    = 0;
+  s->states[0][0].route     = 0;
+  s->states[0][0].num_words = 0;
+  s->states[0][0].saved     = 0;
+  visit( s, key, host_state_key( key, timer_horizon( s ) ) );
+  share_out( s );
+
+  fflush( stdout );
+  for( w = 0; w < workers; w++ )
+  {
+    if( (pids[w] = fork()) == 0 )
+    {
+      worker( s, w );
+      _exit( 0 );
+    }
+    if( pids[w] < 0 )
+    {
+      perror( "fork" );
+      exit( 2 );
+    }
+  }
+
+  /* If one dies the rest would wait for it for ever */
+  for( w = 0; w < workers; w++ )
+  {
+    int   status;
+    pid_t pid = wait( &status );
+
+    if( pid > 0 && !(WIFEXITED(status) && WEXITSTATUS(status) == 0) && !failed )
+    {
+      uint32_t v;
+
+      fprintf( stderr, "level %u: a worker failed\n", level );
+      for( v = 0; v < workers; v++ )
+        kill( pids[v], SIGKILL );
+      failed = 1;
+    }
+  }
+
+  if( verbose )
+    printf( "level %u bound %u searched %lu states, %lu passes, %lu lost, to frame %u\n",
+            level, bound, (unsigned long)s->visited_count, (unsigned long)s->passes_run,
+            (unsigned long)s->losses, s->frame );
+
+  teardown_level( game_state.current_level );
+
+  return failed;
+}
+
+/* Returns 0 if a route through the level was found */
+static int solve_level( SOLVER* s, uint8_t level, uint32_t workers, uint32_t frame_limit,
+                        const char* script_prefix, int verbose )
+{
+  FOUND_ROUTE found;
+  int         fastest;
+  int         failed = 0;
+
+  /* Any route at all, to bound the timers which can matter */
+  if( search( s, level, workers, frame_limit, 0, verbose ) )
+    return 1;
+
+  if( s->finish_route == NO_ROUTE )
+  {
+    if( s->out_of_room )
+      printf( "level %u out of room at frame %u, try a bigger -m\n", level, s->frame );
+    else
+      printf( "level %u can't be finished in %u frames\n", level, frame_limit );
+    return 1;
+  }
+
+  if( read_route( s, &found ) )
+    return 1;
+
+  /*
+   * Then the fastest, which is no slower. Every frame searched is searched
+   * in full, so a finish found in the frame it ran out of room is still
+   * the fastest. If it ran out before that, the first route stands.
+   */
+  if( search( s, level, workers, found.frames+1, found.frames, verbose ) )
+  {
+    free( found.keys );
+    return 1;
+  }
+
+  fastest = (s->finish_route != NO_ROUTE);
+  if( fastest )
+  {
+    free( found.keys );
+    if( read_route( s, &found ) )
+      return 1;
+  }
+
+  printf( "level %u frames %u secs %u.%02u countdown %u of %u",
+          level, found.frames, found.frames/50, (found.frames%50)*2,
+          found.countdown, (unsigned)COUNTDOWN_START_SECS );
+  if( !fastest )
+    printf( ", not shown to be the fastest: out of room at frame %u, try a bigger -m", s->frame );
+  printf( "\n" );
+
+  if( script_prefix )
+    failed = write_route( &found, fastest, script_prefix, level );
+
+  free( found.keys );
+  return failed;
+}
+
+
+/***
+ *      __  __       _
+ *     |  \/  |     (_)
+ *     | \  / | __ _ _ _ __
+ *     | |\/| |/ _` | | '_ \
+ *     | |  | | (_| | | | | |
+ *     |_|  |_|\__,_|_|_| |_|
+ */
+
+static void usage( const char* name )
+{
+  fprintf( stderr, "Usage: %s [-j workers] [-l level] [-f max_frames] [-m visited_bits] [-o script_prefix] [-v]\n", name );
+  exit( 1 );
+}
+
+int main( int argc, char* argv[] )
+{
+  unsigned long workers       = sysconf( _SC_NPROCESSORS_ONLN );
+  unsigned long only_level    = 0;
+  unsigned long frame_limit   = DEFAULT_FRAME_LIMIT;
+  unsigned long visited_bits  = DEFAULT_VISITED_BITS;
+  const char*   script_prefix = NULL;
+  int           verbose       = 0;
+  int           failures      = 0;
+  int           opt;
+  SOLVER*       s;
+  uint8_t       level;
+
+  while( (opt = getopt( argc, argv, "j:l:f:m:o:v" )) != -1 )
+  {
+    switch( opt )
+    {
+    case 'j': workers = strtoul( optarg, NULL, 0 );      break;
+    case 'l': only_level = strtoul( optarg, NULL, 0 );   break;
+    case 'f': frame_limit = strtoul( optarg, NULL, 0 );  break;
+    case 'm': visited_bits = strtoul( optarg, NULL, 0 ); break;
+    case 'o': script_prefix = optarg;                    break;
+    case 'v': verbose = 1;                               break;
+    default:  usage( argv[0] );
+    }
+  }
+
+  if( optind != argc || workers == 0 || workers > MAX_WORKERS ||
+      only_level >= NUM_LEVELS || frame_limit == 0 || visited_bits < 10 || visited_bits > 32 )
+    usage( argv[0] );
+
+  s = map_shared( sizeof(SOLVER) );
+  if( (s->image = host_game_image( &s->image_words )) == NULL )
+  {
+    fprintf( stderr, "The data section isn't word aligned, the state can't be saved\n" );
+    return 2;
+  }
+  s->level_start  = map_shared( s->image_words*sizeof(uint64_t) );
+  s->visited      = map_shared( (1UL << visited_bits) * sizeof(uint64_t) );
+  s->visited_mask = (1UL << visited_bits) - 1;
+  s->routes       = map_shared( MAX_ROUTES * sizeof(ROUTE) );
+  s->states[0]    = map_shared( MAX_LAYER_STATES * sizeof(STATE) );
+  s->states[1]    = map_shared( MAX_LAYER_STATES * sizeof(STATE) );
+  s->arena[0]     = map_shared( LAYER_ARENA_SIZE );
+  s->arena[1]     = map_shared( LAYER_ARENA_SIZE );
+
+  host_setup_game();
+
+  /* Level 0 is the intro screen, which the control key finishes */
+  for( level = only_level ? only_level : 1; level < NUM_LEVELS; level++ )
+  {
+    failures += solve_level( s, level, workers, frame_limit, script_prefix, verbose );
+    if( only_level )
+      break;
+  }
+
+  return failures ? 1 : 0;
+}
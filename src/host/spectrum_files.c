@@ -0,0 +1,686 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <zlib.h>
+
+#include "spectrum_files.h"
+
+#define GET16(p)  ((uint16_t)((p)[0] | ((p)[1]<<8)))
+#define GET32(p)  ((uint32_t)((p)[0] | ((p)[1]<<8) | ((p)[2]<<16) | ((uint32_t)(p)[3]<<24)))
+
+uint8_t* load_file( const char* filename, size_t* length )
+{
+  FILE*    fh;
+  uint8_t* data;
+  long     size;
+
+  if( (fh = fopen( filename, "rb" )) == NULL )
+  {
+    perror( filename );
+    return NULL;
+  }
+
+  fseek( fh, 0, SEEK_END );
+  size = ftell( fh );
+  fseek( fh, 0, SEEK_SET );
+
+  if( size <= 0 || (data = malloc( size )) == NULL || fread( data, 1, size, fh ) != (size_t)size )
+  {
+    fprintf( stderr, "Can't read %s\n", filename );
+    fclose( fh );
+    return NULL;
+  }
+
+  fclose( fh );
+  *length = size;
+  return data;
+}
+
+
+/***
+ *      _______       _____
+ *     |__   __|/\   |  __ \
+ *        | |  /  \  | |__) |
+ *        | | / /\ \ |  ___/
+ *        | |/ ____ \| |
+ *        |_/_/    \_\_|
+ */
+
+#define TAP_HEADER_FLAG   0x00
+#define TAP_TYPE_CODE     3
+#define TAP_HEADER_LENGTH 19
+
+int load_tap( const char* filename, Z80_CORE* z, uint16_t* first_code_addr )
+{
+  size_t   length;
+  uint8_t* data = load_file( filename, &length );
+  size_t   pos = 0;
+  int      code_blocks = 0;
+  int      load_addr = -1;
+
+  if( data == NULL )
+    return 1;
+
+  /*
+   * Blocks are a 2 byte length then flag, data and checksum. A CODE
+   * header gives the address its data block loads to.
+   */
+  while( pos + 2 <= length )
+  {
+    uint16_t       block_length = GET16( data+pos );
+    const uint8_t* block        = data + pos + 2;
+
+    if( pos + 2 + block_length > length || block_length < 2 )
+    {
+      fprintf( stderr, "%s: truncated block at offset %zu\n", filename, pos );
+      free( data );
+      return 1;
+    }
+
+    if( block[0] == TAP_HEADER_FLAG && block_length == TAP_HEADER_LENGTH )
+    {
+      load_addr = (block[1] == TAP_TYPE_CODE) ? GET16( block+14 ) : -1;
+    }
+    else if( load_addr >= 0 )
+    {
+      /* Flag and checksum aren't loaded */
+      size_t data_length = block_length - 2;
+
+      if( load_addr + data_length > 0x10000 )
+      {
+        fprintf( stderr, "%s: CODE block at %d runs off the top of memory\n", filename, load_addr );
+        free( data );
+        return 1;
+      }
+
+      memcpy( z->memory + load_addr, block+1, data_length );
+      if( code_blocks++ == 0 )
+        *first_code_addr = load_addr;
+      load_addr = -1;
+    }
+
+    pos += 2 + block_length;
+  }
+
+  free( data );
+
+  if( code_blocks == 0 )
+  {
+    fprintf( stderr, "%s: no CODE blocks\n", filename );
+    return 1;
+  }
+
+  return 0;
+}
+
+
+/***
+ *      ______ ___   ___
+ *     |___  // _ \ / _ \
+ *        / /| (_) | | | |
+ *       / /  > _ <| | | |
+ *      / /__| (_) | |_| |
+ *     /_____|\___/ \___/
+ */
+
+/*
+ * The .z80 compression: ED ED nn bb is nn copies of bb. Returns the
+ * number of bytes of input used, or 0 if it overruns.
+ */
+static size_t z80_decompress( const uint8_t* in, size_t in_length, uint8_t* out, size_t out_length )
+{
+  size_t i = 0;
+  size_t o = 0;
+
+  while( o < out_length && i < in_length )
+  {
+    if( i+3 < in_length && in[i] == 0xED && in[i+1] == 0xED )
+    {
+      uint8_t count = in[i+2];
+
+      while( count-- && o < out_length )
+        out[o++] = in[i+3];
+      i += 4;
+    }
+    else
+    {
+      out[o++] = in[i++];
+    }
+  }
+
+  return (o == out_length) ? i : 0;
+}
+
+int load_z80_snapshot( const uint8_t* data, size_t length, Z80_CORE* z )
+{
+  uint16_t pc;
+  size_t   pos;
+
+  if( length < 30 )
+  {
+    fprintf( stderr, "Snapshot is too short\n" );
+    return 1;
+  }
+
+  z->a = data[0];   z->f = data[1];
+  z->c = data[2];   z->b = data[3];
+  z->l = data[4];   z->h = data[5];
+  pc   = GET16( data+6 );
+  z->sp = GET16( data+8 );
+  z->i = data[10];
+  z->r = (data[11] & 0x7F) | ((data[12] & 0x01) << 7);
+  z->e = data[13];  z->d = data[14];
+  z->c_ = data[15]; z->b_ = data[16];
+  z->e_ = data[17]; z->d_ = data[18];
+  z->l_ = data[19]; z->h_ = data[20];
+  z->a_ = data[21]; z->f_ = data[22];
+  z->iyl = data[23]; z->iyh = data[24];
+  z->ixl = data[25]; z->ixh = data[26];
+  z->iff1 = data[27] ? 1 : 0;
+  z->iff2 = data[28] ? 1 : 0;
+  z->im = data[29] & 0x03;
+  z->halted = 0;
+
+  if( pc != 0 )
+  {
+    /* Version 1, one 48K block */
+    z->pc = pc;
+
+    if( data[12] & 0x20 )
+    {
+      if( !z80_decompress( data+30, length-30, z->memory+0x4000, 0xC000 ) )
+      {
+        fprintf( stderr, "Snapshot memory is corrupt\n" );
+        return 1;
+      }
+    }
+    else if( length - 30 >= 0xC000 )
+    {
+      memcpy( z->memory+0x4000, data+30, 0xC000 );
+    }
+    else
+    {
+      fprintf( stderr, "Snapshot is too short\n" );
+      return 1;
+    }
+    return 0;
+  }
+
+  /* Version 2 or 3, a header extension then 16K pages */
+  {
+    uint16_t extra = GET16( data+30 );
+    uint8_t  hardware;
+
+    if( length < 32 + (size_t)extra )
+    {
+      fprintf( stderr, "Snapshot is too short\n" );
+      return 1;
+    }
+
+    z->pc = GET16( data+32 );
+    hardware = data[34];
+
+    /* Version 2 has 48K as 0 or 1. Version 3 adds 3, 48K with an MGT */
+    if( hardware > 1 && !(extra != 23 && hardware == 3) )
+    {
+      fprintf( stderr, "Snapshot isn't of a 48K machine\n" );
+      return 1;
+    }
+
+    pos = 32 + extra;
+  }
+
+  while( pos + 3 <= length )
+  {
+    uint16_t block_length = GET16( data+pos );
+    uint8_t  page         = data[pos+2];
+    uint16_t addr;
+
+    pos += 3;
+
+    switch( page )
+    {
+    case 8:  addr = 0x4000; break;
+    case 4:  addr = 0x8000; break;
+    case 5:  addr = 0xC000; break;
+    default: addr = 0;      break;
+    }
+
+    if( block_length == 0xFFFF )
+    {
+      if( pos + 0x4000 > length )
+        break;
+      if( addr )
+        memcpy( z->memory+addr, data+pos, 0x4000 );
+      pos += 0x4000;
+    }
+    else
+    {
+      if( pos + block_length > length )
+        break;
+      if( addr && z80_decompress( data+pos, block_length, z->memory+addr, 0x4000 ) == 0 )
+      {
+        fprintf( stderr, "Snapshot page %u is corrupt\n", page );
+        return 1;
+      }
+      pos += block_length;
+    }
+  }
+
+  return 0;
+}
+
+
+/***
+ *      _____  ________   __
+ *     |  __ \|___  /\ \ / /
+ *     | |__) |  / /  \ V /
+ *     |  _  /  / /    > <
+ *     | | \ \ / /__  / . \
+ *     |_|  \_\_____|/_/ \_\
+ */
+
+#define RZX_BLOCK_SNAPSHOT     0x30
+#define RZX_BLOCK_INPUT        0x80
+#define RZX_SNAPSHOT_EXTERNAL  0x01
+#define RZX_COMPRESSED         0x02
+#define RZX_REPEAT_INPUTS      0xFFFF
+
+static uint8_t* inflate_block( const uint8_t* in, size_t in_length, size_t* out_length, size_t expected )
+{
+  z_stream stream;
+  size_t   allocated = expected ? expected : in_length * 4;
+  uint8_t* out = malloc( allocated );
+  int      result;
+
+  memset( &stream, 0, sizeof(stream) );
+  if( out == NULL || inflateInit( &stream ) != Z_OK )
+  {
+    free( out );
+    return NULL;
+  }
+
+  stream.next_in  = (uint8_t*)in;
+  stream.avail_in = in_length;
+
+  do
+  {
+    if( stream.total_out == allocated )
+    {
+      allocated *= 2;
+      out = realloc( out, allocated );
+    }
+    stream.next_out  = out + stream.total_out;
+    stream.avail_out = allocated - stream.total_out;
+    result = inflate( &stream, Z_NO_FLUSH );
+  }
+  while( result == Z_OK && out != NULL );
+
+  *out_length = stream.total_out;
+  inflateEnd( &stream );
+
+  if( result != Z_STREAM_END )
+  {
+    free( out );
+    return NULL;
+  }
+  return out;
+}
+
+int load_rzx( const char* filename, RZX_RECORDING* rzx )
+{
+  size_t   length;
+  uint8_t* data = load_file( filename, &length );
+  size_t   pos;
+  size_t   input_used = 0;
+  size_t   frames_allocated = 0;
+  size_t*  input_offsets = NULL;
+  uint32_t frame;
+
+  memset( rzx, 0, sizeof(*rzx) );
+
+  if( data == NULL )
+    return 1;
+
+  if( length < 10 || memcmp( data, "RZX!", 4 ) != 0 )
+  {
+    fprintf( stderr, "%s isn't an RZX file\n", filename );
+    free( data );
+    return 1;
+  }
+
+  for( pos = 10; pos + 5 <= length; )
+  {
+    uint8_t        id           = data[pos];
+    uint32_t       block_length = GET32( data+pos+1 );
+    const uint8_t* block        = data + pos + 5;
+
+    if( block_length < 5 || pos + block_length > length )
+    {
+      fprintf( stderr, "%s: truncated block at offset %zu\n", filename, pos );
+      goto fail;
+    }
+
+    if( id == RZX_BLOCK_SNAPSHOT && rzx->snapshot == NULL )
+    {
+      uint32_t flags = GET32( block );
+
+      if( flags & RZX_SNAPSHOT_EXTERNAL )
+      {
+        fprintf( stderr, "%s: external snapshots aren't supported\n", filename );
+        goto fail;
+      }
+
+      memcpy( rzx->snapshot_type, block+4, 4 );
+      rzx->snapshot_type[4] = '\0';
+
+      if( flags & RZX_COMPRESSED )
+      {
+        rzx->snapshot = inflate_block( block+12, block_length-17, &rzx->snapshot_length, GET32( block+8 ) );
+      }
+      else
+      {
+        rzx->snapshot_length = block_length-17;
+        if( (rzx->snapshot = malloc( rzx->snapshot_length )) != NULL )
+          memcpy( rzx->snapshot, block+12, rzx->snapshot_length );
+      }
+
+      if( rzx->snapshot == NULL )
+      {
+        fprintf( stderr, "%s: can't unpack the snapshot\n", filename );
+        goto fail;
+      }
+    }
+    else if( id == RZX_BLOCK_INPUT )
+    {
+      uint32_t       num_frames = GET32( block );
+      uint32_t       flags      = GET32( block+9 );
+      uint8_t*       frame_data;
+      size_t         frame_data_length;
+      size_t         fpos = 0;
+
+      if( rzx->num_frames == 0 )
+        rzx->start_tstates = GET32( block+5 );
+
+      if( flags & RZX_COMPRESSED )
+      {
+        frame_data = inflate_block( block+13, block_length-18, &frame_data_length, 0 );
+      }
+      else
+      {
+        frame_data_length = block_length-18;
+        if( (frame_data = malloc( frame_data_length )) != NULL )
+          memcpy( frame_data, block+13, frame_data_length );
+      }
+
+      if( frame_data == NULL )
+      {
+        fprintf( stderr, "%s: can't unpack the input recording\n", filename );
+        goto fail;
+      }
+
+      /*
+       * The input values all go into one buffer. They're kept as offsets
+       * until the end because the buffer moves as it grows.
+       */
+      if( rzx->num_frames + num_frames > frames_allocated )
+      {
+        frames_allocated = rzx->num_frames + num_frames;
+        rzx->frames   = realloc( rzx->frames, frames_allocated * sizeof(RZX_FRAME) );
+        input_offsets = realloc( input_offsets, frames_allocated * sizeof(size_t) );
+      }
+      rzx->input_data = realloc( rzx->input_data, input_used + frame_data_length );
+
+      if( rzx->frames == NULL || input_offsets == NULL || rzx->input_data == NULL )
+      {
+        fprintf( stderr, "Out of memory reading %s\n", filename );
+        exit( 2 );
+      }
+
+      for( frame = 0; frame < num_frames; frame++ )
+      {
+        RZX_FRAME* f = &rzx->frames[rzx->num_frames];
+        uint16_t   num_inputs;
+
+        if( fpos + 4 > frame_data_length )
+          break;
+
+        f->fetches = GET16( frame_data+fpos );
+        num_inputs = GET16( frame_data+fpos+2 );
+        fpos += 4;
+
+        if( num_inputs == RZX_REPEAT_INPUTS )
+        {
+          f->num_inputs = rzx->num_frames ? rzx->frames[rzx->num_frames-1].num_inputs : 0;
+          input_offsets[rzx->num_frames] = rzx->num_frames ? input_offsets[rzx->num_frames-1] : 0;
+        }
+        else
+        {
+          if( fpos + num_inputs > frame_data_length )
+            break;
+
+          f->num_inputs = num_inputs;
+          input_offsets[rzx->num_frames] = input_used;
+          memcpy( rzx->input_data + input_used, frame_data+fpos, num_inputs );
+          input_used += num_inputs;
+          fpos += num_inputs;
+        }
+
+        rzx->num_frames++;
+      }
+
+      free( frame_data );
+
+      if( frame != num_frames )
+      {
+        fprintf( stderr, "%s: input recording is truncated\n", filename );
+        goto fail;
+      }
+    }
+
+    pos += block_length;
+  }
+
+  for( frame = 0; frame < rzx->num_frames; frame++ )
+    rzx->frames[frame].inputs = rzx->input_data + input_offsets[frame];
+
+  free( input_offsets );
+  free( data );
+
+  if( rzx->num_frames == 0 )
+  {
+    fprintf( stderr, "%s: no input recording\n", filename );
+    free_rzx( rzx );
+    return 1;
+  }
+
+  return 0;
+
+ fail:
+  free( input_offsets );
+  free( data );
+  free_rzx( rzx );
+  return 1;
+}
+
+void free_rzx( RZX_RECORDING* rzx )
+{
+  free( rzx->snapshot );
+  free( rzx->frames );
+  free( rzx->input_data );
+  memset( rzx, 0, sizeof(*rzx) );
+}
+
+
+/***
+ *       _____ ________   __
+ *      / ____|___  /\ \ / /
+ *     | (___    / /  \ V /
+ *      \___ \  / /    > <
+ *      ____) |/ /__  / . \
+ *     |_____//_____|/_/ \_\
+ */
+
+#define SZX_HEADER_LENGTH      8
+#define SZX_BLOCK_HEADER       8
+#define SZX_Z80R_LENGTH        29
+#define SZX_RAMP_COMPRESSED    0x0001
+#define SZX_ROM_COMPRESSED     0x0001
+#define SZX_PAGE_LENGTH        0x4000
+
+/*
+ * A .szx is a header and a list of blocks, each a 4 character id and a
+ * length. Only the registers, the RAM pages and a custom ROM are wanted;
+ * the rest is the state of hardware the host tools don't have.
+ */
+int load_szx_snapshot( const uint8_t* data, size_t length, Z80_CORE* z )
+{
+  size_t  pos;
+  uint8_t paged_at_c000 = 0;
+  int     have_registers = 0;
+
+  if( length < SZX_HEADER_LENGTH || memcmp( data, "ZXST", 4 ) != 0 )
+  {
+    fprintf( stderr, "Snapshot isn't an SZX file\n" );
+    return 1;
+  }
+
+  /* The 128K's paging register says which page is at 0xC000 */
+  for( pos = SZX_HEADER_LENGTH; pos + SZX_BLOCK_HEADER <= length; )
+  {
+    uint32_t block_length = GET32( data+pos+4 );
+
+    if( memcmp( data+pos, "SPCR", 4 ) == 0 && block_length >= 2 && pos + SZX_BLOCK_HEADER + 2 <= length )
+      paged_at_c000 = data[pos+SZX_BLOCK_HEADER+1] & 0x07;
+    pos += SZX_BLOCK_HEADER + block_length;
+  }
+
+  for( pos = SZX_HEADER_LENGTH; pos + SZX_BLOCK_HEADER <= length; )
+  {
+    const uint8_t* block        = data + pos + SZX_BLOCK_HEADER;
+    uint32_t       block_length = GET32( data+pos+4 );
+
+    if( pos + SZX_BLOCK_HEADER + block_length > length )
+    {
+      fprintf( stderr, "Snapshot is truncated at offset %zu\n", pos );
+      return 1;
+    }
+
+    if( memcmp( data+pos, "Z80R", 4 ) == 0 && block_length >= SZX_Z80R_LENGTH )
+    {
+      z->f   = block[0];   z->a   = block[1];
+      z->c   = block[2];   z->b   = block[3];
+      z->e   = block[4];   z->d   = block[5];
+      z->l   = block[6];   z->h   = block[7];
+      z->f_  = block[8];   z->a_  = block[9];
+      z->c_  = block[10];  z->b_  = block[11];
+      z->e_  = block[12];  z->d_  = block[13];
+      z->l_  = block[14];  z->h_  = block[15];
+      z->ixl = block[16];  z->ixh = block[17];
+      z->iyl = block[18];  z->iyh = block[19];
+      z->sp  = GET16( block+20 );
+      z->pc  = GET16( block+22 );
+      z->i   = block[24];
+      z->r   = block[25];
+      z->iff1 = block[26] ? 1 : 0;
+      z->iff2 = block[27] ? 1 : 0;
+      z->im  = block[28] & 0x03;
+      z->halted = 0;
+      have_registers = 1;
+    }
+    else if( memcmp( data+pos, "RAMP", 4 ) == 0 && block_length >= 3 )
+    {
+      uint8_t  page = block[2];
+      uint16_t addr;
+
+      if( page == 5 )
+        addr = 0x4000;
+      else if( page == 2 )
+        addr = 0x8000;
+      else if( page == paged_at_c000 )
+        addr = 0xC000;
+      else
+        addr = 0;
+
+      if( addr )
+      {
+        if( GET16( block ) & SZX_RAMP_COMPRESSED )
+        {
+          size_t   page_length;
+          uint8_t* ram = inflate_block( block+3, block_length-3, &page_length, SZX_PAGE_LENGTH );
+
+          if( ram == NULL || page_length != SZX_PAGE_LENGTH )
+          {
+            fprintf( stderr, "Snapshot page %u is corrupt\n", page );
+            free( ram );
+            return 1;
+          }
+          memcpy( z->memory+addr, ram, SZX_PAGE_LENGTH );
+          free( ram );
+        }
+        else if( block_length - 3 >= SZX_PAGE_LENGTH )
+        {
+          memcpy( z->memory+addr, block+3, SZX_PAGE_LENGTH );
+        }
+        else
+        {
+          fprintf( stderr, "Snapshot page %u is too short\n", page );
+          return 1;
+        }
+      }
+    }
+    else if( memcmp( data+pos, "ROM\0", 4 ) == 0 && block_length >= 6 )
+    {
+      /* Only there if the emulator was using its own ROM image, or it's been written to */
+      uint32_t rom_length = GET32( block+2 );
+      size_t   inflated_length;
+      uint8_t* rom;
+
+      if( GET16( block ) & SZX_ROM_COMPRESSED )
+        rom = inflate_block( block+6, block_length-6, &inflated_length, rom_length );
+      else if( block_length - 6 >= rom_length && (rom = malloc( rom_length )) != NULL )
+        memcpy( rom, block+6, (inflated_length = rom_length) );
+      else
+        rom = NULL;
+
+      if( rom == NULL || inflated_length < SZX_PAGE_LENGTH )
+      {
+        fprintf( stderr, "Snapshot ROM is corrupt\n" );
+        free( rom );
+        return 1;
+      }
+      memcpy( z->memory, rom, SZX_PAGE_LENGTH );
+      free( rom );
+    }
+
+    pos += SZX_BLOCK_HEADER + block_length;
+  }
+
+  if( !have_registers )
+  {
+    fprintf( stderr, "Snapshot has no Z80 registers\n" );
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __SPECTRUM_FILES_H
+#define __SPECTRUM_FILES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "z80_core.h"
+
+/*
+ * Readers for the Spectrum file formats the host tools need. They all
+ * return 0 on success, or print why not and return 1.
+ */
+
+/*
+ * Load the CODE blocks of a TAP file into memory at their own addresses.
+ * BASIC blocks, the loader, are skipped. The address of the first CODE
+ * block is returned in first_code_addr, which for wonky.tap is where
+ * the BASIC loader would have called it.
+ */
+int load_tap( const char* filename, Z80_CORE* z, uint16_t* first_code_addr );
+
+/*
+ * Load a whole file, which needs free()ing. 48K is the largest thing
+ * loaded so there's no streaming.
+ */
+uint8_t* load_file( const char* filename, size_t* length );
+
+/*
+ * Load a .z80 snapshot, any version, 48K only.
+ */
+int load_z80_snapshot( const uint8_t* data, size_t length, Z80_CORE* z );
+
+/*
+ * Load a .szx snapshot, 48K or 128K. The ROM is only loaded if the
+ * snapshot has one, which is where the trace tables are.
+ */
+int load_szx_snapshot( const uint8_t* data, size_t length, Z80_CORE* z );
+
+/*
+ * An RZX recording. Each frame is the number of instruction fetches
+ * until the interrupt, and the values the IN instructions in that frame
+ * read. Frames which repeat the previous frame's inputs point at the
+ * same values.
+ */
+typedef struct _rzx_frame
+{
+  uint16_t       fetches;
+  uint16_t       num_inputs;
+  const uint8_t* inputs;
+} RZX_FRAME;
+
+typedef struct _rzx_recording
+{
+  uint8_t*   snapshot;          /* The embedded snapshot, uncompressed */
+  size_t     snapshot_length;
+  char       snapshot_type[5];  /* File extension, "z80", "sna" etc. */
+  uint32_t   start_tstates;
+
+  uint32_t   num_frames;
+  RZX_FRAME* frames;
+  uint8_t*   input_data;
+} RZX_RECORDING;
+
+int  load_rzx( const char* filename, RZX_RECORDING* rzx );
+void free_rzx( RZX_RECORDING* rzx );
+
+#endif
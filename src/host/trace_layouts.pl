@@ -0,0 +1,236 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Wonky One Key, a ZX Spectrum game featuring a single control key
+# Copyright (C) 2018 Derek Fountain
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+# Trace layout generator. Reads the trace entry structures, the enums
+# they use and the number of entries in each table from the game's
+# source, and writes them out as the tables wonky_traces decodes the
+# trace tables in a snapshot with. The layouts are the ones SDCC gives
+# the structures on the Spectrum: no padding, little endian, 2 byte
+# pointers, and each enum in the smallest type which holds its values.
+#
+# Every entry starts with its timestamp, the 16 bit ticker and the
+# sequence number in the frame, which the tables are merged by. Only the handful of field types the trace structures use
+# are understood. Anything else stops the build so a new field can't
+# quietly decode as rubbish.
+#
+# The game loop's missed frame counters are described the same way, and
+# the input log's records.
+#
+#  trace_layouts.pl *.h *.c > host/trace_layouts.h
+
+# Trace table name, as in TRACE_TABLE(), and the structure of its entries
+my @tables = (
+  [ 'gameloop',    'GAMELOOP_TRACE'    ],
+  [ 'key_action',  'KEY_ACTION_TRACE'  ],
+  [ 'collision',   'COLLISION_TRACE'   ],
+  [ 'runner',      'RUNNER_TRACE'      ],
+  [ 'slowdown',    'SLOWDOWN_TRACE'    ],
+  [ 'door',        'DOOR_TRACE'        ],
+  [ 'collectable', 'COLLECTABLE_TRACE' ],
+);
+
+my %SCALARS = ( uint8_t  => [ 'FIELD_U8',  1 ],
+                int8_t   => [ 'FIELD_I8',  1 ],
+                uint16_t => [ 'FIELD_U16', 2 ],
+                int16_t  => [ 'FIELD_I16', 2 ] );
+
+die "Usage: $0 source files...\n" unless @ARGV;
+
+my $source = '';
+foreach my $file (@ARGV) {
+  local $/;
+  open( my $fh, '<', $file ) or die "Can't open $file: $!\n";
+  $source .= <$fh>;
+  close( $fh );
+}
+$source =~ s{/\*.*?\*/}{ }gs;
+$source =~ s{//[^\n]*}{}g;
+
+# Enum name => list of [ value name, value ]
+my %enums;
+while( $source =~ /typedef\s+enum\s+\w*\s*\{(.*?)\}\s*(\w+)\s*;/gs ) {
+  my ($body, $name) = ($1, $2);
+  my $next = 0;
+  my @values;
+
+  foreach my $item ( grep { /\S/ } split( /,/, $body ) ) {
+    my ($value_name, $value) = $item =~ /^\s*(\w+)\s*(?:=\s*(\S+))?\s*$/
+      or die "enum $name: can't understand '$item'\n";
+
+    if( defined $value ) {
+      die "enum $name: $value_name isn't a plain number\n" unless $value =~ /^(0x[0-9a-f]+|\d+)$/i;
+      $next = $value =~ /^0x/i ? hex($value) : $value;
+    }
+    push( @values, [ $value_name, $next++ ] );
+  }
+  $enums{$name} = \@values;
+}
+
+sub enum_size {
+  my ($name) = @_;
+  my @v = map { $_->[1] } @{$enums{$name}};
+  my ($min, $max) = (sort { $a <=> $b } @v)[0, -1];
+
+  return ($min >= -128 && $max <= 255) ? 1 : 2;
+}
+
+print "/* Generated from the game's trace structures by $0, don't edit */\n\n";
+
+my %enums_used;
+my @table_lines;
+
+foreach my $table (@tables) {
+  my ($name, $type) = @$table;
+
+  $source =~ /typedef\s+struct\s+\w*\s*\{([^}]*)\}\s*$type\s*;/s
+    or die "There's no structure $type\n";
+  my $body = $1;
+
+  $source =~ /#define\s+${type}_ENTRIES\s+(\d+)/
+    or die "There's no ${type}_ENTRIES\n";
+  my $entries = $1;
+
+  my $offset = 0;
+  my @fields;
+
+  foreach my $declaration ( grep { /\S/ } split( /;/, $body ) ) {
+    my ($field_type, $pointer, $field) = $declaration =~ /^\s*(\w+)\s*(\*?)\s*(\w+)\s*$/
+      or die "$type: can't understand '$declaration'\n";
+    my ($kind, $size, $names) = ( undef, undef, 'NULL, 0' );
+
+    if( $pointer ) {
+      ($kind, $size) = ( 'FIELD_PTR', 2 );
+    }
+    elsif( $SCALARS{$field_type} ) {
+      ($kind, $size) = @{$SCALARS{$field_type}};
+    }
+    elsif( $enums{$field_type} ) {
+      ($kind, $size) = ( 'FIELD_ENUM', enum_size( $field_type ) );
+      $names = sprintf( "%s_names, %d", lc($field_type), scalar @{$enums{$field_type}} );
+      $enums_used{$field_type} = 1;
+    }
+    else {
+      die "$type: don't know the size of $field_type $field\n";
+    }
+
+    push( @fields, sprintf( "  { %-18s %2d, %d, %-10s %s },\n", "\"$field\",", $offset, $size, "$kind,", $names ) );
+    $offset += $size;
+  }
+
+  die "$type: it has to start with the timestamp, ticker then frame_seq\n"
+    unless @fields > 1 && $fields[0] =~ /"ticker",\s+0, 2, FIELD_U16/ && $fields[1] =~ /"frame_seq",\s+2, 1, FIELD_U8/;
+
+  push( @table_lines, "static const TRACE_FIELD ${name}_fields[] = {\n", @fields, "};\n\n" );
+  $table->[2] = sprintf( "  { %-14s %-26s %-26s %-26s %3d, %2d, %2d, ${name}_fields },\n",
+                         "\"$name\",", "\"_${name}_tracetable\",", "\"_${name}_next_trace\",", "\"_${name}_ticker_high\",",
+                         $entries, $offset, scalar @fields );
+}
+
+# Enum values are looked up by value, so any gaps are left empty
+foreach my $enum ( sort keys %enums_used ) {
+  my %by_value = map { $_->[1] => $_->[0] } @{$enums{$enum}};
+  my $max = (sort { $a <=> $b } keys %by_value)[-1];
+
+  die "enum $enum: values are too sparse to list\n" if $max > 255;
+
+  print "static const char* const ", lc($enum), "_names[] = {\n";
+  print map { "  " . ( exists $by_value{$_} ? "\"$by_value{$_}\"" : "NULL" ) . ",\n" } 0..$max;
+  print "};\n\n";
+}
+
+print @table_lines;
+
+print "static const TRACE_LAYOUT trace_layouts[] = {\n";
+print map { $_->[2] } @tables;
+print "};\n\n";
+print "#define NUM_TRACE_LAYOUTS ", scalar @tables, "\n\n";
+
+
+# The game loop's missed frame counters, FRAME_STATS. It's a block of
+# uint16_t counts, some of them arrays sized by #defined expressions.
+# The phases are named after the game_actions[] functions and the
+# FRAME_STATS_PHASE_ defines.
+my %defines;
+while( $source =~ /^\s*#define\s+(\w+)\s+([^\n]+?)\s*$/mg ) {
+  $defines{$1} = $2;
+}
+
+sub evaluate {
+  my ($expression, $depth) = @_;
+
+  die "Can't work out '$expression'\n" if $depth > 10;
+  $expression =~ s/\b([A-Z_][A-Z0-9_]*)\b/exists $defines{$1} ? "(".evaluate( $defines{$1}, $depth+1 ).")" : $1/ge;
+  die "Can't work out '$expression'\n" unless $expression =~ /^(?:0x[0-9a-f]+|[\d\s()+*-])+$/i;
+
+  return eval $expression;
+}
+
+$source =~ /typedef\s+struct\s+\w*\s*\{([^}]*)\}\s*FRAME_STATS\s*;/s
+  or die "There's no structure FRAME_STATS\n";
+my $stats_body = $1;
+
+$source =~ /LOOP_ACTION\s+game_actions\s*\[[^\]]*\]\s*=\s*\{(.*?)\}\s*;/s
+  or die "There's no game_actions[]\n";
+my @phases = $1 =~ /\{\s*(\w+)\s*,/g;
+
+foreach my $define ( grep { /^FRAME_STATS_PHASE_/ } keys %defines ) {
+  my $phase = evaluate( $defines{$define}, 0 );
+  ($phases[$phase] = lc $define) =~ s/^frame_stats_phase_//;
+}
+
+my $offset = 0;
+my @stats_fields;
+my @stats_names;
+
+foreach my $declaration ( grep { /\S/ } split( /;/, $stats_body ) ) {
+  my ($field, $size) = $declaration =~ /^\s*uint16_t\s+(\w+)\s*(?:\[([^\]]+)\])?\s*$/
+    or die "FRAME_STATS: can't understand '$declaration', they're all uint16_t\n";
+  my $count = defined $size ? evaluate( $size, 0 ) : 1;
+  my $names = 'NULL';
+
+  if( $field eq 'phase_overruns' ) {
+    die "FRAME_STATS: $count phases, but ", scalar @phases, " named\n" unless @phases == $count && !grep { !defined } @phases;
+    push( @stats_names, "static const char* const frame_stats_phase_names[] = {\n",
+                        ( map { "  \"$_\",\n" } @phases ), "};\n\n" );
+    $names = 'frame_stats_phase_names';
+  }
+  elsif( $field eq 'frames_per_loop' ) {
+    push( @stats_names, "static const char* const frame_stats_frames_names[] = {\n",
+                        ( map { "  \"$_\",\n" } 1..$count-1, $count."+" ), "};\n\n" );
+    $names = 'frame_stats_frames_names';
+  }
+
+  push( @stats_fields, sprintf( "  { %-18s %3d, %3d, %s },\n", "\"$field\",", $offset, $count, $names ) );
+  $offset += 2*$count;
+}
+
+print @stats_names;
+print "static const STATS_FIELD frame_stats_fields[] = {\n", @stats_fields, "};\n\n";
+print "#define NUM_FRAME_STATS_FIELDS ", scalar @stats_fields, "\n";
+print "#define FRAME_STATS_SIZE       $offset\n";
+print "#define FRAME_STATS_SYMBOL     \"_frame_stats\"\n\n";
+
+
+# The input log recorder's record format and size, see input_log.h
+foreach my $define ( qw( INPUT_LOG_SIZE INPUT_RECORD_FRAMES_BYTE INPUT_RECORD_FRAMES_WORD INPUT_KEYS ) ) {
+  die "There's no $define\n" unless exists $defines{$define};
+  printf "#define %-24s 0x%04X\n", $define, evaluate( $defines{$define}, 0 );
+}
+print "#define INPUT_LOG_SYMBOL         \"_input_log\"\n";
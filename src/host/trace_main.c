@@ -0,0 +1,745 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Trace table extractor. The game's trace tables are ring buffers in the
+ * ROM area, which some emulators can make writable (see tracetable.h).
+ * This reads them out of snapshots taken while the game ran, decodes
+ * each entry, and merges all the tables into one timeline in the order
+ * the entries were made, one row per entry:
+ *
+ *  snapshot  frame  frame_seq  table  seq  <a column for each field name>
+ *
+ * frame is the 32 bit 50Hz frame count and frame_seq the entry's place
+ * within its frame, across all the tables. seq is the entry's place in
+ * its own table, oldest first.
+ *
+ * Tab separated, with a field left empty in the rows of tables which
+ * don't have it. Fields with the same name in different tables share a
+ * column, so xpos and ypos line up. Enums are printed by name, pointers
+ * in hex.
+ *
+ *  wonky_traces [-s wonky.sym] [-o output] [-f stats] [-i input_log] [-l list] [snapshot...]
+ *
+ * Snapshots are .szx, .z80, or a raw 64K memory dump. -l reads the names
+ * of more from a file, one a line, or from stdin if it's "-", for batch
+ * runs over thousands of dumps.
+ *
+ * The tables are found through their pointers, _<name>_tracetable and
+ * _<name>_next_trace in wonky.sym, along with _<name>_ticker_high, so the symbols have to come from the
+ * build which was running. The entries are laid out as in
+ * host/trace_layouts.h, which is generated from the game's source. A
+ * table which wasn't compiled in, or wasn't allocated because the ROM
+ * wasn't writable, is skipped.
+ *
+ * -f writes the game loop's missed frame counts (see gameloop.c) from
+ * each snapshot to a second file, also tab separated.
+ *
+ * -i writes the input log recorded by a build made with INPUT_LOG=1 (see
+ * input_log.h) out of the snapshot, ready for a replay build to embed.
+ * There's only one log in a file, so it only works on one snapshot.
+ *
+ * A .z80 snapshot doesn't save the ROM area so it never has any traces
+ * in it. An .szx only has it if the emulator saved a ROM block, which
+ * they do when the ROM isn't the standard one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "z80_core.h"
+#include "spectrum_files.h"
+
+#define DEFAULT_SYMBOLS   "wonky.sym"
+
+#define RAW_MEMORY_LENGTH 0x10000
+
+/* What clear_trace_area() fills the trace area with */
+#define EMPTY_TRACE_BYTE  0xDF
+
+/* Pointers of a table which isn't in use */
+#define TRACING_INACTIVE  0xFFFF
+
+#define OUTPUT_BUFFER_SIZE (1024*1024)
+
+
+/***
+ *      _                            _
+ *     | |                          | |
+ *     | |     __ _ _   _  ___  _   _| |_ ___
+ *     | |    / _` | | | |/ _ \| | | | __/ __|
+ *     | |___| (_| | |_| | (_) | |_| | |_\__ \
+ *     |______\__,_|\__, |\___/ \__,_|\__|___/
+ *                   __/ |
+ *                  |___/
+ */
+
+typedef enum _field_kind
+{
+  FIELD_U8,
+  FIELD_I8,
+  FIELD_U16,
+  FIELD_I16,
+  FIELD_PTR,
+  FIELD_ENUM,
+} FIELD_KIND;
+
+typedef struct _trace_field
+{
+  const char*        name;
+  uint8_t            offset;
+  uint8_t            size;
+  FIELD_KIND         kind;
+  const char* const* enum_names;
+  uint16_t           num_enum_names;
+} TRACE_FIELD;
+
+typedef struct _trace_layout
+{
+  const char*        name;
+  const char*        table_symbol;
+  const char*        next_symbol;
+  const char*        high_symbol;
+  uint16_t           entries;
+  uint16_t           entry_size;
+  uint16_t           num_fields;
+  const TRACE_FIELD* fields;
+} TRACE_LAYOUT;
+
+typedef struct _stats_field
+{
+  const char*        name;
+  uint16_t           offset;
+  uint16_t           count;
+  const char* const* names;
+} STATS_FIELD;
+
+#include "trace_layouts.h"
+
+/* Output column of each field of each table */
+static uint16_t     field_column[NUM_TRACE_LAYOUTS][32];
+static const char*  columns[NUM_TRACE_LAYOUTS*32];
+static uint16_t     num_columns = 0;
+
+static void build_columns( void )
+{
+  uint16_t t, f, c;
+
+  for( t = 0; t < NUM_TRACE_LAYOUTS; t++ )
+  {
+    const TRACE_LAYOUT* layout = &trace_layouts[t];
+
+    if( layout->num_fields > 32 )
+    {
+      fprintf( stderr, "Trace table %s has too many fields\n", layout->name );
+      exit( 2 );
+    }
+
+    for( f = 0; f < layout->num_fields; f++ )
+    {
+      for( c = 0; c < num_columns; c++ )
+        if( strcmp( columns[c], layout->fields[f].name ) == 0 )
+          break;
+
+      if( c == num_columns )
+        columns[num_columns++] = layout->fields[f].name;
+      field_column[t][f] = c;
+    }
+  }
+}
+
+/* The timestamp is always there, so it has its own columns at the front */
+#define IS_TIMESTAMP(name)  (strcmp( (name), "ticker" ) == 0 || strcmp( (name), "frame_seq" ) == 0)
+
+
+/***
+ *       _____                 _           _
+ *      / ____|               | |         | |
+ *     | (___  _   _ _ __ ___ | |__   ___ | |___
+ *      \___ \| | | | '_ ` _ \| '_ \ / _ \| / __|
+ *      ____) | |_| | | | | | | |_) | (_) | \__ \
+ *     |_____/ \__, |_| |_| |_|_.__/ \___/|_|___/
+ *              __/ |
+ *             |___/
+ */
+
+/* Address of each table's pointers and high word, or 0 if the build doesn't have them */
+static uint16_t table_symbol_addr[NUM_TRACE_LAYOUTS];
+static uint16_t next_symbol_addr[NUM_TRACE_LAYOUTS];
+static uint16_t high_symbol_addr[NUM_TRACE_LAYOUTS];
+static uint16_t frame_stats_addr;
+static uint16_t input_log_addr;
+
+/*
+ * wonky.sym is "name hexaddr" per line, as made by generate_symbols.pl.
+ * Only the trace table pointers are wanted from it.
+ */
+static int load_symbols( const char* filename )
+{
+  FILE*    fh;
+  char     name[256];
+  unsigned addr;
+  uint16_t t;
+
+  if( (fh = fopen( filename, "r" )) == NULL )
+  {
+    perror( filename );
+    return 1;
+  }
+
+  while( fscanf( fh, "%255s %x", name, &addr ) == 2 )
+  {
+    if( strcmp( name, FRAME_STATS_SYMBOL ) == 0 )
+      frame_stats_addr = addr;
+    else if( strcmp( name, INPUT_LOG_SYMBOL ) == 0 )
+      input_log_addr = addr;
+
+    for( t = 0; t < NUM_TRACE_LAYOUTS; t++ )
+    {
+      if( strcmp( name, trace_layouts[t].table_symbol ) == 0 )
+        table_symbol_addr[t] = addr;
+      else if( strcmp( name, trace_layouts[t].next_symbol ) == 0 )
+        next_symbol_addr[t] = addr;
+      else if( strcmp( name, trace_layouts[t].high_symbol ) == 0 )
+        high_symbol_addr[t] = addr;
+    }
+  }
+
+  fclose( fh );
+
+  for( t = 0; t < NUM_TRACE_LAYOUTS; t++ )
+  {
+    if( table_symbol_addr[t] && next_symbol_addr[t] )
+      return 0;
+  }
+
+  /* A build can record the input without tracing anything */
+  if( input_log_addr )
+    return 0;
+
+  fprintf( stderr, "%s: no trace tables in the symbols\n", filename );
+  return 1;
+}
+
+
+/***
+ *      ______      _                  _
+ *     |  ____|    | |                | |
+ *     | |__  __  _| |_ _ __ __ _  ___| |_
+ *     |  __| \ \/ / __| '__/ _` |/ __| __|
+ *     | |____ >  <| |_| | | (_| | (__| |_
+ *     |______/_/\_\\__|_|  \__,_|\___|\__|
+ */
+
+typedef struct _trace_record
+{
+  uint32_t       frame;
+  uint8_t        frame_seq;
+  uint8_t        table;
+  uint16_t       seq;     /* Position in its table, oldest first */
+  const uint8_t* entry;
+} TRACE_RECORD;
+
+static TRACE_RECORD records[NUM_TRACE_LAYOUTS*0x10000/2];
+static size_t       num_records;
+
+static int compare_record( const void* a, const void* b )
+{
+  const TRACE_RECORD* ra = (const TRACE_RECORD*)a;
+  const TRACE_RECORD* rb = (const TRACE_RECORD*)b;
+
+  if( ra->frame != rb->frame )
+    return (ra->frame > rb->frame) - (ra->frame < rb->frame);
+  if( ra->frame_seq != rb->frame_seq )
+    return (ra->frame_seq > rb->frame_seq) - (ra->frame_seq < rb->frame_seq);
+  if( ra->table != rb->table )
+    return (ra->table > rb->table) - (ra->table < rb->table);
+  return (ra->seq > rb->seq) - (ra->seq < rb->seq);
+}
+
+static int is_empty_entry( const uint8_t* entry, uint16_t size )
+{
+  uint16_t i;
+
+  for( i = 0; i < size; i++ )
+    if( entry[i] != EMPTY_TRACE_BYTE )
+      return 0;
+  return 1;
+}
+
+#define ENTRY_TICKER(e)     ((uint16_t)((e)[0] | ((e)[1]<<8)))
+#define ENTRY_FRAME_SEQ(e)  ((e)[2])
+
+/*
+ * Collect the entries of each table in the snapshot's memory. The ring
+ * is walked from next_trace, which is the oldest entry once the table
+ * has wrapped; before that the slots from there on are still empty.
+ *
+ * Each entry has the low 16 bits of its frame; the table's ticker_high
+ * is the high word as at its newest entry. Going back from that, each
+ * time the ticker goes up it must have wrapped (see TRACE_STAMP in
+ * tracetable.h). With the sequence number within the frame that puts
+ * every entry of every table in the order it was made.
+ */
+static void collect_records( const char* snapshot, const Z80_CORE* z )
+{
+  uint16_t t, i;
+  size_t   first, r;
+
+  num_records = 0;
+
+  for( t = 0; t < NUM_TRACE_LAYOUTS; t++ )
+  {
+    const TRACE_LAYOUT* layout = &trace_layouts[t];
+    uint32_t            table_bytes = (uint32_t)layout->entries * layout->entry_size;
+    uint16_t            table, next, slot;
+    uint32_t            frame;
+
+    if( !table_symbol_addr[t] || !next_symbol_addr[t] )
+      continue;
+
+    table = Z80_CORE_PEEK16( z, table_symbol_addr[t] );
+    next  = Z80_CORE_PEEK16( z, next_symbol_addr[t] );
+
+    if( table == TRACING_INACTIVE )
+      continue;
+
+    if( (uint32_t)table + table_bytes > 0x10000 || next < table || next >= table + table_bytes
+        || (next - table) % layout->entry_size )
+    {
+      fprintf( stderr, "%s: %s trace table pointers 0x%04X 0x%04X don't make sense, skipped\n",
+                       snapshot, layout->name, table, next );
+      continue;
+    }
+
+    slot  = (next - table) / layout->entry_size;
+    first = num_records;
+
+    for( i = 0; i < layout->entries; i++ )
+    {
+      const uint8_t* entry = z->memory + table + (uint32_t)slot*layout->entry_size;
+
+      if( !is_empty_entry( entry, layout->entry_size ) )
+      {
+        records[num_records].table     = t;
+        records[num_records].seq       = num_records - first;
+        records[num_records].frame_seq = ENTRY_FRAME_SEQ( entry );
+        records[num_records].entry     = entry;
+        num_records++;
+      }
+
+      if( ++slot == layout->entries )
+        slot = 0;
+    }
+
+    if( num_records == first )
+      continue;
+
+    /* Builds without the high word only have the 16 bit ticker */
+    frame = high_symbol_addr[t] ? (uint32_t)Z80_CORE_PEEK16( z, high_symbol_addr[t] ) << 16 : 0;
+    frame |= ENTRY_TICKER( records[num_records-1].entry );
+
+    for( r = num_records; r-- > first; )
+    {
+      uint16_t ticker = ENTRY_TICKER( records[r].entry );
+
+      if( ticker > (uint16_t)frame )
+        frame -= 0x10000;
+      frame = (frame & 0xFFFF0000) | ticker;
+      records[r].frame = frame;
+    }
+  }
+
+  qsort( records, num_records, sizeof(TRACE_RECORD), compare_record );
+}
+
+
+/***
+ *       ____        _               _
+ *      / __ \      | |             | |
+ *     | |  | |_   _| |_ _ __  _   _| |_
+ *     | |  | | | | | __| '_ \| | | | __|
+ *     | |__| | |_| | |_| |_) | |_| | |_
+ *      \____/ \__,_|\__| .__/ \__,_|\__|
+ *                      | |
+ *                      |_|
+ */
+
+static void print_header( FILE* out )
+{
+  uint16_t c;
+
+  fputs( "snapshot\tframe\tframe_seq\ttable\tseq", out );
+  for( c = 0; c < num_columns; c++ )
+    if( !IS_TIMESTAMP( columns[c] ) )
+      fprintf( out, "\t%s", columns[c] );
+  fputc( '\n', out );
+}
+
+static void print_field( FILE* out, const TRACE_FIELD* field, const uint8_t* entry )
+{
+  const uint8_t* p = entry + field->offset;
+  uint16_t       value = (field->size == 2) ? (uint16_t)(p[0] | (p[1]<<8)) : p[0];
+
+  switch( field->kind )
+  {
+  case FIELD_I8:   fprintf( out, "%d", (int8_t)value );   break;
+  case FIELD_I16:  fprintf( out, "%d", (int16_t)value );  break;
+  case FIELD_PTR:  fprintf( out, "0x%04X", value );       break;
+  case FIELD_ENUM:
+    /* A value out of range is rubbish, so it's printed as a number */
+    if( value < field->num_enum_names && field->enum_names[value] )
+      fputs( field->enum_names[value], out );
+    else
+      fprintf( out, "%u", value );
+    break;
+  default:         fprintf( out, "%u", value );           break;
+  }
+}
+
+static void print_records( FILE* out, const char* snapshot )
+{
+  const TRACE_FIELD* in_column[NUM_TRACE_LAYOUTS*32];
+  size_t             r;
+  uint16_t           c, f;
+
+  for( r = 0; r < num_records; r++ )
+  {
+    const TRACE_LAYOUT* layout = &trace_layouts[records[r].table];
+    const uint8_t*      entry  = records[r].entry;
+
+    memset( in_column, 0, num_columns*sizeof(in_column[0]) );
+    for( f = 0; f < layout->num_fields; f++ )
+      in_column[field_column[records[r].table][f]] = &layout->fields[f];
+
+    fprintf( out, "%s\t%u\t%u\t%s\t%u", snapshot, records[r].frame, records[r].frame_seq,
+                                          layout->name, records[r].seq );
+
+    for( c = 0; c < num_columns; c++ )
+    {
+      if( IS_TIMESTAMP( columns[c] ) )
+        continue;
+
+      fputc( '\t', out );
+      if( in_column[c] )
+        print_field( out, in_column[c], entry );
+    }
+    fputc( '\n', out );
+  }
+}
+
+
+/*
+ * The game loop's missed frame counts, one row per count:
+ *
+ *  snapshot  stat  index  name  count
+ *
+ * The name is the phase of the loop for the phase_overruns, the number
+ * of frames for frames_per_loop, and otherwise empty.
+ */
+static void print_stats_header( FILE* out )
+{
+  fputs( "snapshot\tstat\tindex\tname\tcount\n", out );
+}
+
+static void print_frame_stats( FILE* out, const char* snapshot, const Z80_CORE* z )
+{
+  uint16_t stats;
+  uint16_t f, i;
+
+  if( !frame_stats_addr )
+    return;
+
+  stats = Z80_CORE_PEEK16( z, frame_stats_addr );
+  if( stats == TRACING_INACTIVE )
+    return;
+
+  if( (uint32_t)stats + FRAME_STATS_SIZE > 0x10000 )
+  {
+    fprintf( stderr, "%s: frame stats pointer 0x%04X doesn't make sense, skipped\n", snapshot, stats );
+    return;
+  }
+
+  for( f = 0; f < NUM_FRAME_STATS_FIELDS; f++ )
+  {
+    const STATS_FIELD* field = &frame_stats_fields[f];
+
+    for( i = 0; i < field->count; i++ )
+    {
+      uint16_t count = Z80_CORE_PEEK16( z, stats + field->offset + 2*i );
+
+      if( field->count == 1 )
+        fprintf( out, "%s\t%s\t\t\t%u\n", snapshot, field->name, count );
+      else
+        fprintf( out, "%s\t%s\t%u\t%s\t%u\n", snapshot, field->name, i,
+                                                field->names ? field->names[i] : "", count );
+    }
+  }
+}
+
+
+/*
+ * The input log runs from the start of its block to the record with no
+ * passes. It's written with that end marker, which the recorder keeps
+ * after its newest record. Returns 0 if a log was written.
+ */
+static int write_input_log( FILE* out, const char* snapshot, const Z80_CORE* z )
+{
+  uint16_t log;
+  uint16_t length = 0;
+
+  if( !input_log_addr )
+  {
+    fprintf( stderr, "%s: the symbols have no input log, the build wasn't recording\n", snapshot );
+    return 1;
+  }
+
+  log = Z80_CORE_PEEK16( z, input_log_addr );
+  if( log == TRACING_INACTIVE || (uint32_t)log + INPUT_LOG_SIZE > 0x10000 )
+  {
+    fprintf( stderr, "%s: no input log was recorded\n", snapshot );
+    return 1;
+  }
+
+  while( length + 2 <= INPUT_LOG_SIZE && z->memory[log+length+1] != 0 )
+  {
+    uint8_t flags = z->memory[log+length];
+
+    length += 2;
+    if( flags & INPUT_RECORD_FRAMES_WORD )
+      length += 2;
+    else if( flags & INPUT_RECORD_FRAMES_BYTE )
+      length += 1;
+  }
+
+  if( length + 2 > INPUT_LOG_SIZE )
+  {
+    fprintf( stderr, "%s: the input log has no end, it's not a log\n", snapshot );
+    return 1;
+  }
+
+  return fwrite( &z->memory[log], 1, length+2, out ) == length+2 ? 0 : 1;
+}
+
+
+/***
+ *       _____                       _           _
+ *      / ____|                     | |         | |
+ *     | (___  _ __   __ _ _ __  ___| |__   ___ | |_ ___
+ *      \___ \| '_ \ / _` | '_ \/ __| '_ \ / _ \| __/ __|
+ *      ____) | | | | (_| | |_) \__ \ | | | (_) | |_\__ \
+ *     |_____/|_| |_|\__,_| .__/|___/_| |_|\___/ \__|___/
+ *                        | |
+ *                        |_|
+ */
+
+static int has_extension( const char* filename, const char* extension )
+{
+  size_t length = strlen( filename );
+  size_t ext    = strlen( extension );
+
+  return length > ext && strcasecmp( filename + length - ext, extension ) == 0;
+}
+
+/*
+ * Returns 0 if the snapshot was read, whether or not it had any traces.
+ */
+static int extract( FILE* out, FILE* stats_out, FILE* input_log_out, const char* snapshot )
+{
+  static Z80_CORE z;
+
+  size_t   length;
+  uint8_t* data = load_file( snapshot, &length );
+  int      result;
+
+  if( data == NULL )
+    return 1;
+
+  memset( z.memory, 0, sizeof(z.memory) );
+
+  if( length >= 4 && memcmp( data, "ZXST", 4 ) == 0 )
+  {
+    result = load_szx_snapshot( data, length, &z );
+  }
+  else if( has_extension( snapshot, ".z80" ) )
+  {
+    result = load_z80_snapshot( data, length, &z );
+  }
+  else if( length == RAW_MEMORY_LENGTH )
+  {
+    memcpy( z.memory, data, RAW_MEMORY_LENGTH );
+    result = 0;
+  }
+  else
+  {
+    fprintf( stderr, "%s: not a snapshot or a 64K memory dump\n", snapshot );
+    result = 1;
+  }
+  free( data );
+
+  if( result )
+  {
+    fprintf( stderr, "%s: skipped\n", snapshot );
+    return 1;
+  }
+
+  collect_records( snapshot, &z );
+  print_records( out, snapshot );
+
+  if( stats_out )
+    print_frame_stats( stats_out, snapshot, &z );
+
+  if( input_log_out )
+    return write_input_log( input_log_out, snapshot, &z );
+
+  return 0;
+}
+
+
+/***
+ *      __  __       _
+ *     |  \/  |     (_)
+ *     | \  / | __ _ _ _ __
+ *     | |\/| |/ _` | | '_ \
+ *     | |  | | (_| | | | | |
+ *     |_|  |_|\__,_|_|_| |_|
+ */
+
+static void usage( const char* name )
+{
+  fprintf( stderr, "Usage: %s [-s symbols] [-o output] [-f stats_output] [-i input_log] [-l snapshot_list] [snapshot...]\n", name );
+  exit( 1 );
+}
+
+int main( int argc, char* argv[] )
+{
+  const char* symbols_file  = DEFAULT_SYMBOLS;
+  const char* output_file   = NULL;
+  const char* list_file     = NULL;
+  const char* stats_file    = NULL;
+  const char* input_log     = NULL;
+  FILE*       out           = stdout;
+  FILE*       stats_out     = NULL;
+  FILE*       input_log_out = NULL;
+  int         failures      = 0;
+  int         opt;
+
+  while( (opt = getopt( argc, argv, "s:o:f:i:l:" )) != -1 )
+  {
+    switch( opt )
+    {
+    case 's': symbols_file = optarg; break;
+    case 'o': output_file = optarg;  break;
+    case 'f': stats_file = optarg;   break;
+    case 'i': input_log = optarg;    break;
+    case 'l': list_file = optarg;    break;
+    default:  usage( argv[0] );
+    }
+  }
+
+  if( optind == argc && list_file == NULL )
+    usage( argv[0] );
+
+  if( input_log && (optind != argc-1 || list_file) )
+  {
+    fprintf( stderr, "%s: -i takes the log from one snapshot\n", argv[0] );
+    exit( 1 );
+  }
+
+  if( load_symbols( symbols_file ) )
+    exit( 1 );
+
+  if( output_file && (out = fopen( output_file, "w" )) == NULL )
+  {
+    perror( output_file );
+    exit( 1 );
+  }
+  setvbuf( out, NULL, _IOFBF, OUTPUT_BUFFER_SIZE );
+
+  if( stats_file )
+  {
+    if( (stats_out = fopen( stats_file, "w" )) == NULL )
+    {
+      perror( stats_file );
+      exit( 1 );
+    }
+    print_stats_header( stats_out );
+  }
+
+  if( input_log && (input_log_out = fopen( input_log, "wb" )) == NULL )
+  {
+    perror( input_log );
+    exit( 1 );
+  }
+
+  build_columns();
+  print_header( out );
+
+  for( ; optind < argc; optind++ )
+    failures += extract( out, stats_out, input_log_out, argv[optind] );
+
+  if( list_file )
+  {
+    FILE* list = strcmp( list_file, "-" ) == 0 ? stdin : fopen( list_file, "r" );
+    char  snapshot[4096];
+
+    if( list == NULL )
+    {
+      perror( list_file );
+      exit( 1 );
+    }
+
+    while( fgets( snapshot, sizeof(snapshot), list ) )
+    {
+      snapshot[strcspn( snapshot, "\r\n" )] = '\0';
+      if( snapshot[0] )
+        failures += extract( out, stats_out, input_log_out, snapshot );
+    }
+
+    if( list != stdin )
+      fclose( list );
+  }
+
+  if( fclose( out ) )
+  {
+    perror( output_file ? output_file : "output" );
+    exit( 1 );
+  }
+
+  if( stats_out && fclose( stats_out ) )
+  {
+    perror( stats_file );
+    exit( 1 );
+  }
+
+  if( input_log_out && fclose( input_log_out ) )
+  {
+    perror( input_log );
+    exit( 1 );
+  }
+
+  if( failures )
+    fprintf( stderr, "%d snapshots couldn't be read\n", failures );
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,1176 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Z80 core for the profiler. Instructions are decoded from the x/y/z
+ * fields of the opcode rather than with a 256 way switch, and each one
+ * is built from the M-cycles it does so the contention lands at the
+ * right T-state:
+ *
+ *  opcode fetch  4T   (contended on the PC)
+ *  memory read   3T   (contended on the address)
+ *  memory write  3T   (contended on the address)
+ *  port access   4T   (the ULA's I/O contention rules)
+ *
+ * plus whatever internal cycles the instruction has, which are simply
+ * added on.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "z80_core.h"
+
+#define FLAG_C   0x01
+#define FLAG_N   0x02
+#define FLAG_PV  0x04
+#define FLAG_X   0x08
+#define FLAG_H   0x10
+#define FLAG_Y   0x20
+#define FLAG_Z   0x40
+#define FLAG_S   0x80
+
+#define PREFIX_NONE  0x00
+#define PREFIX_IX    0xDD
+#define PREFIX_IY    0xFD
+
+/* Sign, zero and the two undocumented bits; and the same plus parity */
+static uint8_t sz53[256];
+static uint8_t sz53p[256];
+
+/*
+ * Contention delay at each T-state of the frame. The ULA reads the screen
+ * for 128T of each of the 192 display lines, and holds the CPU off for
+ * 6,5,4,3,2,1,0,0 T-states in each 8T cycle of that.
+ */
+#define FIRST_CONTENDED_TSTATE  14335
+#define TSTATES_PER_LINE        224
+
+static uint8_t contention[ZX48_FRAME_TSTATES];
+static int     tables_built = 0;
+
+static void build_tables( void )
+{
+  static const uint8_t pattern[8] = {6,5,4,3,2,1,0,0};
+  int i;
+
+  for( i = 0; i < 256; i++ )
+  {
+    uint8_t parity = 1;
+    int     bit;
+
+    for( bit = 0; bit < 8; bit++ )
+      parity ^= (i >> bit) & 1;
+
+    sz53[i]  = (i & (FLAG_S|FLAG_Y|FLAG_X)) | (i ? 0 : FLAG_Z);
+    sz53p[i] = sz53[i] | (parity ? FLAG_PV : 0);
+  }
+
+  for( i = 0; i < ZX48_FRAME_TSTATES; i++ )
+  {
+    contention[i] = 0;
+    if( i >= FIRST_CONTENDED_TSTATE && i < FIRST_CONTENDED_TSTATE + 192*TSTATES_PER_LINE )
+    {
+      int pos = (i - FIRST_CONTENDED_TSTATE) % TSTATES_PER_LINE;
+      if( pos < 128 )
+        contention[i] = pattern[pos & 7];
+    }
+  }
+
+  tables_built = 1;
+}
+
+
+/***
+ *        _______ _           _
+ *       |__   __(_)         (_)
+ *          | |   _ _ __ ___  _ _ __   __ _
+ *          | |  | | '_ ` _ \| | '_ \ / _` |
+ *          | |  | | | | | | | | | | | (_| |
+ *          |_|  |_|_| |_| |_|_|_| |_|\__, |
+ *                                     __/ |
+ *                                    |___/
+ */
+
+#define IS_CONTENDED(addr)  (((addr) & 0xC000) == 0x4000)
+
+static inline void contend( Z80_CORE* z )
+{
+  if( z->tstates < ZX48_FRAME_TSTATES )
+    z->tstates += contention[z->tstates];
+}
+
+static inline void contend_addr( Z80_CORE* z, uint16_t addr )
+{
+  if( IS_CONTENDED(addr) )
+    contend( z );
+}
+
+static inline uint8_t fetch_opcode( Z80_CORE* z )
+{
+  contend_addr( z, z->pc );
+  z->tstates += 4;
+  z->fetches++;
+  z->r = (z->r & 0x80) | ((z->r + 1) & 0x7F);
+  return z->memory[z->pc++];
+}
+
+static inline uint8_t read_byte( Z80_CORE* z, uint16_t addr )
+{
+  contend_addr( z, addr );
+  z->tstates += 3;
+  return z->memory[addr];
+}
+
+static inline void write_byte( Z80_CORE* z, uint16_t addr, uint8_t value )
+{
+  contend_addr( z, addr );
+  z->tstates += 3;
+  if( addr >= 0x4000 || z->rom_writable )
+    z->memory[addr] = value;
+}
+
+static inline uint8_t read_pc_byte( Z80_CORE* z )
+{
+  return read_byte( z, z->pc++ );
+}
+
+static inline uint16_t read_pc_word( Z80_CORE* z )
+{
+  uint8_t lo = read_pc_byte( z );
+  return lo | (read_pc_byte( z ) << 8);
+}
+
+static inline uint16_t read_word( Z80_CORE* z, uint16_t addr )
+{
+  uint8_t lo = read_byte( z, addr );
+  return lo | (read_byte( z, addr+1 ) << 8);
+}
+
+static inline void write_word( Z80_CORE* z, uint16_t addr, uint16_t value )
+{
+  write_byte( z, addr,   value & 0xFF );
+  write_byte( z, addr+1, value >> 8 );
+}
+
+static inline void push( Z80_CORE* z, uint16_t value )
+{
+  write_byte( z, --z->sp, value >> 8 );
+  write_byte( z, --z->sp, value & 0xFF );
+}
+
+static inline uint16_t pop( Z80_CORE* z )
+{
+  uint8_t lo = read_byte( z, z->sp++ );
+  return lo | (read_byte( z, z->sp++ ) << 8);
+}
+
+/*
+ * Port access timing. The ULA is any even port; the high byte of the port
+ * being in the contended range adds contention as if it were an address.
+ */
+static void port_timing( Z80_CORE* z, uint16_t port )
+{
+  if( IS_CONTENDED(port) )
+  {
+    if( port & 1 )
+    {
+      contend( z ); z->tstates++;
+      contend( z ); z->tstates++;
+      contend( z ); z->tstates++;
+      contend( z ); z->tstates++;
+    }
+    else
+    {
+      contend( z ); z->tstates += 1;
+      contend( z ); z->tstates += 3;
+    }
+  }
+  else
+  {
+    if( port & 1 )
+    {
+      z->tstates += 4;
+    }
+    else
+    {
+      z->tstates += 1;
+      contend( z ); z->tstates += 3;
+    }
+  }
+}
+
+static uint8_t port_in( Z80_CORE* z, uint16_t port )
+{
+  port_timing( z, port );
+  return z->port_in ? z->port_in( z, port ) : 0xFF;
+}
+
+static void port_out( Z80_CORE* z, uint16_t port, uint8_t value )
+{
+  port_timing( z, port );
+  if( z->port_out )
+    z->port_out( z, port, value );
+}
+
+
+/***
+ *                 _
+ *         /\     | |
+ *        /  \    | |    _   _
+ *       / /\ \   | |   | | | |
+ *      / ____ \  | |___| |_| |
+ *     /_/    \_\ |______\__,_|
+ */
+
+static void alu( Z80_CORE* z, int op, uint8_t v )
+{
+  unsigned r;
+  uint8_t  carry = z->f & FLAG_C;
+
+  switch( op )
+  {
+  case 0: /* ADD */
+  case 1: /* ADC */
+    if( op == 0 ) carry = 0;
+    r = z->a + v + carry;
+    z->f = sz53[r & 0xFF] | ((z->a ^ v ^ r) & FLAG_H) |
+           (((z->a ^ ~v) & (z->a ^ r) & 0x80) ? FLAG_PV : 0) | ((r >> 8) & FLAG_C);
+    z->a = r;
+    break;
+
+  case 2: /* SUB */
+  case 3: /* SBC */
+  case 7: /* CP */
+    if( op != 3 ) carry = 0;
+    r = z->a - v - carry;
+    z->f = sz53[r & 0xFF] | FLAG_N | ((z->a ^ v ^ r) & FLAG_H) |
+           (((z->a ^ v) & (z->a ^ r) & 0x80) ? FLAG_PV : 0) | ((r >> 8) & FLAG_C);
+    if( op == 7 )
+      z->f = (z->f & ~(FLAG_X|FLAG_Y)) | (v & (FLAG_X|FLAG_Y));
+    else
+      z->a = r;
+    break;
+
+  case 4: /* AND */
+    z->a &= v;
+    z->f = sz53p[z->a] | FLAG_H;
+    break;
+
+  case 5: /* XOR */
+    z->a ^= v;
+    z->f = sz53p[z->a];
+    break;
+
+  case 6: /* OR */
+    z->a |= v;
+    z->f = sz53p[z->a];
+    break;
+  }
+}
+
+static uint8_t inc8( Z80_CORE* z, uint8_t v )
+{
+  uint8_t r = v + 1;
+  z->f = (z->f & FLAG_C) | sz53[r] | ((r & 0x0F) ? 0 : FLAG_H) | ((r == 0x80) ? FLAG_PV : 0);
+  return r;
+}
+
+static uint8_t dec8( Z80_CORE* z, uint8_t v )
+{
+  uint8_t r = v - 1;
+  z->f = (z->f & FLAG_C) | FLAG_N | sz53[r] | (((r & 0x0F) == 0x0F) ? FLAG_H : 0) | ((r == 0x7F) ? FLAG_PV : 0);
+  return r;
+}
+
+static uint16_t add16( Z80_CORE* z, uint16_t a, uint16_t b )
+{
+  uint32_t r = a + b;
+  z->f = (z->f & (FLAG_S|FLAG_Z|FLAG_PV)) | ((r >> 8) & (FLAG_X|FLAG_Y)) |
+         (((a ^ b ^ r) >> 8) & FLAG_H) | ((r >> 16) & FLAG_C);
+  return r;
+}
+
+static uint16_t adc16( Z80_CORE* z, uint16_t a, uint16_t b )
+{
+  uint32_t r = a + b + (z->f & FLAG_C);
+  z->f = ((r >> 8) & (FLAG_S|FLAG_X|FLAG_Y)) | ((r & 0xFFFF) ? 0 : FLAG_Z) |
+         (((a ^ b ^ r) >> 8) & FLAG_H) | (((a ^ ~b) & (a ^ r) & 0x8000) ? FLAG_PV : 0) |
+         ((r >> 16) & FLAG_C);
+  return r;
+}
+
+static uint16_t sbc16( Z80_CORE* z, uint16_t a, uint16_t b )
+{
+  uint32_t r = a - b - (z->f & FLAG_C);
+  z->f = FLAG_N | ((r >> 8) & (FLAG_S|FLAG_X|FLAG_Y)) | ((r & 0xFFFF) ? 0 : FLAG_Z) |
+         (((a ^ b ^ r) >> 8) & FLAG_H) | (((a ^ b) & (a ^ r) & 0x8000) ? FLAG_PV : 0) |
+         ((r >> 16) & FLAG_C);
+  return r;
+}
+
+/* The CB prefixed rotates and shifts, 0-7 being RLC RRC RL RR SLA SRA SLL SRL */
+static uint8_t rotate( Z80_CORE* z, int op, uint8_t v )
+{
+  uint8_t r, carry;
+
+  switch( op )
+  {
+  case 0:  carry = v >> 7;  r = (v << 1) | carry;               break;
+  case 1:  carry = v & 1;   r = (v >> 1) | (carry << 7);        break;
+  case 2:  carry = v >> 7;  r = (v << 1) | (z->f & FLAG_C);     break;
+  case 3:  carry = v & 1;   r = (v >> 1) | ((z->f & FLAG_C) << 7); break;
+  case 4:  carry = v >> 7;  r = v << 1;                         break;
+  case 5:  carry = v & 1;   r = (v >> 1) | (v & 0x80);          break;
+  case 6:  carry = v >> 7;  r = (v << 1) | 1;                   break;
+  default: carry = v & 1;   r = v >> 1;                         break;
+  }
+
+  z->f = sz53p[r] | carry;
+  return r;
+}
+
+static void bit_test( Z80_CORE* z, int bit, uint8_t v )
+{
+  uint8_t r = v & (1 << bit);
+
+  z->f = (z->f & FLAG_C) | FLAG_H | (v & (FLAG_X|FLAG_Y)) |
+         (r ? (r & FLAG_S) : (FLAG_Z|FLAG_PV));
+}
+
+static void daa( Z80_CORE* z )
+{
+  uint8_t add   = 0;
+  uint8_t carry = z->f & FLAG_C;
+  uint8_t half;
+  uint8_t r;
+
+  if( (z->f & FLAG_H) || (z->a & 0x0F) > 9 )
+    add = 0x06;
+  if( carry || z->a > 0x99 )
+  {
+    add |= 0x60;
+    carry = FLAG_C;
+  }
+
+  if( z->f & FLAG_N )
+  {
+    half = ((z->f & FLAG_H) && (z->a & 0x0F) < 6) ? FLAG_H : 0;
+    r = z->a - add;
+  }
+  else
+  {
+    half = ((z->a & 0x0F) > 9) ? FLAG_H : 0;
+    r = z->a + add;
+  }
+
+  z->f = sz53p[r] | (z->f & FLAG_N) | carry | half;
+  z->a = r;
+}
+
+
+/***
+ *      _____            _     _
+ *     |  __ \          (_)   | |
+ *     | |__) |___  __ _ _ ___| |_ ___ _ __ ___
+ *     |  _  // _ \/ _` | / __| __/ _ \ '__/ __|
+ *     | | \ \  __/ (_| | \__ \ ||  __/ |  \__ \
+ *     |_|  \_\___|\__, |_|___/\__\___|_|  |___/
+ *                  __/ |
+ *                 |___/
+ */
+
+/*
+ * 8 bit register by its 3 bit code, B C D E H L - A. H and L are IXH/IXL
+ * or IYH/IYL under a prefix. Code 6, (HL), is handled by the callers.
+ */
+static uint8_t* reg8( Z80_CORE* z, int code, uint8_t prefix )
+{
+  switch( code )
+  {
+  case 0:  return &z->b;
+  case 1:  return &z->c;
+  case 2:  return &z->d;
+  case 3:  return &z->e;
+  case 4:  return prefix == PREFIX_IX ? &z->ixh : prefix == PREFIX_IY ? &z->iyh : &z->h;
+  case 5:  return prefix == PREFIX_IX ? &z->ixl : prefix == PREFIX_IY ? &z->iyl : &z->l;
+  default: return &z->a;
+  }
+}
+
+static uint16_t get_hl( Z80_CORE* z, uint8_t prefix )
+{
+  return prefix == PREFIX_IX ? Z80_CORE_IX(z) : prefix == PREFIX_IY ? Z80_CORE_IY(z) : Z80_CORE_HL(z);
+}
+
+static void set_hl( Z80_CORE* z, uint8_t prefix, uint16_t v )
+{
+  if( prefix == PREFIX_IX )      { z->ixh = v >> 8; z->ixl = v; }
+  else if( prefix == PREFIX_IY ) { z->iyh = v >> 8; z->iyl = v; }
+  else                           { z->h = v >> 8;   z->l = v; }
+}
+
+/* 16 bit pairs by 2 bit code: BC DE HL SP, or BC DE HL AF for push and pop */
+static uint16_t get_rp( Z80_CORE* z, int code, uint8_t prefix, int af )
+{
+  switch( code )
+  {
+  case 0:  return Z80_CORE_BC(z);
+  case 1:  return Z80_CORE_DE(z);
+  case 2:  return get_hl( z, prefix );
+  default: return af ? (uint16_t)((z->a << 8) | z->f) : z->sp;
+  }
+}
+
+static void set_rp( Z80_CORE* z, int code, uint8_t prefix, int af, uint16_t v )
+{
+  switch( code )
+  {
+  case 0:  z->b = v >> 8; z->c = v; break;
+  case 1:  z->d = v >> 8; z->e = v; break;
+  case 2:  set_hl( z, prefix, v );  break;
+  default:
+    if( af ) { z->a = v >> 8; z->f = v; }
+    else     z->sp = v;
+    break;
+  }
+}
+
+static int condition( Z80_CORE* z, int cc )
+{
+  switch( cc )
+  {
+  case 0:  return !(z->f & FLAG_Z);
+  case 1:  return   z->f & FLAG_Z;
+  case 2:  return !(z->f & FLAG_C);
+  case 3:  return   z->f & FLAG_C;
+  case 4:  return !(z->f & FLAG_PV);
+  case 5:  return   z->f & FLAG_PV;
+  case 6:  return !(z->f & FLAG_S);
+  default: return   z->f & FLAG_S;
+  }
+}
+
+/*
+ * Address of an (HL) operand, or (IX+d)/(IY+d) under a prefix. The
+ * displacement read and the 5T of address arithmetic are the prefixed
+ * forms' extra cost.
+ */
+static uint16_t operand_address( Z80_CORE* z, uint8_t prefix )
+{
+  if( prefix == PREFIX_NONE )
+    return Z80_CORE_HL(z);
+
+  {
+    int8_t d = (int8_t)read_pc_byte( z );
+    z->tstates += 5;
+    return get_hl( z, prefix ) + d;
+  }
+}
+
+#define SWAP8(x,y)  do { uint8_t t = (x); (x) = (y); (y) = t; } while(0)
+
+
+/***
+ *       _____ ____
+ *      / ____|  _ \
+ *     | |    | |_) |
+ *     | |    |  _ <
+ *     | |____| |_) |
+ *      \_____|____/
+ */
+
+static void execute_cb( Z80_CORE* z )
+{
+  uint8_t op = fetch_opcode( z );
+  int     x  = op >> 6;
+  int     y  = (op >> 3) & 7;
+  int     r  = op & 7;
+
+  if( r == 6 )
+  {
+    uint16_t addr = Z80_CORE_HL(z);
+    uint8_t  v    = read_byte( z, addr );
+
+    z->tstates += 1;
+
+    switch( x )
+    {
+    case 0: write_byte( z, addr, rotate( z, y, v ) );   break;
+    case 1: bit_test( z, y, v );                        break;
+    case 2: write_byte( z, addr, v & ~(1 << y) );       break;
+    case 3: write_byte( z, addr, v | (1 << y) );        break;
+    }
+  }
+  else
+  {
+    uint8_t* reg = reg8( z, r, PREFIX_NONE );
+
+    switch( x )
+    {
+    case 0: *reg = rotate( z, y, *reg );  break;
+    case 1: bit_test( z, y, *reg );       break;
+    case 2: *reg &= ~(1 << y);            break;
+    case 3: *reg |= (1 << y);             break;
+    }
+  }
+}
+
+/*
+ * DDCB/FDCB. The displacement comes before the opcode, and the opcode
+ * read isn't an M1 so it doesn't bump R. The undocumented forms with a
+ * register also copy the result into the register.
+ */
+static void execute_index_cb( Z80_CORE* z, uint8_t prefix )
+{
+  int8_t   d    = (int8_t)read_pc_byte( z );
+  uint8_t  op   = read_pc_byte( z );
+  uint16_t addr = get_hl( z, prefix ) + d;
+  int      x    = op >> 6;
+  int      y    = (op >> 3) & 7;
+  int      r    = op & 7;
+  uint8_t  v;
+
+  z->tstates += 2;
+  v = read_byte( z, addr );
+  z->tstates += 1;
+
+  switch( x )
+  {
+  case 0:  v = rotate( z, y, v );  break;
+  case 1:  bit_test( z, y, v );    return;
+  case 2:  v &= ~(1 << y);         break;
+  default: v |= (1 << y);          break;
+  }
+
+  write_byte( z, addr, v );
+  if( r != 6 )
+    *reg8( z, r, PREFIX_NONE ) = v;
+}
+
+
+/***
+ *      ______ _____
+ *     |  ____|  __ \
+ *     | |__  | |  | |
+ *     |  __| | |  | |
+ *     | |____| |__| |
+ *     |______|_____/
+ */
+
+static void execute_block( Z80_CORE* z, int y, int op )
+{
+  int      dir    = (y & 1) ? -1 : 1;
+  int      repeat = y >= 6;
+  uint16_t hl     = Z80_CORE_HL(z);
+  uint16_t bc     = Z80_CORE_BC(z);
+
+  switch( op )
+  {
+  case 0: /* LDI LDD LDIR LDDR */
+  {
+    uint16_t de = Z80_CORE_DE(z);
+    uint8_t  v  = read_byte( z, hl );
+    uint8_t  n;
+
+    write_byte( z, de, v );
+    z->tstates += 2;
+
+    hl += dir; de += dir; bc--;
+    n = v + z->a;
+    z->f = (z->f & (FLAG_S|FLAG_Z|FLAG_C)) | (bc ? FLAG_PV : 0) | (n & FLAG_X) | ((n & 0x02) ? FLAG_Y : 0);
+    z->d = de >> 8; z->e = de;
+
+    if( repeat && bc )
+    {
+      z->tstates += 5;
+      z->pc -= 2;
+    }
+    break;
+  }
+
+  case 1: /* CPI CPD CPIR CPDR */
+  {
+    uint8_t v = read_byte( z, hl );
+    uint8_t r = z->a - v;
+    uint8_t half = (z->a ^ v ^ r) & FLAG_H;
+    uint8_t n = r - (half ? 1 : 0);
+
+    z->tstates += 5;
+    hl += dir; bc--;
+    z->f = (z->f & FLAG_C) | FLAG_N | (r & FLAG_S) | (r ? 0 : FLAG_Z) | half |
+           (bc ? FLAG_PV : 0) | (n & FLAG_X) | ((n & 0x02) ? FLAG_Y : 0);
+
+    if( repeat && bc && r )
+    {
+      z->tstates += 5;
+      z->pc -= 2;
+    }
+    break;
+  }
+
+  case 2: /* INI IND INIR INDR */
+  {
+    uint8_t v;
+
+    z->tstates += 1;
+    v = port_in( z, bc );
+    write_byte( z, hl, v );
+    hl += dir;
+    bc -= 0x100;
+    z->f = sz53[bc >> 8] | ((v & 0x80) ? FLAG_N : 0);
+
+    if( repeat && (bc >> 8) )
+    {
+      z->tstates += 5;
+      z->pc -= 2;
+    }
+    break;
+  }
+
+  case 3: /* OUTI OUTD OTIR OTDR */
+  {
+    uint8_t v;
+
+    z->tstates += 1;
+    v = read_byte( z, hl );
+    bc -= 0x100;
+    port_out( z, bc, v );
+    hl += dir;
+    z->f = sz53[bc >> 8] | ((v & 0x80) ? FLAG_N : 0);
+
+    if( repeat && (bc >> 8) )
+    {
+      z->tstates += 5;
+      z->pc -= 2;
+    }
+    break;
+  }
+  }
+
+  z->h = hl >> 8; z->l = hl;
+  z->b = bc >> 8; z->c = bc;
+}
+
+static void execute_ed( Z80_CORE* z )
+{
+  uint8_t op = fetch_opcode( z );
+  int     x  = op >> 6;
+  int     y  = (op >> 3) & 7;
+  int     r  = op & 7;
+  int     p  = y >> 1;
+  int     q  = y & 1;
+
+  if( x == 2 && y >= 4 && r <= 3 )
+  {
+    execute_block( z, y, r );
+    return;
+  }
+
+  if( x != 1 )
+    return;   /* ED NOP */
+
+  switch( r )
+  {
+  case 0: /* IN r,(C) */
+  {
+    uint8_t v = port_in( z, Z80_CORE_BC(z) );
+    z->f = (z->f & FLAG_C) | sz53p[v];
+    if( y != 6 )
+      *reg8( z, y, PREFIX_NONE ) = v;
+    break;
+  }
+
+  case 1: /* OUT (C),r */
+    port_out( z, Z80_CORE_BC(z), y == 6 ? 0 : *reg8( z, y, PREFIX_NONE ) );
+    break;
+
+  case 2: /* SBC HL,rr / ADC HL,rr */
+  {
+    uint16_t v = get_rp( z, p, PREFIX_NONE, 0 );
+    uint16_t hl = q ? adc16( z, Z80_CORE_HL(z), v ) : sbc16( z, Z80_CORE_HL(z), v );
+    z->tstates += 7;
+    z->h = hl >> 8; z->l = hl;
+    break;
+  }
+
+  case 3: /* LD (nn),rr / LD rr,(nn) */
+  {
+    uint16_t addr = read_pc_word( z );
+    if( q )
+      set_rp( z, p, PREFIX_NONE, 0, read_word( z, addr ) );
+    else
+      write_word( z, addr, get_rp( z, p, PREFIX_NONE, 0 ) );
+    break;
+  }
+
+  case 4: /* NEG */
+  {
+    uint8_t v = z->a;
+    z->a = 0;
+    alu( z, 2, v );
+    break;
+  }
+
+  case 5: /* RETN / RETI */
+    z->iff1 = z->iff2;
+    z->pc = pop( z );
+    break;
+
+  case 6: /* IM */
+  {
+    static const uint8_t modes[8] = {0,0,1,2,0,0,1,2};
+    z->im = modes[y];
+    break;
+  }
+
+  case 7:
+    switch( y )
+    {
+    case 0: z->tstates += 1; z->i = z->a; break;
+    case 1: z->tstates += 1; z->r = z->a; break;
+    case 2:
+    case 3:
+      z->tstates += 1;
+      z->a = (y == 2) ? z->i : z->r;
+      z->f = (z->f & FLAG_C) | sz53[z->a] | (z->iff2 ? FLAG_PV : 0);
+      break;
+    case 4: /* RRD */
+    case 5: /* RLD */
+    {
+      uint16_t hl = Z80_CORE_HL(z);
+      uint8_t  v  = read_byte( z, hl );
+      z->tstates += 4;
+      if( y == 4 )
+      {
+        write_byte( z, hl, (z->a << 4) | (v >> 4) );
+        z->a = (z->a & 0xF0) | (v & 0x0F);
+      }
+      else
+      {
+        write_byte( z, hl, (v << 4) | (z->a & 0x0F) );
+        z->a = (z->a & 0xF0) | (v >> 4);
+      }
+      z->f = (z->f & FLAG_C) | sz53p[z->a];
+      break;
+    }
+    default:
+      break;
+    }
+    break;
+  }
+}
+
+
+/***
+ *      __  __       _
+ *     |  \/  |     (_)
+ *     | \  / | __ _ _ _ __
+ *     | |\/| |/ _` | | '_ \
+ *     | |  | | (_| | | | | |
+ *     |_|  |_|\__,_|_|_| |_|
+ */
+
+void z80_core_reset( Z80_CORE* z )
+{
+  if( !tables_built )
+    build_tables();
+
+  memset( z, 0, sizeof(*z) );
+  z->a = z->f = 0xFF;
+  z->sp = 0xFFFF;
+}
+
+int z80_core_interrupt( Z80_CORE* z )
+{
+  if( !z->iff1 || z->ei_delay )
+    return 0;
+
+  if( z->halted )
+  {
+    z->halted = 0;
+    z->pc++;
+  }
+
+  z->iff1 = z->iff2 = 0;
+  z->r = (z->r & 0x80) | ((z->r + 1) & 0x7F);
+
+  /* The acknowledge cycle is an M1 with 2 wait states */
+  z->tstates += 7;
+  push( z, z->pc );
+
+  if( z->im == 2 )
+    z->pc = read_word( z, (z->i << 8) | 0xFF );
+  else
+    z->pc = 0x0038;
+
+  return 1;
+}
+
+void z80_core_step( Z80_CORE* z )
+{
+  uint8_t prefix = PREFIX_NONE;
+  uint8_t op;
+  int     x, y, r, p, q;
+
+  z->ei_delay = 0;
+
+  if( z->halted )
+  {
+    /* A halted Z80 runs NOPs, which is 4T and an R bump each */
+    z->tstates += 4;
+    z->fetches++;
+    z->r = (z->r & 0x80) | ((z->r + 1) & 0x7F);
+    return;
+  }
+
+  op = fetch_opcode( z );
+  while( op == PREFIX_IX || op == PREFIX_IY )
+  {
+    prefix = op;
+    op = fetch_opcode( z );
+  }
+
+  x = op >> 6;
+  y = (op >> 3) & 7;
+  r = op & 7;
+  p = y >> 1;
+  q = y & 1;
+
+  switch( x )
+  {
+  case 0:
+    switch( r )
+    {
+    case 0:
+      switch( y )
+      {
+      case 0: /* NOP */
+        break;
+      case 1: /* EX AF,AF' */
+        SWAP8( z->a, z->a_ );
+        SWAP8( z->f, z->f_ );
+        break;
+      case 2: /* DJNZ */
+      {
+        int8_t d;
+        z->tstates += 1;
+        d = (int8_t)read_pc_byte( z );
+        if( --z->b )
+        {
+          z->tstates += 5;
+          z->pc += d;
+        }
+        break;
+      }
+      default: /* JR and JR cc */
+      {
+        int8_t d = (int8_t)read_pc_byte( z );
+        if( y == 3 || condition( z, y - 4 ) )
+        {
+          z->tstates += 5;
+          z->pc += d;
+        }
+        break;
+      }
+      }
+      break;
+
+    case 1:
+      if( q == 0 ) /* LD rr,nn */
+      {
+        set_rp( z, p, prefix, 0, read_pc_word( z ) );
+      }
+      else /* ADD HL,rr */
+      {
+        z->tstates += 7;
+        set_hl( z, prefix, add16( z, get_hl( z, prefix ), get_rp( z, p, prefix, 0 ) ) );
+      }
+      break;
+
+    case 2:
+      switch( y )
+      {
+      case 0: write_byte( z, Z80_CORE_BC(z), z->a );                      break;
+      case 1: z->a = read_byte( z, Z80_CORE_BC(z) );                      break;
+      case 2: write_byte( z, Z80_CORE_DE(z), z->a );                      break;
+      case 3: z->a = read_byte( z, Z80_CORE_DE(z) );                      break;
+      case 4: write_word( z, read_pc_word( z ), get_hl( z, prefix ) );   break;
+      case 5: set_hl( z, prefix, read_word( z, read_pc_word( z ) ) );    break;
+      case 6: write_byte( z, read_pc_word( z ), z->a );                  break;
+      case 7: z->a = read_byte( z, read_pc_word( z ) );                  break;
+      }
+      break;
+
+    case 3: /* INC rr / DEC rr */
+      z->tstates += 2;
+      set_rp( z, p, prefix, 0, get_rp( z, p, prefix, 0 ) + (q ? -1 : 1) );
+      break;
+
+    case 4: /* INC r */
+    case 5: /* DEC r */
+      if( y == 6 )
+      {
+        uint16_t addr = operand_address( z, prefix );
+        uint8_t  v    = read_byte( z, addr );
+        z->tstates += 1;
+        write_byte( z, addr, r == 4 ? inc8( z, v ) : dec8( z, v ) );
+      }
+      else
+      {
+        uint8_t* reg = reg8( z, y, prefix );
+        *reg = (r == 4) ? inc8( z, *reg ) : dec8( z, *reg );
+      }
+      break;
+
+    case 6: /* LD r,n */
+      if( y == 6 )
+      {
+        uint16_t addr;
+        if( prefix == PREFIX_NONE )
+        {
+          addr = Z80_CORE_HL(z);
+          write_byte( z, addr, read_pc_byte( z ) );
+        }
+        else
+        {
+          int8_t  d = (int8_t)read_pc_byte( z );
+          uint8_t n = read_pc_byte( z );
+          z->tstates += 2;
+          write_byte( z, get_hl( z, prefix ) + d, n );
+        }
+      }
+      else
+      {
+        *reg8( z, y, prefix ) = read_pc_byte( z );
+      }
+      break;
+
+    case 7:
+      switch( y )
+      {
+      case 0: /* RLCA */
+        z->a = (z->a << 1) | (z->a >> 7);
+        z->f = (z->f & (FLAG_S|FLAG_Z|FLAG_PV)) | (z->a & (FLAG_X|FLAG_Y|FLAG_C));
+        break;
+      case 1: /* RRCA */
+        z->f = (z->f & (FLAG_S|FLAG_Z|FLAG_PV)) | (z->a & FLAG_C);
+        z->a = (z->a >> 1) | (z->a << 7);
+        z->f |= z->a & (FLAG_X|FLAG_Y);
+        break;
+      case 2: /* RLA */
+      {
+        uint8_t carry = z->a >> 7;
+        z->a = (z->a << 1) | (z->f & FLAG_C);
+        z->f = (z->f & (FLAG_S|FLAG_Z|FLAG_PV)) | (z->a & (FLAG_X|FLAG_Y)) | carry;
+        break;
+      }
+      case 3: /* RRA */
+      {
+        uint8_t carry = z->a & 1;
+        z->a = (z->a >> 1) | ((z->f & FLAG_C) << 7);
+        z->f = (z->f & (FLAG_S|FLAG_Z|FLAG_PV)) | (z->a & (FLAG_X|FLAG_Y)) | carry;
+        break;
+      }
+      case 4:
+        daa( z );
+        break;
+      case 5: /* CPL */
+        z->a ^= 0xFF;
+        z->f = (z->f & (FLAG_S|FLAG_Z|FLAG_PV|FLAG_C)) | FLAG_H | FLAG_N | (z->a & (FLAG_X|FLAG_Y));
+        break;
+      case 6: /* SCF */
+        z->f = (z->f & (FLAG_S|FLAG_Z|FLAG_PV)) | (z->a & (FLAG_X|FLAG_Y)) | FLAG_C;
+        break;
+      case 7: /* CCF */
+        z->f = (z->f & (FLAG_S|FLAG_Z|FLAG_PV)) | (z->a & (FLAG_X|FLAG_Y)) |
+               ((z->f & FLAG_C) ? FLAG_H : FLAG_C);
+        break;
+      }
+      break;
+    }
+    break;
+
+  case 1:
+    if( y == 6 && r == 6 ) /* HALT */
+    {
+      z->halted = 1;
+      z->pc--;
+    }
+    else if( y == 6 ) /* LD (HL),r - the source is never IXH/IXL */
+    {
+      uint16_t addr = operand_address( z, prefix );
+      write_byte( z, addr, *reg8( z, r, PREFIX_NONE ) );
+    }
+    else if( r == 6 ) /* LD r,(HL) */
+    {
+      uint16_t addr = operand_address( z, prefix );
+      *reg8( z, y, PREFIX_NONE ) = read_byte( z, addr );
+    }
+    else /* LD r,r' */
+    {
+      *reg8( z, y, prefix ) = *reg8( z, r, prefix );
+    }
+    break;
+
+  case 2: /* ALU A,r */
+    if( r == 6 )
+      alu( z, y, read_byte( z, operand_address( z, prefix ) ) );
+    else
+      alu( z, y, *reg8( z, r, prefix ) );
+    break;
+
+  case 3:
+    switch( r )
+    {
+    case 0: /* RET cc */
+      z->tstates += 1;
+      if( condition( z, y ) )
+        z->pc = pop( z );
+      break;
+
+    case 1:
+      if( q == 0 ) /* POP rr */
+      {
+        set_rp( z, p, prefix, 1, pop( z ) );
+      }
+      else
+      {
+        switch( p )
+        {
+        case 0: /* RET */
+          z->pc = pop( z );
+          break;
+        case 1: /* EXX */
+          SWAP8( z->b, z->b_ ); SWAP8( z->c, z->c_ );
+          SWAP8( z->d, z->d_ ); SWAP8( z->e, z->e_ );
+          SWAP8( z->h, z->h_ ); SWAP8( z->l, z->l_ );
+          break;
+        case 2: /* JP (HL) */
+          z->pc = get_hl( z, prefix );
+          break;
+        case 3: /* LD SP,HL */
+          z->tstates += 2;
+          z->sp = get_hl( z, prefix );
+          break;
+        }
+      }
+      break;
+
+    case 2: /* JP cc,nn */
+    {
+      uint16_t addr = read_pc_word( z );
+      if( condition( z, y ) )
+        z->pc = addr;
+      break;
+    }
+
+    case 3:
+      switch( y )
+      {
+      case 0: /* JP nn */
+        z->pc = read_pc_word( z );
+        break;
+      case 1:
+        if( prefix == PREFIX_NONE )
+          execute_cb( z );
+        else
+          execute_index_cb( z, prefix );
+        break;
+      case 2: /* OUT (n),A */
+      {
+        uint8_t n = read_pc_byte( z );
+        port_out( z, (z->a << 8) | n, z->a );
+        break;
+      }
+      case 3: /* IN A,(n) */
+      {
+        uint8_t n = read_pc_byte( z );
+        z->a = port_in( z, (z->a << 8) | n );
+        break;
+      }
+      case 4: /* EX (SP),HL */
+      {
+        uint16_t v = read_word( z, z->sp );
+        uint16_t hl = get_hl( z, prefix );
+        z->tstates += 1;
+        write_byte( z, z->sp+1, hl >> 8 );
+        write_byte( z, z->sp,   hl & 0xFF );
+        z->tstates += 2;
+        set_hl( z, prefix, v );
+        break;
+      }
+      case 5: /* EX DE,HL, which a prefix doesn't change */
+        SWAP8( z->d, z->h );
+        SWAP8( z->e, z->l );
+        break;
+      case 6: /* DI */
+        z->iff1 = z->iff2 = 0;
+        break;
+      case 7: /* EI */
+        z->iff1 = z->iff2 = 1;
+        z->ei_delay = 1;
+        break;
+      }
+      break;
+
+    case 4: /* CALL cc,nn */
+    {
+      uint16_t addr = read_pc_word( z );
+      if( condition( z, y ) )
+      {
+        z->tstates += 1;
+        push( z, z->pc );
+        z->pc = addr;
+      }
+      break;
+    }
+
+    case 5:
+      if( q == 0 ) /* PUSH rr */
+      {
+        z->tstates += 1;
+        push( z, get_rp( z, p, prefix, 1 ) );
+      }
+      else if( p == 0 ) /* CALL nn */
+      {
+        uint16_t addr = read_pc_word( z );
+        z->tstates += 1;
+        push( z, z->pc );
+        z->pc = addr;
+      }
+      else if( p == 2 )
+      {
+        execute_ed( z );
+      }
+      break;
+
+    case 6: /* ALU A,n */
+      alu( z, y, read_pc_byte( z ) );
+      break;
+
+    case 7: /* RST */
+      z->tstates += 1;
+      push( z, z->pc );
+      z->pc = y << 3;
+      break;
+    }
+    break;
+  }
+}
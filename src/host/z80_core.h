@@ -0,0 +1,91 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __Z80_CORE_H
+#define __Z80_CORE_H
+
+#include <stdint.h>
+
+/*
+ * A Z80 and 48K Spectrum memory, just enough of one to count T-states
+ * for the profiler. It's not an emulator, there's no screen or sound,
+ * but the timing is done properly: every instruction is built out of
+ * its M-cycles, and memory and ULA port accesses in the lower 16K of RAM
+ * take the 48K's contention delays at the T-state they happen. Contention
+ * on the internal cycles of instructions (the "snow" patterns) isn't
+ * modelled, so instructions which spin on a contended address with no
+ * memory access come out a few T-states cheap.
+ *
+ * The frame is the 48K's 69888 T-states, starting from the interrupt.
+ */
+#define ZX48_FRAME_TSTATES     69888
+#define ZX48_INT_LENGTH        32
+
+typedef struct _z80_core Z80_CORE;
+
+struct _z80_core
+{
+  uint8_t   a, f, b, c, d, e, h, l;
+  uint8_t   a_, f_, b_, c_, d_, e_, h_, l_;
+  uint8_t   ixh, ixl, iyh, iyl;
+  uint16_t  sp, pc;
+  uint8_t   i, r;
+  uint8_t   iff1, iff2, im;
+  uint8_t   halted;
+  uint8_t   ei_delay;          /* Set by EI, blocks the interrupt for one instruction */
+
+  uint32_t  tstates;           /* T-states since the start of the frame */
+  uint32_t  fetches;           /* M1 cycles since the start of the frame, the RZX fetch counter */
+
+  uint8_t   rom_writable;
+  uint8_t   memory[0x10000];
+
+  /*
+   * Port hooks. The core does the timing; these provide the values.
+   */
+  uint8_t (*port_in)( Z80_CORE* z, uint16_t port );
+  void    (*port_out)( Z80_CORE* z, uint16_t port, uint8_t value );
+  void*     user;
+};
+
+#define Z80_CORE_BC(z)   ((uint16_t)(((z)->b<<8)|(z)->c))
+#define Z80_CORE_DE(z)   ((uint16_t)(((z)->d<<8)|(z)->e))
+#define Z80_CORE_HL(z)   ((uint16_t)(((z)->h<<8)|(z)->l))
+#define Z80_CORE_IX(z)   ((uint16_t)(((z)->ixh<<8)|(z)->ixl))
+#define Z80_CORE_IY(z)   ((uint16_t)(((z)->iyh<<8)|(z)->iyl))
+
+#define Z80_CORE_PEEK16(z,addr) ((uint16_t)((z)->memory[(uint16_t)(addr)] | ((z)->memory[(uint16_t)((addr)+1)]<<8)))
+
+/*
+ * Power on state, with the memory cleared. The caller loads the ROM, if
+ * it has one, and the program.
+ */
+void     z80_core_reset( Z80_CORE* z );
+
+/*
+ * Run one instruction, prefixes and all. A halted CPU runs one NOP.
+ */
+void     z80_core_step( Z80_CORE* z );
+
+/*
+ * Take the maskable interrupt if the CPU will accept it. Returns 1 if it did.
+ */
+int      z80_core_interrupt( Z80_CORE* z );
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "input_log.h"
+#include "tracetable.h"
+#include "int.h"
+
+/*
+ * See input_log.h for what the log is and the format of its records.
+ */
+
+#if INPUT_LOG != INPUT_LOG_OFF
+uint8_t input_log_pass;
+#endif
+
+#if INPUT_LOG == INPUT_LOG_RECORD
+
+/*
+ *  ____                        _
+ * |  _ \ ___  ___ ___  _ __ __| |
+ * | |_) / _ \/ __/ _ \| '__/ _` |
+ * |  _ <  __/ (_| (_) | | | (_| |
+ * |_| \_\___|\___\___/|_|  \__,_|
+ *
+ */
+
+uint8_t* input_log = TRACING_INACTIVE;
+
+/*
+ * Where the next record goes, and the last byte it can start at with
+ * room for itself and the end marker.
+ */
+static uint8_t* input_log_next;
+static uint8_t* input_log_limit;
+
+/* The record being added to, NULL until the first pass, and what it holds */
+static uint8_t* run_record = NULL;
+static uint8_t  run_keys;
+static uint16_t run_frames;
+
+/*
+ * Ticker at the end of the last pass. It's called before the interrupt
+ * is set up so the first pass is timed from the start.
+ */
+static uint16_t last_pass_ticker = 0;
+
+void init_input_log(void)
+{
+  input_log = allocate_tracememory( INPUT_LOG_SIZE );
+  if( input_log != TRACING_INACTIVE ) {
+    input_log_next  = input_log;
+    input_log_limit = input_log + INPUT_LOG_SIZE - INPUT_RECORD_MAX;
+
+    /* Empty log */
+    input_log[0] = 0;
+    input_log[1] = 0;
+  }
+}
+
+/*
+ * Log the pass just made: the keys it saw and the frames since the last
+ * one. Most passes are the same as the one before, a frame and the same
+ * keys, and only add to the count in the current record. When the log
+ * is full the rest of the run isn't recorded.
+ */
+void record_input_pass(void)
+{
+  uint16_t now    = GET_TICKER;
+  uint16_t frames = now - last_pass_ticker;
+  uint8_t  keys   = input_log_pass;
+
+  last_pass_ticker = now;
+
+  if( input_log == TRACING_INACTIVE )
+    return;
+
+  if( run_record != NULL && keys == run_keys && frames == run_frames && run_record[1] != 0xFF ) {
+    run_record[1]++;
+    return;
+  }
+
+  if( input_log_next > input_log_limit )
+    return;
+
+  run_record = input_log_next;
+  run_keys   = keys;
+  run_frames = frames;
+
+  if( frames > 0xFF ) {
+    *input_log_next++ = keys | INPUT_RECORD_FRAMES_WORD;
+    *input_log_next++ = 1;
+    *input_log_next++ = (uint8_t)frames;
+    *input_log_next++ = (uint8_t)(frames >> 8);
+  } else if( frames != 1 ) {
+    *input_log_next++ = keys | INPUT_RECORD_FRAMES_BYTE;
+    *input_log_next++ = 1;
+    *input_log_next++ = (uint8_t)frames;
+  } else {
+    *input_log_next++ = keys;
+    *input_log_next++ = 1;
+  }
+
+  /* End marker, overwritten by the next record */
+  input_log_next[0] = 0;
+  input_log_next[1] = 0;
+}
+
+#elif INPUT_LOG == INPUT_LOG_REPLAY
+
+/*
+ *  ____            _
+ * |  _ \ ___ _ __ | | __ _ _   _
+ * | |_) / _ \ '_ \| |/ _` | | | |
+ * |  _ <  __/ |_) | | (_| | |_| |
+ * |_| \_\___| .__/|_|\__,_|\__, |
+ *           |_|            |___/
+ */
+
+/* The log built into the game, see embed_input_log.pl */
+extern uint8_t input_log_data[];
+
+static const uint8_t* replay_next = input_log_data;
+static uint8_t        replay_passes = 0;    /* Left in the current record */
+static uint16_t       replay_frames = 1;
+
+uint8_t input_log_finished = 0;
+
+/*
+ * Start a pass: take the keys for it from the log, moving on to the next
+ * record when the current one's used up.
+ */
+void replay_start_pass(void)
+{
+  if( replay_passes == 0 ) {
+    uint8_t flags = replay_next[0];
+
+    if( replay_next[1] == 0 ) {
+      /* End of the log. Carry on with no keys, a frame a pass. */
+      input_log_finished = 1;
+      input_log_pass     = 0;
+      replay_frames      = 1;
+      return;
+    }
+
+    input_log_pass = flags & INPUT_KEYS;
+    replay_passes  = replay_next[1];
+    replay_next   += 2;
+
+    if( flags & INPUT_RECORD_FRAMES_WORD ) {
+      replay_frames = replay_next[0] | (replay_next[1] << 8);
+      replay_next  += 2;
+    } else if( flags & INPUT_RECORD_FRAMES_BYTE ) {
+      replay_frames = *replay_next++;
+    } else {
+      replay_frames = 1;
+    }
+  }
+
+  replay_passes--;
+}
+
+/*
+ * End a pass: the game's time moves on by the frames it took in the
+ * recording.
+ */
+void replay_end_pass(void)
+{
+  advance_game_time( replay_frames );
+}
+
+#endif
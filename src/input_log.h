@@ -0,0 +1,132 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __INPUT_LOG_H
+#define __INPUT_LOG_H
+
+#include <stdint.h>
+#include <input.h>
+
+/*
+ * Input recorder and replay. The game only reads three keys, once each
+ * time round the game loop, so a run of the game is the keys seen on
+ * each pass plus how many frames each pass took. That's what the input
+ * log holds, run length encoded.
+ *
+ * A build made with INPUT_LOG=1 records the log into the trace area as
+ * it's played, so it needs writable ROM the same as the tracing does;
+ * wonky_traces -i gets it out of a snapshot. A build made with
+ * INPUT_LOG=2 has a log built in (INPUT_LOG_FILE in the makefile) and
+ * plays that instead of reading the keyboard.
+ *
+ * In a replay build the game's clock isn't the interrupt. The ISR still
+ * counts frames for the sound, but the game ticker, the 1s and 500ms
+ * timers and the collectable deadlines are moved on by the logged number
+ * of frames at the end of each pass, at the point they were measured in
+ * the recording. Everything the game does then depends only on the log,
+ * so two replays of it are the same run exactly, however long the game
+ * loop takes. A pass which overran its frame in the recording saw the
+ * ticker move under it, which a replay can't reproduce, so a replay can
+ * differ from the recording it came from there.
+ *
+ * It's off by default. Changing it needs a make clean.
+ */
+#define INPUT_LOG_OFF         0
+#define INPUT_LOG_RECORD      1
+#define INPUT_LOG_REPLAY      2
+
+#ifndef INPUT_LOG
+#define INPUT_LOG             INPUT_LOG_OFF
+#endif
+
+/* Keys seen on a pass */
+#define INPUT_CONTROL         0x01
+#define INPUT_MUSIC           0x02
+#define INPUT_SOUND           0x04
+#define INPUT_KEYS            0x07
+
+/*
+ * A record in the log is a run of identical passes:
+ *
+ *  byte     keys, plus INPUT_RECORD_FRAMES_BYTE or _WORD
+ *  byte     number of passes, 1-255
+ *  byte(s)  frames each pass took, if it wasn't 1; a byte or a
+ *           little endian word as the flags say
+ *
+ * A record with no passes ends the log.
+ */
+#define INPUT_RECORD_FRAMES_BYTE 0x80
+#define INPUT_RECORD_FRAMES_WORD 0x40
+
+/* Longest record, plus room for the end marker */
+#define INPUT_RECORD_MAX      (4+2)
+
+/* Bytes of trace memory the recorder takes, about 10 minutes of steady play */
+#define INPUT_LOG_SIZE        2048
+
+/* Keys seen on the current pass */
+extern uint8_t input_log_pass;
+
+#if INPUT_LOG == INPUT_LOG_RECORD
+
+/* Start of the log, for the tools; TRACING_INACTIVE if there's no room */
+extern uint8_t* input_log;
+
+void init_input_log(void);
+void record_input_pass(void);
+
+#define RECORD_KEY(scancode,key)     (in_key_pressed( scancode ) ? (input_log_pass |= (key)) : 0)
+
+#define CONTROL_KEY_PRESSED          RECORD_KEY( IN_KEY_SCANCODE_SPACE, INPUT_CONTROL )
+#define MUSIC_KEY_PRESSED            RECORD_KEY( IN_KEY_SCANCODE_m, INPUT_MUSIC )
+#define SOUND_KEY_PRESSED            RECORD_KEY( IN_KEY_SCANCODE_s, INPUT_SOUND )
+#define WAIT_KEY_RELEASED(scancode)  while( in_key_pressed( scancode ) )
+#define INPUT_LOG_START_PASS         input_log_pass = 0
+#define INPUT_LOG_END_PASS           record_input_pass()
+
+#elif INPUT_LOG == INPUT_LOG_REPLAY
+
+/* Set once the log has run out. After that no keys are pressed. */
+extern uint8_t input_log_finished;
+
+#define init_input_log()
+void replay_start_pass(void);
+void replay_end_pass(void);
+
+#define CONTROL_KEY_PRESSED          (input_log_pass & INPUT_CONTROL)
+#define MUSIC_KEY_PRESSED            (input_log_pass & INPUT_MUSIC)
+#define SOUND_KEY_PRESSED            (input_log_pass & INPUT_SOUND)
+#define WAIT_KEY_RELEASED(scancode)
+#define INPUT_LOG_START_PASS         replay_start_pass()
+#define INPUT_LOG_END_PASS           replay_end_pass()
+
+#else
+
+#define init_input_log()
+
+#define CONTROL_KEY_PRESSED          in_key_pressed( IN_KEY_SCANCODE_SPACE )
+#define MUSIC_KEY_PRESSED            in_key_pressed( IN_KEY_SCANCODE_m )
+#define SOUND_KEY_PRESSED            in_key_pressed( IN_KEY_SCANCODE_s )
+#define WAIT_KEY_RELEASED(scancode)  while( in_key_pressed( scancode ) )
+#define INPUT_LOG_START_PASS
+#define INPUT_LOG_END_PASS
+
+#endif
+
+#endif
@@ -24,6 +24,11 @@
 #include <im2.h>
 #include <string.h>
 
+#include "action.h"
+#include "sound.h"
+#include "tracetable.h"
+#include "input_log.h"
+
 /*
  * Timer ticker for the 50Hz interrupt signal which fires
  * via the hardware every 20ms.
@@ -33,13 +38,20 @@
  */
 volatile uint16_t ticker = 0;
 
+#if ANY_TRACING
+/*
+ * Number of times the ticker has wrapped, which makes it a 32 bit frame
+ * count for timing trace entries over long runs. See tracetable.h.
+ */
+volatile uint16_t ticker_high = 0;
+#endif
+
 /*
  * 1000ms ticker. This one increments every 50 interrupts, so it
  * ticks up every second.
  */
 uint8_t           ticker_1000ms_int_counter;  /* This goes 0-49 */
 volatile uint16_t ticker_1000ms = 0;
-volatile uint8_t  interrupt_service_required_1000ms = 0;
 
 /*
  * 500ms ticker. This one increments every 25 interrupts, so it
@@ -47,7 +59,52 @@ volatile uint8_t  interrupt_service_required_1000ms = 0;
  */
 uint8_t           ticker_500ms_int_counter;  /* This goes 0-25 */
 volatile uint16_t ticker_500ms = 0;
-volatile uint8_t  interrupt_service_required_500ms = 0;
+
+/*
+ * Game actions which have an interrupt driven event waiting for them.
+ */
+volatile uint8_t  interrupt_actions_ready = 0;
+
+/*
+ * Deadline of the next collectable timer to expire, if one's armed. The
+ * collectable code keeps these up to date.
+ */
+volatile uint16_t collectable_timer_deadline;
+volatile uint8_t  collectable_timer_armed = 0;
+
+/*
+ * Move a ticker on a frame, counting its wraps if the tracing wants them.
+ */
+#if ANY_TRACING
+#define ADVANCE_TICKER(t) { if( ++(t) == 0 ) ticker_high++; }
+#else
+#define ADVANCE_TICKER(t) (t)++
+#endif
+
+/*
+ * The game's timers, run once a frame of game time with the ticker they
+ * go by. That's the ISR normally, or the input log's replay, which runs
+ * them through advance_game_time().
+ */
+#define GAME_TIMERS(t) \
+{ \
+  if( ++ticker_1000ms_int_counter == 50 ) \
+  { \
+      ticker_1000ms_int_counter = 0; \
+      ticker_1000ms++; \
+      interrupt_actions_ready |= READY_1000MS; \
+  } \
+  if( ++ticker_500ms_int_counter == 25 ) \
+  { \
+      ticker_500ms_int_counter = 0; \
+      ticker_500ms++; \
+      interrupt_actions_ready |= READY_500MS; \
+  } \
+  if( collectable_timer_armed && ((int16_t)((t) - collectable_timer_deadline) >= 0) ) \
+  { \
+      interrupt_actions_ready |= READY_COLLECTABLE_TIMER; \
+  } \
+}
 
 IM2_DEFINE_ISR(isr)
 {
@@ -55,21 +112,39 @@ IM2_DEFINE_ISR(isr)
    * This all happens with the interrupt still disabled so
    * nothing needs atomic protection.
    */
+#if INPUT_LOG == INPUT_LOG_REPLAY
   ticker++;
+#else
+  ADVANCE_TICKER( ticker );
+#endif
 
-  if( ++ticker_1000ms_int_counter == 50 )
-  {
-      ticker_1000ms_int_counter = 0;
-      ticker_1000ms++;
-      interrupt_service_required_1000ms = 1;
-  }
-  if( ++ticker_500ms_int_counter == 25 )
-  {
-      ticker_500ms_int_counter = 0;
-      ticker_500ms++;
-      interrupt_service_required_500ms = 1;
+  /*
+   * Sound. On the beeper that's one fixed length slice, about 2.2ms, of
+   * the current effect or the background music. On the AY it's a few
+   * register writes.
+   */
+  service_sound_interrupt();
+
+#if INPUT_LOG != INPUT_LOG_REPLAY
+  GAME_TIMERS( ticker );
+#endif
+}
+
+#if INPUT_LOG == INPUT_LOG_REPLAY
+/*
+ * Replaying an input log the game has its own ticker, which only moves
+ * when the log says it does. See input_log.h.
+ */
+uint16_t game_ticker = 0;
+
+void advance_game_time( uint16_t frames )
+{
+  while( frames-- ) {
+    ADVANCE_TICKER( game_ticker );
+    GAME_TIMERS( game_ticker );
   }
 }
+#endif
 
 /*
  * Standard SP1 interrupt set up for now.
@@ -85,7 +160,7 @@ void setup_int(void)
 {
   memset( TABLE_ADDR, JUMP_POINT_HIGH_BYTE, 257 );
   z80_bpoke( JUMP_POINT,   195 );
-  z80_wpoke( JUMP_POINT+1, (unsigned int)isr );
+  z80_wpoke( JUMP_POINT+1, (unsigned int)(uintptr_t)isr );
   im2_init( TABLE_ADDR );
   intrinsic_ei();
 }
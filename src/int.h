@@ -23,9 +23,24 @@
 #include <stdint.h>
 #include <intrinsic.h>
 
+#include "input_log.h"
+
 extern uint16_t ticker;
-extern uint8_t  interrupt_service_required_1000ms;
-extern uint8_t  interrupt_service_required_500ms;
+extern uint16_t ticker_high;
+
+/*
+ * READY_ bits from action.h which the ISR sets. The game loop takes and
+ * clears these once per cycle, with interrupts disabled so the ISR can't
+ * set one in between.
+ */
+extern uint8_t  interrupt_actions_ready;
+
+/*
+ * The ISR sets READY_COLLECTABLE_TIMER when the ticker reaches this, if
+ * it's armed. See collectable.c.
+ */
+extern uint16_t collectable_timer_deadline;
+extern uint8_t  collectable_timer_armed;
 
 void setup_int(void);
 
@@ -35,7 +50,23 @@ void setup_int(void);
  *
  * It's 16 bits so will compile to separate load instructions
  * on the Z80, hence it needs the atomic wrapper.
+ *
+ * When an input log is being replayed this is the game's own ticker,
+ * which only the game loop moves on, and GET_FRAME_TICKER is the
+ * interrupt's. Things which time the real frames, like the profiling,
+ * use that.
  */
-#define GET_TICKER ((uint16_t)intrinsic_load16(_ticker))
+#define GET_FRAME_TICKER ((uint16_t)intrinsic_load16(_ticker))
+
+#if INPUT_LOG == INPUT_LOG_REPLAY
+extern uint16_t game_ticker;
+
+/* Run the game's timers on by this many frames */
+void advance_game_time( uint16_t frames );
+
+#define GET_TICKER game_ticker
+#else
+#define GET_TICKER GET_FRAME_TICKER
+#endif
 
 #endif
@@ -0,0 +1,70 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __JUMP_TABLES_H
+#define __JUMP_TABLES_H
+
+#include <stdint.h>
+
+/*
+ * Jump tables. Most of a jump off a jumper block is through open air,
+ * but the collision probes are run on every pass of it all the same.
+ * The levels don't change, so wonky_jumps works out when they're built
+ * how far into the jump the runner gets from each place he can take off
+ * before a probe could find anything, with every door shut and keeping
+ * clear of the teleporters. A build made with JUMP_TABLES=1 has those
+ * built in (jump_tables.asm, made by the host build) and doesn't probe
+ * until the jump gets that far. Turning mid-jump puts the rest of the
+ * arc somewhere else, so that goes back to probing every pass.
+ *
+ * It's off by default. Changing it needs a make clean.
+ */
+#ifndef JUMP_TABLES
+#define JUMP_TABLES           0
+#endif
+
+/*
+ * An entry covers a run of take off points on one row of jumpers. The
+ * jump offset probing starts at is the first one any of them needs, by
+ * which way he's facing. A level number of JUMP_TABLE_END ends the list.
+ */
+typedef struct _jump_table_entry
+{
+  uint8_t  level_num;
+  uint8_t  ypos;
+  uint8_t  first_xpos;
+  uint8_t  last_xpos;
+  uint8_t  safe_offset[2];     /* Indexed by DIRECTION */
+} JUMP_TABLE_ENTRY;
+
+#define JUMP_TABLE_END        0xFF
+
+#if JUMP_TABLES
+extern const JUMP_TABLE_ENTRY jump_tables[];
+
+/*
+ * Look the runner's take off point up, as he starts a jump, and set the
+ * jump offset probing starts at.
+ */
+void look_up_jump_safe( uint8_t level_num );
+#else
+#define look_up_jump_safe(level_num)
+#endif
+
+#endif
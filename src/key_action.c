@@ -19,7 +19,6 @@
 
 #include <arch/zx.h>
 #include <input.h>
-#include <sound.h>
 #include <string.h>
 #include "utils.h"
 #include "action.h"
@@ -31,6 +30,7 @@
 #include "int.h"
 #include "sound.h"
 #include "levels.h"
+#include "tile_map.h"
 
 /***
  *      _______             _             
@@ -60,12 +60,13 @@ typedef enum _key_action_tracetype
   TEST_FINISH,
   CONSUMED_SLOWDOWN,
   OPENED_DOOR,
-  SLOWDOWN_EXPIRED,
+  COLLECTABLE_TIMER_EXPIRED,
 } KEY_ACTION_TRACETYPE;
 
 typedef struct _key_action_trace
 {
   uint16_t               ticker;
+  uint8_t                frame_seq;
   KEY_ACTION_TRACETYPE   tracetype;
 
   /* BE:LITERAL:START
@@ -77,6 +78,7 @@ typedef struct _key_action_trace
     n16 dec valid "tracetype==TEST_FALL_RIGHT_NO_TOE_SUPPORT"  "mod(8) xpos"
     n16 dec valid "tracetype==TEST_FALL_LEFT_HEEL_SUPPORT"  "mod(8) xpos"
     n16 dec valid "tracetype==ENTER_TELEPORTER"  "toggle direction"
+    n16 dec valid "tracetype==COLLECTABLE_TIMER_EXPIRED"  "collectable type"
   }    
   BE:LITERAL:END */
 
@@ -87,22 +89,24 @@ typedef struct _key_action_trace
 #define KEY_ACTION_TRACE_ENTRIES   100
 #define KEY_ACTION_TRACETABLE_SIZE ((size_t)sizeof(KEY_ACTION_TRACE)*KEY_ACTION_TRACE_ENTRIES)
 
-TRACE_FN( key_action, KEY_ACTION_TRACE, KEY_ACTION_TRACETABLE_SIZE )
+#if KEY_ACTION_TRACING
+
+TRACE_TABLE( key_action, KEY_ACTION_TRACE )
 
 /*
  * Filling in a blank trace entry is normally done with a macro,
  * but since this one is called several times a function is more
  * economical.
  */
-void KEY_ACTION_TRACE_CREATE( KEY_ACTION_TRACETYPE ttype, uint16_t d )
+static void KEY_ACTION_TRACE_CREATE( KEY_ACTION_TRACETYPE ttype, uint16_t d )
 {
   if( key_action_tracetable != TRACING_INACTIVE ) {
-    KEY_ACTION_TRACE  ka;                 
-    ka.ticker       = GET_TICKER;                       
-    ka.tracetype    = ttype;
-    ka.data         = d;
-    key_action_add_trace(&ka);                  
-  }                                             
+    KEY_ACTION_TRACE* ka = TRACE_ENTRY(key_action);
+    TRACE_STAMP(key_action, ka);
+    ka->tracetype    = ttype;
+    ka->data         = d;
+    TRACE_ADVANCE(key_action, KEY_ACTION_TRACETABLE_SIZE);
+  }
 }
 
 void init_key_action_trace(void)
@@ -110,11 +114,25 @@ void init_key_action_trace(void)
   key_action_tracetable = key_action_next_trace = allocate_tracememory(KEY_ACTION_TRACETABLE_SIZE);
 }
 
+#else
+
+#define KEY_ACTION_TRACE_CREATE(ttype,d)
+
+#endif
+
 /*
  * See comment in test_for_teleporter() to see what this is for
  */
 uint8_t just_teleported = 0;
 
+/*
+ * The runner is on a teleporter's trigger point if he's exactly at the top
+ * left of a teleporter cell. The neighbourhood's centre cell is the one his
+ * top left pixel is in, and its tile says which teleporter and which end.
+ */
+#define ON_TELEPORTER_TRIGGER(n)  ( !((n).x_mod8 | (n).y_mod8) && \
+                                    TILE_IS_TELEPORTER( GET_NEIGHBOUR_TILE( (n), 0, 0 ) ) )
+
 
 /***
  *      _____  _               _   _                _____ _                            
@@ -135,10 +153,6 @@ uint8_t just_teleported = 0;
 PROCESSING_FLAG test_for_direction_change( void* data, GAME_ACTION* output_action )
 {
   GAME_STATE* game_state = (GAME_STATE*)data;
-  uint8_t*    attr_address = NULL;
-
-  uint8_t     xpos = GET_RUNNER_XPOS;
-  uint8_t     ypos = GET_RUNNER_YPOS;
 
   /* If the user pressed the button, turn him */
   if( game_state->key_pressed && ! game_state->key_processed ) {
@@ -153,23 +167,13 @@ PROCESSING_FLAG test_for_direction_change( void* data, GAME_ACTION* output_actio
      * the flags so next time round the cycle when he's moved off the
      * teleporter it's safe to change direction.
      */
-    LEVEL_DATA* level_data            = game_state->current_level;
-    TELEPORTER_DEFINITION* teleporter = level_data->teleporters;
-
-    if( teleporter )
+    if( ON_TELEPORTER_TRIGGER( game_state->neighbourhood ) )
     {
-      while( (teleporter->end_1_x || teleporter->end_1_y) ) {
+      /* Trace the tile, which says which teleporter and which end */
+      KEY_ACTION_TRACE_CREATE( SKIP_DIR_CHG_TELEPORTER, GET_NEIGHBOUR_TILE( game_state->neighbourhood, 0, 0 ) );
 
-        if( (xpos == teleporter->end_1_x && ypos == teleporter->end_1_y) ||
-            (xpos == teleporter->end_2_x && ypos == teleporter->end_2_y) )
-        {
-          KEY_ACTION_TRACE_CREATE( SKIP_DIR_CHG_TELEPORTER, (uint16_t)teleporter );
-
-          *output_action = NO_ACTION;
-          return KEEP_PROCESSING;
-        }
-        teleporter++;
-      }
+      *output_action = NO_ACTION;
+      return KEEP_PROCESSING;
     }
 
     game_state->key_processed = 1;
@@ -205,13 +209,8 @@ PROCESSING_FLAG test_for_direction_change( void* data, GAME_ACTION* output_actio
  */
 PROCESSING_FLAG test_for_start_jump( void* data, GAME_ACTION* output_action )
 {
-  GAME_STATE* game_state = (GAME_STATE*)data;
-  uint8_t*    attr_address;
-  uint8_t     on_jump_block = 0;
-  uint8_t     jumper_attribute;
-
-  uint8_t     xpos = GET_RUNNER_XPOS;
-  uint8_t     ypos = GET_RUNNER_YPOS;
+  GAME_STATE*           game_state    = (GAME_STATE*)data;
+  RUNNER_NEIGHBOURHOOD* neighbourhood = &(game_state->neighbourhood);
 
   /*
    * Are we already jumping? If so, no action. Don't process any keypress so
@@ -231,29 +230,24 @@ PROCESSING_FLAG test_for_start_jump( void* data, GAME_ACTION* output_action )
     return KEEP_PROCESSING;
   }
 
-  /* Find the attribute colour of a jumper block in this level */
-  jumper_attribute = game_state->current_level->jumper_att;
-
   /* Is the cell directly below him a trampoline block? */
-  attr_address = zx_pxy2aaddr( xpos, ypos+8  );
-  if( *attr_address != jumper_attribute ) {
+  if( GET_NEIGHBOUR_TILE( *neighbourhood, 0, 1 ) != TILE_JUMPER ) {
 
     /* No, so check the block below and to the right, which the sprite might have rotated into */
-    if( MODULO8( xpos ) < 3 ) {
+    if( neighbourhood->x_mod8 < 3 ) {
       /* Sprite hasn't rotated far enough to stray onto next block */
       *output_action = NO_ACTION;
       return KEEP_PROCESSING;
     }
 
-    attr_address = zx_pxy2aaddr( xpos+8, ypos+8  );
-    if( *attr_address != jumper_attribute ) {
+    if( GET_NEIGHBOUR_TILE( *neighbourhood, 1, 1 ) != TILE_JUMPER ) {
       /* Block the sprite is rotated onto isn't a jump block either. */
       *output_action = NO_ACTION;
       return KEEP_PROCESSING;
     }
 
     /* His heel or toe is on top of a jump block so drop through */
-    KEY_ACTION_TRACE_CREATE( TEST_JUMP_PARTIAL_ON_BLOCK, MODULO8( xpos ) );
+    KEY_ACTION_TRACE_CREATE( TEST_JUMP_PARTIAL_ON_BLOCK, neighbourhood->x_mod8 );
   }
   else {
     /* He's directly on top of a jump block, so drop through */
@@ -282,7 +276,7 @@ PROCESSING_FLAG test_for_start_jump( void* data, GAME_ACTION* output_action )
  * Runner falls if:
  *
  *  he's not in the middle of a jump; and
- *  the attribute cell underneath him is clear; and
+ *  the cell underneath him is clear; and
  *  he's aligned on top of that cell
  *
  * If he's facing left he must move the 2 pixels of alignment on the
@@ -297,12 +291,7 @@ PROCESSING_FLAG test_for_start_jump( void* data, GAME_ACTION* output_action )
  */
 PROCESSING_FLAG test_for_falling( void* data, GAME_ACTION* output_action )
 {
-  GAME_STATE* game_state = (GAME_STATE*)data;
-  uint8_t*    attr_address = NULL;
-  uint8_t     background_attribute;
-
-  uint8_t     xpos = GET_RUNNER_XPOS;
-  uint8_t     ypos = GET_RUNNER_YPOS;
+  RUNNER_NEIGHBOURHOOD* neighbourhood = &(((GAME_STATE*)data)->neighbourhood);
 
   /* Are we in the middle of a jump? If so, no action */
   if( RUNNER_JUMPING( GET_RUNNER_JUMP_OFFSET ) ) {
@@ -310,17 +299,8 @@ PROCESSING_FLAG test_for_falling( void* data, GAME_ACTION* output_action )
     return KEEP_PROCESSING;
   }
 
-  /* Find the attribute colour of a background block in this level */
-  background_attribute = game_state->current_level->background_att;
-
-  /*
-   * I can probably optimise this for space but pulling out
-   * the repeated zx_pxy2aaddr() calls.
-   */
-
   /* Is the cell below him solid? If so, he's supported */
-  attr_address = zx_pxy2aaddr( xpos, ypos+8 );
-  if( *attr_address != background_attribute ) {
+  if( TILE_IS_SUPPORTING( GET_NEIGHBOUR_TILE( *neighbourhood, 0, 1 ) ) ) {
     *output_action = NO_ACTION;
     return KEEP_PROCESSING;
   }
@@ -331,9 +311,9 @@ PROCESSING_FLAG test_for_falling( void* data, GAME_ACTION* output_action )
      * If he's facing right and hasn't rotated onto the cell to his right (in front of him)
      * then he's only supported by the cell directly underneath him which we know isn't solid.
      */
-    if( MODULO8(xpos) < 3 ) {
+    if( neighbourhood->x_mod8 < 3 ) {
       *output_action = MOVE_DOWN;
-      KEY_ACTION_TRACE_CREATE( TEST_FALL_RIGHT_UNROTATED, MODULO8(xpos) );
+      KEY_ACTION_TRACE_CREATE( TEST_FALL_RIGHT_UNROTATED, neighbourhood->x_mod8 );
       return STOP_PROCESSING;
     }
 
@@ -341,8 +321,7 @@ PROCESSING_FLAG test_for_falling( void* data, GAME_ACTION* output_action )
      * He's rotated onto the cell in front of him, to the right. If that cell is solid
      * then his toes are supported
      */
-    attr_address = zx_pxy2aaddr( xpos+8, ypos+8 );
-    if( *attr_address != background_attribute ) {
+    if( TILE_IS_SUPPORTING( GET_NEIGHBOUR_TILE( *neighbourhood, 1, 1 ) ) ) {
       *output_action = NO_ACTION;
       return KEEP_PROCESSING;
     }
@@ -358,13 +337,11 @@ PROCESSING_FLAG test_for_falling( void* data, GAME_ACTION* output_action )
      * If he's over on the right side of his cell, check if his heels are supported.
      * If not he should fall.
      */
-    if( MODULO8( xpos ) >= 3 ) {
-
-      attr_address = zx_pxy2aaddr( xpos+8, ypos+8  );
+    if( neighbourhood->x_mod8 >= 3 ) {
 
-      KEY_ACTION_TRACE_CREATE( TEST_FALL_LEFT_HEEL_SUPPORT, MODULO8( xpos ) );
+      KEY_ACTION_TRACE_CREATE( TEST_FALL_LEFT_HEEL_SUPPORT, neighbourhood->x_mod8 );
 
-      if( *attr_address != background_attribute ) {
+      if( TILE_IS_SUPPORTING( GET_NEIGHBOUR_TILE( *neighbourhood, 1, 1 ) ) ) {
         *output_action = NO_ACTION;
         return KEEP_PROCESSING;
       }
@@ -388,11 +365,8 @@ PROCESSING_FLAG test_for_falling( void* data, GAME_ACTION* output_action )
  */
 PROCESSING_FLAG test_for_finish( void* data, GAME_ACTION* output_action )
 {
-  GAME_STATE* game_state = (GAME_STATE*)data;
-  uint8_t*    attr_address;
-
-  uint8_t     xpos = GET_RUNNER_XPOS;
-  uint8_t     ypos = GET_RUNNER_YPOS;
+  RUNNER_NEIGHBOURHOOD* neighbourhood = &(((GAME_STATE*)data)->neighbourhood);
+  TILE_TYPE             facing_tile;
 
 #define CHEAT_MODE 0
 #if CHEAT_MODE
@@ -414,15 +388,15 @@ PROCESSING_FLAG test_for_finish( void* data, GAME_ACTION* output_action )
   }
 
   /* If he's not on a character cell boundary he can't be up against a wall */
-  if( MODULO8( xpos ) == 0 ) {
+  if( neighbourhood->x_mod8 == 0 ) {
 
-    /* Pick up the attributes of the char cell he's facing and about to move into */
+    /* Pick up the tile in the char cell he's facing and about to move into */
     if( GET_RUNNER_FACING == RIGHT )
-      attr_address = zx_pxy2aaddr( xpos+8, ypos );
+      facing_tile = GET_NEIGHBOUR_TILE( *neighbourhood, 1, 0 );
     else
-      attr_address = zx_pxy2aaddr( xpos-8, ypos );
+      facing_tile = GET_NEIGHBOUR_TILE( *neighbourhood, -1, 0 );
   
-    if( *attr_address == FINISH_ATT ) {
+    if( facing_tile == TILE_FINISH ) {
       *output_action = FINISH;
       return STOP_PROCESSING;
     }
@@ -449,14 +423,8 @@ PROCESSING_FLAG test_for_finish( void* data, GAME_ACTION* output_action )
 PROCESSING_FLAG test_for_teleporter( void* data, GAME_ACTION* output_action )
 {
   GAME_STATE* game_state = (GAME_STATE*)data;
-  LEVEL_DATA* level_data = game_state->current_level;
   PROCESSING_FLAG return_value = KEEP_PROCESSING;
 
-  uint8_t     xpos = GET_RUNNER_XPOS;
-  uint8_t     ypos = GET_RUNNER_YPOS;
-
-  TELEPORTER_DEFINITION* teleporter = level_data->teleporters;
-
   *output_action = NO_ACTION;
 
   /*
@@ -477,55 +445,80 @@ PROCESSING_FLAG test_for_teleporter( void* data, GAME_ACTION* output_action )
     KEY_ACTION_TRACE_CREATE( JUST_TELEPORTED, (*output_action == TOGGLE_DIRECTION) );
     just_teleported--;
   }
-  else
+  else if( ON_TELEPORTER_TRIGGER( game_state->neighbourhood ) )
   {
+    /*
+     * The tile map says which teleporter this is and which end he's at.
+     * Most of the time he's not on one and that test is all there is.
+     */
+    uint8_t                tile       = GET_NEIGHBOUR_TILE( game_state->neighbourhood, 0, 0 );
+    TELEPORTER_DEFINITION* teleporter = &(game_state->current_level->teleporters[TELEPORTER_TILE_INDEX(tile)]);
 
-    while( teleporter && (teleporter->end_1_x || teleporter->end_1_y) ) {
+    if( TELEPORTER_TILE_END(tile) == 0 ) {
 
-      if( xpos == teleporter->end_1_x && ypos == teleporter->end_1_y ) {
+      SET_RUNNER_XPOS( teleporter->end_2_x );
+      SET_RUNNER_YPOS( teleporter->end_2_y );
+      just_teleported = 2;
 
-        SET_RUNNER_XPOS( teleporter->end_2_x );
-        SET_RUNNER_YPOS( teleporter->end_2_y );
-        just_teleported = 2;
+    } else {
 
-        if( teleporter->change_direction ) {
-          *output_action = TOGGLE_DIRECTION;
-        }
+      SET_RUNNER_XPOS( teleporter->end_1_x );
+      SET_RUNNER_YPOS( teleporter->end_1_y );
+      just_teleported = 1;
 
-        /* Play effect immediately otherwise he starts to emerge from the teleporter */
-        play_beepfx_sound_immediate(BEEPFX_SELECT_3);
+    }
 
-        KEY_ACTION_TRACE_CREATE( ENTER_TELEPORTER, (*output_action == TOGGLE_DIRECTION) );
+    if( teleporter->change_direction ) {
+      *output_action = TOGGLE_DIRECTION;
+    }
 
-        return_value = STOP_PROCESSING;
+    /* The effect plays over the next few frames while he emerges */
+    start_sound_effect(EFFECT_TELEPORT);
 
-        break;
+    KEY_ACTION_TRACE_CREATE( ENTER_TELEPORTER, (*output_action == TOGGLE_DIRECTION) );
 
-      } else if( xpos == teleporter->end_2_x && ypos == teleporter->end_2_y ) {
+    return_value = STOP_PROCESSING;
+  }
+  return return_value;
+}
 
-        SET_RUNNER_XPOS( teleporter->end_1_x );
-        SET_RUNNER_YPOS( teleporter->end_1_y );
-        just_teleported = 1;
 
-        if( teleporter->change_direction ) {
-          *output_action = TOGGLE_DIRECTION;
-        }
 
-        /* Play effect immediately otherwise he starts to emerge from the teleporter */
-        play_beepfx_sound_immediate(BEEPFX_SELECT_3);
 
-        KEY_ACTION_TRACE_CREATE( ENTER_TELEPORTER, (*output_action == TOGGLE_DIRECTION) );
+/***
+ *      _______ _                          _   ___
+ *     |__   __(_)                        | | |__ \
+ *        | |   _ _ __ ___   ___  ___  _   _| |_   ) |
+ *        | |  | | '_ ` _ \ / _ \/ _ \| | | | __| / /
+ *        | |  | | | | | | |  __/ (_) | |_| | |_ |_|
+ *        |_|  |_|_| |_| |_|\___|\___/ \__,_|\__|(_)
+ *
+ *
+ */
+PROCESSING_FLAG service_collectable_timers( void* data, GAME_ACTION* output_action )
+{
+  COLLECTABLE* collectable;
 
-        return_value = STOP_PROCESSING;
+  (void)data;
 
-        break;
+  *output_action = NO_ACTION;
 
-      }
+  /*
+   * The ISR has seen the ticker reach the earliest deadline. Run the
+   * timeout function of every timer which has expired. For pills the
+   * return value is taken to indicate whether the slowdown mode should
+   * be deactivated. Collectables are the first member of their owners.
+   */
+  while( (collectable = next_expired_collectable_timer()) )
+  {
+    KEY_ACTION_TRACE_CREATE( COLLECTABLE_TIMER_EXPIRED, collectable->type );
 
-      teleporter++;
-    }
+    if( (*(collectable->timer_fn))( collectable, (void*)collectable ) &&
+        (collectable->type == SLOWDOWN_PILL) )
+      *output_action = DEACTIVATE_SLOWDOWN;
   }
-  return return_value;
+
+  return KEEP_PROCESSING;
 }
 
 
@@ -543,70 +536,34 @@ PROCESSING_FLAG test_for_teleporter( void* data, GAME_ACTION* output_action )
  */
 PROCESSING_FLAG test_for_slowdown_pill( void* data, GAME_ACTION* output_action )
 {
-  GAME_STATE* game_state = (GAME_STATE*)data;
+  (void)data;
 
   *output_action = NO_ACTION;
 
-  /* Skip everything if this level doesn't have slowdown pills */
-  if( game_state->current_level->slowdowns )
+  /*
+   * If slowdowns are active and he's walked onto an available pill, call
+   * the handler. The trigger index only holds available collectables.
+   */
+  if( !SLOWDOWNS_DISABLED )
   {
-    SLOWDOWN* slowdown = game_state->current_level->slowdowns;
-
-    uint8_t xpos = GET_RUNNER_XPOS;
-    uint8_t ypos = GET_RUNNER_YPOS;
+    COLLECTABLE* collectable = find_collectable_trigger( RUNNER_CENTRE_X(GET_RUNNER_XPOS),
+                                                         RUNNER_CENTRE_Y(GET_RUNNER_YPOS) );
 
-    /* Loop over slowdown pills */
-    while( IS_VALID_SLOWDOWN(slowdown) )
+    if( collectable && (collectable->type == SLOWDOWN_PILL) )
     {
-      /*
-       * If the pill has been consumed and is active, reduce the timer. If that's got
-       * to zero, reinstate the pill.
-       *
-       * This needs to happen even if the last pill has been consumed because the timeout
-       * for the active one still needs to work.
-       */
-      if( !IS_COLLECTABLE_AVAILABLE( slowdown->collectable ) )
-      {
-        DECREMENT_COLLECTABLE_TIMER( slowdown->collectable );
+      /* The collectable is the first member of the slowdown */
+      SLOWDOWN* slowdown = (SLOWDOWN*)collectable;
 
-        if( COLLECTABLE_TIMER_EXPIRED( slowdown->collectable ) )
-        {
-          KEY_ACTION_TRACE_CREATE( SLOWDOWN_EXPIRED, 0 );
-
-          /*
-           * The return value of the timeout function is taken to indicate
-           * whether the slowdown mode should be deactivated.
-           */
-          if( (*(slowdown->collectable.timer_fn))( &(slowdown->collectable), (void*)slowdown ) )
-            *output_action = DEACTIVATE_SLOWDOWN;
-          else
-            *output_action = NO_ACTION;
-        }
+      KEY_ACTION_TRACE_CREATE( CONSUMED_SLOWDOWN, 0 );
 
-      }
-      else if( !SLOWDOWNS_DISABLED )
-      {
-        /*
-         * Pill is available and slowdowns are active. If he's walked onto it call the hander.
-         */
-        if( IS_COLLECTION_POINT( RUNNER_CENTRE_X(xpos),
-                                 RUNNER_CENTRE_Y(ypos), slowdown->collectable ) )
-        {
-          KEY_ACTION_TRACE_CREATE( CONSUMED_SLOWDOWN, 0 );
-
-          /*
-           * The handler currently returns void. This could be changed to
-           * return a flag to activate (or not) the slowdown. This is not
-           * currently required.
-           */
-          (*(slowdown->collectable.collection_fn))( &(slowdown->collectable), (void*)slowdown );
-
-          *output_action = ACTIVATE_SLOWDOWN;
-          break;
-        }
-      }
+      /*
+       * The handler currently returns void. This could be changed to
+       * return a flag to activate (or not) the slowdown. This is not
+       * currently required.
+       */
+      (*(slowdown->collectable.collection_fn))( &(slowdown->collectable), (void*)slowdown );
 
-      slowdown++;
+      *output_action = ACTIVATE_SLOWDOWN;
     }
   }
 
@@ -628,68 +585,33 @@ PROCESSING_FLAG test_for_slowdown_pill( void* data, GAME_ACTION* output_action )
  */
 PROCESSING_FLAG test_for_door_key( void* data, GAME_ACTION* output_action )
 {
-  GAME_STATE* game_state = (GAME_STATE*)data;
-
-  *output_action = NO_ACTION;
-
-  /* Skip everything if this level doesn't have doors */
-  if( game_state->current_level->doors )
-  {
-    DOOR* door = game_state->current_level->doors;
+  COLLECTABLE* collectable;
 
-    uint8_t xpos = GET_RUNNER_XPOS;
-    uint8_t ypos = GET_RUNNER_YPOS;
+  (void)data;
 
-    /* Loop over doors */
-    while( IS_VALID_DOOR(door) )
-    {
-      /*
-       * If the door has been opened and is active, reduce the
-       * timer. If that's got to zero, reinstate the key.
-       */
-      if( !IS_COLLECTABLE_AVAILABLE( door->collectable ) )
-      {
-        DECREMENT_COLLECTABLE_TIMER( door->collectable );
+  *output_action = NO_ACTION;
 
-        if( COLLECTABLE_TIMER_EXPIRED( door->collectable ) )
-        {
-          KEY_ACTION_TRACE_CREATE( SLOWDOWN_EXPIRED, 0 );
-
-          /*
-           * The return value of the timeout function is taken to indicate
-           * whether the slowdown mode should be deactivated.
-           */
-          if( (*(door->collectable.timer_fn))( &door->collectable, (void*)door ) )
-            *output_action = CLOSE_DOOR;
-          else
-            *output_action = NO_ACTION;
-        }
+  /*
+   * If he's walked onto an available key call the handler.
+   */
+  collectable = find_collectable_trigger( RUNNER_CENTRE_X(GET_RUNNER_XPOS),
+                                          RUNNER_CENTRE_Y(GET_RUNNER_YPOS) );
 
-      }
-      else
-      {
-        /*
-         * Key is available. If he's walked onto it call the hander.
-         */
-        if( IS_COLLECTION_POINT( RUNNER_CENTRE_X(xpos),
-                                 RUNNER_CENTRE_Y(ypos), door->collectable ) )
-        {
-          KEY_ACTION_TRACE_CREATE( OPENED_DOOR, 0 );
+  if( collectable && (collectable->type == DOOR_KEY) )
+  {
+    /* The collectable is the first member of the door */
+    DOOR* door = (DOOR*)collectable;
 
-          /*
-           * The handler currently returns void. This could be changed to
-           * return a flag to activate (or not) the door. This is not
-           * currently required.
-           */
-          (*(door->collectable.collection_fn))( &(door->collectable), (void*)door );
+    KEY_ACTION_TRACE_CREATE( OPENED_DOOR, 0 );
 
-          *output_action = OPEN_DOOR;
-          break;
-        }
-      }
+    /*
+     * The handler currently returns void. This could be changed to
+     * return a flag to activate (or not) the door. This is not
+     * currently required.
+     */
+    (*(door->collectable.collection_fn))( &(door->collectable), (void*)door );
 
-      door++;
-    }
+    *output_action = OPEN_DOOR;
   }
 
   return KEEP_PROCESSING;
@@ -712,6 +634,13 @@ PROCESSING_FLAG animate_doors( void* data, GAME_ACTION* output_action )
 {
   GAME_STATE* game_state = (GAME_STATE*)data;
 
+  /*
+   * This is only called when a key collection or door timeout has set a
+   * door moving. Once every door is either still or wedged open there's
+   * nothing more for it to do until the next one, so it drops its ready bit.
+   */
+  uint8_t     doors_busy = 0;
+
   if( game_state->current_level->doors )
   {
     DOOR* door = game_state->current_level->doors;
@@ -720,6 +649,8 @@ PROCESSING_FLAG animate_doors( void* data, GAME_ACTION* output_action )
     {
       if( DOOR_IS_MOVING( door ) )
       {
+        doors_busy = 1;
+
         /*
          * This function is called 50 times a second, but I don't want to
          * animate the doors that fast. They just whizz away too quickly.
@@ -740,16 +671,17 @@ PROCESSING_FLAG animate_doors( void* data, GAME_ACTION* output_action )
       {
         /*
          * The door isn't moving, so check to see if it's open and he's reached it.
-         * When a door opens its sprite moves aside. Once it's fully open the attribute
-         * of the single cell the door occupies is set to the background which means
-         * the collision code won't see the door and the runner will be able the
+         * When a door opens its sprite moves aside. Once it's fully open the tile
+         * map entry of the single cell the door occupies is set to background which
+         * means the collision code won't see the door and the runner will be able the
          * move through the doorway. Once that happens the door is set to stay
          * permanently open.
          * Check to see if he's reached this door. The function does what's necessary
          * to wedge the door open if he's reached it.
          */
-        if( DOOR_IS_OPEN(door) )
+        if( DOOR_IS_OPEN(door) && !COLLECTABLE_TIMER_EXPIRED(door->collectable) )
         {
+          doors_busy = 1;
           check_door_passed_through( door );
         }
       }
@@ -758,6 +690,9 @@ PROCESSING_FLAG animate_doors( void* data, GAME_ACTION* output_action )
     }
   }
 
+  if( !doors_busy )
+    CLEAR_GAME_ACTION_READY( READY_DOORS );
+
   *output_action = NO_ACTION;
   return KEEP_PROCESSING;
 }
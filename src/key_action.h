@@ -21,11 +21,22 @@
 #define __KEY_ACTION_H
 
 #include "action.h"
+#include "tracetable.h"
 
 /*
  * Initialise trace table for key actions
  */
+#if KEY_ACTION_TRACING
 void init_key_action_trace(void);
+#else
+#define init_key_action_trace()
+#endif
+
+/*
+ * Passes left before the runner can be teleported again, see
+ * test_for_teleporter(). The route solver keeps it as part of the state.
+ */
+extern uint8_t just_teleported;
 
 /*
  * Information on these game action functions is in the C code file.
@@ -36,6 +47,7 @@ PROCESSING_FLAG test_for_start_jump( void* data, GAME_ACTION* output_action );
 PROCESSING_FLAG test_for_falling( void* data, GAME_ACTION* output_action );
 PROCESSING_FLAG test_for_finish( void* data, GAME_ACTION* output_action );
 PROCESSING_FLAG test_for_teleporter( void* data, GAME_ACTION* output_action );
+PROCESSING_FLAG service_collectable_timers( void* data, GAME_ACTION* output_action );
 PROCESSING_FLAG test_for_slowdown_pill( void* data, GAME_ACTION* output_action );
 PROCESSING_FLAG test_for_door_key( void* data, GAME_ACTION* output_action );
 PROCESSING_FLAG test_for_through_door( void* data, GAME_ACTION* output_action );
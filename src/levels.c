@@ -20,6 +20,7 @@
 #include <arch/zx.h>
 #include <arch/zx/sp1.h>
 #include <string.h>
+#include <stddef.h>
 #include <malloc.h>
 
 #include "utils.h"
@@ -28,6 +29,7 @@
 #include "door.h"
 #include "levels.h"
 #include "graphics.h"
+#include "tile_map.h"
 
 /*
  * These are the UDGs, defined in assembler because
@@ -52,15 +54,15 @@ extern uint8_t score_slider_right[8];
 extern uint8_t score_slider_centre[8];
 
 /*
- * Maps, also in assembler because the strings require
- * '\0' bytes.
+ * Level blobs, built by compile_level.pl from the .lvl files
+ * and assembled in levels_blobs.asm.
  */
-extern uint8_t level_intro_map[];
-extern uint8_t level0_map[];
-extern uint8_t level1_map[];
-extern uint8_t level2_map[];
-extern uint8_t level3_map[];
-extern uint8_t level4_map[];
+extern uint8_t level_intro_blob[];
+extern uint8_t level0_blob[];
+extern uint8_t level1_blob[];
+extern uint8_t level2_blob[];
+extern uint8_t level3_blob[];
+extern uint8_t level4_blob[];
 
 
 /***
@@ -87,7 +89,7 @@ TILE_DEFINITION level0_tiles[] = {
   {140, score_slider_left},
   {141, score_slider_right},
   {142, score_slider_centre},
-  {0,   {0}   }
+  {0,   0     }
 };
 
 TILE_DEFINITION level1_tiles[] = {
@@ -99,7 +101,7 @@ TILE_DEFINITION level1_tiles[] = {
   {140, score_slider_left},
   {141, score_slider_right},
   {142, score_slider_centre},
-  {0,   {0}   }
+  {0,   0     }
 };
 
 TILE_DEFINITION level2_tiles[] = {
@@ -113,7 +115,7 @@ TILE_DEFINITION level2_tiles[] = {
   {141, score_slider_right},
   {142, score_slider_centre},
   {255, blank},
-  {0,   {0}   }
+  {0,   0     }
 };
 
 TILE_DEFINITION level3_tiles[] = {
@@ -126,7 +128,7 @@ TILE_DEFINITION level3_tiles[] = {
   {141, score_slider_right},
   {142, score_slider_centre},
   {255, blank},
-  {0,   {0}   }
+  {0,   0     }
 };
 
 TILE_DEFINITION level4_tiles[] = {
@@ -140,364 +142,10 @@ TILE_DEFINITION level4_tiles[] = {
   {141, score_slider_right},
   {142, score_slider_centre},
   {255, blank},
-  {0,   {0}   }
+  {0,   0     }
 };
 
 
-/***
- *      _______   _                       _
- *     |__   __| | |                     | |
- *        | | ___| | ___ _ __   ___  _ __| |_ ___ _ __ ___
- *        | |/ _ | |/ _ | '_ \ / _ \| '__| __/ _ | '__/ __|
- *        | |  __| |  __| |_) | (_) | |  | ||  __| |  \__ \
- *        |_|\___|_|\___| .__/ \___/|_|   \__\___|_|  |___/
- *                      | |
- *                      |_|
- */
-
-TELEPORTER_DEFINITION level1_teleporters[] = {
-  {  0*8,  1*8,  0,  1,
-    22*8, 30*8, 22, 30,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  {  0*8, 10*8,  0, 10,
-    22*8, 10*8, 22, 10,
-    NAMED_VALUES_1("Change direction", 1)
-  },
-  { 14*8, 20*8, 14, 20,
-     3*8,  0*8,  3,  0,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  { 11*8, 28*8, 11, 28,
-     6*8,  0*8,  6,  0,
-    NAMED_VALUES_1("Change direction", 1)
-  },
-  {  4*8,  8*8,  4,  8,
-     2*8, 30*8,  2, 30,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  {  2*8, 23*8,  2, 23,
-    16*8,  6*8,  16, 6,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  {0}
-};
-
-TELEPORTER_DEFINITION level2_teleporters[] = {
-  { 15*8, 13*8, 15, 13,
-    14*8, 22*8, 14, 22,
-    NAMED_VALUES_1("Change direction", 1)
-  },
-  {  9*8, 14*8,  9, 14,
-     4*8,  1*8,  4,  1,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  {  13*8, 24*8,  13, 24,
-     9*8,  30*8,  9,  30,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  {0}
-};
-
-TELEPORTER_DEFINITION level3_teleporters[] = {
-  /* Bottom left up to top left */
-  {  4*8,  1*8,  4,  1,
-    22*8,  1*8, 22,  1,
-    NAMED_VALUES_1("Change direction", 1)
-  },
-  /* Third platform up to central puzzle start */
-  { 14*8,  7*8, 14,  7,
-     6*8, 16*8,  6, 16,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  /* Lower left decoy */
-  { 10*8,  7*8, 10,  7,
-    10*8, 25*8, 10, 25,
-    NAMED_VALUES_1("Change direction", 1)
-  },
-  /* Upper left decoy */
-  { 8*8,  7*8, 8,  7,
-    12*8, 25*8, 12, 25,
-    NAMED_VALUES_1("Change direction", 1)
-  },
-  /* Upper right passage */
-  { 8*8, 25*8, 8, 25,
-    2*8, 30*8, 2, 30,
-    NAMED_VALUES_1("Change direction", 1)
-  },
-  {  9*8, 30*8,  9, 30,
-    22*8, 27*8, 22, 27,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  /* Final one */
-  {  1*8,  7*8,  1,  7,
-    19*8,  7*8, 19,  7,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  {0}
-};
-
-TELEPORTER_DEFINITION level4_teleporters[] = {
-  {  1*8,  1*8,  1,  1,
-    20*8, 31*8, 20, 31,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  {  1*8, 30*8,  1, 30,
-    22*8, 11*8, 22, 11,
-    NAMED_VALUES_1("Change direction", 1)
-  },
-  { 12*8,  8*8, 12,  8,
-    16*8, 25*8, 16, 25,
-    NAMED_VALUES_1("Change direction", 0)
-  },
-  {0}
-};
-
-/***
- *       _____ _                  _
- *      / ____| |                | |
- *     | (___ | | _____      ____| | _____      ___ __  ___
- *      \___ \| |/ _ \ \ /\ / / _` |/ _ \ \ /\ / | '_ \/ __|
- *      ____) | | (_) \ V  V | (_| | (_) \ V  V /| | | \__ \
- *     |_____/|_|\___/ \_/\_/ \__,_|\___/ \_/\_/ |_| |_|___/
- *
- *
- */
-
-SLOWDOWN level0_slowdowns[] = {
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x", 184, "Sprite y", 176,
-                            "Centre x", 188, "Centre y", 180,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(15) },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x",  30, "Sprite y",  64,
-                            "Centre x",  34, "Centre y",  68,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(15) },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x", 208, "Sprite y", 104,
-                            "Centre x", 210, "Centre y", 108,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(15) },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x",   0, "Sprite y",   0,
-                            "Centre x",   0, "Centre y",   0,
-                            0,
-                            0)}},
-};
-
-SLOWDOWN level1_slowdowns[] = {
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x", 180, "Sprite y", 128,
-                            "Centre x", 184, "Centre y", 132,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(15)  },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x", 240, "Sprite y", 88,
-                            "Centre x", 244, "Centre y", 92,
-                            slowdown_collected,
-                            slowdown_timeup)},  SLOWDOWN_SECS(12)  },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x",   0, "Sprite y",   0,
-                            "Centre x",   0, "Centre y",   0,
-                            0,
-                            0)}},
-};
-
-SLOWDOWN level2_slowdowns[] = {
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x", 14*8,   "Sprite y", 20*8,
-                            "Centre x", 14*8+4, "Centre y", 20*8+4,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(12)  },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x", 1*8,    "Sprite y", 11*8,
-                            "Centre x", 1*8+4,  "Centre y", 11*8+4,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(15)  },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x", 30*8,   "Sprite y", 20*8,
-                            "Centre x", 30*8+4, "Centre y", 20*8+4,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(15)  },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x", 23*8,   "Sprite y",  9*8,
-                            "Centre x", 23*8+4, "Centre y",  9*8+4,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(15)  },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x",   0, "Sprite y",   0,
-                            "Centre x",   0, "Centre y",   0,
-                            0,
-                            0)}},
-};
-
-SLOWDOWN level3_slowdowns[] = {
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-			    "Sprite x", 16*8,   "Sprite y",  4*8,
-                            "Centre x", 16*8+4, "Centre y",  4*8+4,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(5)  },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-			    "Sprite x", 16*8,   "Sprite y", 22*8,
-                            "Centre x", 16*8+4, "Centre y", 22*8+4,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(7)  },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-			    "Sprite x",   0, "Sprite y",   0,
-                            "Centre x",   0, "Centre y",   0,
-                            0,
-                            0)}},
-};
-
-SLOWDOWN level4_slowdowns[] = {
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-	                   		    "Sprite x", 28*8,   "Sprite y",  8*8,
-                            "Centre x", 28*8+4, "Centre y",  8*8+4,
-                            slowdown_collected,
-                            slowdown_timeup)}, SLOWDOWN_SECS(8)  },
-  { {INITIALISE_COLLECTABLE(SLOWDOWN_PILL,
-                            "Sprite x",   0, "Sprite y",   0,
-                            "Centre x",   0, "Centre y",   0,
-                            0,
-                            0)}},
-};
-
-
-/***
- *      _____
- *     |  __ \
- *     | |  | | ___   ___  _ __ ___
- *     | |  | |/ _ \ / _ \| '__/ __|
- *     | |__| | (_) | (_) | |  \__ \
- *     |_____/ \___/ \___/|_|  |___/
- *
- *
- */
-
-DOOR level2_doors[] = {
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Key x cell",       8,  "Key y cell",        4,
-                            "Centre x px", (8*8+4), "Centre y px", (4*8+4),
-                            door_key_collected,
-                            door_open_timeup)},
-    INITIALISE_DOOR_LOCATION(17,22),
-    NAMED_VALUES_1("Door ink",     INK_MAGENTA),
-    NAMED_VALUES_1("Key ink",        INK_WHITE),
-    NAMED_VALUES_1("Key paper",      INK_BLACK),
-    NAMED_VALUES_1("Door open secs",        10),
-    NAMED_VALUES_1("Start open secs",        2),
-  },
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Key x cell",       5,  "Key y cell",       22,
-                            "Centre x px", (5*8+4), "Centre y px", (22*8+4),
-                            door_key_collected,
-                            door_open_timeup)},
-    INITIALISE_DOOR_LOCATION(22,22),
-    NAMED_VALUES_1("Door ink",        INK_BLUE),
-    NAMED_VALUES_1("Key ink",        INK_WHITE),
-    NAMED_VALUES_1("Key paper",      INK_BLACK),
-    NAMED_VALUES_1("Door open secs",         5),
-    NAMED_VALUES_1("Start open secs",        3),
-  },
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Key x cell",       30,  "Key y cell",        4,
-                            "Centre x px", (30*8+4), "Centre y px", (4*8+4),
-                            door_key_collected,
-                            door_open_timeup)},
-    INITIALISE_DOOR_LOCATION(27,22),
-    NAMED_VALUES_1("Door ink",       INK_GREEN),
-    NAMED_VALUES_1("Key ink",        INK_WHITE),
-    NAMED_VALUES_1("Key paper",      INK_BLACK),
-    NAMED_VALUES_1("Door open secs",         6),
-    NAMED_VALUES_1("Start open secs",        4),
-  },
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Sprite x",   0, "Sprite y",   0,
-                            "Centre x",   0, "Centre y",   0,
-                            0,
-                            0)}, 0 },
-};
-
-DOOR level3_doors[] = {
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Key x cell",       30,  "Key y cell",        22,
-                            "Centre x px", (30*8+4), "Centre y px", (22*8+4),
-                            door_key_collected,
-                            door_open_timeup)},
-    INITIALISE_DOOR_LOCATION(4,1),
-    NAMED_VALUES_1("Door ink",       INK_RED),
-    NAMED_VALUES_1("Key ink",        INK_BLACK),
-    NAMED_VALUES_1("Key paper",      INK_WHITE),
-    NAMED_VALUES_1("Door open secs",        12),
-    NAMED_VALUES_1("Start open secs",        3),
-  },
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Sprite x",   0, "Sprite y",   0,
-                            "Centre x",   0, "Centre y",   0,
-                            0,
-                            0)}, 0 },
-};
-
-DOOR level4_doors[] = {
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Key x cell",        6,  "Key y cell",         1,
-                            "Centre x px",  (6*8+4), "Centre y px",  (1*8+4),
-                            door_key_collected,
-                            door_open_timeup)},
-    INITIALISE_DOOR_LOCATION(9,22),
-    NAMED_VALUES_1("Door ink",       INK_GREEN),
-    NAMED_VALUES_1("Key ink",        INK_WHITE),
-    NAMED_VALUES_1("Key paper",      INK_BLACK),
-    NAMED_VALUES_1("Door open secs",         6),
-    NAMED_VALUES_1("Start open secs",        0),
-  },
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Key x cell",       24,  "Key y cell",         4,
-                            "Centre x px",  (24*8+4), "Centre y px",  (4*8+4),
-                            door_key_collected,
-                            door_open_timeup)},
-    INITIALISE_DOOR_LOCATION(8,4),
-    NAMED_VALUES_1("Door ink",       INK_RED),
-    NAMED_VALUES_1("Key ink",        INK_WHITE),
-    NAMED_VALUES_1("Key paper",      INK_BLACK),
-    NAMED_VALUES_1("Door open secs",        10),
-    NAMED_VALUES_1("Start open secs",        0),
-  },
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Key x cell",        7,  "Key y cell",         4,
-                            "Centre x px",  (7*8+4), "Centre y px",  (4*8+4),
-                            door_key_collected,
-                            door_open_timeup)},
-    INITIALISE_DOOR_LOCATION(11,12 ),
-    NAMED_VALUES_1("Door ink",       INK_YELLOW),
-    NAMED_VALUES_1("Key ink",        INK_WHITE),
-    NAMED_VALUES_1("Key paper",      INK_BLACK),
-    NAMED_VALUES_1("Door open secs",        10),
-    NAMED_VALUES_1("Start open secs",        0),
-  },
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Key x cell",        23,  "Key y cell",       12,
-                            "Centre x px",  (23*8+4), "Centre y px",  (12*8+4),
-                            door_key_collected,
-                            door_open_timeup)},
-    INITIALISE_DOOR_LOCATION(2,14),
-    NAMED_VALUES_1("Door ink",       INK_CYAN),
-    NAMED_VALUES_1("Key ink",        INK_WHITE),
-    NAMED_VALUES_1("Key paper",      INK_BLACK),
-    NAMED_VALUES_1("Door open secs",        6),
-    NAMED_VALUES_1("Start open secs",        0),
-  },
-  { {INITIALISE_COLLECTABLE(DOOR_KEY,
-                            "Sprite x",   0, "Sprite y",   0,
-                            "Centre x",   0, "Centre y",   0,
-                            0,
-                            0)}, 0 },
-};
-
-
-
 /***
  *      _                    _
  *     | |                  | |
@@ -522,22 +170,8 @@ LEVEL_DATA level_data[] = {
  */
   {
     0,
-    level_intro_map,
-    START_POINT(100,0),
-    LEVEL_BORDER(INK_BLACK),
-    START_FACING(RIGHT),
-    NAMED_VALUES_3("Background", INK_BLACK|PAPER_WHITE,
-                   "Solid",      INK_GREEN|PAPER_WHITE,
-                   "Jumper",     INK_RED|PAPER_GREEN),
-    &level0_tiles[0],
-    NULL,
-    NULL,
-    NULL,
-    { NAMED_VALUES_5("Countdown slider X", 255,  /* I don't want bonuses showing on the intro */
-                     "Countdown slider Y", 255,  /* level so they actually get drawn off screen */
-                     "Scores att",         0,
-                     "Bonus X pixel",      255,
-                     "Bonus Y pixel",      255) }
+    level_intro_blob,
+    &level0_tiles[0]
   },
 
   /***
@@ -549,22 +183,8 @@ LEVEL_DATA level_data[] = {
    */
   {
     1,
-    level0_map,
-    START_POINT(3,140),
-    LEVEL_BORDER(INK_RED),
-    START_FACING(RIGHT),
-    NAMED_VALUES_3("Background", INK_BLACK|PAPER_WHITE,
-                   "Solid",      INK_GREEN|PAPER_WHITE,
-                   "Jumper",     INK_RED|PAPER_GREEN),
-    &level0_tiles[0],
-    NULL,
-    &level0_slowdowns[0],
-    NULL,
-    { NAMED_VALUES_5("Countdown slider X", 19*8,
-                     "Countdown slider Y", 18*8,
-                     "Scores att",         INK_BLUE|PAPER_WHITE,
-                     "Bonus X pixel",      19*8,
-                     "Bonus Y pixel",      19*8) }
+    level0_blob,
+    &level0_tiles[0]
   },
 
   /***
@@ -576,22 +196,8 @@ LEVEL_DATA level_data[] = {
    */
   {
     2,
-    level1_map,
-    START_POINT(3,155),
-    LEVEL_BORDER(INK_BLUE),
-    START_FACING(RIGHT),
-    NAMED_VALUES_3("Background", INK_MAGENTA|PAPER_BLACK,
-                   "Solid",      INK_CYAN|PAPER_BLACK,
-                   "Jumper",     INK_RED|PAPER_BLACK),
-    &level1_tiles[0],
-    &level1_teleporters[0],
-    &level1_slowdowns[0],
-    NULL,
-    { NAMED_VALUES_5("Countdown slider X", 14*8,
-                     "Countdown slider Y", 19*8,
-                     "Scores att",         INK_YELLOW|PAPER_BLACK,
-                     "Bonus X pixel",      14*8,
-                     "Bonus Y pixel",      20*8) }
+    level1_blob,
+    &level1_tiles[0]
   },
 
   /***
@@ -603,22 +209,8 @@ LEVEL_DATA level_data[] = {
    */
   {
     3,
-    level2_map,
-    START_POINT(3,163),
-    LEVEL_BORDER(INK_BLACK),
-    START_FACING(RIGHT),
-    NAMED_VALUES_3("Background", INK_WHITE|PAPER_BLACK,
-                   "Solid",      INK_YELLOW|PAPER_BLACK,
-                   "Jumper",     INK_RED|PAPER_BLACK),
-    &level2_tiles[0],
-    &level2_teleporters[0],
-    level2_slowdowns,
-    &level2_doors[0],
-    { NAMED_VALUES_5("Countdown slider X",  0*8,
-                     "Countdown slider Y",  0*8,
-                     "Scores att",          INK_WHITE|PAPER_BLACK,
-                     "Bonus X pixel",       0*8,
-                     "Bonus Y pixel",       1*8) }
+    level2_blob,
+    &level2_tiles[0]
   },
 
   /***
@@ -630,22 +222,8 @@ LEVEL_DATA level_data[] = {
    */
   {
     4,
-    level3_map,
-    START_POINT(11,16),
-    LEVEL_BORDER(INK_RED),
-    START_FACING(RIGHT),
-    NAMED_VALUES_3("Background", INK_BLACK|PAPER_WHITE,
-                   "Solid",      INK_RED|PAPER_YELLOW,
-                   "Jumper",     INK_RED|PAPER_WHITE),
-    level3_tiles,
-    level3_teleporters,
-    level3_slowdowns,
-    level3_doors,
-    { NAMED_VALUES_5("Countdown slider X", 21*8,
-                     "Countdown slider Y",  0*8,
-                     "Scores att",         INK_BLUE|PAPER_WHITE,
-                     "Bonus X pixel",      21*8,
-                     "Bonus Y pixel",       1*8) }
+    level3_blob,
+    level3_tiles
   },
 
   /***
@@ -657,22 +235,8 @@ LEVEL_DATA level_data[] = {
    */
   {
     5,
-    level4_map,
-    START_POINT(11,0),
-    LEVEL_BORDER(INK_BLACK),
-    START_FACING(RIGHT),
-    NAMED_VALUES_3("Background", INK_WHITE|PAPER_BLACK,
-                   "Solid",      INK_MAGENTA|PAPER_BLACK,
-                   "Jumper",     INK_RED|PAPER_BLACK),
-    level4_tiles,
-    level4_teleporters,
-    level4_slowdowns,
-    level4_doors,
-    { NAMED_VALUES_5("Countdown slider X", 20*8,
-                     "Countdown slider Y", 21*8,
-                     "Scores att",         INK_GREEN|PAPER_BLACK,
-                     "Bonus X pixel",      20*8,
-                     "Bonus Y pixel",      22*8) }
+    level4_blob,
+    level4_tiles
   },
 
 };
@@ -685,7 +249,8 @@ extern uint8_t font[];
 
 /*
  * This "prints" a level using the comprehensive SP1 print function.
- * The level data draw_data value should be a pointer to the string.
+ * The level data draw_data value should be a pointer to the packed
+ * map, which is unpacked back into print string a bufferful at a time.
  * The string itself will likely need to be defined in ASM because
  * it'll probably require embedded zeroes.
  *
@@ -706,10 +271,177 @@ struct sp1_pss level_print_control = { &full_screen, SP1_PSSFLAG_INVALIDATE,
                                        0x00, 0,
                                        0,
                                        0 };
+
+/*
+ * Unpacking buffer, with room for the terminator. Print position and
+ * colours are kept in level_print_control between prints so it doesn't
+ * matter where the string is broken.
+ */
+static uint8_t  level_map_buffer[LEVEL_MAP_BUFFER_SIZE+1];
+static uint8_t* level_map_buffer_ptr;
+
+static void flush_level_map_buffer( void )
+{
+  *level_map_buffer_ptr = '\0';
+  sp1_PrintString(&level_print_control, level_map_buffer);
+  level_map_buffer_ptr = level_map_buffer;
+}
+
+/* Make sure there's room for n more bytes */
+#define RESERVE_LEVEL_MAP_BUFFER(n) \
+  if( level_map_buffer_ptr > &level_map_buffer[LEVEL_MAP_BUFFER_SIZE-(n)] ) flush_level_map_buffer()
+
+/* AT <y>,<x> then the tile */
+#define UNPACK_LEVEL_MAP_TILE(y,x,c) \
+  RESERVE_LEVEL_MAP_BUFFER(4);       \
+  *level_map_buffer_ptr++ = '\x16';  \
+  *level_map_buffer_ptr++ = (y);     \
+  *level_map_buffer_ptr++ = (x);     \
+  *level_map_buffer_ptr++ = (c)
+
+/*
+ * Unpack a map in the format described in levels.h and print it.
+ */
+static void print_level_map( uint8_t* map )
+{
+  uint8_t record;
+  uint8_t y, x, c, n;
+
+  level_map_buffer_ptr = level_map_buffer;
+
+  while( (record = *map++) != 0 )
+  {
+    switch( record )
+    {
+    case LEVEL_MAP_STRING:
+      n = *map++;
+      RESERVE_LEVEL_MAP_BUFFER(n);
+      memcpy( level_map_buffer_ptr, map, n );
+      level_map_buffer_ptr += n;
+      map += n;
+      break;
+
+    case LEVEL_MAP_HRUN:
+      y = *map++; x = *map++; c = *map++; n = *map++;
+      UNPACK_LEVEL_MAP_TILE(y,x,c);
+      while( --n )
+      {
+        /* The print position carries on along the row */
+        RESERVE_LEVEL_MAP_BUFFER(1);
+        *level_map_buffer_ptr++ = c;
+      }
+      break;
+
+    case LEVEL_MAP_VRUN:
+      y = *map++; x = *map++; c = *map++; n = *map++;
+      while( n-- )
+      {
+        UNPACK_LEVEL_MAP_TILE(y,x,c);
+        y++;
+      }
+      break;
+
+    case LEVEL_MAP_TILES:
+      c = *map++; n = *map++;
+      while( n-- )
+      {
+        y = *map++; x = *map++;
+        UNPACK_LEVEL_MAP_TILE(y,x,c);
+      }
+      break;
+    }
+  }
+
+  flush_level_map_buffer();
+}
+
+/*
+ * The level's pills and doors. These change as the level is played, so
+ * they're filled in from the blob each time it starts.
+ */
+static SLOWDOWN level_slowdowns[MAX_LEVEL_SLOWDOWNS+1];
+static DOOR     level_doors[MAX_LEVEL_DOORS+1];
+
+/* The DOOR members which are in the blob as they are */
+#define BLOB_DOOR_SIZE (offsetof(DOOR,start_open_secs) + 1 - offsetof(DOOR,door_cell_x))
+
+static uint8_t* load_collectable( COLLECTABLE* collectable, COLLECTABLE_TYPE type, uint8_t* blob )
+{
+  collectable->type      = type;
+  collectable->x         = *blob++;
+  collectable->y         = *blob++;
+  collectable->centre_x  = *blob++;
+  collectable->centre_y  = *blob++;
+  collectable->available = COLLECTABLE_AVAILABLE;
+
+  return blob;
+}
+
+/*
+ * Fill in the level data from its blob, in the order described in
+ * levels.h, and load its tile map. Nothing here needs working out,
+ * compile_level.pl has done that.
+ */
+static void load_level_blob( LEVEL_DATA* level_data )
+{
+  uint8_t*  blob = level_data->blob;
+  uint8_t   n;
+  SLOWDOWN* slowdown;
+  DOOR*     door;
+
+  level_data->start_x        = *blob++;
+  level_data->start_y        = *blob++;
+  level_data->start_facing   = (DIRECTION)*blob++;
+  level_data->border_colour  = *blob++;
+  level_data->background_att = *blob++;
+  level_data->solid_att      = *blob++;
+  level_data->jumper_att     = *blob++;
+  level_data->runner_ink     = *blob++;
+
+  level_data->score_screen_data.countdown_slider_x     = *blob++;
+  level_data->score_screen_data.countdown_slider_y     = *blob++;
+  level_data->score_screen_data.score_screen_attribute = *blob++;
+  level_data->score_screen_data.bonus_sprite0_x_pixel  = *blob++;
+  level_data->score_screen_data.bonus_sprite0_y_pixel  = *blob++;
+
+  level_data->teleporters = NULL;
+  if( (n = *blob++) )
+  {
+    level_data->teleporters = (TELEPORTER_DEFINITION*)blob;
+    blob += (n+1) * sizeof(TELEPORTER_DEFINITION);
+  }
+
+  memset( level_slowdowns, 0, sizeof(level_slowdowns) );
+  level_data->slowdowns = (n = *blob++) ? level_slowdowns : NULL;
+  for( slowdown = level_slowdowns; n; n--, slowdown++ )
+  {
+    blob = load_collectable( &slowdown->collectable, SLOWDOWN_PILL, blob );
+    slowdown->collectable.collection_fn = slowdown_collected;
+    slowdown->collectable.timer_fn      = slowdown_timeup;
+    slowdown->duration_secs             = *blob++;
+  }
+
+  memset( level_doors, 0, sizeof(level_doors) );
+  level_data->doors = (n = *blob++) ? level_doors : NULL;
+  for( door = level_doors; n; n--, door++ )
+  {
+    blob = load_collectable( &door->collectable, DOOR_KEY, blob );
+    door->collectable.collection_fn = door_key_collected;
+    door->collectable.timer_fn      = door_open_timeup;
+
+    memcpy( &door->door_cell_x, blob, BLOB_DOOR_SIZE );
+    blob += BLOB_DOOR_SIZE;
+  }
+
+  level_data->draw_data = (uint8_t*)load_tile_map( blob );
+}
+
 void print_level_from_sp1_string(LEVEL_DATA* level_data)
 {
   TILE_DEFINITION* tile_ptr;
 
+  load_level_blob( level_data );
+
   level_print_control.attr = level_data->background_att;
 
   /* Reset screen, remove tiles and sprites, and reset to new colours */
@@ -726,15 +458,13 @@ void print_level_from_sp1_string(LEVEL_DATA* level_data)
   }
 
   /* Print the string from the levels map data */
-  sp1_PrintString(&level_print_control, (uint8_t*)(level_data->draw_data));
+  print_level_map( (uint8_t*)(level_data->draw_data) );
 
   /*
    * If the level has teleporters they are filled in here. These could be
-   * done in the level map string in the ASM code, but they are required
-   * in the C code as well so their cells can be vaildated. The duplication
-   * was confusing, so I moved the code to deal with them here. It's less
-   * efficient space-wise but makes things easier when putting the level
-   * together.
+   * done in the level map string, but they are required in the C code as
+   * well so their cells can be vaildated. The duplication was confusing,
+   * so they're printed from the level's teleporter table instead.
    */
   if( level_data->teleporters )
   {
@@ -769,6 +499,15 @@ void print_level_from_sp1_string(LEVEL_DATA* level_data)
     }
   }
 
+  /*
+   * The tile map came in with the blob. Door creation below marks the
+   * door cells in it. Keys and pills don't affect collisions.
+   */
+
+  /* Pills and doors register their collection points as they're created */
+  clear_collectable_triggers();
+  clear_collectable_timers();
+
   if( level_data->slowdowns )
   {
     SLOWDOWN* slowdown = level_data->slowdowns;
@@ -794,8 +533,66 @@ void print_level_from_sp1_string(LEVEL_DATA* level_data)
 }
 
 
+/*
+ * Teleporter ends and the cells doors hide in mustn't be redrawn when the
+ * runner or a door sprite moves over them. The teleporter is drawn in
+ * front of him so he appears to go "into" it, and the door slides out
+ * from underneath its protected cell.
+ *
+ * This used to be done by validating each of the cells after every
+ * frame's draw. SP1 can take a cell out of the update process altogether,
+ * so that's done once for the level and undone when it's torn down.
+ */
+static void set_cell_protection( uint8_t row, uint8_t col, uint8_t protect )
+{
+  struct sp1_update* cell = sp1_GetUpdateStruct( row, col );
+
+  if( protect )
+    sp1_RemoveUpdateStruct( cell );
+  else
+    sp1_RestoreUpdateStruct( cell );
+}
+
+static void set_level_cells_protection( LEVEL_DATA* level_data, uint8_t protect )
+{
+  if( level_data->teleporters )
+  {
+    TELEPORTER_DEFINITION* teleporter = level_data->teleporters;
+
+    while( teleporter->end_1_x || teleporter->end_1_y )
+    {
+      set_cell_protection( teleporter->end_1_y_cell, teleporter->end_1_x_cell, protect );
+      set_cell_protection( teleporter->end_2_y_cell, teleporter->end_2_x_cell, protect );
+      teleporter++;
+    }
+  }
+
+  if( level_data->doors )
+  {
+    DOOR* door = level_data->doors;
+
+    while( IS_VALID_COLLECTABLE(door->collectable) )
+    {
+      set_cell_protection( door->door_protected_cell_y, door->door_protected_cell_x, protect );
+      door++;
+    }
+  }
+}
+
+/*
+ * Called once the printed level has been through a full update, otherwise
+ * the protected cells would never be drawn at all.
+ */
+void protect_level_cells(LEVEL_DATA* level_data)
+{
+  set_level_cells_protection( level_data, 1 );
+}
+
 void teardown_level(LEVEL_DATA* level_data)
 {
+  /* Put the protected cells back so the next screen draws over them */
+  set_level_cells_protection( level_data, 0 );
+
   /* Reclaim slowdown pill memory (SP1 structs, etc)*/
   if( level_data->slowdowns )
   {
@@ -44,7 +44,15 @@ typedef struct _level_data
 {
   uint8_t   level_num;
 
-  void*     draw_data;
+  /*
+   * The level as built by compile_level.pl from its .lvl description,
+   * and the UDGs it's drawn with. Everything below these is filled in
+   * from the blob when the level is printed.
+   */
+  uint8_t*         blob;
+  TILE_DEFINITION* level_tiles;
+
+  uint8_t*  draw_data;
 
   uint8_t   start_x;
   uint8_t   start_y;
@@ -55,21 +63,21 @@ typedef struct _level_data
 
   /*
    * Background attribute paper provides the background colour.
-   * Its ink colour provides the runner's colour. It has to be
-   * this way because the runner sprite sets the colours of the
-   * two cells it gets placed in, and since collision detection
-   * is based on paper colour the sprite will "collide with
-   * itself" if the runner were to have a different background
-   * colour.
+   * Its ink colour used to provide the runner's colour too, because
+   * collision detection read the attribute file and the runner sprite
+   * colours the cells it's placed in, so he'd "collide with himself"
+   * in any other colour. Collisions now use the tile map (see
+   * tile_map.h) which is worked out from these values when the level
+   * is compiled, so the runner has his own ink.
    */
   uint8_t   background_att;
   uint8_t   solid_att;
   uint8_t   jumper_att;
+  uint8_t   runner_ink;
 
-  TILE_DEFINITION*       level_tiles;
   TELEPORTER_DEFINITION* teleporters;
   SLOWDOWN*              slowdowns;
-  DOOR*       doors;
+  DOOR*                  doors;
 
   SCORE_SCREEN_DATA      score_screen_data;
 } LEVEL_DATA;
@@ -82,14 +90,54 @@ typedef struct _level_data
 
 #define NUM_LEVELS 6
 
-#define START_POINT(x,y) x,y
-#define LEVEL_BORDER(b) b
-#define START_FACING(f) f
 #define MAX_POINTS(m) m
 #define MAX_BONUS(b) b
-#define SLOWDOWN_SECS(s) s
+
+/*
+ * The pills and doors are filled in from the blob into these many
+ * places, plus an empty one to end the list.
+ */
+#define MAX_LEVEL_SLOWDOWNS   6
+#define MAX_LEVEL_DOORS       6
+
+/*
+ * A level blob is, in order:
+ *
+ *  start x, start y, start facing, border
+ *  background, solid and jumper attributes, runner ink
+ *  countdown slider x, y, scores attribute, bonus sprite x, y
+ *  n, then n TELEPORTER_DEFINITIONs and a zeroed one if n isn't 0
+ *  n, then n pills:  sprite x, y, centre x, y, secs
+ *  n, then n doors:  key x, y, centre x, y, then the DOOR from
+ *                    door_cell_x to start_open_secs
+ *  the tile map, see tile_map.h
+ *  the packed map
+ *
+ * The teleporters are used where they are. compile_level.pl has the
+ * details of the description it's built from, and its own copy of the
+ * sizes here.
+ *
+ * Level maps are SP1 print strings in levels_maps.asm, packed at build
+ * time. The packed map is a list of records ended by a zero:
+ *
+ *  STRING n <n bytes>        a piece of SP1 print string, used as it is
+ *  HRUN   y x c n            n of tile c going right from y,x
+ *  VRUN   y x c n            n of tile c going down from y,x
+ *  TILES  c n <n y,x pairs>  tile c at each of the places
+ *
+ * The records are unpacked into a buffer which is printed whenever it
+ * fills. A STRING is never split over two prints, so it can't be longer
+ * than the buffer.
+ */
+#define LEVEL_MAP_STRING      0x01
+#define LEVEL_MAP_HRUN        0x02
+#define LEVEL_MAP_VRUN        0x03
+#define LEVEL_MAP_TILES       0x04
+
+#define LEVEL_MAP_BUFFER_SIZE 32
 
 void print_level_from_sp1_string(LEVEL_DATA* level_data);
+void protect_level_cells(LEVEL_DATA* level_data);
 void teardown_level(LEVEL_DATA* level_data);
 void setup_levels_font( void );
 
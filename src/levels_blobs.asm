@@ -0,0 +1,29 @@
+;; Wonky One Key, a ZX Spectrum game featuring a single control key
+;; Copyright (C) 2018 Derek Fountain
+;;
+;; This program is free software; you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License
+;; as published by the Free Software Foundation; either version 2
+;; of the License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful,
+;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;; GNU General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program; if not, write to the Free Software
+;; Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+SECTION LEVEL_DATA
+ORG 25000
+
+;;  The level blobs. Each one is generated from the level's .lvl file
+;;  by compile_level.pl; the makefile has the rule.
+
+INCLUDE "level_intro_blob.asm"
+INCLUDE "level0_blob.asm"
+INCLUDE "level1_blob.asm"
+INCLUDE "level2_blob.asm"
+INCLUDE "level3_blob.asm"
+INCLUDE "level4_blob.asm"
@@ -218,177 +218,6 @@ PUBLIC _score_slider_centre
         defb @00000000
         defb @00000000
 
-;;     _____ _                  _                       _____ _ _ _ 
-;;    / ____| |                | |                     |  __ (_| | |
-;;   | (___ | | _____      ____| | _____      ___ __   | |__) _| | |
-;;    \___ \| |/ _ \ \ /\ / / _` |/ _ \ \ /\ / | '_ \  |  ___| | | |
-;;    ____) | | (_) \ V  V | (_| | (_) \ V  V /| | | | | |   | | | |
-;;   |_____/|_|\___/ \_/\_/ \__,_|\___/ \_/\_/ |_| |_| |_|   |_|_|_|
-;;                                                                  
-;;                                                                  
-     
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-
-PUBLIC _slowdown_pill_f1
-._slowdown_pill_f1
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00010000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-
-PUBLIC _slowdown_pill_f2
-._slowdown_pill_f2
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00011000
-        defb @00011000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-
-PUBLIC _slowdown_pill_f3
-._slowdown_pill_f3
-        defb @00000000
-        defb @00000000
-        defb @00011000
-        defb @00100100
-        defb @00100100
-        defb @00011000
-        defb @00000000
-        defb @00000000
-
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-
-
-
-;;    _____
-;;   |  __ \
-;;   | |  | | ___   ___  _ __
-;;   | |  | |/ _ \ / _ \| '__|
-;;   | |__| | (_) | (_) | |
-;;   |_____/ \___/ \___/|_|
-;;
-;;
-
-PUBLIC _door_f1
-._door_f1
-        defb @01111110
-        defb @11111111
-        defb @11111111
-        defb @11111111
-        defb @11111111
-        defb @11011011
-        defb @11011011
-        defb @11000011
-
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-
-
-
-;;    ____
-;;   |  _ \
-;;   | |_) | ___  _ __  _   _ ___
-;;   |  _ < / _ \| '_ \| | | / __|
-;;   | |_) | (_) | | | | |_| \__ \
-;;   |____/ \___/|_| |_|\__,_|___/
-;;
-;;
-
-PUBLIC _bonus
-._bonus
-        defb @00000000
-        defb @00111100
-        defb @01111110
-        defb @01100110
-        defb @01100110
-        defb @01111110
-        defb @00111100
-        defb @00000000
-
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-
-
-
-
-;;     _____                          _ _     _
-;;    / ____|                        | (_)   | |
-;;   | (___   ___ ___  _ __ ___   ___| |_  __| | ___ _ __
-;;    \___ \ / __/ _ \| '__/ _ \ / __| | |/ _` |/ _ | '__|
-;;    ____) | (_| (_) | | |  __/ \__ | | | (_| |  __| |
-;;   |_____/ \___\___/|_|  \___| |___|_|_|\__,_|\___|_|
-;;
-;;
-PUBLIC _score_slider
-._score_slider
-        defb @01111000
-        defb @10110100
-        defb @00110000
-        defb @00110000
-        defb @00110000
-        defb @00110000
-        defb @10110100
-        defb @01111000
-
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-        defb @00000000
-
-
 ;;      ______          _
 ;;     |  ____|        | |
 ;;     | |__ ___  _ __ | |_
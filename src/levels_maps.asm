@@ -15,8 +15,10 @@
 ;; along with this program; if not, write to the Free Software
 ;; Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
-SECTION LEVEL_DATA
-ORG 25000
+;;  The level maps, as SP1 print strings. These aren't assembled as
+;;  they are: compile_level.pl picks each one up by its label, for the
+;;  level description which names it, and packs it into that level's
+;;  blob. See levels_blobs.asm.
 
 ;;  In the SP1 print string routine, embedded paper colours are
 ;;  set using 3 bit colour values, i.e. the same as INK.
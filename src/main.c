@@ -36,6 +36,8 @@
 #include "winner.h"
 #include "bonus.h"
 #include "countdown.h"
+#include "sound.h"
+#include "input_log.h"
 
 /* Hopefully the optimiser won't remove this. :) Keep it 8 bytes, BE expects that */
 unsigned char version[8] = "ver1.01";
@@ -66,7 +68,8 @@ int main()
 {
   uint8_t current_level_num;
 
-  if( is_rom_writable() ) {
+#if ANY_TRACING || INPUT_LOG == INPUT_LOG_RECORD
+  if( clear_trace_area() ) {
     /* Flicker the border if ROM is being used for trace */
     zx_border(INK_RED);
     z80_delay_ms(100);
@@ -74,8 +77,6 @@ int main()
     z80_delay_ms(100);
     zx_border(INK_WHITE);
 
-    clear_trace_area();    
-
     init_gameloop_trace();
     init_key_action_trace();
     init_collision_trace();
@@ -83,11 +84,20 @@ int main()
     init_slowdown_trace();
     init_door_trace();
     init_collectable_trace();
+    init_frame_stats();
+    init_input_log();
   }
+#endif
 
+  detect_sound_hardware();
   setup_int();
 
-  sp1_Initialize( SP1_IFLAG_MAKE_ROTTBL | SP1_IFLAG_OVERWRITE_TILES | SP1_IFLAG_OVERWRITE_DFILE,
+  /*
+   * No SP1_IFLAG_MAKE_ROTTBL. The sprites are all drawn from pre-shifted
+   * frames (see preshift_sprites.pl) so SP1 never rotates anything, and
+   * the 3.5K of memory it would build its rotation tables in is free.
+   */
+  sp1_Initialize( SP1_IFLAG_OVERWRITE_TILES | SP1_IFLAG_OVERWRITE_DFILE,
                   INK_BLACK | PAPER_WHITE,
                   ' ' );
 
@@ -119,8 +129,16 @@ int main()
       sp1_Invalidate(&full_screen);
       sp1_UpdateNow();
 
+      /*
+       * The level has been drawn in full, so its teleporters and door hiding
+       * places can be taken out of SP1's updates. The runner then moves "into"
+       * a teleporter rather than being drawn over it. teardown_level() puts
+       * them back.
+       */
+      protect_level_cells( game_state.current_level );
+
       /* Wait in case the user is holding down the control key */
-      while( in_key_pressed( IN_KEY_SCANCODE_SPACE ) );
+      WAIT_KEY_RELEASED( IN_KEY_SCANCODE_SPACE );
       game_state.key_pressed = 0;
       game_state.key_processed = 0;
 
@@ -129,11 +147,14 @@ int main()
       SET_RUNNER_FACING( game_state.current_level->start_facing );
       SET_RUNNER_XPOS( game_state.current_level->start_x );
       SET_RUNNER_YPOS( game_state.current_level->start_y );
-      set_runner_colour( game_state.current_level->background_att );
+      set_runner_colour( game_state.current_level->runner_ink );
       SET_RUNNER_SLOWDOWN( SLOWDOWN_INACTIVE );
 
       /* Enter game loop, exit when player completes the level */
+      start_background_music();
       completion_type = gameloop( &game_state );
+      stop_background_music();
+      wait_for_sound_effect();
 
       /* Call the level's teardown function to reclaim resources */
       teardown_level( game_state.current_level );
@@ -0,0 +1,292 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Wonky One Key, a ZX Spectrum game featuring a single control key
+# Copyright (C) 2018 Derek Fountain
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+# Pack the level maps. levels_maps.asm, and the level designer's include
+# files, hold each level as an SP1 print string, and the designer's
+# output puts every tile at its own AT: four bytes a cell. This reads
+# those strings and writes them out again in the packed form which
+# print_level_from_sp1_string() unpacks. See levels.h for the format.
+#
+# compile_level.pl loads this with require and packs the map named in
+# each level's description into its blob with pack_map(). Run on its own
+# it packs every map in the file it's given, which is handy for seeing
+# what a map from the level designer packs down to.
+#
+# A tile is only taken out of the string if nothing after it relies on
+# where it left the print position, i.e. the next thing which isn't a
+# colour change is another AT or the end of the string. Tiles in a row
+# which share a colour are then sorted into horizontal and vertical runs;
+# their order doesn't matter because none of them overlap. Everything
+# else, text, repeats, the cursor moves in level 0, is kept as it is.
+#
+#  pack_level_maps.pl levels_maps.asm > /tmp/levels_maps_packed.asm
+
+use File::Basename;
+
+# These must match levels.h
+my $LEVEL_MAP_STRING        = 0x01;
+my $LEVEL_MAP_HRUN          = 0x02;
+my $LEVEL_MAP_VRUN          = 0x03;
+my $LEVEL_MAP_TILES         = 0x04;
+my $LEVEL_MAP_BUFFER_SIZE   = 32;
+
+my $SP1_AT = 0x16;
+
+sub to_byte {
+  my ($value, $where) = @_;
+  my $byte;
+
+  if(    $value =~ /^@([01]+)$/ )            { $byte = oct("0b$1"); }
+  elsif( $value =~ /^(?:0x|\$)([0-9a-f]+)$/i ) { $byte = hex($1); }
+  elsif( $value =~ /^(\d+)$/ )               { $byte = $1; }
+  else { die "$where: can't convert value '$value'\n"; }
+
+  die "$where: value '$value' isn't a byte\n" if $byte > 255;
+  return $byte;
+}
+
+# Read an ASM file into a list of lines to copy through (SECTION, ORG,
+# PUBLIC, labels) and byte lists, following INCLUDEs.
+sub read_asm {
+  my ($file, $items) = @_;
+  my $dir = dirname($file);
+
+  open( my $fh, '<', $file ) or die "Can't open $file: $!\n";
+
+  while( my $line = <$fh> ) {
+    my $where = "$file:$.";
+
+    $line =~ s/\r?\n$//;
+
+    if( $line =~ /^\s*defm\s+"([^"]*)"/i ) {
+      push( @$items, { bytes => [ map { ord } split( //, $1 ) ] } );
+      next;
+    }
+
+    $line =~ s/;.*//;
+    next if $line =~ /^\s*$/;
+
+    if( $line =~ /^\s*(SECTION|ORG|PUBLIC)\b/i ) {
+      $line =~ s/^\s+|\s+$//g;
+      push( @$items, { line => $line } );
+    }
+    elsif( $line =~ /^\s*\.(_\w+)\s*$/ || $line =~ /^\s*(_\w+):\s*$/ ) {
+      push( @$items, { line => ".$1", label => $1 } );
+    }
+    elsif( $line =~ /^\s*INCLUDE\s+"([^"]+)"\s*$/i ) {
+      read_asm( "$dir/$1", $items );
+    }
+    elsif( $line =~ /^\s*defb\s+(.*?)\s*$/i ) {
+      push( @$items, { bytes => [ map { to_byte( $_, $where ) } split( /\s*,\s*/, $1 ) ] } );
+    }
+    else {
+      die "$where: don't know how to pack '$line'\n";
+    }
+  }
+
+  close( $fh );
+}
+
+# Split an SP1 print string into its control sequences and characters.
+# A repeat, with everything up to its end, is one token because it
+# can't be broken up.
+sub tokenise {
+  my ($label, @s) = @_;
+  my @tokens;
+
+  while( @s ) {
+    my $c = $s[0];
+    my $length;
+
+    if(    $c >= 0x20 )                 { $length = 1; }
+    elsif( $c >= 0x08 && $c <= 0x0d )   { $length = 1; }
+    elsif( $c >= 0x10 && $c <= 0x14 )   { $length = 2; }
+    elsif( $c == $SP1_AT )              { $length = 3; }
+    elsif( $c == 0x0e ) {
+      $length = 2;
+      $length++ while $length < @s && $s[$length] != 0x0f;
+      die "$label: repeat without an end\n" if $length == @s;
+      $length++;
+    }
+    else {
+      die sprintf( "%s: control code 0x%02X isn't understood\n", $label, $c );
+    }
+
+    die "$label: string ends in the middle of a control code\n" if $length > @s;
+    push( @tokens, [ splice( @s, 0, $length ) ] );
+  }
+
+  return @tokens;
+}
+
+sub is_colour { my ($t) = @_; return $t->[0] >= 0x10 && $t->[0] <= 0x14; }
+sub is_at     { my ($t) = @_; return $t->[0] == $SP1_AT; }
+
+# Turn a group of same coloured tiles, a hash of "y,x" => character, into
+# records. Runs come first, then whatever's left over.
+sub pack_tiles {
+  my ($tiles, $out) = @_;
+  my %done;
+  my @singles;
+
+  foreach my $cell ( sort { $a->[0] <=> $b->[0] || $a->[1] <=> $b->[1] }
+                     map { [ split( /,/ ) ] } keys %$tiles ) {
+    my ($y, $x) = @$cell;
+    next if $done{"$y,$x"};
+
+    my $c = $tiles->{"$y,$x"};
+    my ($h, $v) = (1, 1);
+    $h++ while $x+$h < 32 && !$done{"$y,".($x+$h)} && ($tiles->{"$y,".($x+$h)} // -1) == $c;
+    $v++ while !$done{($y+$v).",$x"} && ($tiles->{($y+$v).",$x"} // -1) == $c;
+
+    if( $v >= 2 && $v >= $h ) {
+      push( @$out, [ $LEVEL_MAP_VRUN, $y, $x, $c, $v ] );
+      $done{($y+$_).",$x"} = 1 foreach 0..$v-1;
+    }
+    elsif( $h >= 3 ) {
+      push( @$out, [ $LEVEL_MAP_HRUN, $y, $x, $c, $h ] );
+      $done{"$y,".($x+$_)} = 1 foreach 0..$h-1;
+    }
+    else {
+      push( @singles, [ $y, $x, $c ] );
+      $done{"$y,$x"} = 1;
+    }
+  }
+
+  # Tiles on their own are listed by character, two bytes each, unless
+  # there's just one of them
+  my %by_char;
+  push( @{$by_char{$_->[2]}}, $_ ) foreach @singles;
+
+  foreach my $c ( sort { $a <=> $b } keys %by_char ) {
+    my @cells = @{$by_char{$c}};
+
+    if( @cells == 1 ) {
+      push( @$out, [ $SP1_AT, $cells[0][0], $cells[0][1], $c ] );
+    }
+    else {
+      while( my @some = splice( @cells, 0, 255 ) ) {
+        push( @$out, [ $LEVEL_MAP_TILES, $c, scalar(@some), map { ( $_->[0], $_->[1] ) } @some ] );
+      }
+    }
+  }
+}
+
+# Pack one level map string, without its terminator
+sub pack_map {
+  my ($label, @s) = @_;
+  my @tokens = tokenise( $label, @s );
+  my @out;
+  my %tiles;
+
+  for( my $i = 0; $i < @tokens; $i++ ) {
+    my $t = $tokens[$i];
+
+    if( is_at( $t ) && $i+1 < @tokens && @{$tokens[$i+1]} == 1 && $tokens[$i+1][0] >= 0x20 ) {
+      my $next = $i+2;
+      $next++ while $next < @tokens && is_colour( $tokens[$next] );
+
+      if( $next == @tokens || is_at( $tokens[$next] ) ) {
+        $tiles{"$t->[1],$t->[2]"} = $tokens[$i+1][0];
+        $i++;
+        next;
+      }
+    }
+
+    if( %tiles ) {
+      pack_tiles( \%tiles, \@out );
+      %tiles = ();
+    }
+    push( @out, $t );
+  }
+  pack_tiles( \%tiles, \@out ) if %tiles;
+
+  # Runs and tile lists are records of their own, everything else is
+  # gathered into strings which fit the unpacking buffer
+  my @packed;
+  my @string;
+  foreach my $t ( @out, undef ) {
+    my $record = defined($t) && $t->[0] < 0x08;
+
+    if( @string && ( !defined($t) || $record || @string + @$t > $LEVEL_MAP_BUFFER_SIZE ) ) {
+      push( @packed, $LEVEL_MAP_STRING, scalar(@string), @string );
+      @string = ();
+    }
+    last unless defined($t);
+
+    if( $record ) {
+      push( @packed, @$t );
+    }
+    else {
+      die "$label: a control sequence is too long to unpack\n" if @$t > $LEVEL_MAP_BUFFER_SIZE;
+      push( @string, @$t );
+    }
+  }
+
+  return @packed;
+}
+
+# Not when compile_level.pl is loading it
+unless( caller ) {
+  die "Usage: $0 levels_maps.asm\n" unless @ARGV == 1;
+
+  my @items;
+  read_asm( $ARGV[0], \@items );
+
+  # Gather the bytes which follow each label
+  my @output;
+  my $current;
+  foreach my $item ( @items ) {
+    if( exists $item->{bytes} ) {
+      die "$ARGV[0]: bytes before the first label\n" unless defined($current);
+      push( @{$current->{bytes}}, @{$item->{bytes}} );
+    }
+    else {
+      if( exists $item->{label} ) {
+        $current = { %$item, bytes => [] };
+        push( @output, $current );
+      }
+      else {
+        push( @output, $item );
+      }
+    }
+  }
+
+  print ";; Generated from $ARGV[0] by $0, don't edit\n\n";
+  foreach my $item ( @output ) {
+    print "$item->{line}\n";
+
+    my @s = @{$item->{bytes} // []};
+    next unless @s;
+
+    my $label = $item->{label};
+    die "$label: map isn't zero terminated\n" unless $s[-1] == 0;
+    pop( @s );
+
+    my @packed = ( pack_map( $label, @s ), 0x00 );
+    printf STDERR "%-20s %4d -> %4d bytes\n", $label, scalar(@s)+1, scalar(@packed);
+
+    while( my @line = splice( @packed, 0, 16 ) ) {
+      print "        defb ", join( ", ", map { sprintf( "0x%02X", $_ ) } @line ), "\n";
+    }
+  }
+}
+
+1;
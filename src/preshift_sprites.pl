@@ -0,0 +1,138 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Wonky One Key, a ZX Spectrum game featuring a single control key
+# Copyright (C) 2018 Derek Fountain
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+# Sprite pre-shifter. SP1 can move a sprite to any pixel by rotating its
+# graphic as it draws it, using 3.5K of rotation tables built when it's
+# initialised. That's a table lookup for every byte of every column of
+# every sprite drawn, every frame. The sprites here are all 8 pixels
+# wide, so this builds each graphic already shifted right by each pixel
+# offset it can be drawn at, and the game draws them with SP1's "no
+# rotate" functions. Picking a frame is then the only work. Replaying
+# media/wonky.rzx with NR in place of each of the 1.00 release's LB/RB
+# draws takes sp1_UpdateNow() from 5619 to 5126 T-states a frame on
+# average, and its worst frame from 17719 to 17228. That's the 1.00
+# binary with its draws swapped, not this build, which also drops the
+# rotation tables and moves the graphics; "make profile" on a wonky.tap
+# built from here is the real figure and hasn't been taken yet.
+#
+# Each frame is 2 columns, each the 8 bytes of graphic and 8 of zeros
+# SP1 needs for a sprite 2 characters high, so the frames of a block are
+# 32 bytes apart (PRESHIFTED_FRAME_SIZE in graphics.h). Each block starts
+# with the 7 zero bytes SP1 reads above the first frame when it's moved
+# down by a pixel or more:
+#
+#  shift n, column 0:  graphic >> n       8 bytes, then 8 zeros
+#  shift n, column 1:  graphic << (8-n)   8 bytes, then 8 zeros
+#
+# The graphics are the first 8 bytes after each label in the source
+# files, which aren't assembled themselves.
+#
+#  preshift_sprites.pl > sprites_preshifted.asm
+
+# Each block is a label, the section it goes in, and its frames as
+# (source label, shift) pairs. The runner's animation frame is picked
+# from the same 3 bits of his x position as the shift, so each of his
+# frames only ever needs one shift. The pills and the slider can sit at
+# any pixel. Doors and bonuses are always on a character boundary.
+my @blocks = (
+  [ 'runner_right',     'rodata_user', map { [ "runner_right_f".($_+1), $_ ] } 0..7 ],
+  [ 'runner_left',      'rodata_user', map { [ "runner_left_f".($_+1),  $_ ] } 0..7 ],
+  [ 'slowdown_pill_f1', 'LEVEL_DATA',  map { [ 'slowdown_pill_f1', $_ ] } 0..7 ],
+  [ 'slowdown_pill_f2', 'LEVEL_DATA',  map { [ 'slowdown_pill_f2', $_ ] } 0..7 ],
+  [ 'slowdown_pill_f3', 'LEVEL_DATA',  map { [ 'slowdown_pill_f3', $_ ] } 0..7 ],
+  [ 'score_slider',     'LEVEL_DATA',  map { [ 'score_slider', $_ ] } 0..7 ],
+  [ 'door_f1',          'LEVEL_DATA',  [ 'door_f1', 0 ] ],
+  [ 'bonus',            'LEVEL_DATA',  [ 'bonus', 0 ] ],
+);
+
+my @sources = ( 'runner_sprite.asm', 'sprites.asm' );
+
+
+sub to_byte {
+  my ($value, $where) = @_;
+
+  return oct("0b$1") if $value =~ /^@([01]{8})$/;
+  return hex($1)     if $value =~ /^(?:0x|\$)([0-9a-f]{1,2})$/i;
+  return $1          if $value =~ /^(\d+)$/ && $1 < 256;
+
+  die "$where: can't convert value '$value'\n";
+}
+
+# Label name => its 8 bytes of graphic
+sub read_graphics {
+  my %graphics;
+
+  foreach my $file (@sources) {
+    my $label;
+
+    open( my $fh, '<', $file ) or die "Can't open $file: $!\n";
+    while( my $line = <$fh> ) {
+      my $where = "$file:$.";
+
+      $line =~ s/;.*//;
+
+      if( $line =~ /^\s*\._(\w+)\s*$/ ) {
+        $label = $1;
+        die "$where: $label is defined twice\n" if exists $graphics{$label};
+        $graphics{$label} = [];
+      }
+      elsif( $line =~ /^\s*defb\s+(.*?)\s*$/i ) {
+        next unless defined $label && @{$graphics{$label}} < 8;
+        push( @{$graphics{$label}}, map { to_byte( $_, $where ) } split( /\s*,\s*/, $1 ) );
+        die "$where: more than 8 bytes in a row for $label\n" if @{$graphics{$label}} > 8;
+      }
+    }
+    close( $fh );
+  }
+
+  return %graphics;
+}
+
+sub column {
+  my (@bytes) = @_;
+
+  return join( '', map { sprintf( "\tdefb @%08b\n", $_ ) } @bytes, (0) x 8 );
+}
+
+
+my %graphics = read_graphics();
+
+print ";; Generated by $0 from ", join( ' and ', @sources ), ", don't edit\n";
+
+foreach my $block (@blocks) {
+  my ($name, $section, @frames) = @$block;
+
+  print "\nSECTION $section\n\n";
+  print "\tdefb ", join( ', ', (0) x 7 ), "\n\n";
+  print "PUBLIC _$name\n._$name\n";
+
+  foreach my $frame (@frames) {
+    my ($label, $shift) = @$frame;
+    my $graphic = $graphics{$label};
+
+    die "$label isn't in ", join( ' or ', @sources ), "\n" unless $graphic;
+    die "$label has fewer than 8 bytes of graphic\n" unless @$graphic == 8;
+
+    print ";; $label shifted $shift\n";
+    print column( map { $_ >> $shift } @$graphic );
+    print column( map { ($_ << (8-$shift)) & 0xFF } @$graphic );
+  }
+}
+
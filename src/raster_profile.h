@@ -0,0 +1,102 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __RASTER_PROFILE_H
+#define __RASTER_PROFILE_H
+
+#include <arch/zx.h>
+#include <stdint.h>
+#include <z80.h>
+
+#include "int.h"
+
+/*
+ * Raster bar profiler. In a build made with RASTER_PROFILE=1 the game
+ * loop changes the border colour as it starts each phase of its work,
+ * so the border shows, on any emulator or a real machine, how far down
+ * the 20ms frame each phase takes it. Black is time spent waiting at
+ * the halt, which is what's left over. A frame which was missed shows
+ * its wait in yellow, and is counted.
+ *
+ * The border is written straight to the ULA port, without z88dk's copy
+ * of it, so the beeper code in the ISR puts it back to the level's own
+ * colour while it plays. Time in the ISR shows in that colour.
+ *
+ * It's off by default and compiles to nothing. Changing it needs a
+ * make clean.
+ */
+#ifndef RASTER_PROFILE
+#define RASTER_PROFILE        0
+#endif
+
+#define RASTER_INPUT          INK_WHITE
+#define RASTER_ACTION_EVEN    INK_BLUE
+#define RASTER_ACTION_ODD     INK_RED
+#define RASTER_DRAW_RUNNER    INK_MAGENTA
+#define RASTER_HUD            INK_GREEN
+#define RASTER_SP1_UPDATE     INK_CYAN
+#define RASTER_HALT           INK_BLACK
+#define RASTER_HALT_OVERRUN   INK_YELLOW
+
+#if RASTER_PROFILE
+
+#define RASTER_ULA_PORT       0xFE
+
+/*
+ * Number of times round the game loop which took more than a frame.
+ * It's not static so it can be watched from a debugger with wonky.sym.
+ */
+extern uint16_t raster_overruns;
+
+#define RASTER_PHASE(colour)  z80_outp( RASTER_ULA_PORT, (colour) )
+
+/*
+ * Each game_actions[] entry that runs gets the other colour of the pair
+ * from the one before it, so they show as separate bands.
+ */
+#define RASTER_ACTION(action_iter) \
+  RASTER_PHASE( ((action_iter) & 1) ? RASTER_ACTION_ODD : RASTER_ACTION_EVEN )
+
+/*
+ * Start of the wait at the halt. The frame started when the last halt
+ * returned; if the ticker has moved on since then the interrupt has been
+ * and gone, the halt will wait for the next one, and this frame's been
+ * missed. The wait is shown in yellow instead of black when that happens.
+ */
+#define RASTER_HALT_START(frame_start) { \
+    if( GET_FRAME_TICKER != (frame_start) ) { \
+      raster_overruns++; \
+      RASTER_PHASE( RASTER_HALT_OVERRUN ); \
+    } else { \
+      RASTER_PHASE( RASTER_HALT ); \
+    } \
+}
+
+#define RASTER_FRAME_START(frame_start)  (frame_start) = GET_FRAME_TICKER
+
+#else
+
+#define RASTER_PHASE(colour)
+#define RASTER_ACTION(action_iter)
+#define RASTER_HALT_START(frame_start)
+#define RASTER_FRAME_START(frame_start)
+
+#endif
+
+#endif
@@ -30,23 +30,9 @@
 #include "collision.h"
 #include "graphics.h"
 
-extern uint8_t runner_right_f1[];
-extern uint8_t runner_right_f2[];
-extern uint8_t runner_right_f3[];
-extern uint8_t runner_right_f4[];
-extern uint8_t runner_right_f5[];
-extern uint8_t runner_right_f6[];
-extern uint8_t runner_right_f7[];
-extern uint8_t runner_right_f8[];
-
-extern uint8_t runner_left_f1[];
-extern uint8_t runner_left_f2[];
-extern uint8_t runner_left_f3[];
-extern uint8_t runner_left_f4[];
-extern uint8_t runner_left_f5[];
-extern uint8_t runner_left_f6[];
-extern uint8_t runner_left_f7[];
-extern uint8_t runner_left_f8[];
+/* Pre-shifted frames, built from runner_sprite.asm */
+extern uint8_t runner_right[];
+extern uint8_t runner_left[];
 
 /***
  *      _______             _             
@@ -73,6 +59,7 @@ typedef enum _runner_tracetype
 typedef struct _runner_trace
 {
   uint16_t           ticker;
+  uint8_t            frame_seq;
   RUNNER_TRACETYPE   tracetype;
   uint8_t            xpos;
   uint8_t            ypos;
@@ -84,7 +71,9 @@ typedef struct _runner_trace
 #define RUNNER_TRACE_ENTRIES 50
 #define RUNNER_TRACETABLE_SIZE ((size_t)sizeof(RUNNER_TRACE)*RUNNER_TRACE_ENTRIES)
 
-TRACE_FN( runner, RUNNER_TRACE, RUNNER_TRACETABLE_SIZE )
+#if RUNNER_TRACING
+
+TRACE_TABLE( runner, RUNNER_TRACE )
 
 void init_runner_trace(void)
 {
@@ -96,20 +85,26 @@ void init_runner_trace(void)
  * but since this one is called several times a function is more
  * economical.
  */
-void RUNNER_TRACE_CREATE( RUNNER_TRACETYPE ttype, uint8_t x, uint8_t y, int8_t yd, uint8_t sd )
+static void RUNNER_TRACE_CREATE( RUNNER_TRACETYPE ttype, uint8_t x, uint8_t y, int8_t yd, uint8_t sd )
 {
   if( runner_tracetable != TRACING_INACTIVE ) {
-    RUNNER_TRACE  rt;             
-    rt.ticker          = GET_TICKER;                    
-    rt.tracetype       = ttype; 
-    rt.xpos            = x;      
-    rt.ypos            = y;       
-    rt.slowdown_active = sd;      
-    rt.ydelta          = yd;         
-    runner_add_trace(&rt);                      
-  }                                             
+    RUNNER_TRACE* rt = TRACE_ENTRY(runner);
+    TRACE_STAMP(runner, rt);
+    rt->tracetype       = ttype;
+    rt->xpos            = x;
+    rt->ypos            = y;
+    rt->slowdown_active = sd;
+    rt->ydelta          = yd;
+    TRACE_ADVANCE(runner, RUNNER_TRACETABLE_SIZE);
+  }
 }
 
+#else
+
+#define RUNNER_TRACE_CREATE(ttype,x,y,yd,sd)
+
+#endif
+
 /***
  *           _                        __     __   ____   __  __          _       
  *          | |                       \ \   / /  / __ \ / _|/ _|        | |      
@@ -131,27 +126,6 @@ const int8_t jump_y_offsets[40] =  { 2,  2,  2,  2,    2,  1,  1,  1,
                                      0, -1, -1, -1,   -1, -1, -1, -1,
                                     -1, -1, -1, -2,   -2, -2, -2, -2 };
 
-/*
- * Size in bytes of one frame of the runner sprite graphic. It's currently
- * bytes of data plus 8 bytes of padding.
- *
- * For flexibility I want to do something like:
- *
- *  static const uint16_t runner_frame_size = runner_right_f2-runner_right_f1;
- *
- * but the compiler complains that those values aren't constants. So maybe
- * there's a way to export a DEFC'ed value from the assembler to the C?
- * I can't find a way to do that either. So for now use a hard coded constant.
- *
- * Futhermore, this:
- *
- *   static const uint16_t runner_frame_size = 16;
- * 
- * actually compiles to a value held in memory, which is a bit crap.
- * Using a constant of 16 compiles to 4 'add hl,hl' instructions.
- */
-#define RUNNER_FRAME_SIZE (uint16_t)16
-
 
 /*
  * Structure to look after the runner character.
@@ -172,14 +146,14 @@ RUNNER runner;
 
 RUNNER* create_runner( void )
 {
-  runner.sprite = sp1_CreateSpr(SP1_DRAW_OR1LB, SP1_TYPE_1BYTE, 2, 0, RUNNER_PLANE);
-  sp1_AddColSpr(runner.sprite, SP1_DRAW_OR1RB, SP1_TYPE_1BYTE, 0, RUNNER_PLANE);
+  runner.sprite = sp1_CreateSpr(SP1_DRAW_OR1NR, SP1_TYPE_1BYTE, 2, 0, RUNNER_PLANE);
+  sp1_AddColSpr(runner.sprite, SP1_DRAW_OR1NR, SP1_TYPE_1BYTE, PRESHIFTED_COLUMN_1, RUNNER_PLANE);
 
   /*
-   * The sprite is actually 6 pixels wide, not 8, so it can be rotated
+   * The sprite is actually 6 pixels wide, not 8, so it can be shifted
    * 2 pixels horizontally without crossing into the next cell and requiring
    * the rightmost column to be drawn. The x-threshold is therefore 3:
-   * the rightmost column needs drawing if the sprite is rotated 3 more
+   * the rightmost column needs drawing if the sprite is shifted 3 more
    * more pixels.
    */
   runner.sprite->xthresh = 3;
@@ -196,6 +170,7 @@ void reset_runner( DIRECTION initial_direction )
   runner.slowdown    = FALSE;
 
   runner.jump_offset = NO_JUMP;
+  runner.jump_safe   = 0;
 }
 
 
@@ -204,13 +179,13 @@ static void initialiseColour(unsigned int count, struct sp1_cs *c)
 {
   (void)count;    /* Suppress compiler warning about unused parameter */
 
-  c->attr_mask = SP1_AMASK_INK|SP1_AMASK_PAPER;
+  c->attr_mask = SP1_AMASK_INK;
   c->attr      = required_colour;
 }
 
-void set_runner_colour( uint8_t new_att )
+void set_runner_colour( uint8_t new_ink )
 {
-  required_colour = new_att;
+  required_colour = new_ink;
   sp1_IterateSprChar(runner.sprite, initialiseColour);
 }
 
@@ -295,25 +270,27 @@ void draw_runner(void)
   uint16_t offset_to_frame;
 
   /*
-   * Frame number is calculated from the lowest 8 bits of the x position.
+   * Frame number is calculated from the lowest 3 bits of the x position.
    * This won't be flexible enough if the animation gets more complex
-   * but for now it's fast and simple.
+   * but for now it's fast and simple. It's the same 3 bits the sprite
+   * is shifted by, so each animation frame comes already shifted for the
+   * one pixel position it's drawn at, and SP1 doesn't have to rotate it.
    *
    * The calculation is, for example:
    * 
    *  frame_num   = x & 0x0007;
-   *  runner_data = runner_right_f1+(RUNNER_FRAME_SIZE*frame_num);
+   *  runner_data = runner_right+(PRESHIFTED_FRAME_SIZE*frame_num);
    *
    * The implementation below doesn't use the intermediate variable and
    * generates more succinct code.
    */
-  offset_to_frame = RUNNER_FRAME_SIZE * (runner.xpos & 0x0007);
+  offset_to_frame = PRESHIFTED_FRAME_SIZE * (runner.xpos & 0x0007);
 
   if( runner.facing == RIGHT ) {
-    runner_data = runner_right_f1+offset_to_frame;
+    runner_data = runner_right+offset_to_frame;
   }
   else {
-    runner_data = runner_left_f1+offset_to_frame;
+    runner_data = runner_left+offset_to_frame;
   }
 
   sp1_MoveSprPix(runner.sprite, &full_screen, runner_data, runner.xpos, runner.ypos);
@@ -338,6 +315,11 @@ void toggle_runner_direction(void)
   if( RUNNER_JUMPING(runner.jump_offset) )
     if( runner.jump_offset && (runner.jump_offset < sizeof(jump_y_offsets)/2) )
       runner.jump_offset = sizeof(jump_y_offsets) - runner.jump_offset;
+
+#if JUMP_TABLES
+  /* The rest of the jump isn't the one in the tables now */
+  runner.jump_safe = 0;
+#endif
 }
 
 
@@ -349,6 +331,24 @@ void start_runner_jumping(void)
 }
 
 
+#if JUMP_TABLES
+void look_up_jump_safe( uint8_t level_num )
+{
+  const JUMP_TABLE_ENTRY* entry;
+
+  for( entry = jump_tables; entry->level_num != JUMP_TABLE_END; entry++ ) {
+    if( (entry->level_num == level_num) && (entry->ypos == runner.ypos)
+        && (runner.xpos >= entry->first_xpos) && (runner.xpos <= entry->last_xpos) ) {
+      runner.jump_safe = entry->safe_offset[runner.facing];
+      return;
+    }
+  }
+
+  runner.jump_safe = 0;
+}
+#endif
+
+
 void stop_runner_jumping(void)
 {
   runner.jump_offset = NO_JUMP;
@@ -24,6 +24,8 @@
 
 #include "action.h"
 #include "slowdown_pill.h"
+#include "tracetable.h"
+#include "jump_tables.h"
 
 /*
  * Jump offset value is an index into an array. This value
@@ -45,6 +47,9 @@
 #define RUNNER_CENTRE_X(x) (x+3)
 #define RUNNER_CENTRE_Y(y) (y+4)
 
+#define RUNNER_WIDTH       6
+#define RUNNER_HEIGHT      8
+
 /*
  * Directions. Up and down may be added at some point.
  * This is currently only used for the runner, hence it's
@@ -90,6 +95,9 @@ typedef struct _runner
   uint8_t          jump_offset;
 
   SLOWDOWN_STATUS  slowdown;
+
+  /* Collision probing starts at this jump offset, see jump_tables.h */
+  uint8_t          jump_safe;
 } RUNNER;
 
 
@@ -131,7 +139,11 @@ JUMP_STATUS     get_runner_jump_status(void);
 /*
  * Initialise trace table for runner
  */
+#if RUNNER_TRACING
 void init_runner_trace(void);
+#else
+#define init_runner_trace()
+#endif
 
 /*
  * Adjust the runner's screen position depending on where he
@@ -5,6 +5,9 @@
 ;; and the original copyright therefore remains.
 ;;
 ;; (C) Copyright Derek Fountain 2018
+;;
+;; This file isn't assembled. preshift_sprites.pl reads the frames and
+;; builds the pre-shifted ones the game draws.
 	
 SECTION rodata_user
 
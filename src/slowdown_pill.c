@@ -19,7 +19,6 @@
 
 #include <stdint.h>
 #include <arch/zx/sp1.h>
-#include <sound.h>
 
 #include "utils.h"
 #include "int.h"
@@ -55,6 +54,7 @@ typedef enum _slowdown_tracetype
 typedef struct _slowdown_trace
 {
   uint16_t           ticker;
+  uint8_t            frame_seq;
   SLOWDOWN_TRACETYPE tracetype;
   SLOWDOWN*          slowdown;
   uint8_t            num_active_slowdowns;
@@ -65,29 +65,37 @@ typedef struct _slowdown_trace
 #define SLOWDOWN_TRACE_ENTRIES 120
 #define SLOWDOWN_TRACETABLE_SIZE ((size_t)sizeof(SLOWDOWN_TRACE)*SLOWDOWN_TRACE_ENTRIES)
 
+#if SLOWDOWN_TRACING
+
 /* It's quicker to do this with a macro, as long as it's only used once or twice */
 #define SLOWDOWN_TRACE_CREATE(ttype,sptr,n,d) {     \
     if( slowdown_tracetable != TRACING_INACTIVE ) { \
-      SLOWDOWN_TRACE            st;   \
-      st.ticker               = GET_TICKER; \
-      st.tracetype            = ttype; \
-      st.slowdown             = sptr; \
-      st.num_active_slowdowns = n; \
-      st.slowdowns_disabled   = d; \
-      slowdown_add_trace(&st); \
+      SLOWDOWN_TRACE*           st = TRACE_ENTRY(slowdown);   \
+      TRACE_STAMP(slowdown, st); \
+      st->tracetype            = ttype; \
+      st->slowdown             = sptr; \
+      st->num_active_slowdowns = n; \
+      st->slowdowns_disabled   = d; \
+      TRACE_ADVANCE(slowdown, SLOWDOWN_TRACETABLE_SIZE); \
     } \
 }
 
-TRACE_FN( slowdown, SLOWDOWN_TRACE, SLOWDOWN_TRACETABLE_SIZE )
+TRACE_TABLE( slowdown, SLOWDOWN_TRACE )
 
 void init_slowdown_trace(void)
 {
   slowdown_tracetable = slowdown_next_trace = allocate_tracememory(SLOWDOWN_TRACETABLE_SIZE);
 }
 
+#else
+
+#define SLOWDOWN_TRACE_CREATE(ttype,sptr,n,d)
+
+#endif
 
 
-/* These are in the assembly language file */
+
+/* Pre-shifted frames, built from sprites.asm */
 extern uint8_t slowdown_pill_f1[];
 extern uint8_t slowdown_pill_f2[];
 extern uint8_t slowdown_pill_f3[];
@@ -121,8 +129,9 @@ void create_slowdown_pill( SLOWDOWN* slowdown )
   slowdown->frame     = 0;
   slowdown->expanding = 1;
   SET_COLLECTABLE_AVAILABLE(slowdown->collectable,COLLECTABLE_AVAILABLE);
-  slowdown->sprite    = sp1_CreateSpr(SP1_DRAW_OR1LB, SP1_TYPE_1BYTE, 2, 0, SLOWDOWN_PILL_PLANE);
-  sp1_AddColSpr(slowdown->sprite, SP1_DRAW_OR1RB, SP1_TYPE_1BYTE, 0, SLOWDOWN_PILL_PLANE);
+  register_collectable(&(slowdown->collectable));
+  slowdown->sprite    = sp1_CreateSpr(SP1_DRAW_OR1NR, SP1_TYPE_1BYTE, 2, 0, SLOWDOWN_PILL_PLANE);
+  sp1_AddColSpr(slowdown->sprite, SP1_DRAW_OR1NR, SP1_TYPE_1BYTE, PRESHIFTED_COLUMN_1, SLOWDOWN_PILL_PLANE);
 
   SLOWDOWN_TRACE_CREATE(SLOWDOWN_CREATED,slowdown,num_active_slowdowns,slowdowns_disabled);
 
@@ -138,7 +147,7 @@ void create_slowdown_pill( SLOWDOWN* slowdown )
                           255,255);
   else
     sp1_MoveSprPix_callee(slowdown->sprite, &full_screen,
-                          (void*)slowdown_pill_f1,
+                          PRESHIFTED_FRAME(slowdown_pill_f1, slowdown->collectable.x),
                           SLOWDOWN_SCREEN_LOCATION(slowdown));
 
   COLLECTABLE_TRACE_CREATE( COLLECTABLE_CREATED, &(slowdown->collectable), 0, 0 );
@@ -238,9 +247,9 @@ void animate_slowdown_pill( SLOWDOWN* slowdown )
       }
     }
 
-    /* Set the correct graphic on the pill sprite */
+    /* Set the correct graphic on the pill sprite, shifted to where it is */
     sp1_MoveSprPix_callee(slowdown->sprite, &full_screen,
-                          next_frame,
+                          PRESHIFTED_FRAME(next_frame, slowdown->collectable.x),
                           SLOWDOWN_SCREEN_LOCATION(slowdown));
 
     SLOWDOWN_TRACE_CREATE(SLOWDOWN_ANIMATED,slowdown,num_active_slowdowns,slowdowns_disabled);
@@ -265,6 +274,7 @@ void slowdown_collected(COLLECTABLE* collectable, void* data)
   (void)collectable;
 
   SET_COLLECTABLE_AVAILABLE(slowdown->collectable,COLLECTABLE_NOT_AVAILABLE);
+  rebuild_collectable_triggers();
 
   /*
    * Bit of a design breakage here. Updating screen data in a collectable
@@ -278,7 +288,7 @@ void slowdown_collected(COLLECTABLE* collectable, void* data)
   START_COLLECTABLE_TIMER(slowdown->collectable,slowdown->duration_secs);
 
   lose_bonus();
-  queue_beepfx_sound(BEEPFX_JUMP_2);
+  start_sound_effect(EFFECT_SLOWDOWN);
   SET_RUNNER_SLOWDOWN( SLOWDOWN_ACTIVE );
 
   COLLECTABLE_TRACE_CREATE( COLLECTABLE_COLLECTED, &(slowdown->collectable), GET_RUNNER_XPOS, GET_RUNNER_YPOS );
@@ -293,6 +303,7 @@ uint8_t slowdown_timeup(COLLECTABLE* collectable, void* data)
   (void)collectable;
 
   SET_COLLECTABLE_AVAILABLE(slowdown->collectable,COLLECTABLE_AVAILABLE);
+  rebuild_collectable_triggers();
 
   /*
    * Update screen. This should really be done in the gameloop
@@ -21,6 +21,7 @@
 #define __SLOWDOWN_PILL_H
 
 #include "collectable.h"
+#include "tracetable.h"
 
 typedef enum _slowdown_status
 {
@@ -58,7 +59,11 @@ extern uint8_t slowdowns_disabled;
  */
 #define IS_VALID_SLOWDOWN(slowdown) (IS_VALID_COLLECTABLE(slowdown->collectable))
 
+#if SLOWDOWN_TRACING
 void init_slowdown_trace(void);
+#else
+#define init_slowdown_trace()
+#endif
 
 void create_slowdown_pill( SLOWDOWN* slowdown );
 void destroy_slowdown_pill( SLOWDOWN* slowdown );
@@ -19,16 +19,20 @@
 
 #include <stdint.h>
 #include <sound.h>
+#include <z80.h>
+#include <intrinsic.h>
 #include "key_action.h"
 #include "int.h"
 #include "runner.h"
+#include "action.h"
+#include "sound.h"
 
 /*
  * The low level music note player routine in background_music.asm was stolen
  * from Manic Miner and adapted to run from C. I looked at the music data from
  * Manic Miner and reverse engineered the notes the data plays from sheet music.
- * Each note lasts 8.8ms and each one is repeated, so in fact each note lasts
- * 17.6ms.
+ * Each note is played for 8.8ms in total, in slices, and each one is repeated,
+ * so in fact each note lasts 17.6ms.
  */
 
 #define _C     86, 86
@@ -83,122 +87,427 @@ static uint8_t  effects_on  = START_WITH_SOUND;
 static uint16_t music_current_note_index = 0;
 static uint8_t  slow_note                = 0;
 
-/* This is the low level speaker waggler, in ASM */
-void play_note_raw( uint8_t* pitch ) __z88dk_fastcall;
+/* Music only plays while the game loop is running, not on the other screens */
+static uint8_t  music_playing            = 0;
+
+/* These are the low level speaker wagglers, in ASM */
+void    play_note_slice( uint8_t* pitch ) __z88dk_fastcall;
+void    start_beepfx_effect( void* effect ) __z88dk_fastcall;
+uint8_t play_beepfx_slice( void );
 
 void toggle_music( void )
 {
   music_on = !music_on;
 }
 
-/*
- * Sounds are split into 4 cycles. A cycle is a 50th of a second, i.e. one
- * frame of the Spectrum's display. Each and every cycle does the usual game
- * stuff, but because sound is CPU intensive we can't play sounds every cycle,
- * and we can't play both a music note and a sound effect in one cycle.
- * So, the spare time in every 4th cycle is handed over to playing background
- * music. The spare time in every other 4th cycle is handed over to playing
- * sound effects. There are 2 other cycles where the spare time is currently
- * not used.
- */
-#define UNUSED_CYCLE_1         0x000
-#define BACKGROUND_MUSIC_CYCLE 0x001
-#define UNUSED_CYCLE_2         0x002
-#define SOUND_EFFECT_CYCLE     0x003
-
-PROCESSING_FLAG play_bg_music_note( void* data, GAME_ACTION* output_action )
+void start_background_music( void )
 {
-  (void)data;
+  music_playing = 1;
+}
 
-  *output_action = NO_ACTION;
+void stop_background_music( void )
+{
+  music_playing = 0;
+}
 
-  /*
-   * Play a note every 4 game cycles. i.e. the game runs at 50fps, a note of music
-   * is played every 4 of those. Each note lasts 8.8ms so every 4th game cycle
-   * needs to complete in 11ms to ensure a frame isn't dropped. This currently
-   * isn't a problem.
-   */
-  if( music_on && ((GET_TICKER & 0x0003) == BACKGROUND_MUSIC_CYCLE) )
-  {
-    play_note_raw( &(music_notes[music_current_note_index]) );
 
-    if( GET_RUNNER_SLOWDOWN )
-    {
-      slow_note = !slow_note;
-      if( !slow_note )
-        music_current_note_index++;
-    }
-    else
-    {
-      slow_note = 0;
-      music_current_note_index++;
-    }
+/***
+ *      ______  __  __           _
+ *     |  ____|/ _|/ _|         | |
+ *     | |__  | |_| |_ ___  ___| |_ ___
+ *     |  __| |  _|  _/ _ \/ __| __/ __|
+ *     | |____| | | ||  __| (__| |_\__ \
+ *     |______|_| |_| \___|\___|\__|___/
+ *
+ * Sound effects are beepfx effects from Shiru:
+ *
+ *   https://shiru.untergrund.net/software.shtml
+ *
+ * which have been ported into Z88DK. They used to be played by bit_beepfx
+ * from the game loop, which runs the whole effect in one go, so anything
+ * longer than about 10ms dropped a frame, and the level end ones stopped
+ * the game dead while they played.
+ *
+ * Now the ISR plays them alongside the music. On the beeper the effect's
+ * data is run a slice at a time by play_beepfx_slice() in
+ * background_music.asm, which takes the place of that frame's music
+ * slice, so a frame never pays for more than one slice. On the AY the
+ * same data is played on channel B, at the speed bit_beepfx played it,
+ * see ay_effect_frame().
+ *
+ * Only one effect plays at a time. A new one replaces the one playing
+ * unless that one has a higher priority, so a bounce can't cut off the
+ * level finish.
+ */
+typedef struct _effect_definition
+{
+  void*    beepfx;      /* The beepfx effect, played on the beeper or the AY */
+  uint8_t  priority;
+} EFFECT_DEFINITION;
 
-    if( music_current_note_index == MUSIC_NUM_NOTES )
-      music_current_note_index = 0;
+/* In SOUND_EFFECT order */
+static const EFFECT_DEFINITION effect_definitions[] = {
+  { BEEPFX_PICK,      0 },   /* EFFECT_BOUNCE   */
+  { BEEPFX_SHOT_1,    0 },   /* EFFECT_JUMP     */
+  { BEEPFX_JUMP_2,    1 },   /* EFFECT_SLOWDOWN */
+  { BEEPFX_SELECT_3,  2 },   /* EFFECT_TELEPORT */
+  { BEEPFX_SELECT_6,  3 },   /* EFFECT_FINISH   */
+  { BEEPFX_POWER_OFF, 3 },   /* EFFECT_LOSE     */
+};
 
-    /*
-     * The action of playing a note is already done, so this just causes
-     * the main gameloop to trace the fact.
-     */
-    *output_action = MUSIC_NOTE;
-  }
+/*
+ * Effect the main code wants started, as 1 + its SOUND_EFFECT value, or 0.
+ * It's a byte so the ISR can't see it half written.
+ */
+static volatile uint8_t effect_request = 0;
+
+/*
+ * The effect the ISR is playing, and where the AY's got to with it. The
+ * pointer's volatile because wait_for_sound_effect() watches it.
+ */
+static const EFFECT_DEFINITION* volatile effect = 0;
+static const uint8_t*           ay_block;          /* Tone block being played */
+static uint16_t                 ay_block_frames;   /* beepfx frames left in it */
+static uint16_t                 ay_frame_left;     /* Times round the loop left in this one */
+static uint16_t                 ay_frequency;
+static uint8_t                  ay_duty;
+
+/*
+ * Ask for an effect. It starts at the next interrupt. If two are asked
+ * for before then, the higher priority one wins.
+ */
+void start_sound_effect( SOUND_EFFECT sound_effect )
+{
+  uint8_t request = effect_request;
 
-  return KEEP_PROCESSING;
+  if( !effects_on )
+    return;
+
+  if( !request ||
+      (effect_definitions[sound_effect].priority >= effect_definitions[request-1].priority) )
+    effect_request = sound_effect+1;
+}
 
+void toggle_sound_effects( void )
+{
+  effects_on = !effects_on;
+  effect_request = 0;
 }
 
 /*
- * Sound effects use the beepfx engine from Shuru:
- *
- *   https://shiru.untergrund.net/software.shtml
- *
- * which has been ported into Z88DK.
- *
- * There are lots of good effects, and the editor works in Windows 7 so
- * creating more is possible. The problem is that if the effect lasts
- * longer than about 10ms the game skips a frame which is rather obvious
- * and effects game play. So until I get to doing multi frame sound effects
- * the effects used are the very short ones. :)
+ * The level finish and lose effects are asked for as the game loop ends.
+ * Left to the ISR they'd carry on into the next level, or over the
+ * winner and loser screens' own effects, so the level waits for them
+ * the way it did when they were played in one go.
+ */
+void wait_for_sound_effect( void )
+{
+  while( effect_request || effect )
+    intrinsic_halt();
+}
+
+
+/***
+ *               __     __
+ *         /\    \ \   / /
+ *        /  \    \ \_/ /
+ *       / /\ \    \   /
+ *      / ____ \    | |
+ *     /_/    \_\   |_|
  *
- * Sound effects are put into a queue, which is currently of length 1. :)
- * It's still important though, because the effect can only be played during
- * the correct cycle which is something the play function takes into account.
+ * 128K machines have an AY-3-8912 sound chip. If there's one, music goes
+ * on channel A and effects on channel B. The ISR writes the registers
+ * once per frame and the chip does the rest, so sound costs next to no
+ * CPU. The beeper code remains for 48K machines.
  *
- * There's a immediate play function too which is used on the odd occasion
- * when sound needs to play immediately, like end of level or teleport.
+ * All AY writes happen in the ISR. Selecting a register then writing it
+ * is two OUTs, and an interrupt between them would leave the main code
+ * writing whichever register the ISR last selected.
  */
-void* pending_sound = 0;
-void queue_beepfx_sound( void* sound )
+#define AY_REGISTER_PORT   0xFFFD
+#define AY_DATA_PORT       0xBFFD
+
+#define AY_TONE_A_FINE     0
+#define AY_TONE_A_COARSE   1
+#define AY_TONE_B_FINE     2
+#define AY_TONE_B_COARSE   3
+#define AY_MIXER           7
+#define AY_VOLUME_A        8
+#define AY_VOLUME_B        9
+
+/* Mixer bits disable. Tone on A and B */
+#define AY_MIXER_TONE_B    0x3C
+
+/*
+ * The beeper note values are delay loop counts, about 40 T-states per
+ * loop and a speaker toggle every count loops. This converts one to the
+ * AY tone period of the same pitch with the 128K's 1.77MHz AY clock.
+ */
+#define AY_TONE_PERIOD(n)  ((uint16_t)(((uint16_t)(n)*81)>>5))
+
+/* Music notes start at this volume and fade over the 4 cycles they last */
+#define AY_MUSIC_VOLUME    12
+#define AY_MUSIC_FADE      3
+
+/*
+ * A beepfx tone block is the type, then words of frames, frame length,
+ * frequency and slide, then bytes of duty and duty change.
+ */
+#define BEEPFX_TONE            1
+#define BEEPFX_FRAMES          1
+#define BEEPFX_FRAME_LENGTH    3
+#define BEEPFX_FREQUENCY       5
+#define BEEPFX_SLIDE           7
+#define BEEPFX_DUTY            9
+#define BEEPFX_DUTY_CHANGE     10
+#define BEEPFX_TONE_BLOCK_SIZE 11
+
+#define BEEPFX_WORD(block,offset) (*(const uint16_t*)((block)+(offset)))
+
+/*
+ * bit_beepfx's tone loop is 79 T-states and adds the frequency to a 16
+ * bit phase each time round. The speaker's on while the phase's high
+ * byte is below the duty. So the pitch has a period of 65536/frequency
+ * times round, and the 128K's AY clock is half the CPU's, so the AY tone
+ * period of the same pitch is 79*65536/32/frequency. A frame of the
+ * 128K, 70908 T-states, is 898 times round.
+ */
+#define BEEPFX_AY_PERIOD       161792UL
+#define BEEPFX_LOOPS_PER_FRAME 898
+#define AY_MAX_TONE_PERIOD     0x0FFF
+
+static uint8_t ay_present = 0;
+
+static void ay_write( uint8_t reg, uint8_t value )
 {
-  pending_sound = sound;
+  z80_outp( AY_REGISTER_PORT, reg );
+  z80_outp( AY_DATA_PORT, value );
 }
 
-void toggle_sound_effects( void )
+/*
+ * The AY's registers read back through the register port. A 48K has
+ * nothing there and reads back the floating bus, which won't give back
+ * both patterns. Called once at startup, before the ISR is running.
+ */
+void detect_sound_hardware( void )
 {
-  effects_on = !effects_on;
-  if( pending_sound )
-    pending_sound = 0;
+  ay_write( AY_TONE_A_FINE, 0x55 );
+  if( z80_inp( AY_REGISTER_PORT ) == 0x55 )
+  {
+    ay_write( AY_TONE_A_FINE, 0xAA );
+    if( z80_inp( AY_REGISTER_PORT ) == 0xAA )
+      ay_present = 1;
+  }
+
+  if( ay_present )
+  {
+    ay_write( AY_VOLUME_A, 0 );
+    ay_write( AY_VOLUME_B, 0 );
+    ay_write( AY_MIXER, AY_MIXER_TONE_B );
+  }
+}
+
+/*
+ * The current music note on channel A. ISR only. The volume fades over
+ * the note's 4 cycles, rather like the beeper's short burst then silence.
+ */
+static void ay_music_frame( void )
+{
+  uint16_t period = AY_TONE_PERIOD( music_notes[music_current_note_index] );
+  uint8_t  cycle  = ((uint8_t)ticker - (BACKGROUND_MUSIC_CYCLE+1)) & SOUND_CYCLE_MASK;
+
+  ay_write( AY_TONE_A_FINE,   (uint8_t)period );
+  ay_write( AY_TONE_A_COARSE, (uint8_t)(period>>8) );
+  ay_write( AY_VOLUME_A,      AY_MUSIC_VOLUME - (cycle*AY_MUSIC_FADE) );
 }
 
-PROCESSING_FLAG play_beepfx_sound( void* data, GAME_ACTION* output_action )
+/*
+ * Pick up the tone block at ay_block. Returns false if it isn't one,
+ * which ends the effect. None of the game's effects have noise or
+ * sample blocks.
+ */
+static uint8_t ay_load_block( void )
 {
-  (void)data;
+  if( *ay_block != BEEPFX_TONE || !BEEPFX_WORD( ay_block, BEEPFX_FRAME_LENGTH ) )
+    return 0;
 
-  *output_action = NO_ACTION;
+  ay_block_frames = BEEPFX_WORD( ay_block, BEEPFX_FRAMES );
+  ay_frame_left   = BEEPFX_WORD( ay_block, BEEPFX_FRAME_LENGTH );
+  ay_frequency    = BEEPFX_WORD( ay_block, BEEPFX_FREQUENCY );
+  ay_duty         = ay_block[BEEPFX_DUTY];
 
-  if( effects_on && pending_sound && ((GET_TICKER & 0x0003) == SOUND_EFFECT_CYCLE) )
+  return 1;
+}
+
+/*
+ * The current effect's beepfx data, a frame's worth at a time on channel
+ * B. ISR only. It goes through the data as bit_beepfx did, a beepfx
+ * frame of the loop then the slides, so the effect lasts as long as it
+ * used to, and plays the pitch it's got to by the end of the frame.
+ *
+ * The AY can only play a square wave. A narrower duty is a quieter, thinner
+ * sound on the beeper, so it's played quieter, 2 steps for each halving.
+ * Nothing's heard with no duty or no frequency, which is how the effects
+ * put gaps in. Returns false when the effect's over.
+ */
+static uint8_t ay_effect_frame( void )
+{
+  uint16_t budget = BEEPFX_LOOPS_PER_FRAME;
+  uint16_t period;
+  uint8_t  duty;
+  uint8_t  width;
+  uint8_t  volume;
+
+  while( budget >= ay_frame_left )
   {
-    bit_beepfx(pending_sound);
-    pending_sound = 0;
-    *output_action = SOUND_EFFECT;
+    budget -= ay_frame_left;
+
+    ay_frequency  += BEEPFX_WORD( ay_block, BEEPFX_SLIDE );
+    ay_duty       += ay_block[BEEPFX_DUTY_CHANGE];
+    ay_frame_left  = BEEPFX_WORD( ay_block, BEEPFX_FRAME_LENGTH );
+
+    if( --ay_block_frames == 0 )
+    {
+      ay_block += BEEPFX_TONE_BLOCK_SIZE;
+      if( !ay_load_block() )
+      {
+        ay_write( AY_VOLUME_B, 0 );
+        return 0;
+      }
+    }
+  }
+  ay_frame_left -= budget;
+
+  /* Above half the duty's the same as below it, the other way up */
+  duty   = (ay_duty <= 128) ? ay_duty : (uint8_t)-ay_duty;
+  volume = 0;
+  if( duty && ay_frequency )
+  {
+    for( volume = 15, width = 64; duty < width && volume > 7; width >>= 1 )
+      volume -= 2;
+
+    period = (ay_frequency > BEEPFX_AY_PERIOD/AY_MAX_TONE_PERIOD) ?
+               (uint16_t)(BEEPFX_AY_PERIOD / ay_frequency) : AY_MAX_TONE_PERIOD;
+    ay_write( AY_TONE_B_FINE,   (uint8_t)period );
+    ay_write( AY_TONE_B_COARSE, (uint8_t)(period>>8) );
   }
+  ay_write( AY_VOLUME_B, volume );
 
-  return KEEP_PROCESSING;
+  return 1;
 }
 
-void play_beepfx_sound_immediate( void* sound )
+
+/***
+ *      _____       _                             _
+ *     |_   _|     | |                           | |
+ *       | |  _ __ | |_ ___ _ __ _ __ _   _ _ __ | |_
+ *       | | | '_ \| __/ _ | '__| '__| | | | '_ \| __|
+ *      _| |_| | | | ||  __| |  | |  | |_| | |_) | |_
+ *     |_____|_| |_|\__\___|_|  |_|   \__,_| .__/ \__|
+ *                                         | |
+ *                                         |_|
+ *
+ * Sounds are split into 4 cycles. A cycle is a 50th of a second, i.e. one
+ * frame of the Spectrum's display. Each and every cycle does the usual game
+ * stuff, but because sound is CPU intensive it has to be rationed.
+ *
+ * Background music is played by the ISR. Every interrupt plays a 2.2ms
+ * slice of the current note, and the note moves on every 4th cycle, so a
+ * note gets the same 8.8ms it used to get in one go. The cost is spread
+ * evenly over the frames instead of every 4th frame having to finish its
+ * game work in 11ms. The cycle numbers are in sound.h.
+ *
+ * That's 11% of every frame gone on the beeper, see background_music.asm
+ * for the figures. An effect slice takes its place, so it's never both.
+ */
+
+/*
+ * Start a requested effect, if it's allowed to pre-empt, then play a step
+ * of the current one. Returns true if the step was played, in which case
+ * on the beeper it's used up this frame's slice.
+ */
+static uint8_t play_effect_frame( void )
 {
-  if( effects_on )
-    bit_beepfx(sound);
+  if( effect_request )
+  {
+    const EFFECT_DEFINITION* requested = &effect_definitions[effect_request-1];
+
+    effect_request = 0;
+
+    if( !effect || (requested->priority >= effect->priority) )
+    {
+      effect = requested;
+
+      if( ay_present )
+      {
+        ay_block = (const uint8_t*)effect->beepfx;
+        if( !ay_load_block() )
+          effect = 0;
+      }
+      else
+      {
+        start_beepfx_effect( effect->beepfx );
+      }
+    }
+  }
+
+  if( !effect || !effects_on )
+  {
+    effect = 0;
+    if( ay_present )
+      ay_write( AY_VOLUME_B, 0 );
+    return 0;
+  }
+
+  if( ay_present )
+  {
+    if( !ay_effect_frame() )
+      effect = 0;
+  }
+  else if( !play_beepfx_slice() )
+  {
+    effect = 0;
+  }
+
+  return 1;
+}
+
+/*
+ * Called from the ISR, so keep it short. On the beeper that's at most one
+ * fixed length slice, of the effect if one's playing, otherwise of the
+ * music. The AY just needs its registers updating.
+ */
+void service_sound_interrupt( void )
+{
+  uint8_t effect_played = play_effect_frame();
+
+  if( !music_on || !music_playing )
+  {
+    if( ay_present )
+      ay_write( AY_VOLUME_A, 0 );
+    return;
+  }
+
+  if( ay_present )
+    ay_music_frame();
+  else if( !effect_played )
+    play_note_slice( &(music_notes[music_current_note_index]) );
+
+  if( ((uint8_t)ticker & SOUND_CYCLE_MASK) == BACKGROUND_MUSIC_CYCLE )
+  {
+    if( GET_RUNNER_SLOWDOWN )
+    {
+      slow_note = !slow_note;
+      if( !slow_note )
+        music_current_note_index++;
+    }
+    else
+    {
+      slow_note = 0;
+      music_current_note_index++;
+    }
+
+    if( music_current_note_index == MUSIC_NUM_NOTES )
+      music_current_note_index = 0;
+  }
 }
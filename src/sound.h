@@ -20,12 +20,34 @@
 #ifndef __SOUND_H
 #define __SOUND_H
 
+/*
+ * Sounds are split into 4 cycles of the 50Hz ticker, see sound.c. The ISR
+ * moves the music on to the next note on the music cycle.
+ */
+#define SOUND_CYCLE_MASK       0x0003
+#define BACKGROUND_MUSIC_CYCLE 0x001
+
+/* The order matches the effect definitions in sound.c */
+typedef enum _sound_effect
+{
+  EFFECT_BOUNCE,
+  EFFECT_JUMP,
+  EFFECT_SLOWDOWN,
+  EFFECT_TELEPORT,
+  EFFECT_FINISH,
+  EFFECT_LOSE,
+} SOUND_EFFECT;
+
+void detect_sound_hardware( void );
+
 void toggle_music( void );
-PROCESSING_FLAG play_bg_music_note( void* data, GAME_ACTION* output_action );
+void start_background_music( void );
+void stop_background_music( void );
 
 void toggle_sound_effects( void );
-void queue_beepfx_sound( void* sound );
-PROCESSING_FLAG play_beepfx_sound( void* data, GAME_ACTION* output_action );
-void play_beepfx_sound_immediate( void* sound );
+void start_sound_effect( SOUND_EFFECT sound_effect );
+void wait_for_sound_effect( void );
+
+void service_sound_interrupt( void );
 
 #endif
@@ -47,6 +47,13 @@
  * each time round.
  * Some teleporters change the runner's direction, so he might go in
  * facing left and come out facing right. That's the flag at the end.
+ *
+ * The pixel coords are always the top left of the cell. The runner is
+ * found on a teleporter by looking his cell up in the tile map, which
+ * only works because the trigger point is cell aligned.
+ *
+ * A level can have up to 63 of these, which is what fits in a tile map
+ * entry. See tile_map.h.
  */
 typedef struct _teleporter_defintion
 {
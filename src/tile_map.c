@@ -0,0 +1,89 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <arch/zx.h>
+#include <arch/zx/sp1.h>
+
+#include "tile_map.h"
+#include "utils.h"
+#include "teleporter.h"
+#include "levels.h"
+
+/*
+ * One byte per cell. 768 bytes is a lot for a 48K game, but packing
+ * two cells per byte would add shifting and masking to every probe,
+ * which is exactly what this is meant to get rid of.
+ */
+uint8_t tile_map[TILE_MAP_WIDTH*TILE_MAP_HEIGHT];
+
+const uint8_t* load_tile_map( const uint8_t* runs )
+{
+  uint8_t* map_ptr = tile_map;
+
+  while( map_ptr < &tile_map[TILE_MAP_WIDTH*TILE_MAP_HEIGHT] )
+  {
+    uint8_t run = *runs++;
+
+    if( TILE_IS_TELEPORTER(run) )
+    {
+      *map_ptr++ = run;
+    }
+    else
+    {
+      uint8_t length = TILE_MAP_RUN_LENGTH(run);
+
+      memset( map_ptr, TILE_MAP_RUN_TILE(run), length );
+      map_ptr += length;
+    }
+  }
+
+  return runs;
+}
+
+void capture_runner_neighbourhood( RUNNER_NEIGHBOURHOOD* neighbourhood, uint8_t x, uint8_t y )
+{
+  uint8_t  row;
+  uint8_t  col;
+  uint8_t  cell_x = (x>>3)-1;
+  uint8_t  cell_y = (y>>3)-1;
+
+  neighbourhood->x_mod8 = MODULO8(x);
+  neighbourhood->y_mod8 = MODULO8(y);
+
+  /*
+   * cell_x and cell_y are unsigned so one off the left or top of the
+   * screen wraps round to 255, which the range checks catch along with
+   * the right and bottom edges.
+   */
+  for( row = 0; row < 3; row++, cell_y++ )
+  {
+    uint8_t  map_x = cell_x;
+    uint8_t* tile  = neighbourhood->tiles[row];
+
+    for( col = 0; col < 3; col++, map_x++ )
+    {
+      if( (cell_y < TILE_MAP_HEIGHT) && (map_x < TILE_MAP_WIDTH) )
+        *tile++ = GET_TILE_AT_CELL(map_x, cell_y);
+      else
+        *tile++ = TILE_SOLID;
+    }
+  }
+}
@@ -0,0 +1,137 @@
+/*
+ * Wonky One Key, a ZX Spectrum game featuring a single control key
+ * Copyright (C) 2018 Derek Fountain
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __TILE_MAP_H
+#define __TILE_MAP_H
+
+#include <stdint.h>
+
+#include "teleporter.h"
+
+/*
+ * The tile map is a logical copy of the level layout, one byte per
+ * character cell, saying what sort of thing is in that cell. It's loaded
+ * once when the level is printed. Collision detection and the "what am
+ * I standing on?" tests used to read the Spectrum's attribute file to
+ * find this out. The attribute file is in contended memory, and reading
+ * it meant the runner's colour had to match the background paper or
+ * he'd collide with himself. The tile map lives up in uncontended memory
+ * with the rest of the C data and doesn't care what colour anything is.
+ */
+typedef enum _tile_type
+{
+  TILE_BACKGROUND,
+  TILE_SOLID,
+  TILE_JUMPER,
+  TILE_FINISH,
+  TILE_DOOR,
+  TILE_TELEPORTER = 0x80,
+} TILE_TYPE;
+
+#define TILE_MAP_WIDTH  32
+#define TILE_MAP_HEIGHT 24
+
+/*
+ * Expose the map so the lookup can be done with a macro. This is in
+ * the hot path of the collision code so a CALL per probe is too much.
+ */
+extern uint8_t tile_map[TILE_MAP_WIDTH*TILE_MAP_HEIGHT];
+
+/*
+ * Offset into the map of the cell containing pixel x,y. (y/8)*32 is the
+ * same as (y&0xF8)*4, which is a mask and a couple of shifts. Like the
+ * attribute lookups this replaced, there's no bounds check. The levels
+ * have solid borders so the runner never probes off screen.
+ */
+#define TILE_MAP_OFFSET(x,y)         ((((uint16_t)((uint8_t)(y)&0xF8))<<2) + ((uint8_t)(x)>>3))
+#define TILE_MAP_CELL_OFFSET(cx,cy)  ((((uint16_t)(cy))<<5) + (uint8_t)(cx))
+
+/*
+ * Teleporter cells carry the teleporter they belong to. The top bit says
+ * it's a teleporter, the next 6 are its index in the level's list and the
+ * bottom one says which end this is. So finding out whether the runner
+ * is on a teleporter, and which, is the one lookup.
+ */
+#define TELEPORTER_TILE(index,end)   ((uint8_t)(TILE_TELEPORTER | ((index)<<1) | (end)))
+#define TILE_IS_TELEPORTER(t)        ((t) & TILE_TELEPORTER)
+#define TELEPORTER_TILE_INDEX(t)     (((t) & 0x7F) >> 1)
+#define TELEPORTER_TILE_END(t)       ((t) & 0x01)
+
+#define GET_TILE_AT_PIXEL(x,y)       ((TILE_TYPE)tile_map[TILE_MAP_OFFSET(x,y)])
+#define GET_TILE_AT_CELL(cx,cy)      ((TILE_TYPE)tile_map[TILE_MAP_CELL_OFFSET(cx,cy)])
+#define SET_TILE_AT_CELL(cx,cy,t)    (tile_map[TILE_MAP_CELL_OFFSET(cx,cy)] = (uint8_t)(t))
+
+/*
+ * The runner can walk through background and teleporter cells. Anything
+ * else stops him. Anything other than background holds him up, which
+ * includes a teleporter cell underneath him.
+ */
+#define TILE_IS_PASSABLE(t)          (((t) == TILE_BACKGROUND) || TILE_IS_TELEPORTER(t))
+#define TILE_IS_SUPPORTING(t)        ((t) != TILE_BACKGROUND)
+
+/*
+ * The 3x3 block of cells around the runner, captured once per frame.
+ * The centre cell is the one his top left pixel is in. Every probe the
+ * action functions make is within a cell of that, so they all read from
+ * this rather than each working out their own tile map offsets.
+ *
+ * The rows are 4 bytes wide, not 3, so the assembly language probe walker
+ * can find a cell with shifts rather than a multiply by 3. The last byte
+ * of each row is unused.
+ *
+ * The sub-cell offsets of the runner's x,y are kept alongside because the
+ * action functions need those too.
+ */
+#define NEIGHBOURHOOD_ROW_WIDTH 4
+
+typedef struct _runner_neighbourhood
+{
+  uint8_t  x_mod8;
+  uint8_t  y_mod8;
+  uint8_t  tiles[3][NEIGHBOURHOOD_ROW_WIDTH];
+} RUNNER_NEIGHBOURHOOD;
+
+/*
+ * Tile at a cell relative to the runner's cell, where dx,dy are -1, 0 or 1.
+ * Constant arguments make this compile to a fixed offset load.
+ */
+#define GET_NEIGHBOUR_TILE(n,dx,dy)  ((TILE_TYPE)((n).tiles[(dy)+1][(dx)+1]))
+
+/*
+ * Fill in the neighbourhood for a runner at pixel x,y. Cells off the edge
+ * of the screen are given as solid.
+ */
+void capture_runner_neighbourhood( RUNNER_NEIGHBOURHOOD* neighbourhood, uint8_t x, uint8_t y );
+
+/*
+ * The map is worked out when the level is compiled, from the colours the
+ * level's print string leaves in each cell, and comes in the level blob
+ * as runs of a tile type, a byte each. The type is in bits 5 and 6 and
+ * the run length less one in the bottom 5. Teleporter cells have the
+ * top bit set and are their own tile byte. Doors aren't in it because
+ * they mark their own cells when they're created.
+ *
+ * Load the map from the blob and return where the blob carries on.
+ */
+#define TILE_MAP_RUN_TILE(r)         ((uint8_t)((r)>>5))
+#define TILE_MAP_RUN_LENGTH(r)       ((uint8_t)(((r)&0x1F)+1))
+
+const uint8_t* load_tile_map( const uint8_t* runs );
+
+#endif
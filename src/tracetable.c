@@ -30,6 +30,10 @@
 
 static uint8_t* tracetable_head = TRACE_MEMORY_START;
 
+/* Frame of the last entry made in any table, and how many it's had */
+uint16_t trace_frame;
+uint8_t  trace_frame_seq;
+
 void* allocate_tracememory( size_t size )
 {
   void* allocated_block;
@@ -43,9 +47,19 @@ void* allocate_tracememory( size_t size )
   return allocated_block;
 }
 
-void* clear_trace_area(void)
+/*
+ * Fills what hasn't been given out to a table yet. It's called before any
+ * of them are allocated, so that's the lot. Same check as the allocator,
+ * there's nothing to fill if the ROM can't be written, and main() goes by
+ * the answer rather than checking again.
+ */
+uint8_t clear_trace_area(void)
 {
-  memset((void*)TRACE_MEMORY_START, 0xDF, MAX_TRACE_MEMORY);
+  if( !is_rom_writable() )
+    return 0;
+
+  memset(tracetable_head, 0xDF, MAX_TRACE_MEMORY - (size_t)tracetable_head);
+  return 1;
 }
 
 /*
@@ -32,7 +32,7 @@
 #define __TRACETABLE_H
 
 #include <unistd.h>
-#include <string.h>
+#include <stdint.h>
 
 #define TRACING_INACTIVE      ((void*)0xFFFF)
 
@@ -48,33 +48,123 @@
 #define MAX_TRACE_MEMORY ((uint16_t)(0x3D00))
 
 /*
- * Macro to generate a function to add an entry to a trace table.
- * The process is to take a pointer to a structure which defines
- * the trace entry, memcpy() it into the next slot of the trace
- * table, advance the next slot point, and if it wraps put the
- * next slot pointer back to the start of the table. Since all
- * tracing needs to do exactly this, this function is generated
+ * What gets traced is decided at compile time, by level and category.
+ * A trace which isn't wanted compiles to nothing at all: no table, no
+ * test of whether tracing is active, no code at the call sites.
+ *
+ * The level says how much: none, only the things which happen now and
+ * then, or also the ones made every frame. The categories are a mask,
+ * one bit per trace table. The makefile sets both, TRACE_LEVEL and
+ * TRACE_CATEGORIES; the defaults trace everything.
+ */
+#define TRACE_LEVEL_NONE      0
+#define TRACE_LEVEL_EVENTS    1
+#define TRACE_LEVEL_FRAMES    2
+
+#define TRACE_GAMELOOP        0x01
+#define TRACE_KEY_ACTION      0x02
+#define TRACE_COLLISION       0x04
+#define TRACE_RUNNER          0x08
+#define TRACE_SLOWDOWN        0x10
+#define TRACE_DOOR            0x20
+#define TRACE_COLLECTABLE     0x40
+#define TRACE_FRAME_STATS     0x80
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL           TRACE_LEVEL_FRAMES
+#endif
+
+#ifndef TRACE_CATEGORIES
+#define TRACE_CATEGORIES      0xFF
+#endif
+
+#define TRACING(CATEGORY,LEVEL) ((TRACE_CATEGORIES & (CATEGORY)) && TRACE_LEVEL >= (LEVEL))
+
+/*
+ * Each trace table's category and level. These can be used in #if.
+ * The runner traces every frame of a jump, the game loop every action
+ * and the collision checker every frame. The frame stats aren't a table
+ * but a block of counters; they cost a few instructions a frame so they
+ * come in at the lower level, to be there in the lightest traced build.
+ */
+#define GAMELOOP_TRACING      TRACING(TRACE_GAMELOOP,    TRACE_LEVEL_FRAMES)
+#define KEY_ACTION_TRACING    TRACING(TRACE_KEY_ACTION,  TRACE_LEVEL_EVENTS)
+#define COLLISION_TRACING     TRACING(TRACE_COLLISION,   TRACE_LEVEL_FRAMES)
+#define RUNNER_TRACING        TRACING(TRACE_RUNNER,      TRACE_LEVEL_FRAMES)
+#define SLOWDOWN_TRACING      TRACING(TRACE_SLOWDOWN,    TRACE_LEVEL_EVENTS)
+#define DOOR_TRACING          TRACING(TRACE_DOOR,        TRACE_LEVEL_EVENTS)
+#define COLLECTABLE_TRACING   TRACING(TRACE_COLLECTABLE, TRACE_LEVEL_EVENTS)
+#define FRAME_STATS_TRACING   TRACING(TRACE_FRAME_STATS, TRACE_LEVEL_EVENTS)
+
+#define ANY_TRACING           (TRACE_LEVEL != TRACE_LEVEL_NONE && TRACE_CATEGORIES != 0)
+
+/*
+ * Macro to define a trace table. It defines and initialises the table
+ * pointer and the next entry in the table pointer, for the name of the
+ * thing to be traced and the type which defines the trace entry
+ * structure. Since all tracing needs to do exactly this, it's done
  * with a macro to enforce conformity.
  *
- * The macro takes the name of the thing to be traced, the type
- * which defines the trace entry structure, and the size of the
- * table in bytes so it knows when to wrap.
- * It also defines and initialises the table pointer and the
- * next entry in the table pointer.
+ * An entry is added by filling in the fields of TRACE_ENTRY(NAME) where
+ * it sits, then calling TRACE_ADVANCE to move the next slot pointer on,
+ * putting it back to the start of the table if it wraps. The table
+ * size is in bytes. This used to copy a filled in entry into the table
+ * with memcpy(), which was a call and a copy more than was needed.
+ *
+ * Only fill in an entry if NAME_tracetable isn't TRACING_INACTIVE.
+ *
+ * wonky_traces decodes the tables out of snapshots using layouts which
+ * host/trace_layouts.pl reads from the entry structures, so each entry
+ * has to start with its timestamp, uint16_t ticker then uint8_t
+ * frame_seq, filled in with TRACE_STAMP.
  */
-#define TRACE_FN( NAME, TYPE, TABLE_SIZE )	\
-\
-TYPE * NAME ## _tracetable = TRACING_INACTIVE; \
-TYPE * NAME ## _next_trace = 0xFFFF; \
-\
-void NAME ## _add_trace( TYPE * ptr ) \
-{\
-  memcpy( NAME ## _next_trace, ptr, sizeof(TYPE));\
+#define TRACE_TABLE( NAME, TYPE ) \
 \
-  NAME ## _next_trace = (void*)((uint8_t*)NAME ## _next_trace + sizeof(TYPE));\
-\
-  if( NAME ## _next_trace == (void*)((uint8_t*)NAME ## _tracetable + TABLE_SIZE) )\
-      NAME ## _next_trace = NAME ## _tracetable;\
+TYPE * NAME ## _tracetable = (TYPE *)TRACING_INACTIVE; \
+TYPE * NAME ## _next_trace = (TYPE *)0xFFFF; \
+uint16_t NAME ## _ticker_high = 0;
+
+/*
+ * Timestamp for an entry. The 16 bit ticker wraps every 22 minutes and
+ * several entries are often made in one frame, so on its own it can't
+ * put a long run's entries in order. The ISR counts the wraps in
+ * ticker_high, making a 32 bit frame count, and each entry gets a
+ * sequence number within its frame.
+ *
+ * Only the low 16 bits of the frame go in each entry. The high word is
+ * kept once per table, as at its newest entry. Reading the table back
+ * from there, each time the ticker goes up instead of down is a wrap.
+ * That's right as long as a table never goes a whole wrap without an
+ * entry.
+ *
+ * The ticker and its high word are read without holding interrupts
+ * off, again if the ISR wrapped the ticker in between. They're in int.h,
+ * which the tracing modules include for the ticker anyway.
+ */
+extern uint16_t trace_frame;
+extern uint8_t  trace_frame_seq;
+
+#define TRACE_STAMP( NAME, ENTRY ) \
+{ \
+  uint16_t trace_ticker; \
+  do { \
+    NAME ## _ticker_high = ticker_high; \
+    trace_ticker = GET_TICKER; \
+  } while( NAME ## _ticker_high != ticker_high ); \
+  if( trace_ticker != trace_frame ) { \
+    trace_frame     = trace_ticker; \
+    trace_frame_seq = 0; \
+  } \
+  (ENTRY)->ticker    = trace_ticker; \
+  (ENTRY)->frame_seq = trace_frame_seq++; \
+}
+
+#define TRACE_ENTRY( NAME ) (NAME ## _next_trace)
+
+#define TRACE_ADVANCE( NAME, TABLE_SIZE ) \
+{ \
+  if( ++NAME ## _next_trace == (void*)((uint8_t*)NAME ## _tracetable + TABLE_SIZE) ) \
+    NAME ## _next_trace = NAME ## _tracetable; \
 }
 
 
@@ -86,9 +176,10 @@ uint8_t is_rom_writable(void);
 
 /*
  * Clear or otherwise initialise the area of memory all the
- * tracing will go into.
+ * tracing will go into. Answers 1 if it did, or 0 if the ROM
+ * can't be written so there's no tracing.
  */
-void* clear_trace_area(void);
+uint8_t clear_trace_area(void);
 
 /*
  * Allocate memory to hold a tracetable of 'size' bytes.